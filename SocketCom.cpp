@@ -8,6 +8,7 @@ http://opensource.org/licenses/mit-license.php
 */
 
 #include "SocketCom.h"
+#include "SocketComStats.h"
 
 #ifdef _SOCKETCOM_WIN32_
 
@@ -18,6 +19,8 @@ http://opensource.org/licenses/mit-license.php
 #define errno WSAGetLastError()
 #define SOCKETCOM_EINTR WSAEINTR
 #define SOCKETCOM_EINPROGRESS  WSAEINPROGRESS
+#define SOCKETCOM_EWOULDBLOCK WSAEWOULDBLOCK
+#define SOCKETCOM_EAGAIN WSAEWOULDBLOCK
 
 #else
 
@@ -25,19 +28,31 @@ http://opensource.org/licenses/mit-license.php
 #include <unistd.h>
 #include <arpa/inet.h>
 #include <sys/time.h>
+#include <time.h>
 #include <sys/ioctl.h>
 #include <sys/types.h>
 #include <netinet/tcp.h>
+#include <netinet/udp.h>
 #include <netdb.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <poll.h>
+#ifdef _SOCKETCOM_LINUX_
+#include <sys/epoll.h>
+#include <sys/sendfile.h>
+#include <linux/errqueue.h>
+#endif
 
 #define SOCKETCOM_EINTR EINTR
 #define SOCKETCOM_EINPROGRESS  EINPROGRESS
+#define SOCKETCOM_EWOULDBLOCK EWOULDBLOCK
+#define SOCKETCOM_EAGAIN EAGAIN
 
 #endif
 
 #include <string.h>
+#include <stdlib.h>
+#include <limits.h>
 
 #ifdef SOCKETCOM_NDEBUG
 #define PERROR(str) do{}while(0)
@@ -45,6 +60,61 @@ http://opensource.org/licenses/mit-license.php
 #define PERROR(str) perror(str)
 #endif
 
+#if defined(IOV_MAX)
+#define SOCKETCOM_IOV_MAX IOV_MAX
+#else
+#define SOCKETCOM_IOV_MAX 16
+#endif
+
+#ifdef MSG_NOSIGNAL
+#define SOCKETCOM_MSG_NOSIGNAL MSG_NOSIGNAL
+#else
+#define SOCKETCOM_MSG_NOSIGNAL 0
+#endif
+
+#define SOCKETCOM_IS_WOULDBLOCK(err) ((err) == SOCKETCOM_EWOULDBLOCK || (err) == SOCKETCOM_EAGAIN)
+
+static long long SocketCom_NowMsec(void)
+{
+#ifdef _SOCKETCOM_WIN32_
+  return (long long)GetTickCount64();
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+#endif
+}
+
+#ifdef SOCKETCOM_USE_STATS
+/**
+ *  total length of iov; requested bytes of a syscall for SOCKETCOM_STATS_COUNT()
+ */
+static size_t SocketCom_IoVecLen(const SocketCom_IoVec *iov, int iovcnt)
+{
+  size_t len = 0;
+  int i;
+
+  for (i = 0; i < iovcnt; i++) {
+    len += SOCKETCOM_IOVEC_LEN(iov[i]);
+  }
+  return len;
+}
+#endif
+
+/**
+ *  milli seconds left until deadline; -1 for no deadline (deadline < 0)
+ */
+static long SocketCom_RemainMsec(long long deadline)
+{
+  long long now;
+
+  if (deadline < 0) {
+    return -1;
+  }
+  now = SocketCom_NowMsec();
+  return (deadline > now) ? (long)(deadline - now) : 0;
+}
+
 int SocketCom_ResolveHostname(const char *hostname, char *ip_str)
 {
   int res;
@@ -139,6 +209,72 @@ int SocketCom_SetReuseaddr(SocketCom *sock)
   return SOCKETCOM_SUCCESS;
 }
 
+int SocketCom_SetReuseport(SocketCom *sock)
+{
+#ifdef SO_REUSEPORT
+  int res;
+  int on = 1;
+
+  res = setsockopt(sock->fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+  if (res < 0) {
+    PERROR("SocketCom_SetReuseport()");
+    return SOCKETCOM_ERROR_SETREUSEPORT;
+  }
+
+  return SOCKETCOM_SUCCESS;
+#else
+  (void)sock;
+  return SOCKETCOM_ERROR_NOTSUPPORTED;
+#endif
+}
+
+int SocketCom_SetFastOpen(SocketCom *sock, int qlen)
+{
+#if defined(_SOCKETCOM_POSIX_) && defined(TCP_FASTOPEN)
+  if (setsockopt(sock->fd, IPPROTO_TCP, TCP_FASTOPEN, &qlen, sizeof(qlen)) < 0) {
+    PERROR("SocketCom_SetFastOpen()");
+    return SOCKETCOM_ERROR_SETFASTOPEN;
+  }
+
+  return SOCKETCOM_SUCCESS;
+#else
+  (void)sock; (void)qlen;
+  return SOCKETCOM_ERROR_NOTSUPPORTED;
+#endif
+}
+
+int SocketCom_SetNoDelay(SocketCom *sock, int on)
+{
+  on = (on != 0);
+  if (setsockopt(sock->fd, IPPROTO_TCP, TCP_NODELAY, (const char *)&on, sizeof(on)) < 0) {
+    PERROR("SocketCom_SetNoDelay()");
+    return SOCKETCOM_ERROR_SETNODELAY;
+  }
+
+  return SOCKETCOM_SUCCESS;
+}
+
+int SocketCom_SetCork(SocketCom *sock, int on)
+{
+#if defined(TCP_CORK) || defined(TCP_NOPUSH)
+#ifdef TCP_CORK
+  int opt = TCP_CORK;
+#else
+  int opt = TCP_NOPUSH;
+#endif
+  on = (on != 0);
+  if (setsockopt(sock->fd, IPPROTO_TCP, opt, &on, sizeof(on)) < 0) {
+    PERROR("SocketCom_SetCork()");
+    return SOCKETCOM_ERROR_SETCORK;
+  }
+
+  return SOCKETCOM_SUCCESS;
+#else
+  (void)sock; (void)on;
+  return SOCKETCOM_ERROR_NOTSUPPORTED;
+#endif
+}
+
 int SocketCom_Startup(void)
 {
 #ifdef _SOCKETCOM_WIN32_
@@ -159,21 +295,40 @@ void SocketCom_Init(SocketCom *sock)
 }
 
 int SocketCom_Create(SocketCom* sock)
+{
+  return SocketCom_CreateEx(sock, AF_INET, SOCK_STREAM);
+}
+
+int SocketCom_CreateEx(SocketCom* sock, int family, int type)
 {
   if (sock->status & SOCKETCOM_STATE_CREATED) {
     return SOCKETCOM_ERROR_ALREADY_CREATED;
   }
 
-  sock->fd = socket(AF_INET, SOCK_STREAM, 0);
+  sock->fd = socket(family, type, 0);
   if (sock->fd == SOCKET_ERROR) {
-    PERROR("SocketCom_Create()");
+    PERROR("SocketCom_CreateEx()");
     return SOCKETCOM_ERROR_CREATE;
   }
 
+  if (!(sock->status & SOCKETCOM_STATE_HAS_ADDR)) {
+    // remember the family for SocketCom_Bind() to any address
+    memset(&sock->addr, 0, sizeof(struct sockaddr_storage));
+    sock->addr.ss_family = family;
+  }
   sock->status |= SOCKETCOM_STATE_CREATED;
+  SOCKETCOM_STATS_RESET(sock);
+  if (type == SOCK_DGRAM) {
+    sock->status |= SOCKETCOM_STATE_DGRAM;
+  }
   return SOCKETCOM_SUCCESS;
 }
 
+int SocketCom_CreateDgram(SocketCom* sock)
+{
+  return SocketCom_CreateEx(sock, AF_INET, SOCK_DGRAM);
+}
+
 int SocketCom_Dispose(SocketCom* sock)
 {
   if (!(sock->status & SOCKETCOM_STATE_CREATED)) {
@@ -196,10 +351,18 @@ int SocketCom_Dispose(SocketCom* sock)
 }
 
 int SocketCom_Close(SocketCom* sock)
+{
+  return SocketCom_CloseWithTimeout(sock, SOCKETCOM_CLOSE_TIMEOUT_MSEC);
+}
+
+int SocketCom_CloseStart(SocketCom* sock)
 {
   if (!(sock->status & SOCKETCOM_STATE_CREATED)) {
     return SOCKETCOM_ERROR_ALREADY_CLOSED;
   }
+  if (sock->status & SOCKETCOM_STATE_DGRAM) {
+    return SOCKETCOM_SUCCESS;
+  }
 
   int res;
 #ifdef _SOCKETCOM_WIN32_
@@ -208,25 +371,110 @@ int SocketCom_Close(SocketCom* sock)
   res = shutdown(sock->fd, SHUT_WR);
 #endif
   if (res < 0) {
-    PERROR("SocketCom_Close()");
+    // e.g. the peer already reset the connection; nothing to drain
+    PERROR("shutdown in SocketCom_CloseStart()");
+    SocketCom_Dispose(sock);
     return SOCKETCOM_ERROR_CLOSE;
   }
 
-  char tmp;
-  while (1) {
-    res = SocketCom_Recv(sock, &tmp, sizeof(tmp), NULL);
+  res = SocketCom_SetNonBlockingSocket(sock);
+  if (res != SOCKETCOM_SUCCESS) {
+    SocketCom_Dispose(sock);
+    return res;
+  }
+  return SOCKETCOM_SUCCESS;
+}
+
+int SocketCom_CloseDrain(SocketCom* sock)
+{
+  char buf[SOCKETCOM_CLOSE_DRAIN_BUF_SIZE];
+  long drained = 0;
+  int res;
+
+  if (!(sock->status & SOCKETCOM_STATE_CREATED)) {
+    return SOCKETCOM_ERROR_ALREADY_CLOSED;
+  }
+  if (sock->status & SOCKETCOM_STATE_DGRAM) {
+    // no connection to shut down
+    return SocketCom_Dispose(sock);
+  }
+
+  // discard data until FIN, in large reads; a peer which keeps sending is bounded by SOCKETCOM_CLOSE_DRAIN_BUDGET per call
+  while (drained < SOCKETCOM_CLOSE_DRAIN_BUDGET) {
+    int recvLen = 0;
+    res = SocketCom_RecvEx(sock, buf, sizeof(buf), &recvLen, 0);
+    if (res == SOCKETCOM_ERROR_WOULDBLOCK) {
+      return SOCKETCOM_ERROR_WOULDBLOCK;
+    }
     if (res == SOCKETCOM_ERROR_DISCONNECTED) {
-      break;
+      return SocketCom_Dispose(sock);
     }
     if (res != SOCKETCOM_SUCCESS) {
+      SocketCom_Dispose(sock);
       return res;
     }
+    drained += recvLen;
+  }
+
+  return SOCKETCOM_ERROR_WOULDBLOCK;
+}
+
+int SocketCom_Abort(SocketCom* sock)
+{
+  struct linger lin;
+
+  if (!(sock->status & SOCKETCOM_STATE_CREATED)) {
+    return SOCKETCOM_ERROR_ALREADY_CLOSED;
+  }
+
+  // close with RST, discarding unsent and unread data, without TIME_WAIT
+  lin.l_onoff = 1;
+  lin.l_linger = 0;
+  if (setsockopt(sock->fd, SOL_SOCKET, SO_LINGER, (const char *)&lin, sizeof(lin)) != 0) {
+    PERROR("setsockopt(SO_LINGER) in SocketCom_Abort()");
   }
 
   return SocketCom_Dispose(sock);
 }
 
+int SocketCom_CloseWithTimeout(SocketCom* sock, long timeout_msec)
+{
+  long long deadline = (timeout_msec >= 0) ? SocketCom_NowMsec() + timeout_msec : -1;
+  int res;
+
+  res = SocketCom_CloseStart(sock);
+  if (res != SOCKETCOM_SUCCESS) {
+    return res;
+  }
+
+  while (1) {
+    res = SocketCom_CloseDrain(sock);
+    if (res != SOCKETCOM_ERROR_WOULDBLOCK) {
+      return res;
+    }
+
+    long wait = SocketCom_RemainMsec(deadline);
+    if (wait == 0) {
+      break;
+    }
+    res = SocketCom_WaitForRecvableWithTimeout(sock, (wait < 0) ? -1 : wait / 1000, (wait < 0) ? -1 : (wait % 1000) * 1000);
+    if (res != SOCKETCOM_SUCCESS && res != SOCKETCOM_ERROR_TIMEOUT_SELECT) {
+      SocketCom_Abort(sock);
+      return res;
+    }
+  }
+
+  // the peer did not close in time
+  SocketCom_Abort(sock);
+  return SOCKETCOM_ERROR_TIMEOUT_CLOSE;
+}
+
 int SocketCom_Listen(SocketCom* sock, u_short port)
+{
+  return SocketCom_ListenEx(sock, NULL, port, SOCKETCOM_LISTEN_BACKLOG, SOCKETCOM_LISTEN_FLAGS);
+}
+
+int SocketCom_ListenEx(SocketCom* sock, const char *ip, u_short port, int backlog, int flags)
 {
   int res;
 
@@ -234,19 +482,32 @@ int SocketCom_Listen(SocketCom* sock, u_short port)
     return SOCKETCOM_ERROR_ILLEGAL_SOCK;
   }
 
-  memset(&sock->addr, 0, sizeof(struct sockaddr_in));
-  sock->addr.sin_family = AF_INET;
-  sock->addr.sin_port = htons(port);
-  sock->addr.sin_addr.s_addr = htonl(INADDR_ANY);
-  res = bind(sock->fd, (struct sockaddr *)&sock->addr, sizeof(struct sockaddr_in));
-  if (res < 0) {
-    PERROR("bind() in SocketCom_Listen()");
-    return SOCKETCOM_ERROR_BIND;
+  if (flags & SOCKETCOM_LISTEN_FLAG_REUSEADDR) {
+    res = SocketCom_SetReuseaddr(sock);
+    if (res != SOCKETCOM_SUCCESS) {
+      return res;
+    }
+  }
+  if (flags & SOCKETCOM_LISTEN_FLAG_REUSEPORT) {
+    res = SocketCom_SetReuseport(sock);
+    if (res != SOCKETCOM_SUCCESS) {
+      return res;
+    }
+  }
+
+  res = SocketCom_Bind(sock, ip, port);
+  if (res != SOCKETCOM_SUCCESS) {
+    return res;
+  }
+
+  if (flags & SOCKETCOM_LISTEN_FLAG_FASTOPEN) {
+    // best effort; connections without Fast Open are accepted as usual
+    SocketCom_SetFastOpen(sock, SOCKETCOM_FASTOPEN_QLEN);
   }
 
-  res = listen(sock->fd, 5);
+  res = listen(sock->fd, backlog);
   if (res < 0) {
-    PERROR("listen() in SocketCom_Listen()");
+    PERROR("listen() in SocketCom_ListenEx()");
     return SOCKETCOM_ERROR_LISTEN;
   }
 
@@ -255,30 +516,179 @@ int SocketCom_Listen(SocketCom* sock, u_short port)
   return SOCKETCOM_SUCCESS;
 }
 
+socklen_t SocketCom_SockaddrLen(const struct sockaddr_storage *addr)
+{
+  switch (addr->ss_family) {
+  case AF_INET:
+    return sizeof(struct sockaddr_in);
+  case AF_INET6:
+    return sizeof(struct sockaddr_in6);
+  default:
+    return sizeof(struct sockaddr_storage);
+  }
+}
+
+/**
+ *  build address from ip and port; ip containing ':' is IPv6, and NULL is the any address of family
+ */
+static int SocketCom_ToSockaddr(const char *ip, u_short port, int family, struct sockaddr_storage *addr)
+{
+  memset(addr, 0, sizeof(struct sockaddr_storage));
+
+  if (ip != NULL) {
+    family = (strchr(ip, ':') != NULL) ? AF_INET6 : AF_INET;
+  }
+
+  if (family == AF_INET6) {
+    struct sockaddr_in6 *addr6 = (struct sockaddr_in6 *)addr;
+    addr6->sin6_family = AF_INET6;
+    addr6->sin6_port = htons(port);
+    if (ip == NULL) {
+      addr6->sin6_addr = in6addr_any;
+    } else if (inet_pton(AF_INET6, ip, &addr6->sin6_addr) != 1) {
+      return SOCKETCOM_ERROR_ILLEGAL_SOCK;
+    }
+  } else {
+    struct sockaddr_in *addr4 = (struct sockaddr_in *)addr;
+    addr4->sin_family = AF_INET;
+    addr4->sin_port = htons(port);
+    if (ip == NULL) {
+      addr4->sin_addr.s_addr = htonl(INADDR_ANY);
+    } else if (inet_pton(AF_INET, ip, &addr4->sin_addr) != 1) {
+      // unlike inet_addr(), 255.255.255.255 is valid and malformed strings are not taken as it
+      return SOCKETCOM_ERROR_ILLEGAL_SOCK;
+    }
+  }
+
+  return SOCKETCOM_SUCCESS;
+}
+
+int SocketCom_Bind(SocketCom* sock, const char *ip, u_short port)
+{
+  if (!(sock->status & SOCKETCOM_STATE_CREATED)) {
+    return SOCKETCOM_ERROR_ILLEGAL_SOCK;
+  }
+
+  int family = (sock->addr.ss_family == AF_INET6) ? AF_INET6 : AF_INET;
+  if (SocketCom_ToSockaddr(ip, port, family, &sock->addr) != SOCKETCOM_SUCCESS) {
+    return SOCKETCOM_ERROR_BIND;
+  }
+  if (bind(sock->fd, (struct sockaddr *)&sock->addr, SocketCom_SockaddrLen(&sock->addr)) < 0) {
+    PERROR("bind() in SocketCom_Bind()");
+    return SOCKETCOM_ERROR_BIND;
+  }
+
+  return SOCKETCOM_SUCCESS;
+}
+
 int SocketCom_Accept(SocketCom* sock, SocketCom *connectedSock)
 {
   if (!(sock->status & SOCKETCOM_STATE_SERVER)) {
     return SOCKETCOM_ERROR_ILLEGAL_SOCK;
   }
 
-  socklen_t addrlen = sizeof(struct sockaddr_in);
+  socklen_t addrlen = sizeof(struct sockaddr_storage);
   connectedSock->fd = accept(sock->fd, (struct sockaddr *)&connectedSock->addr, &addrlen);
   if (connectedSock->fd == SOCKET_ERROR) {
     PERROR("accept() in SocketCom_Accept()");
     return SOCKETCOM_ERROR_ACCEPT;
   }
 
-  connectedSock->status |= SOCKETCOM_STATE_CLIENT | SOCKETCOM_STATE_HAS_ADDR;
+  connectedSock->status |= SOCKETCOM_STATE_CREATED | SOCKETCOM_STATE_CLIENT | SOCKETCOM_STATE_HAS_ADDR;
+  SOCKETCOM_STATS_RESET(connectedSock);
 
   return SOCKETCOM_SUCCESS;
 }
 
+int SocketCom_AcceptMany(SocketCom* sock, SocketCom connectedSocks[], int *connectedSocks_len)
+{
+  int n = 0;
+  int res = SOCKETCOM_SUCCESS;
+
+  if (!(sock->status & SOCKETCOM_STATE_SERVER)) {
+    *connectedSocks_len = 0;
+    return SOCKETCOM_ERROR_ILLEGAL_SOCK;
+  }
+
+#ifdef _SOCKETCOM_POSIX_
+  int blocking = !(fcntl(sock->fd, F_GETFL, 0) & O_NONBLOCK);
+#endif
+
+  while (n < *connectedSocks_len) {
+    SocketCom *connectedSock = &connectedSocks[n];
+    socklen_t addrlen = sizeof(struct sockaddr_storage);
+
+#ifdef _SOCKETCOM_POSIX_
+    if (n > 0 && blocking) {
+      // do not block after the first connection
+      struct pollfd pfd;
+      pfd.fd = sock->fd;
+      pfd.events = POLLIN;
+      pfd.revents = 0;
+      if (poll(&pfd, 1, 0) <= 0) {
+        break;
+      }
+    }
+#endif
+
+#ifdef _SOCKETCOM_LINUX_
+    int fd = accept4(sock->fd, (struct sockaddr *)&connectedSock->addr, &addrlen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+#else
+    int fd = accept(sock->fd, (struct sockaddr *)&connectedSock->addr, &addrlen);
+#endif
+    if (fd == SOCKET_ERROR) {
+      int err = errno;
+      if (err == SOCKETCOM_EINTR) {
+        continue;
+      }
+#ifdef _SOCKETCOM_POSIX_
+      if (err == ECONNABORTED || err == EPROTO) {
+        // the connection was reset while queued
+        continue;
+      }
+#endif
+      if (SOCKETCOM_IS_WOULDBLOCK(err)) {
+        res = SOCKETCOM_ERROR_WOULDBLOCK;
+      } else {
+        // e.g. out of fds; return the accepted ones, the error recurs on the next call
+        PERROR("accept() in SocketCom_AcceptMany()");
+        res = SOCKETCOM_ERROR_ACCEPT;
+      }
+      break;
+    }
+
+#ifdef _SOCKETCOM_WIN32_
+    u_long val = 1;
+    ioctlsocket(fd, FIONBIO, &val);
+#elif !defined(_SOCKETCOM_LINUX_)
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+#endif
+    connectedSock->fd = fd;
+    connectedSock->status = SOCKETCOM_STATE_CREATED | SOCKETCOM_STATE_CLIENT | SOCKETCOM_STATE_HAS_ADDR;
+    SOCKETCOM_STATS_RESET(connectedSock);
+    n++;
+  }
+
+  *connectedSocks_len = n;
+  return (n > 0) ? SOCKETCOM_SUCCESS : res;
+}
+
 int SocketCom_SetAddrin(SocketCom* sock, const sockaddr_in *addr)
+{
+  return SocketCom_SetSockaddr(sock, (const struct sockaddr *)addr, sizeof(struct sockaddr_in));
+}
+
+int SocketCom_SetSockaddr(SocketCom* sock, const struct sockaddr *addr, socklen_t addrlen)
 {
   if (sock->status & (SOCKETCOM_STATE_SERVER|SOCKETCOM_STATE_CLIENT)) {
     return SOCKETCOM_ERROR_ILLEGAL_SOCK;
   }
-  sock->addr = *addr;
+  if (addrlen > (socklen_t)sizeof(struct sockaddr_storage)) {
+    return SOCKETCOM_ERROR_ILLEGAL_SOCK;
+  }
+  memset(&sock->addr, 0, sizeof(struct sockaddr_storage));
+  memcpy(&sock->addr, addr, addrlen);
   sock->status |= SOCKETCOM_STATE_HAS_ADDR;
 
   return SOCKETCOM_SUCCESS;
@@ -286,12 +696,13 @@ int SocketCom_SetAddrin(SocketCom* sock, const sockaddr_in *addr)
 
 int SocketCom_SetAddr(SocketCom* sock, const char *ip, u_short port)
 {
-  sockaddr_in addr = {0};
-  addr.sin_family = AF_INET;
-  addr.sin_port = htons(port);
-  addr.sin_addr.s_addr = inet_addr(ip);
+  struct sockaddr_storage addr;
+
+  if (SocketCom_ToSockaddr(ip, port, AF_INET, &addr) != SOCKETCOM_SUCCESS) {
+    return SOCKETCOM_ERROR_ILLEGAL_SOCK;
+  }
 
-  return SocketCom_SetAddrin(sock, &addr);
+  return SocketCom_SetSockaddr(sock, (const struct sockaddr *)&addr, SocketCom_SockaddrLen(&addr));
 }
 
 int SocketCom_Connect(SocketCom* sock)
@@ -300,7 +711,7 @@ int SocketCom_Connect(SocketCom* sock)
   if (!(sock->status & (SOCKETCOM_STATE_CREATED|SOCKETCOM_STATE_HAS_ADDR))) {
     return SOCKETCOM_ERROR_ILLEGAL_SOCK;
   }
-  res = connect(sock->fd, (struct sockaddr*)&sock->addr, sizeof(struct sockaddr_in));
+  res = connect(sock->fd, (struct sockaddr*)&sock->addr, SocketCom_SockaddrLen(&sock->addr));
   if (res != 0) {
     PERROR("SocketCom_Connect()");
     return SOCKETCOM_ERROR_CONNECT;
@@ -328,6 +739,43 @@ int SocketCom_ConnectTo(SocketCom* sock, const char *ip, u_short port)
   return SOCKETCOM_SUCCESS;
 }
 
+int SocketCom_ConnectStart(SocketCom* sock)
+{
+  if (!(sock->status & (SOCKETCOM_STATE_CREATED|SOCKETCOM_STATE_HAS_ADDR))) {
+    return SOCKETCOM_ERROR_ILLEGAL_SOCK;
+  }
+  if (connect(sock->fd, (struct sockaddr*)&sock->addr, SocketCom_SockaddrLen(&sock->addr)) == 0) {
+    sock->status |= SOCKETCOM_STATE_CLIENT;
+    return SOCKETCOM_SUCCESS;
+  }
+  if (errno == SOCKETCOM_EINPROGRESS || SOCKETCOM_IS_WOULDBLOCK(errno)) {
+    return SOCKETCOM_ERROR_WOULDBLOCK;
+  }
+  PERROR("connect in SocketCom_ConnectStart()");
+  return SOCKETCOM_ERROR_CONNECT;
+}
+
+int SocketCom_ConnectFinish(SocketCom* sock)
+{
+  int error = 0;
+  socklen_t error_len = sizeof(error);
+
+  if (getsockopt(sock->fd, SOL_SOCKET, SO_ERROR, (char *)&error, &error_len) != 0) {
+    PERROR("getsockopt in SocketCom_ConnectFinish()");
+    return SOCKETCOM_ERROR_GETSOCKOPT;
+  }
+  if (error != 0) {
+#ifdef _SOCKETCOM_POSIX_
+    errno = error;
+#endif
+    PERROR("SO_ERROR in SocketCom_ConnectFinish()");
+    return SOCKETCOM_ERROR_CONNECT;
+  }
+
+  sock->status |= SOCKETCOM_STATE_CLIENT;
+  return SOCKETCOM_SUCCESS;
+}
+
 int SocketCom_ConnectWithTimeout(SocketCom* sock, unsigned long timeout_msec)
 {
   int res;
@@ -355,7 +803,7 @@ int SocketCom_ConnectWithTimeout(SocketCom* sock, unsigned long timeout_msec)
   }
 
   // connect
-  res = connect(sock->fd, (struct sockaddr*)&sock->addr, sizeof(struct sockaddr_in));
+  res = connect(sock->fd, (struct sockaddr*)&sock->addr, SocketCom_SockaddrLen(&sock->addr));
   if (res == SOCKET_ERROR) {
     res = WSAGetLastError();
     if (res != WSAEWOULDBLOCK) {
@@ -405,64 +853,46 @@ int SocketCom_ConnectWithTimeout(SocketCom* sock, unsigned long timeout_msec)
 
 #else
 
-  int error;
-  socklen_t error_len;
-
-  // set socket nonblocking
-  res = fcntl(sock->fd, F_SETFL, O_NONBLOCK);
-  if(res < 0) {
+  // set socket nonblocking, keeping other flags
+  int fl = fcntl(sock->fd, F_GETFL, 0);
+  if (fl < 0 || fcntl(sock->fd, F_SETFL, fl | O_NONBLOCK) < 0) {
     PERROR("fcntl set nonbolocking in SocketCom_ConnectWithTimeout()");
     return SOCKETCOM_ERROR_FCNTL;
   }
 
   // connect with timeout
-  res = connect(sock->fd, (struct sockaddr*)&sock->addr, sizeof(struct sockaddr_in));
-  if (res < 0) {
-    if (errno != SOCKETCOM_EINPROGRESS) {
-      PERROR("connect in SocketCom_ConnectWithTimeout()");
-      return SOCKETCOM_ERROR_CONNECT;
-    }
-
-    struct timeval tv;
-    tv.tv_sec = timeout_msec / 1000;
-    tv.tv_usec = (timeout_msec * 1000) - (tv.tv_sec * 1000 * 1000);
-
+  res = SocketCom_ConnectStart(sock);
+  if (res == SOCKETCOM_ERROR_WOULDBLOCK) {
+    struct pollfd pfd;
+    pfd.fd = sock->fd;
+    pfd.events = POLLOUT;
     while (1) {
-      fd_set set;
-      FD_ZERO(&set);
-      FD_SET(sock->fd , &set);
-      res = select(sock->fd+1, NULL, &set, NULL, &tv);
-      if (res <= 0 || !FD_ISSET(sock->fd, &set)) {
-        if (errno == SOCKETCOM_EINTR) {
-          //retry
-          continue;
-        }
-        // error or timeout
-        PERROR("select in SocketCom_ConnectWithTimeout()");
-        return SOCKETCOM_ERROR_SELECT;
+      pfd.revents = 0;
+      int ready = poll(&pfd, 1, (timeout_msec > INT_MAX) ? INT_MAX : (int)timeout_msec);
+      if (ready > 0) {
+        res = SocketCom_ConnectFinish(sock);
+        break;
       }
-
-      error_len = sizeof(error);
-      if (getsockopt(sock->fd, SOL_SOCKET, SO_ERROR, &error, &error_len) != 0) {
-        PERROR("getsockopt in SocketCom_ConnectWithTimeout()");
-        return SOCKETCOM_ERROR_GETSOCKOPT;
+      if (ready == 0) {
+        res = SOCKETCOM_ERROR_TIMEOUT_CONNECT;
+        break;
       }
-      if (error != 0) {
-        errno = error;
-        PERROR("SO_ERROR in SocketCom_ConnectWithTimeout()");
-        return SOCKETCOM_ERROR_CONNECT;
+      if (errno != SOCKETCOM_EINTR) {
+        PERROR("poll in SocketCom_ConnectWithTimeout()");
+        res = SOCKETCOM_ERROR_SELECT;
+        break;
       }
-
-      break;
     }
   }
 
-  // set blocking socket
-  res = fcntl(sock->fd, F_SETFL, 0);
-  if(res < 0) {
+  // restore flags
+  if (fcntl(sock->fd, F_SETFL, fl) < 0) {
     PERROR("fcntl set bolocking in SocketCom_ConnectWithTimeout()");
     return SOCKETCOM_ERROR_FCNTL;
   }
+  if (res != SOCKETCOM_SUCCESS) {
+    return res;
+  }
 
   sock->status |= SOCKETCOM_STATE_CLIENT;
   return SOCKETCOM_SUCCESS;
@@ -497,134 +927,2166 @@ int SocketCom_RecvWithTimeout(SocketCom* sock, void *buf, int bufLen, int *recvL
   return SocketCom_RecvExWithTimeout(sock, buf, bufLen, recvLen, 0, timeout_sec, timeout_usec);
 }
 
-int SocketCom_WaitForRecvablesWithTimeout(SocketCom* socks[], int* socks_len, long timeout_sec, long timeout_usec)
+int SocketCom_ToMsec(long timeout_sec, long timeout_usec)
 {
-  int res;
-  int i;
-  struct timeval tv;
+  if (timeout_sec < 0 || timeout_usec < 0) {
+    return -1;
+  }
+  long long msec = timeout_usec / 1000 + ((timeout_usec % 1000) ? 1 : 0);
+  if (msec > INT_MAX || timeout_sec > (INT_MAX - msec) / 1000) {
+    return INT_MAX;
+  }
+  return (int)(timeout_sec * 1000 + msec);
+}
 
-#ifdef _SOCKETCOM_WIN32_
-  SOCKET fd_max;
-#else
-  int fd_max;
-#endif
+#ifdef _SOCKETCOM_LINUX_
 
-  fd_max = socks[0]->fd;
-  fd_set fds;
-  FD_ZERO(&fds);
-  for (i = 0; i < *socks_len; i++) {
-    FD_SET(socks[i]->fd, &fds);
-    if (socks[i]->fd > fd_max) {
-      fd_max = socks[i]->fd;
+static unsigned int SocketCom_ToEpollEvents(int events)
+{
+  unsigned int ev = 0;
+  if (events & SOCKETCOM_POLL_IN) {
+    ev |= EPOLLIN | EPOLLRDHUP;
+  }
+  if (events & SOCKETCOM_POLL_OUT) {
+    ev |= EPOLLOUT;
+  }
+  if (events & SOCKETCOM_POLL_ET) {
+    ev |= EPOLLET;
+  }
+  if (events & SOCKETCOM_POLL_ONESHOT) {
+    ev |= EPOLLONESHOT;
+  }
+  return ev;
+}
+
+static int SocketCom_FromEpollEvents(unsigned int ev)
+{
+  int events = 0;
+  if (ev & (EPOLLIN | EPOLLRDHUP)) {
+    events |= SOCKETCOM_POLL_IN;
+  }
+  if (ev & EPOLLOUT) {
+    events |= SOCKETCOM_POLL_OUT;
+  }
+  if (ev & EPOLLERR) {
+    events |= SOCKETCOM_POLL_ERR;
+  }
+  if (ev & EPOLLHUP) {
+    events |= SOCKETCOM_POLL_HUP;
+  }
+  return events;
+}
+
+int SocketCom_PollerCreate(SocketCom_Poller *poller, int max_events)
+{
+  if (max_events <= 0) {
+    max_events = 1;
+  }
+
+  poller->epfd = epoll_create1(EPOLL_CLOEXEC);
+  if (poller->epfd < 0) {
+    PERROR("epoll_create1() in SocketCom_PollerCreate()");
+    return SOCKETCOM_ERROR_POLLER;
+  }
+
+  poller->events = malloc(sizeof(struct epoll_event) * max_events);
+  if (poller->events == NULL) {
+    close(poller->epfd);
+    return SOCKETCOM_ERROR_MEMORY;
+  }
+  poller->max_events = max_events;
+
+  return SOCKETCOM_SUCCESS;
+}
+
+int SocketCom_PollerDestroy(SocketCom_Poller *poller)
+{
+  close(poller->epfd);
+  free(poller->events);
+  poller->epfd = -1;
+  poller->events = NULL;
+  poller->max_events = 0;
+
+  return SOCKETCOM_SUCCESS;
+}
+
+static int SocketCom_PollerCtl(SocketCom_Poller *poller, int op, SocketCom *sock, int events)
+{
+  struct epoll_event ev;
+  ev.events = SocketCom_ToEpollEvents(events);
+  ev.data.ptr = sock;
+
+  if (epoll_ctl(poller->epfd, op, sock->fd, &ev) < 0) {
+    PERROR("epoll_ctl() in SocketCom_PollerCtl()");
+    return SOCKETCOM_ERROR_POLLER_CTL;
+  }
+
+  return SOCKETCOM_SUCCESS;
+}
+
+int SocketCom_PollerAdd(SocketCom_Poller *poller, SocketCom *sock, int events)
+{
+  return SocketCom_PollerCtl(poller, EPOLL_CTL_ADD, sock, events);
+}
+
+int SocketCom_PollerModify(SocketCom_Poller *poller, SocketCom *sock, int events)
+{
+  return SocketCom_PollerCtl(poller, EPOLL_CTL_MOD, sock, events);
+}
+
+int SocketCom_PollerRemove(SocketCom_Poller *poller, SocketCom *sock)
+{
+  return SocketCom_PollerCtl(poller, EPOLL_CTL_DEL, sock, 0);
+}
+
+int SocketCom_PollerWait(SocketCom_Poller *poller, SocketCom_PollEvent *events, int *events_len, long timeout_sec, long timeout_usec)
+{
+  int res;
+  int i;
+  int max_events;
+  struct epoll_event *evs = (struct epoll_event *)poller->events;
+
+  max_events = (*events_len < poller->max_events) ? *events_len : poller->max_events;
+  if (max_events <= 0) {
+    return SOCKETCOM_ERROR_POLLER;
+  }
+
+  while (1) {
+    res = epoll_wait(poller->epfd, evs, max_events, SocketCom_ToMsec(timeout_sec, timeout_usec));
+    if (res > 0) { //success
+      break;
+    }
+    if (res == 0) {
+      *events_len = 0;
+      return SOCKETCOM_ERROR_TIMEOUT_POLLER;
+    }
+    if (errno == SOCKETCOM_EINTR) {
+      continue;
+    }
+    // error
+    PERROR("epoll_wait() in SocketCom_PollerWait()");
+    return SOCKETCOM_ERROR_POLLER;
+  }
+
+  for (i = 0; i < res; i++) {
+    events[i].sock = (SocketCom *)evs[i].data.ptr;
+    events[i].events = SocketCom_FromEpollEvents(evs[i].events);
+  }
+  *events_len = res;
+
+  return SOCKETCOM_SUCCESS;
+}
+
+#else
+
+// poll() based poller (select() on WIN32); SOCKETCOM_POLL_ET is not supported and treated as level-triggered
+
+#define SOCKETCOM_POLL_DISABLED 0x40
+
+int SocketCom_PollerCreate(SocketCom_Poller *poller, int max_events)
+{
+  (void)max_events;
+  poller->socks = NULL;
+  poller->interests = NULL;
+  poller->pfds = NULL;
+  poller->count = 0;
+  poller->capacity = 0;
+
+  return SOCKETCOM_SUCCESS;
+}
+
+int SocketCom_PollerDestroy(SocketCom_Poller *poller)
+{
+  free(poller->socks);
+  free(poller->interests);
+  free(poller->pfds);
+  poller->socks = NULL;
+  poller->interests = NULL;
+  poller->pfds = NULL;
+  poller->count = 0;
+  poller->capacity = 0;
+
+  return SOCKETCOM_SUCCESS;
+}
+
+static int SocketCom_PollerFind(const SocketCom_Poller *poller, const SocketCom *sock)
+{
+  int i;
+  for (i = 0; i < poller->count; i++) {
+    if (poller->socks[i] == sock) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+int SocketCom_PollerAdd(SocketCom_Poller *poller, SocketCom *sock, int events)
+{
+  if (SocketCom_PollerFind(poller, sock) >= 0) {
+    return SOCKETCOM_ERROR_POLLER_CTL;
+  }
+#ifdef _SOCKETCOM_WIN32_
+  if (poller->count >= FD_SETSIZE) {
+    return SOCKETCOM_ERROR_POLLER_FULL;
+  }
+#endif
+
+  if (poller->count == poller->capacity) {
+    int capacity = (poller->capacity == 0) ? 16 : poller->capacity * 2;
+    SocketCom **socks = (SocketCom **)realloc(poller->socks, sizeof(SocketCom *) * capacity);
+    if (socks == NULL) {
+      return SOCKETCOM_ERROR_MEMORY;
+    }
+    poller->socks = socks;
+    int *interests = (int *)realloc(poller->interests, sizeof(int) * capacity);
+    if (interests == NULL) {
+      return SOCKETCOM_ERROR_MEMORY;
+    }
+    poller->interests = interests;
+#ifndef _SOCKETCOM_WIN32_
+    void *pfds = realloc(poller->pfds, sizeof(struct pollfd) * capacity);
+    if (pfds == NULL) {
+      return SOCKETCOM_ERROR_MEMORY;
+    }
+    poller->pfds = pfds;
+#endif
+    poller->capacity = capacity;
+  }
+
+  poller->socks[poller->count] = sock;
+  poller->interests[poller->count] = events;
+  poller->count++;
+
+  return SOCKETCOM_SUCCESS;
+}
+
+int SocketCom_PollerModify(SocketCom_Poller *poller, SocketCom *sock, int events)
+{
+  int i = SocketCom_PollerFind(poller, sock);
+  if (i < 0) {
+    return SOCKETCOM_ERROR_POLLER_CTL;
+  }
+  poller->interests[i] = events;
+
+  return SOCKETCOM_SUCCESS;
+}
+
+int SocketCom_PollerRemove(SocketCom_Poller *poller, SocketCom *sock)
+{
+  int i = SocketCom_PollerFind(poller, sock);
+  if (i < 0) {
+    return SOCKETCOM_ERROR_POLLER_CTL;
+  }
+  poller->count--;
+  poller->socks[i] = poller->socks[poller->count];
+  poller->interests[i] = poller->interests[poller->count];
+
+  return SOCKETCOM_SUCCESS;
+}
+
+#ifndef _SOCKETCOM_WIN32_
+
+int SocketCom_PollerWait(SocketCom_Poller *poller, SocketCom_PollEvent *events, int *events_len, long timeout_sec, long timeout_usec)
+{
+  int res;
+  int i;
+  int count;
+  struct pollfd *pfds = (struct pollfd *)poller->pfds;
+
+  if (*events_len <= 0) {
+    return SOCKETCOM_ERROR_POLLER;
+  }
+
+  for (i = 0; i < poller->count; i++) {
+    int interest = poller->interests[i];
+    // poll() skips negative fds
+    pfds[i].fd = (interest & SOCKETCOM_POLL_DISABLED) ? -1 : poller->socks[i]->fd;
+    pfds[i].events = 0;
+    pfds[i].revents = 0;
+    if (interest & SOCKETCOM_POLL_IN) {
+      pfds[i].events |= POLLIN;
+    }
+    if (interest & SOCKETCOM_POLL_OUT) {
+      pfds[i].events |= POLLOUT;
+    }
+  }
+
+  while (1) {
+    res = poll(pfds, (nfds_t)poller->count, SocketCom_ToMsec(timeout_sec, timeout_usec));
+    if (res > 0) { //success
+      break;
+    }
+    if (res == 0) {
+      *events_len = 0;
+      return SOCKETCOM_ERROR_TIMEOUT_POLLER;
+    }
+    if (errno == SOCKETCOM_EINTR) {
+      continue;
+    }
+    // error
+    PERROR("poll() in SocketCom_PollerWait()");
+    return SOCKETCOM_ERROR_POLLER;
+  }
+
+  count = 0;
+  for (i = 0; i < poller->count && count < *events_len; i++) {
+    int ev = 0;
+    if (pfds[i].fd < 0) {
+      continue;
+    }
+    if (pfds[i].revents & POLLIN) {
+      ev |= SOCKETCOM_POLL_IN;
+    }
+    if (pfds[i].revents & POLLOUT) {
+      ev |= SOCKETCOM_POLL_OUT;
+    }
+    if (pfds[i].revents & (POLLERR | POLLNVAL)) {
+      ev |= SOCKETCOM_POLL_ERR;
+    }
+    if (pfds[i].revents & POLLHUP) {
+      ev |= SOCKETCOM_POLL_HUP;
+    }
+    if (ev == 0) {
+      continue;
+    }
+    if (poller->interests[i] & SOCKETCOM_POLL_ONESHOT) {
+      poller->interests[i] |= SOCKETCOM_POLL_DISABLED;
+    }
+    events[count].sock = poller->socks[i];
+    events[count].events = ev;
+    count++;
+  }
+  *events_len = count;
+
+  return SOCKETCOM_SUCCESS;
+}
+
+#else
+
+int SocketCom_PollerWait(SocketCom_Poller *poller, SocketCom_PollEvent *events, int *events_len, long timeout_sec, long timeout_usec)
+{
+  int res;
+  int i;
+  int count;
+  struct timeval tv;
+  fd_set rfds, wfds, efds;
+
+#ifdef _SOCKETCOM_WIN32_
+  SOCKET fd_max = 0;
+#else
+  int fd_max = 0;
+#endif
+
+  if (*events_len <= 0) {
+    return SOCKETCOM_ERROR_POLLER;
+  }
+
+  FD_ZERO(&rfds);
+  FD_ZERO(&wfds);
+  FD_ZERO(&efds);
+  for (i = 0; i < poller->count; i++) {
+    int interest = poller->interests[i];
+    if (interest & SOCKETCOM_POLL_DISABLED) {
+      continue;
+    }
+    if (interest & SOCKETCOM_POLL_IN) {
+      FD_SET(poller->socks[i]->fd, &rfds);
+    }
+    if (interest & SOCKETCOM_POLL_OUT) {
+      FD_SET(poller->socks[i]->fd, &wfds);
+#ifdef _SOCKETCOM_WIN32_
+      // winsock reports a failed connect in exceptfds, not in writefds
+      FD_SET(poller->socks[i]->fd, &efds);
+#endif
+    }
+    if (poller->socks[i]->fd > fd_max) {
+      fd_max = poller->socks[i]->fd;
+    }
+  }
+
+  tv.tv_sec = timeout_sec;
+  tv.tv_usec = timeout_usec;
+
+  while (1) {
+    if (timeout_sec >= 0 && timeout_usec >= 0) {
+      res = select(fd_max+1, &rfds, &wfds, &efds, &tv);
+    } else {
+      res = select(fd_max+1, &rfds, &wfds, &efds, NULL);
+    }
+    if (res > 0) { //success
+      break;
+    }
+    if (res == 0) {
+      *events_len = 0;
+      return SOCKETCOM_ERROR_TIMEOUT_POLLER;
+    }
+    if (errno == SOCKETCOM_EINTR) {
+      continue;
+    }
+    // error
+    return SOCKETCOM_ERROR_POLLER;
+  }
+
+  count = 0;
+  for (i = 0; i < poller->count && count < *events_len; i++) {
+    int ev = 0;
+    if (poller->interests[i] & SOCKETCOM_POLL_DISABLED) {
+      continue;
+    }
+    if (FD_ISSET(poller->socks[i]->fd, &rfds)) {
+      ev |= SOCKETCOM_POLL_IN;
+    }
+    if (FD_ISSET(poller->socks[i]->fd, &wfds)) {
+      ev |= SOCKETCOM_POLL_OUT;
+    }
+    if (FD_ISSET(poller->socks[i]->fd, &efds)) {
+      ev |= SOCKETCOM_POLL_ERR;
+    }
+    if (ev == 0) {
+      continue;
+    }
+    if (poller->interests[i] & SOCKETCOM_POLL_ONESHOT) {
+      poller->interests[i] |= SOCKETCOM_POLL_DISABLED;
+    }
+    events[count].sock = poller->socks[i];
+    events[count].events = ev;
+    count++;
+  }
+  *events_len = count;
+
+  return SOCKETCOM_SUCCESS;
+}
+
+#endif
+
+#endif
+
+// socks waited on the stack by SocketCom_WaitForRecvablesWithTimeout(); more need an allocation
+#define SOCKETCOM_WAIT_STACK_FDS 64
+
+int SocketCom_WaitForRecvablesWithTimeout(SocketCom* socks[], int* socks_len, long timeout_sec, long timeout_usec)
+{
+  int res;
+  int i;
+  int count;
+
+  if (*socks_len <= 0) {
+    return SOCKETCOM_ERROR_ILLEGAL_SOCK;
+  }
+
+#ifdef _SOCKETCOM_WIN32_
+  // one-shot wait; a persistent interest set (SocketCom_Poller) would cost more than it saves
+  struct timeval tv;
+  SOCKET fd_max;
+  fd_set fds;
+
+  fd_max = socks[0]->fd;
+  FD_ZERO(&fds);
+  for (i = 0; i < *socks_len; i++) {
+    FD_SET(socks[i]->fd, &fds);
+    if (socks[i]->fd > fd_max) {
+      fd_max = socks[i]->fd;
+    }
+  }
+
+  tv.tv_sec = timeout_sec;
+  tv.tv_usec = timeout_usec;
+
+  while (1) {
+    if (timeout_sec >= 0 && timeout_usec >= 0) {
+      res = select(fd_max+1, &fds, NULL, NULL, &tv);
+    } else {
+      res = select(fd_max+1, &fds, NULL, NULL, NULL);
+    }
+    if (res > 0) { //success
+      break;
+    }
+    if (res == 0) {
+      return SOCKETCOM_ERROR_TIMEOUT_SELECT;
+    }
+    if (errno == SOCKETCOM_EINTR) {
+      continue;
+    }
+    // error
+    return SOCKETCOM_ERROR_SELECT;
+  }
+
+#define SOCKETCOM_WAIT_READY(i) FD_ISSET(socks[i]->fd, &fds)
+#else
+  // one-shot wait by one poll(); no FD_SETSIZE limit, and the same sock may be given twice
+  struct pollfd stack_pfds[SOCKETCOM_WAIT_STACK_FDS];
+  struct pollfd *pfds = stack_pfds;
+
+  if (*socks_len > SOCKETCOM_WAIT_STACK_FDS) {
+    pfds = (struct pollfd *)malloc(sizeof(struct pollfd) * (*socks_len));
+    if (pfds == NULL) {
+      return SOCKETCOM_ERROR_MEMORY;
+    }
+  }
+  for (i = 0; i < *socks_len; i++) {
+    pfds[i].fd = socks[i]->fd;
+    pfds[i].events = POLLIN;
+    pfds[i].revents = 0;
+  }
+
+  while (1) {
+    res = poll(pfds, (nfds_t)(*socks_len), SocketCom_ToMsec(timeout_sec, timeout_usec));
+    if (res > 0) { //success
+      break;
+    }
+    if (res < 0 && errno == SOCKETCOM_EINTR) {
+      continue;
+    }
+    if (pfds != stack_pfds) {
+      free(pfds);
+    }
+    return (res == 0) ? SOCKETCOM_ERROR_TIMEOUT_SELECT : SOCKETCOM_ERROR_SELECT;
+  }
+
+  // errors and hangups are receivable as with select(); the following recv reports them
+#define SOCKETCOM_WAIT_READY(i) (pfds[i].revents != 0)
+#endif
+
+  // move ready socks to the head of the list, keeping the others in the list
+  count = 0;
+  for (i = 0; i < *socks_len; i++) {
+    if (SOCKETCOM_WAIT_READY(i)) {
+      if (count != i) {
+        SocketCom *tmp;
+        tmp = socks[count];
+        socks[count] = socks[i];
+        socks[i] = tmp;
+      }
+      count++;
+    }
+  }
+#undef SOCKETCOM_WAIT_READY
+
+#ifndef _SOCKETCOM_WIN32_
+  if (pfds != stack_pfds) {
+    free(pfds);
+  }
+#endif
+  *socks_len = count;
+
+  return SOCKETCOM_SUCCESS;
+}
+
+int SocketCom_SelectRecvables(SocketCom* socks[], int* socks_len)
+{
+  return SocketCom_WaitForRecvablesWithTimeout(socks, socks_len, 0, 0);
+}
+
+int SocketCom_WaitForRecvables(SocketCom* socks[], int* socks_len)
+{
+  return SocketCom_WaitForRecvablesWithTimeout(socks, socks_len, -1, -1);
+}
+
+int SocketCom_WaitForRecvableWithTimeout(SocketCom* sock, long timeout_sec, long timeout_usec)
+{
+#ifdef _SOCKETCOM_WIN32_
+  int socks_len = 1;
+  return SocketCom_WaitForRecvablesWithTimeout(&sock, &socks_len, timeout_sec, timeout_usec);
+#else
+  // a single socket needs no interest set; poll() is one syscall and has no FD_SETSIZE limit
+  int res;
+  struct pollfd pfd;
+
+  pfd.fd = sock->fd;
+  pfd.events = POLLIN;
+  pfd.revents = 0;
+
+  while (1) {
+    res = poll(&pfd, 1, SocketCom_ToMsec(timeout_sec, timeout_usec));
+    if (res > 0) { //success
+      return SOCKETCOM_SUCCESS;
+    }
+    if (res == 0) {
+      return SOCKETCOM_ERROR_TIMEOUT_SELECT;
+    }
+    if (errno == SOCKETCOM_EINTR) {
+      continue;
+    }
+    // error
+    return SOCKETCOM_ERROR_SELECT;
+  }
+#endif
+}
+
+int SocketCom_WaitForRecvable(SocketCom* sock)
+{
+  return SocketCom_WaitForRecvableWithTimeout(sock, -1, -1);
+}
+
+int SocketCom_IsRecvable(SocketCom* sock)
+{
+  int res = SocketCom_WaitForRecvableWithTimeout(sock, 0, 0);
+  return (res == SOCKETCOM_SUCCESS) ? 1 : 0;
+}
+
+int SocketCom_IsAlive(SocketCom* sock)
+{
+#ifdef _SOCKETCOM_WIN32_
+  // receivable idle connection is closed, or has unexpected data
+  return SocketCom_IsRecvable(sock) ? 0 : 1;
+#else
+  char tmp;
+  ssize_t res;
+
+  do {
+    res = recv(sock->fd, &tmp, sizeof(tmp), MSG_PEEK | MSG_DONTWAIT);
+  } while (res < 0 && errno == SOCKETCOM_EINTR);
+
+  return (res < 0 && SOCKETCOM_IS_WOULDBLOCK(errno)) ? 1 : 0;
+#endif
+}
+
+#ifdef _SOCKETCOM_POSIX_
+
+#define SOCKETCOM_NONBLOCKING_FAILED (-2) // by SocketCom_BeginNonBlocking(); fd is left as it is
+
+/**
+ *  make fd non-blocking for a bounded operation
+ *
+ *  @return flags to restore, -1 if fd is already non-blocking, or SOCKETCOM_NONBLOCKING_FAILED if fcntl() fails
+ */
+static int SocketCom_BeginNonBlocking(int fd)
+{
+  int fl = fcntl(fd, F_GETFL, 0);
+  if (fl < 0) {
+    PERROR("fcntl(F_GETFL) in SocketCom_BeginNonBlocking()");
+    return SOCKETCOM_NONBLOCKING_FAILED;
+  }
+  if (fl & O_NONBLOCK) {
+    return -1;
+  }
+  if (fcntl(fd, F_SETFL, fl | O_NONBLOCK) < 0) {
+    PERROR("fcntl(F_SETFL) in SocketCom_BeginNonBlocking()");
+    return SOCKETCOM_NONBLOCKING_FAILED;
+  }
+  return fl;
+}
+
+static void SocketCom_EndNonBlocking(int fd, int fl)
+{
+  if (fl >= 0) {
+    fcntl(fd, F_SETFL, fl);
+  }
+}
+
+/**
+ *  wait until fd gets ready for events, unless deadline passes
+ *
+ *  @param[in] deadline_set 0 if the caller must not wait at all
+ */
+static int SocketCom_WaitFd(int fd, short events, long long deadline, int deadline_set)
+{
+  int res;
+  struct pollfd pfd;
+
+  if (!deadline_set) {
+    return SOCKETCOM_ERROR_WOULDBLOCK;
+  }
+
+  pfd.fd = fd;
+  pfd.events = events;
+  while (1) {
+    pfd.revents = 0;
+    res = poll(&pfd, 1, (int)SocketCom_RemainMsec(deadline));
+    if (res > 0) {
+      return SOCKETCOM_SUCCESS;
+    }
+    if (res == 0) {
+      return SOCKETCOM_ERROR_TIMEOUT;
+    }
+    if (errno != SOCKETCOM_EINTR) {
+      return SOCKETCOM_ERROR_SELECT;
+    }
+  }
+}
+
+#endif
+
+/**
+ *  order of connection attempts: alternate address families, starting with the family of addrs[0]
+ */
+static void SocketCom_ConnectOrder(const struct sockaddr_storage addrs[], int addrs_len, int order[])
+{
+  int first = addrs[0].ss_family;
+  int i = 0; // next address of the first family
+  int j = 0; // next address of the other family
+  int n = 0;
+
+  while (n < addrs_len) {
+    while (i < addrs_len && addrs[i].ss_family != first) {
+      i++;
+    }
+    if (i < addrs_len) {
+      order[n++] = i++;
+    }
+    while (j < addrs_len && addrs[j].ss_family == first) {
+      j++;
+    }
+    if (j < addrs_len) {
+      order[n++] = j++;
+    }
+  }
+}
+
+/**
+ *  create non-blocking attempt to addr, and start connect
+ */
+static int SocketCom_ConnectAttempt(SocketCom* attempt, const struct sockaddr_storage *addr, u_short port)
+{
+  int res;
+
+  SocketCom_Init(attempt);
+  res = SocketCom_CreateEx(attempt, addr->ss_family, SOCK_STREAM);
+  if (res != SOCKETCOM_SUCCESS) {
+    return res;
+  }
+  res = SocketCom_SetSockaddr(attempt, (const struct sockaddr *)addr, SocketCom_SockaddrLen(addr));
+  if (res == SOCKETCOM_SUCCESS && port != 0) {
+    if (attempt->addr.ss_family == AF_INET6) {
+      ((struct sockaddr_in6 *)&attempt->addr)->sin6_port = htons(port);
+    } else {
+      ((struct sockaddr_in *)&attempt->addr)->sin_port = htons(port);
+    }
+  }
+  if (res == SOCKETCOM_SUCCESS) {
+    res = SocketCom_SetNonBlockingSocket(attempt);
+  }
+  if (res == SOCKETCOM_SUCCESS) {
+    res = SocketCom_ConnectStart(attempt);
+  }
+  if (res != SOCKETCOM_SUCCESS && res != SOCKETCOM_ERROR_WOULDBLOCK) {
+    SocketCom_Dispose(attempt);
+  }
+  return res;
+}
+
+int SocketCom_ConnectAddrs(SocketCom* sock, const struct sockaddr_storage addrs[], int addrs_len, u_short port, long timeout_msec)
+{
+  SocketCom attempts[SOCKETCOM_CONNECT_MAX_ADDRS];
+  SocketCom_PollEvent events[SOCKETCOM_CONNECT_MAX_ADDRS];
+  SocketCom_Poller poller;
+  SocketCom *winner = NULL;
+  int order[SOCKETCOM_CONNECT_MAX_ADDRS];
+  int started = 0;
+  int active = 0;
+  int res = SOCKETCOM_ERROR_CONNECT;
+  int n = (addrs_len < SOCKETCOM_CONNECT_MAX_ADDRS) ? addrs_len : SOCKETCOM_CONNECT_MAX_ADDRS;
+  int i;
+
+  if (sock->status & SOCKETCOM_STATE_CREATED) {
+    return SOCKETCOM_ERROR_ALREADY_CREATED;
+  }
+  if (n <= 0) {
+    return SOCKETCOM_ERROR_CONNECT;
+  }
+
+  res = SocketCom_PollerCreate(&poller, SOCKETCOM_CONNECT_MAX_ADDRS);
+  if (res != SOCKETCOM_SUCCESS) {
+    return res;
+  }
+  SocketCom_ConnectOrder(addrs, n, order);
+
+  long long deadline = (timeout_msec >= 0) ? SocketCom_NowMsec() + timeout_msec : -1;
+  long long next_start = SocketCom_NowMsec();
+  res = SOCKETCOM_ERROR_CONNECT;
+  while (winner == NULL) {
+    long long now = SocketCom_NowMsec();
+    if (deadline >= 0 && now >= deadline) {
+      res = SOCKETCOM_ERROR_TIMEOUT_CONNECT;
+      break;
+    }
+
+    // start the next attempt when its delay has passed, or when no attempt is running
+    if (started < n && (active == 0 || now >= next_start)) {
+      SocketCom *attempt = &attempts[started];
+      int attempt_res = SocketCom_ConnectAttempt(attempt, &addrs[order[started]], port);
+      started++;
+      next_start = now + SOCKETCOM_CONNECT_ATTEMPT_DELAY_MSEC;
+      if (attempt_res == SOCKETCOM_SUCCESS) {
+        winner = attempt;
+      } else if (attempt_res == SOCKETCOM_ERROR_WOULDBLOCK) {
+        if (SocketCom_PollerAdd(&poller, attempt, SOCKETCOM_POLL_OUT) == SOCKETCOM_SUCCESS) {
+          active++;
+        } else {
+          SocketCom_Dispose(attempt);
+        }
+      }
+      continue;
+    }
+    if (active == 0) {
+      // all addresses failed
+      break;
+    }
+
+    long wait = SocketCom_RemainMsec(deadline);
+    if (started < n) {
+      long delay = (next_start > now) ? (long)(next_start - now) : 0;
+      if (wait < 0 || delay < wait) {
+        wait = delay;
+      }
+    }
+    int events_len = SOCKETCOM_CONNECT_MAX_ADDRS;
+    int poll_res = SocketCom_PollerWait(&poller, events, &events_len, (wait < 0) ? -1 : wait / 1000, (wait < 0) ? -1 : (wait % 1000) * 1000);
+    if (poll_res == SOCKETCOM_ERROR_TIMEOUT_POLLER) {
+      continue;
+    }
+    if (poll_res != SOCKETCOM_SUCCESS) {
+      res = poll_res;
+      break;
+    }
+
+    for (i = 0; i < events_len; i++) {
+      SocketCom *attempt = events[i].sock;
+      if (SocketCom_ConnectFinish(attempt) == SOCKETCOM_SUCCESS) {
+        winner = attempt;
+        break;
+      }
+      // failed; start the next attempt without waiting for the delay
+      SocketCom_PollerRemove(&poller, attempt);
+      SocketCom_Dispose(attempt);
+      active--;
+      next_start = SocketCom_NowMsec();
+    }
+  }
+
+  // cancel the others
+  SocketCom_PollerDestroy(&poller);
+  for (i = 0; i < started; i++) {
+    if (&attempts[i] != winner && (attempts[i].status & SOCKETCOM_STATE_CREATED)) {
+      SocketCom_Dispose(&attempts[i]);
+    }
+  }
+  if (winner == NULL) {
+    return res;
+  }
+
+  res = SocketCom_SetBlockingSocket(winner);
+  if (res != SOCKETCOM_SUCCESS) {
+    SocketCom_Dispose(winner);
+    return res;
+  }
+  *sock = *winner;
+  sock->status |= SOCKETCOM_STATE_CLIENT;
+
+  return SOCKETCOM_SUCCESS;
+}
+
+int SocketCom_ConnectHost(SocketCom* sock, const char *hostname, u_short port, long timeout_msec)
+{
+  struct sockaddr_storage addrs[SOCKETCOM_CONNECT_MAX_ADDRS];
+  struct addrinfo hints, *resolved_addr, *ai;
+  int addrs_len = 0;
+  long long start = SocketCom_NowMsec();
+
+  if (sock->status & SOCKETCOM_STATE_CREATED) {
+    return SOCKETCOM_ERROR_ALREADY_CREATED;
+  }
+
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_flags = AI_ADDRCONFIG;
+  if (getaddrinfo(hostname, NULL, &hints, &resolved_addr) != 0) {
+    return SOCKETCOM_ERROR_SLAVEHOSTNAME;
+  }
+  for (ai = resolved_addr; ai != NULL && addrs_len < SOCKETCOM_CONNECT_MAX_ADDRS; ai = ai->ai_next) {
+    if ((ai->ai_family == AF_INET || ai->ai_family == AF_INET6) && ai->ai_addrlen <= sizeof(struct sockaddr_storage)) {
+      memset(&addrs[addrs_len], 0, sizeof(struct sockaddr_storage));
+      memcpy(&addrs[addrs_len], ai->ai_addr, ai->ai_addrlen);
+      addrs_len++;
+    }
+  }
+  freeaddrinfo(resolved_addr);
+  if (addrs_len == 0) {
+    return SOCKETCOM_ERROR_SLAVEHOSTNAME;
+  }
+
+  // resolving is a part of the timeout
+  if (timeout_msec >= 0) {
+    long long elapsed = SocketCom_NowMsec() - start;
+    timeout_msec = (elapsed < timeout_msec) ? (long)(timeout_msec - elapsed) : 0;
+  }
+
+  return SocketCom_ConnectAddrs(sock, addrs, addrs_len, port, timeout_msec);
+}
+
+typedef struct SocketCom_ConnectManyEntry {
+  SocketCom *sock;
+  int index;
+} SocketCom_ConnectManyEntry;
+
+static int SocketCom_ConnectManyCompare(const void *a, const void *b)
+{
+  const SocketCom *x = ((const SocketCom_ConnectManyEntry *)a)->sock;
+  const SocketCom *y = ((const SocketCom_ConnectManyEntry *)b)->sock;
+  return (x < y) ? -1 : (x > y) ? 1 : 0;
+}
+
+/**
+ *  restore blocking mode of sock whose connect is finished with res
+ */
+static int SocketCom_ConnectManyDone(SocketCom* sock, int fl, int res)
+{
+#ifdef _SOCKETCOM_WIN32_
+  (void)fl;
+  SocketCom_SetBlockingSocket(sock);
+#else
+  SocketCom_EndNonBlocking(sock->fd, fl);
+#endif
+  if (res == SOCKETCOM_SUCCESS) {
+    sock->status |= SOCKETCOM_STATE_CLIENT;
+  }
+  return res;
+}
+
+int SocketCom_ConnectMany(SocketCom *socks[], int socks_len, int results[], long timeout_msec)
+{
+  SocketCom_PollEvent events[SOCKETCOM_CONNECT_MANY_EVENTS];
+  SocketCom_Poller poller;
+  SocketCom_ConnectManyEntry *entries;
+  int *fls;
+  int pending = 0;
+  int failed = 0;
+  int res;
+  int i;
+
+  if (socks_len <= 0) {
+    return SOCKETCOM_SUCCESS;
+  }
+
+  entries = (SocketCom_ConnectManyEntry *)malloc(sizeof(SocketCom_ConnectManyEntry) * socks_len);
+  fls = (int *)malloc(sizeof(int) * socks_len);
+  res = (entries != NULL && fls != NULL) ? SOCKETCOM_SUCCESS : SOCKETCOM_ERROR_MEMORY;
+  if (res == SOCKETCOM_SUCCESS) {
+    res = SocketCom_PollerCreate(&poller, SOCKETCOM_CONNECT_MANY_EVENTS);
+  }
+  if (res != SOCKETCOM_SUCCESS) {
+    free(entries);
+    free(fls);
+    for (i = 0; i < socks_len; i++) {
+      results[i] = res;
+    }
+    return res;
+  }
+
+  // start all connects; results[i] is SOCKETCOM_ERROR_WOULDBLOCK while socks[i] is in progress
+  for (i = 0; i < socks_len; i++) {
+    SocketCom *sock = socks[i];
+    entries[i].sock = sock;
+    entries[i].index = i;
+    fls[i] = -1;
+    if ((sock->status & (SOCKETCOM_STATE_CREATED|SOCKETCOM_STATE_HAS_ADDR)) != (SOCKETCOM_STATE_CREATED|SOCKETCOM_STATE_HAS_ADDR)) {
+      results[i] = SOCKETCOM_ERROR_ILLEGAL_SOCK;
+      continue;
+    }
+#ifdef _SOCKETCOM_WIN32_
+    res = SocketCom_SetNonBlockingSocket(sock);
+    if (res != SOCKETCOM_SUCCESS) {
+      results[i] = res;
+      continue;
+    }
+#else
+    fls[i] = SocketCom_BeginNonBlocking(sock->fd);
+    if (fls[i] == SOCKETCOM_NONBLOCKING_FAILED) {
+      // a blocking connect would hold up the whole batch
+      results[i] = SOCKETCOM_ERROR_FCNTL;
+      continue;
+    }
+#endif
+    res = SocketCom_ConnectStart(sock);
+    if (res == SOCKETCOM_ERROR_WOULDBLOCK) {
+      res = SocketCom_PollerAdd(&poller, sock, SOCKETCOM_POLL_OUT);
+      if (res == SOCKETCOM_SUCCESS) {
+        results[i] = SOCKETCOM_ERROR_WOULDBLOCK;
+        pending++;
+        continue;
+      }
+    }
+    results[i] = SocketCom_ConnectManyDone(sock, fls[i], res);
+  }
+  qsort(entries, socks_len, sizeof(SocketCom_ConnectManyEntry), SocketCom_ConnectManyCompare);
+
+  // wait for all of them under one deadline
+  long long deadline = (timeout_msec >= 0) ? SocketCom_NowMsec() + timeout_msec : -1;
+  res = SOCKETCOM_ERROR_TIMEOUT_CONNECT;
+  while (pending > 0) {
+    long wait = SocketCom_RemainMsec(deadline);
+    int events_len = SOCKETCOM_CONNECT_MANY_EVENTS;
+    int poll_res = SocketCom_PollerWait(&poller, events, &events_len, (wait < 0) ? -1 : wait / 1000, (wait < 0) ? -1 : (wait % 1000) * 1000);
+    if (poll_res == SOCKETCOM_ERROR_TIMEOUT_POLLER) {
+      break;
+    }
+    if (poll_res != SOCKETCOM_SUCCESS) {
+      res = poll_res;
+      break;
+    }
+
+    for (i = 0; i < events_len; i++) {
+      SocketCom_ConnectManyEntry key;
+      key.sock = events[i].sock;
+      SocketCom_ConnectManyEntry *entry = (SocketCom_ConnectManyEntry *)bsearch(&key, entries, socks_len, sizeof(SocketCom_ConnectManyEntry), SocketCom_ConnectManyCompare);
+      if (entry == NULL || results[entry->index] != SOCKETCOM_ERROR_WOULDBLOCK) {
+        continue;
+      }
+      SocketCom_PollerRemove(&poller, entry->sock);
+      results[entry->index] = SocketCom_ConnectManyDone(entry->sock, fls[entry->index], SocketCom_ConnectFinish(entry->sock));
+      pending--;
+    }
+  }
+
+  // connects left in progress are timed out
+  for (i = 0; i < socks_len; i++) {
+    if (results[i] == SOCKETCOM_ERROR_WOULDBLOCK) {
+      SocketCom_PollerRemove(&poller, socks[i]);
+      results[i] = SocketCom_ConnectManyDone(socks[i], fls[i], res);
+    }
+    if (results[i] != SOCKETCOM_SUCCESS) {
+      failed++;
+    }
+  }
+
+  SocketCom_PollerDestroy(&poller);
+  free(entries);
+  free(fls);
+
+  return (failed == 0) ? SOCKETCOM_SUCCESS : SOCKETCOM_ERROR_CONNECT;
+}
+
+int SocketCom_ConnectSendFastOpen(SocketCom* sock, const void *buf, int bufLen, int *synData, long timeout_msec)
+{
+  int res;
+
+  if (synData != NULL) {
+    *synData = 0;
+  }
+  if ((sock->status & (SOCKETCOM_STATE_CREATED | SOCKETCOM_STATE_HAS_ADDR)) != (SOCKETCOM_STATE_CREATED | SOCKETCOM_STATE_HAS_ADDR)) {
+    return SOCKETCOM_ERROR_ILLEGAL_SOCK;
+  }
+
+#if defined(_SOCKETCOM_LINUX_) && defined(MSG_FASTOPEN)
+  long long deadline = (timeout_msec < 0) ? -1 : SocketCom_NowMsec() + timeout_msec;
+  int fl = SocketCom_BeginNonBlocking(sock->fd);
+  ssize_t size;
+  int sent = 0;
+
+  // connect by sending; without a cookie, nothing is sent and the SYN requests a cookie for the next time
+  do {
+    size = sendto(sock->fd, (const char *)buf, bufLen, MSG_FASTOPEN | SOCKETCOM_MSG_NOSIGNAL, (const struct sockaddr *)&sock->addr, SocketCom_SockaddrLen(&sock->addr));
+  } while (size < 0 && errno == SOCKETCOM_EINTR);
+  if (size >= 0) {
+    SOCKETCOM_STATS_COUNT(sock, SOCKETCOM_STATS_DIR_SEND, size, bufLen, 0);
+    sent = (int)size;
+    res = SOCKETCOM_ERROR_WOULDBLOCK;
+  } else if (errno == SOCKETCOM_EINPROGRESS) {
+    res = SOCKETCOM_ERROR_WOULDBLOCK;
+  } else if (errno == EOPNOTSUPP) {
+    // Fast Open is disabled for the socket
+    res = SocketCom_ConnectStart(sock);
+  } else {
+    PERROR("sendto(MSG_FASTOPEN) in SocketCom_ConnectSendFastOpen()");
+    res = SOCKETCOM_ERROR_CONNECT;
+  }
+
+  if (res == SOCKETCOM_ERROR_WOULDBLOCK) {
+    res = SocketCom_WaitFd(sock->fd, POLLOUT, deadline, 1);
+    if (res == SOCKETCOM_SUCCESS) {
+      res = SocketCom_ConnectFinish(sock);
+    } else if (res == SOCKETCOM_ERROR_TIMEOUT) {
+      res = SOCKETCOM_ERROR_TIMEOUT_CONNECT;
+    }
+  }
+  SocketCom_EndNonBlocking(sock->fd, fl);
+  if (res != SOCKETCOM_SUCCESS) {
+    return res;
+  }
+  sock->status |= SOCKETCOM_STATE_CLIENT;
+
+#ifdef TCPI_OPT_SYN_DATA
+  if (sent > 0 && synData != NULL) {
+    SocketCom_TcpInfo info;
+    if (SocketCom_GetTcpInfo(sock, &info) == SOCKETCOM_SUCCESS && (info.options & TCPI_OPT_SYN_DATA)) {
+      *synData = 1;
+    }
+  }
+#endif
+
+  // the rest which did not fit in the SYN
+  if (sent < bufLen) {
+    return SocketCom_Send(sock, (const char *)buf + sent, bufLen - sent);
+  }
+  return SOCKETCOM_SUCCESS;
+#else
+  res = (timeout_msec < 0) ? SocketCom_Connect(sock) : SocketCom_ConnectWithTimeout(sock, (unsigned long)timeout_msec);
+  if (res != SOCKETCOM_SUCCESS) {
+    return res;
+  }
+  return SocketCom_Send(sock, buf, bufLen);
+#endif
+}
+
+int SocketCom_RecvEx(SocketCom* sock, void* buf, int bufLen, int *recvLen, int flags)
+{
+  int _recvLen;
+
+  while (1) {
+    _recvLen = recv(sock->fd, (char *)buf, bufLen, flags);
+    SOCKETCOM_STATS_COUNT(sock, SOCKETCOM_STATS_DIR_RECV, _recvLen, bufLen, (_recvLen < 0) ? errno : 0);
+    if (_recvLen >= 0) {
+      break;
+    }
+    if (errno == SOCKETCOM_EINTR) {
+      continue;
+    }
+    if (SOCKETCOM_IS_WOULDBLOCK(errno)) {
+      return SOCKETCOM_ERROR_WOULDBLOCK;
+    }
+    PERROR("SocketCom_RecvEx()");
+    return SOCKETCOM_ERROR_RECV;
+  }
+  if (_recvLen == 0) {
+    return SOCKETCOM_ERROR_DISCONNECTED;
+  }
+
+  if (recvLen != NULL) {
+    *recvLen = _recvLen;
+  }
+  return SOCKETCOM_SUCCESS;
+}
+
+int SocketCom_Recv(SocketCom* sock, void* buf, int bufLen, int *recvLen)
+{
+  return SocketCom_RecvEx(sock, buf, bufLen, recvLen, 0);
+}
+
+int SocketCom_RecvAll(SocketCom* sock, void* buf, int recvLen)
+{
+  SocketCom_IoVec vec;
+  SocketCom_IoVec *iov = &vec;
+  int iovcnt = 1;
+
+  SOCKETCOM_IOVEC_SET(vec, buf, recvLen);
+  return SocketCom_RecvAllV(sock, &iov, &iovcnt, NULL);
+}
+
+int SocketCom_Send(SocketCom* sock, const void *buf, int bufLen)
+{
+  SocketCom_IoVec vec;
+  SocketCom_IoVec *iov = &vec;
+  int iovcnt = 1;
+
+  SOCKETCOM_IOVEC_SET(vec, buf, bufLen);
+  return SocketCom_SendV(sock, &iov, &iovcnt, NULL);
+}
+
+void SocketCom_IoVecAdvance(SocketCom_IoVec **iov, int *iovcnt, size_t len)
+{
+  // skip consumed buffers and empty buffers
+  while (*iovcnt > 0 && len >= (size_t)SOCKETCOM_IOVEC_LEN((*iov)[0])) {
+    len -= SOCKETCOM_IOVEC_LEN((*iov)[0]);
+    (*iov)++;
+    (*iovcnt)--;
+  }
+  if (*iovcnt > 0 && len > 0) {
+    SocketCom_IoVec *head = &(*iov)[0];
+    SOCKETCOM_IOVEC_SET(*head, (char *)SOCKETCOM_IOVEC_BASE(*head) + len, SOCKETCOM_IOVEC_LEN(*head) - len);
+  }
+}
+
+int SocketCom_SendV(SocketCom* sock, SocketCom_IoVec **iov, int *iovcnt, size_t *sentLen)
+{
+  int res = SOCKETCOM_SUCCESS;
+  size_t total = 0;
+
+  SocketCom_IoVecAdvance(iov, iovcnt, 0);
+  while (*iovcnt > 0) {
+    int cnt = (*iovcnt < SOCKETCOM_IOV_MAX) ? *iovcnt : SOCKETCOM_IOV_MAX;
+#ifdef _SOCKETCOM_WIN32_
+    DWORD size;
+    if (WSASend(sock->fd, *iov, cnt, &size, 0, NULL, NULL) == SOCKET_ERROR) {
+#else
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = *iov;
+    msg.msg_iovlen = cnt;
+    ssize_t size = sendmsg(sock->fd, &msg, SOCKETCOM_MSG_NOSIGNAL);
+    if (size < 0) {
+#endif
+      SOCKETCOM_STATS_COUNT(sock, SOCKETCOM_STATS_DIR_SEND, -1, 0, errno);
+      if (errno == SOCKETCOM_EINTR) {
+        continue;
+      }
+      if (SOCKETCOM_IS_WOULDBLOCK(errno)) {
+        res = SOCKETCOM_ERROR_WOULDBLOCK;
+        break;
+      }
+      PERROR("SocketCom_SendV()");
+      res = SOCKETCOM_ERROR_SEND;
+      break;
+    }
+    SOCKETCOM_STATS_COUNT(sock, SOCKETCOM_STATS_DIR_SEND, size, SocketCom_IoVecLen(*iov, cnt), 0);
+    total += size;
+    SocketCom_IoVecAdvance(iov, iovcnt, size);
+  }
+
+  if (sentLen != NULL) {
+    *sentLen = total;
+  }
+  return res;
+}
+
+static int SocketCom_RecvVEx(SocketCom* sock, SocketCom_IoVec **iov, int *iovcnt, size_t *recvLen, int all)
+{
+  int res = SOCKETCOM_SUCCESS;
+  size_t total = 0;
+
+  SocketCom_IoVecAdvance(iov, iovcnt, 0);
+  while (*iovcnt > 0) {
+    int cnt = (*iovcnt < SOCKETCOM_IOV_MAX) ? *iovcnt : SOCKETCOM_IOV_MAX;
+#ifdef _SOCKETCOM_WIN32_
+    DWORD size;
+    DWORD flags = 0;
+    if (WSARecv(sock->fd, *iov, cnt, &size, &flags, NULL, NULL) == SOCKET_ERROR) {
+#else
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = *iov;
+    msg.msg_iovlen = cnt;
+    ssize_t size = recvmsg(sock->fd, &msg, all ? MSG_WAITALL : 0);
+    if (size < 0) {
+#endif
+      SOCKETCOM_STATS_COUNT(sock, SOCKETCOM_STATS_DIR_RECV, -1, 0, errno);
+      if (errno == SOCKETCOM_EINTR) {
+        continue;
+      }
+      if (SOCKETCOM_IS_WOULDBLOCK(errno)) {
+        res = SOCKETCOM_ERROR_WOULDBLOCK;
+        break;
+      }
+      PERROR("SocketCom_RecvV()");
+      res = SOCKETCOM_ERROR_RECV;
+      break;
+    }
+    SOCKETCOM_STATS_COUNT(sock, SOCKETCOM_STATS_DIR_RECV, size, SocketCom_IoVecLen(*iov, cnt), 0);
+    if (size == 0) {
+      res = SOCKETCOM_ERROR_DISCONNECTED;
+      break;
+    }
+    total += size;
+    SocketCom_IoVecAdvance(iov, iovcnt, size);
+    if (!all) {
+      break;
+    }
+  }
+
+  if (recvLen != NULL) {
+    *recvLen = total;
+  }
+  return res;
+}
+
+int SocketCom_RecvV(SocketCom* sock, SocketCom_IoVec **iov, int *iovcnt, size_t *recvLen)
+{
+  return SocketCom_RecvVEx(sock, iov, iovcnt, recvLen, 0);
+}
+
+int SocketCom_RecvAllV(SocketCom* sock, SocketCom_IoVec **iov, int *iovcnt, size_t *recvLen)
+{
+  return SocketCom_RecvVEx(sock, iov, iovcnt, recvLen, 1);
+}
+
+int SocketCom_SetBusyPoll(SocketCom *sock, int busy_poll_usec, int prefer)
+{
+#if defined(_SOCKETCOM_LINUX_) && defined(SO_BUSY_POLL)
+  if (setsockopt(sock->fd, SOL_SOCKET, SO_BUSY_POLL, &busy_poll_usec, sizeof(busy_poll_usec)) < 0) {
+    PERROR("setsockopt(SO_BUSY_POLL) in SocketCom_SetBusyPoll()");
+    return SOCKETCOM_ERROR_SETBUSYPOLL;
+  }
+  if (prefer) {
+#ifdef SO_PREFER_BUSY_POLL
+    int on = 1;
+    if (setsockopt(sock->fd, SOL_SOCKET, SO_PREFER_BUSY_POLL, &on, sizeof(on)) < 0) {
+      PERROR("setsockopt(SO_PREFER_BUSY_POLL) in SocketCom_SetBusyPoll()");
+      return SOCKETCOM_ERROR_SETBUSYPOLL;
+    }
+#else
+    return SOCKETCOM_ERROR_NOTSUPPORTED;
+#endif
+  }
+
+  return SOCKETCOM_SUCCESS;
+#else
+  (void)sock; (void)busy_poll_usec; (void)prefer;
+  return SOCKETCOM_ERROR_NOTSUPPORTED;
+#endif
+}
+
+void SocketCom_BusyPollInit(SocketCom_BusyPoll *bp, long spin_usec)
+{
+  memset(bp, 0, sizeof(SocketCom_BusyPoll));
+  bp->spin_usec = (spin_usec < 0) ? 0 : spin_usec;
+}
+
+#ifdef _SOCKETCOM_POSIX_
+
+static long long SocketCom_NowUsec(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/**
+ *  try non-blocking recv() until it does not would block, or bp->spin_usec passes
+ *
+ *  @retval SOCKETCOM_ERROR_WOULDBLOCK nothing arrived while spinning
+ *  @retval others result of SocketCom_RecvEx()
+ */
+static int SocketCom_BusySpin(SocketCom_BusyPoll *bp, SocketCom *sock, void *buf, int bufLen, int *recvLen, int flags)
+{
+  long long start = 0;
+  int first = 1;
+  int res;
+
+  while (1) {
+    res = SocketCom_RecvEx(sock, buf, bufLen, recvLen, flags | MSG_DONTWAIT);
+    if (res != SOCKETCOM_ERROR_WOULDBLOCK) {
+      if (first) {
+        bp->immediate++;
+      } else {
+        bp->spin_hits++;
+        bp->spin_usec_total += SocketCom_NowUsec() - start;
+      }
+      return res;
+    }
+    bp->spin_polls++;
+
+    long long now = SocketCom_NowUsec();
+    if (first) {
+      start = now;
+      first = 0;
+    }
+    if (now - start >= bp->spin_usec) {
+      bp->spin_usec_total += now - start;
+      return SOCKETCOM_ERROR_WOULDBLOCK;
+    }
+  }
+}
+
+#endif
+
+int SocketCom_RecvBusyPoll(SocketCom_BusyPoll *bp, SocketCom *sock, void *buf, int bufLen, int *recvLen, long timeout_msec)
+{
+  long long deadline = (timeout_msec < 0) ? -1 : SocketCom_NowMsec() + timeout_msec;
+  int res;
+
+  bp->calls++;
+#ifdef _SOCKETCOM_POSIX_
+  res = SocketCom_BusySpin(bp, sock, buf, bufLen, recvLen, 0);
+  if (res != SOCKETCOM_ERROR_WOULDBLOCK) {
+    return res;
+  }
+#endif
+  bp->blocked++;
+
+  while (1) {
+    long remain = SocketCom_RemainMsec(deadline);
+    res = SocketCom_WaitForRecvableWithTimeout(sock, (remain < 0) ? -1 : remain / 1000, (remain < 0) ? -1 : (remain % 1000) * 1000);
+    if (res != SOCKETCOM_SUCCESS) {
+      return res;
+    }
+#ifdef _SOCKETCOM_POSIX_
+    // the data may have been taken by another thread
+    res = SocketCom_RecvEx(sock, buf, bufLen, recvLen, MSG_DONTWAIT);
+    if (res != SOCKETCOM_ERROR_WOULDBLOCK) {
+      return res;
+    }
+#else
+    return SocketCom_RecvEx(sock, buf, bufLen, recvLen, 0);
+#endif
+  }
+}
+
+int SocketCom_WaitForRecvableBusyPoll(SocketCom_BusyPoll *bp, SocketCom *sock, long timeout_msec)
+{
+  bp->calls++;
+#ifdef _SOCKETCOM_POSIX_
+  char c;
+  // data, FIN and errors all make sock recvable
+  if (SocketCom_BusySpin(bp, sock, &c, 1, NULL, MSG_PEEK) != SOCKETCOM_ERROR_WOULDBLOCK) {
+    return SOCKETCOM_SUCCESS;
+  }
+#endif
+  bp->blocked++;
+
+  return SocketCom_WaitForRecvableWithTimeout(sock, (timeout_msec < 0) ? -1 : timeout_msec / 1000, (timeout_msec < 0) ? -1 : (timeout_msec % 1000) * 1000);
+}
+
+int SocketCom_ZeroCopyInit(SocketCom_ZeroCopy *zc, SocketCom *sock, size_t threshold)
+{
+  memset(zc, 0, sizeof(SocketCom_ZeroCopy));
+  zc->sock = sock;
+  zc->threshold = (threshold > 0) ? threshold : SOCKETCOM_ZEROCOPY_DEFAULT_THRESHOLD;
+
+#if defined(_SOCKETCOM_LINUX_) && defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+  int on = 1;
+  if (setsockopt(sock->fd, SOL_SOCKET, SO_ZEROCOPY, &on, sizeof(on)) < 0) {
+    PERROR("setsockopt(SO_ZEROCOPY) in SocketCom_ZeroCopyInit()");
+    return SOCKETCOM_ERROR_SETZEROCOPY;
+  }
+  zc->enabled = 1;
+
+  return SOCKETCOM_SUCCESS;
+#else
+  return SOCKETCOM_ERROR_NOTSUPPORTED;
+#endif
+}
+
+int SocketCom_ZeroCopySend(SocketCom_ZeroCopy *zc, const void *buf, size_t bufLen, size_t *sentLen, SocketCom_ZeroCopyRange *ids)
+{
+  ids->lo = SOCKETCOM_ZEROCOPY_ID_NONE;
+  ids->hi = SOCKETCOM_ZEROCOPY_ID_NONE;
+  ids->copied = 0;
+
+#if defined(_SOCKETCOM_LINUX_) && defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+  if (zc->enabled && bufLen >= zc->threshold) {
+    int res = SOCKETCOM_SUCCESS;
+    size_t total = 0;
+
+    while (total < bufLen) {
+      if (zc->next_id - zc->completed_next >= SOCKETCOM_ZEROCOPY_WINDOW) {
+        // completions of this many ids cannot be tracked; copy the rest
+        SocketCom_IoVec vec;
+        SocketCom_IoVec *iov = &vec;
+        int iovcnt = 1;
+        size_t copiedLen = 0;
+        SOCKETCOM_IOVEC_SET(vec, (const char *)buf + total, bufLen - total);
+        res = SocketCom_SendV(zc->sock, &iov, &iovcnt, &copiedLen);
+        total += copiedLen;
+        zc->copied_sends++;
+        break;
+      }
+      ssize_t size = send(zc->sock->fd, (const char *)buf + total, bufLen - total, MSG_ZEROCOPY | SOCKETCOM_MSG_NOSIGNAL);
+      SOCKETCOM_STATS_COUNT(zc->sock, SOCKETCOM_STATS_DIR_SEND, size, bufLen - total, (size < 0) ? errno : 0);
+      if (size < 0) {
+        if (errno == SOCKETCOM_EINTR) {
+          continue;
+        }
+        if (errno == ENOBUFS) {
+          // out of optmem for pinning pages; copy the rest
+          SocketCom_IoVec vec;
+          SocketCom_IoVec *iov = &vec;
+          int iovcnt = 1;
+          size_t copiedLen = 0;
+          SOCKETCOM_IOVEC_SET(vec, (const char *)buf + total, bufLen - total);
+          res = SocketCom_SendV(zc->sock, &iov, &iovcnt, &copiedLen);
+          total += copiedLen;
+          zc->copied_sends++;
+          break;
+        }
+        if (SOCKETCOM_IS_WOULDBLOCK(errno)) {
+          res = SOCKETCOM_ERROR_WOULDBLOCK;
+          break;
+        }
+        PERROR("SocketCom_ZeroCopySend()");
+        res = SOCKETCOM_ERROR_SEND;
+        break;
+      }
+      // every send which queued data consumes one id
+      if (ids->lo == SOCKETCOM_ZEROCOPY_ID_NONE) {
+        ids->lo = zc->next_id;
+      }
+      ids->hi = zc->next_id++;
+      zc->zerocopy_sends++;
+      total += size;
+    }
+
+    if (sentLen != NULL) {
+      *sentLen = total;
+    }
+    return res;
+  }
+#endif
+
+  SocketCom_IoVec vec;
+  SocketCom_IoVec *iov = &vec;
+  int iovcnt = 1;
+  SOCKETCOM_IOVEC_SET(vec, buf, bufLen);
+  zc->copied_sends++;
+  return SocketCom_SendV(zc->sock, &iov, &iovcnt, sentLen);
+}
+
+#define SOCKETCOM_ZEROCOPY_BIT(id) (1ULL << ((id) % 64))
+#define SOCKETCOM_ZEROCOPY_WORD(zc, id) ((zc)->completed_bits[((id) % SOCKETCOM_ZEROCOPY_WINDOW) / 64])
+
+#if defined(_SOCKETCOM_LINUX_) && defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+
+/**
+ *  record completed ids [lo, hi], and advance the watermark over all ids completed so far
+ *  ranges are not guaranteed to come in order, so one after a gap is kept in completed_bits until the gap is completed
+ */
+static void SocketCom_ZeroCopyComplete(SocketCom_ZeroCopy *zc, unsigned int lo, unsigned int hi)
+{
+  unsigned int id;
+
+  // only ids in flight (completed_next <= id < next_id) are recorded; others are completed already or not ours
+  if ((int)(hi - zc->completed_next) < 0) {
+    return;
+  }
+  if ((int)(lo - zc->completed_next) < 0) {
+    lo = zc->completed_next;
+  }
+  if ((int)(hi - zc->next_id) >= 0) {
+    hi = zc->next_id - 1;
+  }
+  if ((int)(hi - lo) < 0) {
+    return;
+  }
+
+  if (lo == zc->completed_next) {
+    zc->completed_next = hi + 1;
+  } else {
+    for (id = lo; id != hi + 1; id++) {
+      SOCKETCOM_ZEROCOPY_WORD(zc, id) |= SOCKETCOM_ZEROCOPY_BIT(id);
+    }
+  }
+
+  while (zc->completed_next != zc->next_id && (SOCKETCOM_ZEROCOPY_WORD(zc, zc->completed_next) & SOCKETCOM_ZEROCOPY_BIT(zc->completed_next))) {
+    SOCKETCOM_ZEROCOPY_WORD(zc, zc->completed_next) &= ~SOCKETCOM_ZEROCOPY_BIT(zc->completed_next);
+    zc->completed_next++;
+  }
+}
+
+#endif
+
+int SocketCom_ZeroCopyReap(SocketCom_ZeroCopy *zc, SocketCom_ZeroCopyRange *ranges, int *ranges_len)
+{
+  int count = 0;
+
+#if defined(_SOCKETCOM_LINUX_) && defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+  while (ranges == NULL || count < *ranges_len) {
+    char control[CMSG_SPACE(sizeof(struct sock_extended_err) + sizeof(struct sockaddr_in6))];
+    struct msghdr msg;
+    struct cmsghdr *cmsg;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    if (recvmsg(zc->sock->fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+      if (errno == SOCKETCOM_EINTR) {
+        continue;
+      }
+      if (SOCKETCOM_IS_WOULDBLOCK(errno)) {
+        break;
+      }
+      PERROR("recvmsg(MSG_ERRQUEUE) in SocketCom_ZeroCopyReap()");
+      if (ranges_len != NULL) {
+        *ranges_len = count;
+      }
+      return SOCKETCOM_ERROR_ERRQUEUE;
+    }
+
+    for (cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+      if (!((cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR) || (cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR))) {
+        continue;
+      }
+      struct sock_extended_err *serr = (struct sock_extended_err *)CMSG_DATA(cmsg);
+      if (serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY || serr->ee_errno != 0) {
+        continue;
+      }
+
+      unsigned int lo = serr->ee_info;
+      unsigned int hi = serr->ee_data;
+      unsigned int n = hi - lo + 1;
+      int copied = (serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) ? 1 : 0;
+
+      zc->completions += n;
+      if (copied) {
+        zc->kernel_copied += n;
+      }
+      SocketCom_ZeroCopyComplete(zc, lo, hi);
+
+      if (ranges != NULL) {
+        ranges[count].lo = lo;
+        ranges[count].hi = hi;
+        ranges[count].copied = copied;
+      }
+      count++;
     }
   }
+#else
+  (void)zc;
+  (void)ranges;
+#endif
 
-  tv.tv_sec = timeout_sec;
-  tv.tv_usec = timeout_usec;
+  if (ranges_len != NULL) {
+    *ranges_len = count;
+  }
+  return SOCKETCOM_SUCCESS;
+}
+
+int SocketCom_ZeroCopyIsCompleted(const SocketCom_ZeroCopy *zc, const SocketCom_ZeroCopyRange *ids)
+{
+  unsigned int id = ids->hi;
+
+  if (ids->lo == SOCKETCOM_ZEROCOPY_ID_NONE) {
+    return 1;
+  }
+  if ((int)(id - zc->completed_next) < 0) {
+    return 1;
+  }
+  if (ids->lo != id || (int)(id - zc->next_id) >= 0) {
+    // a buffer of several sends is completed only when the watermark passes all of its ids
+    return 0;
+  }
+  return (SOCKETCOM_ZEROCOPY_WORD(zc, id) & SOCKETCOM_ZEROCOPY_BIT(id)) ? 1 : 0;
+}
+
+int SocketCom_ZeroCopyFlush(SocketCom_ZeroCopy *zc, long timeout_msec)
+{
+#if defined(_SOCKETCOM_LINUX_) && defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+  int res;
+  struct pollfd pfd;
+  long long deadline = (timeout_msec >= 0) ? SocketCom_NowMsec() + timeout_msec : -1;
+  unsigned long long completions;
 
+  pfd.revents = 0;
   while (1) {
-    if (timeout_sec >= 0 && timeout_usec >= 0) {
-      res = select(fd_max+1, &fds, NULL, NULL, &tv);
-    } else {
-      res = select(fd_max+1, &fds, NULL, NULL, NULL);
+    completions = zc->completions;
+    res = SocketCom_ZeroCopyReap(zc, NULL, NULL);
+    if (res != SOCKETCOM_SUCCESS) {
+      return res;
     }
-    if (res > 0) { //success
-      break;
+    if (zc->completed_next == zc->next_id) {
+      return SOCKETCOM_SUCCESS;
     }
+    // a reset or hung-up sock stays ready; without completions poll() would return at once forever
+    if ((pfd.revents & (POLLHUP | POLLNVAL)) && zc->completions == completions) {
+      return SOCKETCOM_ERROR_ERRQUEUE;
+    }
+
+    // POLLERR is reported when the error queue is not empty
+    pfd.fd = zc->sock->fd;
+    pfd.events = 0;
+    pfd.revents = 0;
+    res = poll(&pfd, 1, (int)SocketCom_RemainMsec(deadline));
     if (res == 0) {
-      return SOCKETCOM_ERROR_TIMEOUT_SELECT;
+      return SOCKETCOM_ERROR_TIMEOUT;
     }
-    if (errno == SOCKETCOM_EINTR) {
-      continue;
+    if (res < 0 && errno != SOCKETCOM_EINTR) {
+      return SOCKETCOM_ERROR_ERRQUEUE;
     }
-    // error
-    return SOCKETCOM_ERROR_SELECT;
+  }
+#else
+  (void)zc;
+  (void)timeout_msec;
+  return SOCKETCOM_SUCCESS;
+#endif
+}
+
+#ifdef _SOCKETCOM_POSIX_
+
+#define SOCKETCOM_SENDFILE_CHUNK (1024 * 1024)
+#define SOCKETCOM_SPLICE_CHUNK (64 * 1024)
+
+#endif
+
+int SocketCom_SendFile(SocketCom *sock, int fd, long long offset, long long len, long long *sentLen, long timeout_msec)
+{
+#ifdef _SOCKETCOM_POSIX_
+  int res = SOCKETCOM_SUCCESS;
+  long long total = 0;
+  long long deadline = (timeout_msec > 0) ? SocketCom_NowMsec() + timeout_msec : -1;
+  int fl = -1;
+
+  // a bounded transfer must not block inside the syscall
+  if (timeout_msec >= 0) {
+    fl = SocketCom_BeginNonBlocking(sock->fd);
   }
 
-  int count = 0;
-  for (i = 0; i < *socks_len; i++) {
-    if (FD_ISSET(socks[i]->fd, &fds)) {
-      if (count != i) {
-        SocketCom *tmp;
-        tmp = socks[count];
-        socks[count] = socks[i];
-        socks[i] = tmp;
+  while (len < 0 || total < len) {
+    size_t chunk = SOCKETCOM_SENDFILE_CHUNK;
+    if (len >= 0 && len - total < (long long)chunk) {
+      chunk = (size_t)(len - total);
+    }
+
+#ifdef _SOCKETCOM_LINUX_
+    off_t off = (off_t)(offset + total);
+    ssize_t size = sendfile(sock->fd, fd, &off, chunk);
+    SOCKETCOM_STATS_COUNT(sock, SOCKETCOM_STATS_DIR_SEND, size, chunk, (size < 0) ? errno : 0);
+    if (size == 0) {
+      // end of file
+      res = (len < 0) ? SOCKETCOM_SUCCESS : SOCKETCOM_ERROR_SENDFILE;
+      break;
+    }
+    if (size < 0) {
+      if (errno == SOCKETCOM_EINTR) {
+        continue;
       }
-      count++;
+      if (!SOCKETCOM_IS_WOULDBLOCK(errno)) {
+        PERROR("sendfile() in SocketCom_SendFile()");
+        res = (errno == EPIPE || errno == ECONNRESET || errno == ENOTCONN) ? SOCKETCOM_ERROR_SEND : SOCKETCOM_ERROR_SENDFILE;
+        break;
+      }
+    } else {
+      total += size;
+      continue;
+    }
+#else
+    char buf[64 * 1024];
+    if (chunk > sizeof(buf)) {
+      chunk = sizeof(buf);
+    }
+    ssize_t readLen = pread(fd, buf, chunk, (off_t)(offset + total));
+    if (readLen == 0) {
+      res = (len < 0) ? SOCKETCOM_SUCCESS : SOCKETCOM_ERROR_SENDFILE;
+      break;
+    }
+    if (readLen < 0) {
+      if (errno == SOCKETCOM_EINTR) {
+        continue;
+      }
+      PERROR("pread() in SocketCom_SendFile()");
+      res = SOCKETCOM_ERROR_SENDFILE;
+      break;
+    }
+    ssize_t size = send(sock->fd, buf, readLen, SOCKETCOM_MSG_NOSIGNAL);
+    SOCKETCOM_STATS_COUNT(sock, SOCKETCOM_STATS_DIR_SEND, size, readLen, (size < 0) ? errno : 0);
+    if (size < 0) {
+      if (errno == SOCKETCOM_EINTR) {
+        continue;
+      }
+      if (!SOCKETCOM_IS_WOULDBLOCK(errno)) {
+        PERROR("send() in SocketCom_SendFile()");
+        res = SOCKETCOM_ERROR_SEND;
+        break;
+      }
+    } else {
+      total += size;
+      continue;
+    }
+#endif
+
+    res = SocketCom_WaitFd(sock->fd, POLLOUT, deadline, timeout_msec != 0);
+    if (res != SOCKETCOM_SUCCESS) {
+      break;
     }
   }
 
-  *socks_len = res;
+  SocketCom_EndNonBlocking(sock->fd, fl);
+  if (sentLen != NULL) {
+    *sentLen = total;
+  }
+  return res;
+#else
+  (void)sock; (void)fd; (void)offset; (void)len; (void)timeout_msec;
+  if (sentLen != NULL) {
+    *sentLen = 0;
+  }
+  return SOCKETCOM_ERROR_NOTSUPPORTED;
+#endif
+}
 
+int SocketCom_RelayInit(SocketCom_Relay *relay)
+{
+  relay->pipefd[0] = -1;
+  relay->pipefd[1] = -1;
+  relay->buffered = 0;
+
+#ifdef _SOCKETCOM_LINUX_
+  if (pipe2(relay->pipefd, O_NONBLOCK | O_CLOEXEC) < 0) {
+    PERROR("pipe2() in SocketCom_RelayInit()");
+    return SOCKETCOM_ERROR_SPLICE;
+  }
   return SOCKETCOM_SUCCESS;
+#else
+  return SOCKETCOM_ERROR_NOTSUPPORTED;
+#endif
 }
 
-int SocketCom_SelectRecvables(SocketCom* socks[], int* socks_len)
+int SocketCom_RelayDestroy(SocketCom_Relay *relay)
 {
-  return SocketCom_WaitForRecvablesWithTimeout(socks, socks_len, 0, 0);
+#ifdef _SOCKETCOM_POSIX_
+  if (relay->pipefd[0] >= 0) {
+    close(relay->pipefd[0]);
+  }
+  if (relay->pipefd[1] >= 0) {
+    close(relay->pipefd[1]);
+  }
+#endif
+  relay->pipefd[0] = -1;
+  relay->pipefd[1] = -1;
+  relay->buffered = 0;
+
+  return SOCKETCOM_SUCCESS;
 }
 
-int SocketCom_WaitForRecvables(SocketCom* socks[], int* socks_len)
+int SocketCom_RelayTransfer(SocketCom_Relay *relay, SocketCom *from, SocketCom *to, long long len, long long *movedLen, long timeout_msec)
 {
-  return SocketCom_WaitForRecvablesWithTimeout(socks, socks_len, -1, -1);
+#ifdef _SOCKETCOM_LINUX_
+  int res = SOCKETCOM_SUCCESS;
+  long long moved = 0;
+  long long deadline = (timeout_msec > 0) ? SocketCom_NowMsec() + timeout_msec : -1;
+  int from_fl = -1;
+  int to_fl = -1;
+  int eof = 0;
+
+  if (timeout_msec >= 0) {
+    from_fl = SocketCom_BeginNonBlocking(from->fd);
+    to_fl = SocketCom_BeginNonBlocking(to->fd);
+  }
+
+  while (len < 0 || moved < len) {
+    ssize_t size;
+
+    if (relay->buffered > 0) {
+      // pipe -> to
+      size = splice(relay->pipefd[0], NULL, to->fd, NULL, (size_t)relay->buffered, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+      SOCKETCOM_STATS_COUNT(to, SOCKETCOM_STATS_DIR_SEND, size, relay->buffered, (size < 0) ? errno : 0);
+      if (size > 0) {
+        relay->buffered -= size;
+        moved += size;
+        continue;
+      }
+      if (size < 0 && errno == SOCKETCOM_EINTR) {
+        continue;
+      }
+      if (size < 0 && !SOCKETCOM_IS_WOULDBLOCK(errno)) {
+        PERROR("splice() to sock in SocketCom_RelayTransfer()");
+        res = SOCKETCOM_ERROR_SPLICE;
+        break;
+      }
+      res = SocketCom_WaitFd(to->fd, POLLOUT, deadline, timeout_msec != 0);
+      if (res != SOCKETCOM_SUCCESS) {
+        break;
+      }
+      continue;
+    }
+
+    if (eof) {
+      res = (len < 0) ? SOCKETCOM_SUCCESS : SOCKETCOM_ERROR_DISCONNECTED;
+      break;
+    }
+
+    // from -> pipe; never read more than requested
+    size_t chunk = SOCKETCOM_SPLICE_CHUNK;
+    if (len >= 0 && len - moved < (long long)chunk) {
+      chunk = (size_t)(len - moved);
+    }
+    size = splice(from->fd, NULL, relay->pipefd[1], NULL, chunk, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    SOCKETCOM_STATS_COUNT(from, SOCKETCOM_STATS_DIR_RECV, size, chunk, (size < 0) ? errno : 0);
+    if (size > 0) {
+      relay->buffered += size;
+      continue;
+    }
+    if (size == 0) {
+      eof = 1;
+      continue;
+    }
+    if (errno == SOCKETCOM_EINTR) {
+      continue;
+    }
+    if (!SOCKETCOM_IS_WOULDBLOCK(errno)) {
+      PERROR("splice() from sock in SocketCom_RelayTransfer()");
+      res = SOCKETCOM_ERROR_SPLICE;
+      break;
+    }
+    res = SocketCom_WaitFd(from->fd, POLLIN, deadline, timeout_msec != 0);
+    if (res != SOCKETCOM_SUCCESS) {
+      break;
+    }
+  }
+
+  SocketCom_EndNonBlocking(from->fd, from_fl);
+  SocketCom_EndNonBlocking(to->fd, to_fl);
+  if (movedLen != NULL) {
+    *movedLen = moved;
+  }
+  return res;
+#else
+  (void)relay; (void)from; (void)to; (void)len; (void)timeout_msec;
+  if (movedLen != NULL) {
+    *movedLen = 0;
+  }
+  return SOCKETCOM_ERROR_NOTSUPPORTED;
+#endif
 }
 
-int SocketCom_WaitForRecvableWithTimeout(SocketCom* sock, long timeout_sec, long timeout_usec)
+int SocketCom_SendTo(SocketCom* sock, const void *buf, int bufLen, const struct sockaddr_storage *addr)
 {
-  int socks_len = 1;
-  return SocketCom_WaitForRecvablesWithTimeout(&sock, &socks_len, timeout_sec, timeout_usec);
+  while (1) {
+    int size = sendto(sock->fd, (const char *)buf, bufLen, SOCKETCOM_MSG_NOSIGNAL, (const struct sockaddr *)addr, SocketCom_SockaddrLen(addr));
+    SOCKETCOM_STATS_COUNT(sock, SOCKETCOM_STATS_DIR_SEND, size, bufLen, (size < 0) ? errno : 0);
+    if (size == SOCKET_ERROR) {
+      if (errno == SOCKETCOM_EINTR) {
+        continue;
+      }
+      if (SOCKETCOM_IS_WOULDBLOCK(errno)) {
+        return SOCKETCOM_ERROR_WOULDBLOCK;
+      }
+      PERROR("sendto() in SocketCom_SendTo()");
+      return SOCKETCOM_ERROR_SEND;
+    }
+    return SOCKETCOM_SUCCESS;
+  }
 }
 
-int SocketCom_WaitForRecvable(SocketCom* sock)
+int SocketCom_RecvFrom(SocketCom* sock, void *buf, int bufLen, int *recvLen, struct sockaddr_storage *addr)
 {
-  return SocketCom_WaitForRecvableWithTimeout(sock, -1, -1);
+  struct sockaddr_storage tmp;
+
+  while (1) {
+    socklen_t addrlen = sizeof(struct sockaddr_storage);
+    int size = recvfrom(sock->fd, (char *)buf, bufLen, 0, (struct sockaddr *)((addr != NULL) ? addr : &tmp), &addrlen);
+    SOCKETCOM_STATS_COUNT(sock, SOCKETCOM_STATS_DIR_RECV, size, 0, (size < 0) ? errno : 0);
+    if (size == SOCKET_ERROR) {
+      if (errno == SOCKETCOM_EINTR) {
+        continue;
+      }
+      if (SOCKETCOM_IS_WOULDBLOCK(errno)) {
+        return SOCKETCOM_ERROR_WOULDBLOCK;
+      }
+      PERROR("recvfrom() in SocketCom_RecvFrom()");
+      return SOCKETCOM_ERROR_RECV;
+    }
+    if (recvLen != NULL) {
+      *recvLen = size;
+    }
+    return SOCKETCOM_SUCCESS;
+  }
 }
 
-int SocketCom_IsRecvable(SocketCom* sock)
+#ifdef _SOCKETCOM_LINUX_
+
+#ifdef SOCKETCOM_USE_STATS
+/**
+ *  total bytes of msgs done by recvmmsg()/sendmmsg()
+ */
+static size_t SocketCom_MmsgLen(const struct mmsghdr *msgs, int n)
 {
-  int res = SocketCom_WaitForRecvableWithTimeout(sock, 0, 0);
-  return (res == SOCKETCOM_SUCCESS) ? 1 : 0;
+  size_t len = 0;
+  int i;
+
+  for (i = 0; i < n; i++) {
+    len += msgs[i].msg_len;
+  }
+  return len;
 }
+#endif
 
-int SocketCom_RecvEx(SocketCom* sock, void* buf, int bufLen, int *recvLen, int flags)
+int SocketCom_RecvMany(SocketCom* sock, SocketCom_Datagram dgrams[], int *dgrams_len)
 {
-  int _recvLen;
+  struct mmsghdr msgs[SOCKETCOM_DGRAM_BATCH];
+  struct iovec iovs[SOCKETCOM_DGRAM_BATCH];
+  char control[SOCKETCOM_DGRAM_BATCH][CMSG_SPACE(sizeof(int))];
+  int n = (*dgrams_len < SOCKETCOM_DGRAM_BATCH) ? *dgrams_len : SOCKETCOM_DGRAM_BATCH;
+  int i;
+  int res;
 
-  _recvLen = recv(sock->fd, (char *)buf, bufLen, flags);
-  if (_recvLen == 0) {
-    return SOCKETCOM_ERROR_DISCONNECTED;
-  } else if (_recvLen < 0) {
-    PERROR("SocketCom_RecvEx()");
+  memset(msgs, 0, sizeof(struct mmsghdr) * n);
+  for (i = 0; i < n; i++) {
+    iovs[i].iov_base = dgrams[i].buf;
+    iovs[i].iov_len = dgrams[i].len;
+    msgs[i].msg_hdr.msg_name = &dgrams[i].addr;
+    msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_storage);
+    msgs[i].msg_hdr.msg_iov = &iovs[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+    msgs[i].msg_hdr.msg_control = control[i];
+    msgs[i].msg_hdr.msg_controllen = sizeof(control[i]);
+  }
+
+  // MSG_WAITFORONE: wait for the first datagram only
+  do {
+    res = recvmmsg(sock->fd, msgs, n, MSG_WAITFORONE, NULL);
+    SOCKETCOM_STATS_COUNT(sock, SOCKETCOM_STATS_DIR_RECV, (res < 0) ? -1 : (long long)SocketCom_MmsgLen(msgs, res), 0, (res < 0) ? errno : 0);
+  } while (res < 0 && errno == EINTR);
+  if (res < 0) {
+    *dgrams_len = 0;
+    if (SOCKETCOM_IS_WOULDBLOCK(errno)) {
+      return SOCKETCOM_ERROR_WOULDBLOCK;
+    }
+    PERROR("recvmmsg() in SocketCom_RecvMany()");
     return SOCKETCOM_ERROR_RECV;
   }
 
-  if (recvLen != NULL) {
-    *recvLen = _recvLen;
+  for (i = 0; i < res; i++) {
+    struct cmsghdr *cmsg;
+    dgrams[i].len = msgs[i].msg_len;
+    dgrams[i].segSize = 0;
+#ifdef UDP_GRO
+    for (cmsg = CMSG_FIRSTHDR(&msgs[i].msg_hdr); cmsg != NULL; cmsg = CMSG_NXTHDR(&msgs[i].msg_hdr, cmsg)) {
+      if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
+        int segSize;
+        memcpy(&segSize, CMSG_DATA(cmsg), sizeof(int));
+        dgrams[i].segSize = segSize;
+      }
+    }
+#else
+    (void)cmsg;
+#endif
   }
+
+  *dgrams_len = res;
   return SOCKETCOM_SUCCESS;
 }
 
-int SocketCom_Recv(SocketCom* sock, void* buf, int bufLen, int *recvLen)
+int SocketCom_SendMany(SocketCom* sock, const SocketCom_Datagram dgrams[], int *dgrams_len)
 {
-  return SocketCom_RecvEx(sock, buf, bufLen, recvLen, 0);
+  struct mmsghdr msgs[SOCKETCOM_DGRAM_BATCH];
+  struct iovec iovs[SOCKETCOM_DGRAM_BATCH];
+  char control[SOCKETCOM_DGRAM_BATCH][CMSG_SPACE(sizeof(uint16_t))];
+  int sent = 0;
+  int res = SOCKETCOM_SUCCESS;
+  int i;
+
+  while (sent < *dgrams_len) {
+    int n = (*dgrams_len - sent < SOCKETCOM_DGRAM_BATCH) ? (*dgrams_len - sent) : SOCKETCOM_DGRAM_BATCH;
+
+    memset(msgs, 0, sizeof(struct mmsghdr) * n);
+    for (i = 0; i < n; i++) {
+      const SocketCom_Datagram *dgram = &dgrams[sent + i];
+      iovs[i].iov_base = dgram->buf;
+      iovs[i].iov_len = dgram->len;
+      if (dgram->addr.ss_family != AF_UNSPEC) {
+        msgs[i].msg_hdr.msg_name = (void *)&dgram->addr;
+        msgs[i].msg_hdr.msg_namelen = SocketCom_SockaddrLen(&dgram->addr);
+      }
+      msgs[i].msg_hdr.msg_iov = &iovs[i];
+      msgs[i].msg_hdr.msg_iovlen = 1;
+      if (dgram->segSize > 0) {
+#ifdef UDP_SEGMENT
+        uint16_t segSize = (uint16_t)dgram->segSize;
+        msgs[i].msg_hdr.msg_control = control[i];
+        msgs[i].msg_hdr.msg_controllen = sizeof(control[i]);
+        struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msgs[i].msg_hdr);
+        cmsg->cmsg_level = SOL_UDP;
+        cmsg->cmsg_type = UDP_SEGMENT;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+        memcpy(CMSG_DATA(cmsg), &segSize, sizeof(uint16_t));
+#else
+        *dgrams_len = sent;
+        return SOCKETCOM_ERROR_NOTSUPPORTED;
+#endif
+      }
+    }
+
+    int size = sendmmsg(sock->fd, msgs, n, SOCKETCOM_MSG_NOSIGNAL);
+    SOCKETCOM_STATS_COUNT(sock, SOCKETCOM_STATS_DIR_SEND, (size < 0) ? -1 : (long long)SocketCom_MmsgLen(msgs, size), 0, (size < 0) ? errno : 0);
+    if (size < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (SOCKETCOM_IS_WOULDBLOCK(errno)) {
+        res = SOCKETCOM_ERROR_WOULDBLOCK;
+      } else {
+        PERROR("sendmmsg() in SocketCom_SendMany()");
+        res = SOCKETCOM_ERROR_SEND;
+      }
+      break;
+    }
+    sent += size;
+  }
+
+  *dgrams_len = sent;
+  return res;
 }
 
-int SocketCom_RecvAll(SocketCom* sock, void* buf, int recvLen)
+#else
+
+int SocketCom_RecvMany(SocketCom* sock, SocketCom_Datagram dgrams[], int *dgrams_len)
 {
-  return SocketCom_RecvEx(sock, buf, recvLen, NULL, MSG_WAITALL);
+  int n = 0;
+  int res = SOCKETCOM_SUCCESS;
+
+  while (n < *dgrams_len) {
+    socklen_t addrlen = sizeof(struct sockaddr_storage);
+#ifdef _SOCKETCOM_WIN32_
+    if (n > 0) {
+      break;
+    }
+    int flags = 0;
+#else
+    // wait for the first datagram only
+    int flags = (n > 0) ? MSG_DONTWAIT : 0;
+#endif
+    int size = recvfrom(sock->fd, (char *)dgrams[n].buf, (int)dgrams[n].len, flags, (struct sockaddr *)&dgrams[n].addr, &addrlen);
+    SOCKETCOM_STATS_COUNT(sock, SOCKETCOM_STATS_DIR_RECV, size, 0, (size < 0) ? errno : 0);
+    if (size == SOCKET_ERROR) {
+      if (errno == SOCKETCOM_EINTR) {
+        continue;
+      }
+      if (SOCKETCOM_IS_WOULDBLOCK(errno)) {
+        res = SOCKETCOM_ERROR_WOULDBLOCK;
+      } else {
+        PERROR("recvfrom() in SocketCom_RecvMany()");
+        res = SOCKETCOM_ERROR_RECV;
+      }
+      break;
+    }
+    dgrams[n].len = size;
+    dgrams[n].segSize = 0;
+    n++;
+  }
+
+  *dgrams_len = n;
+  return (n > 0) ? SOCKETCOM_SUCCESS : res;
 }
 
-int SocketCom_Send(SocketCom* sock, const void *buf, int bufLen)
+int SocketCom_SendMany(SocketCom* sock, const SocketCom_Datagram dgrams[], int *dgrams_len)
 {
-  int size;
+  int sent = 0;
+  int res = SOCKETCOM_SUCCESS;
 
-  size = send(sock->fd, (const char *)buf, bufLen, 0);
-  if (size != bufLen) {
-    PERROR("SocketCom_Send()");
-    return SOCKETCOM_ERROR_SEND;
+  while (sent < *dgrams_len) {
+    const SocketCom_Datagram *dgram = &dgrams[sent];
+    if (dgram->segSize > 0) {
+      res = SOCKETCOM_ERROR_NOTSUPPORTED;
+      break;
+    }
+    int size;
+    if (dgram->addr.ss_family != AF_UNSPEC) {
+      size = sendto(sock->fd, (const char *)dgram->buf, (int)dgram->len, SOCKETCOM_MSG_NOSIGNAL, (const struct sockaddr *)&dgram->addr, SocketCom_SockaddrLen(&dgram->addr));
+    } else {
+      size = send(sock->fd, (const char *)dgram->buf, (int)dgram->len, SOCKETCOM_MSG_NOSIGNAL);
+    }
+    SOCKETCOM_STATS_COUNT(sock, SOCKETCOM_STATS_DIR_SEND, size, dgram->len, (size < 0) ? errno : 0);
+    if (size == SOCKET_ERROR) {
+      if (errno == SOCKETCOM_EINTR) {
+        continue;
+      }
+      if (SOCKETCOM_IS_WOULDBLOCK(errno)) {
+        res = SOCKETCOM_ERROR_WOULDBLOCK;
+      } else {
+        PERROR("sendto() in SocketCom_SendMany()");
+        res = SOCKETCOM_ERROR_SEND;
+      }
+      break;
+    }
+    sent++;
   }
 
+  *dgrams_len = sent;
+  return res;
+}
+
+#endif
+
+int SocketCom_SetUdpGro(SocketCom* sock, int on)
+{
+#if defined(_SOCKETCOM_LINUX_) && defined(UDP_GRO)
+  if (setsockopt(sock->fd, SOL_UDP, UDP_GRO, &on, sizeof(on)) < 0) {
+    PERROR("setsockopt(UDP_GRO) in SocketCom_SetUdpGro()");
+    return SOCKETCOM_ERROR_SETUDPGRO;
+  }
   return SOCKETCOM_SUCCESS;
+#else
+  (void)sock; (void)on;
+  return SOCKETCOM_ERROR_NOTSUPPORTED;
+#endif
 }
 
 int inline SocketCom_IsClient(const SocketCom* sock)
@@ -648,12 +3110,23 @@ int inline SocketCom_IsReady(const SocketCom* sock)
 }
 
 int SocketCom_GetAddrin(const SocketCom *sock, sockaddr_in *addrin)
+{
+  if (!(sock->status & SOCKETCOM_STATE_HAS_ADDR) || sock->addr.ss_family != AF_INET) {
+    return SOCKETCOM_ERROR_ILLEGAL_SOCK;
+  }
+
+  memcpy(addrin, &sock->addr, sizeof(struct sockaddr_in));
+
+  return SOCKETCOM_SUCCESS;
+}
+
+int SocketCom_GetSockaddr(const SocketCom *sock, struct sockaddr_storage *addr)
 {
   if (!(sock->status & SOCKETCOM_STATE_HAS_ADDR)) {
     return SOCKETCOM_ERROR_ILLEGAL_SOCK;
   }
 
-  *addrin = sock->addr;
+  *addr = sock->addr;
 
   return SOCKETCOM_SUCCESS;
 }
@@ -663,20 +3136,69 @@ int SocketCom_GetPort(const SocketCom *sock, u_short *port)
   if (!(sock->status & SOCKETCOM_STATE_HAS_ADDR)) {
     return SOCKETCOM_ERROR_ILLEGAL_SOCK;
   }
-  *port = ntohs(sock->addr.sin_port);
+  if (sock->addr.ss_family == AF_INET6) {
+    *port = ntohs(((const struct sockaddr_in6 *)&sock->addr)->sin6_port);
+  } else {
+    *port = ntohs(((const struct sockaddr_in *)&sock->addr)->sin_port);
+  }
 
   return SOCKETCOM_SUCCESS;
 }
 
 int SocketCom_GetIpStr(SocketCom* sock, char* ipstr)
 {
+  const char *res;
+
   if (!(sock->status & SOCKETCOM_STATE_HAS_ADDR)) {
     return SOCKETCOM_ERROR_ILLEGAL_SOCK;
   }
 
-  strcpy(ipstr, inet_ntoa(sock->addr.sin_addr));
+  if (sock->addr.ss_family == AF_INET6) {
+    res = inet_ntop(AF_INET6, (void *)&((struct sockaddr_in6 *)&sock->addr)->sin6_addr, ipstr, SOCKETCOM_IPV6_STR_SIZE);
+  } else {
+    res = inet_ntop(AF_INET, (void *)&((struct sockaddr_in *)&sock->addr)->sin_addr, ipstr, SOCKETCOM_IPV4_STR_SIZE);
+  }
+  if (res == NULL) {
+    return SOCKETCOM_ERROR_ILLEGAL_SOCK;
+  }
+
+  return SOCKETCOM_SUCCESS;
+}
+
+int SocketCom_GetTcpInfo(const SocketCom *sock, SocketCom_TcpInfo *info)
+{
+#if defined(_SOCKETCOM_LINUX_) && defined(TCP_INFO)
+  struct tcp_info ti;
+  socklen_t len = sizeof(ti);
+
+  if (!(sock->status & SOCKETCOM_STATE_CREATED)) {
+    return SOCKETCOM_ERROR_ILLEGAL_SOCK;
+  }
+
+  memset(&ti, 0, sizeof(ti));
+  if (getsockopt(sock->fd, IPPROTO_TCP, TCP_INFO, &ti, &len) != 0) {
+    PERROR("getsockopt(TCP_INFO) in SocketCom_GetTcpInfo()");
+    return SOCKETCOM_ERROR_GETSOCKOPT;
+  }
+  info->state = ti.tcpi_state;
+  info->rtt_usec = ti.tcpi_rtt;
+  info->rttvar_usec = ti.tcpi_rttvar;
+  info->retransmits = ti.tcpi_retransmits;
+  info->total_retrans = ti.tcpi_total_retrans;
+  info->lost = ti.tcpi_lost;
+  info->unacked = ti.tcpi_unacked;
+  info->snd_cwnd = ti.tcpi_snd_cwnd;
+  info->snd_ssthresh = ti.tcpi_snd_ssthresh;
+  info->snd_mss = ti.tcpi_snd_mss;
+  info->rcv_mss = ti.tcpi_rcv_mss;
+  info->options = ti.tcpi_options;
 
   return SOCKETCOM_SUCCESS;
+#else
+  (void)sock;
+  memset(info, 0, sizeof(*info));
+  return SOCKETCOM_ERROR_NOTSUPPORTED;
+#endif
 }
 
 int SocketCom_SetBlockingSocket(SocketCom* sock)
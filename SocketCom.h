@@ -11,22 +11,29 @@ http://opensource.org/licenses/mit-license.php
 #define __SOCKETCOM_H__
 
 //#define SOCKETCOM_USE_SETKEEPALIVE
+//#define SOCKETCOM_USE_STATS
 #define SOCKETCOM_NDEBUG
 
 #if defined(_WIN32) || defined(__WIN32__) || defined(__WINDOWS__)
 #define _SOCKETCOM_WIN32_
 #else
 #define _SOCKETCOM_POSIX_
+#if defined(__linux__)
+#define _SOCKETCOM_LINUX_
+#endif
 #endif
 
 #ifdef _SOCKETCOM_WIN32_
 
 #include <winsock2.h>
+#include <ws2tcpip.h>
 
 typedef int socklen_t;
 #else
 
+#include <sys/socket.h>
 #include <netinet/in.h>
+#include <sys/uio.h>
 
 #define SOCKET_ERROR (-1)
 
@@ -39,6 +46,7 @@ enum SOCKETCOM_STATE {
   SOCKETCOM_STATE_HAS_ADDR = 0x02,
   SOCKETCOM_STATE_SERVER = 0x04,
   SOCKETCOM_STATE_CLIENT = 0x08,
+  SOCKETCOM_STATE_DGRAM = 0x10, // datagram(UDP) sock
 };
 
 
@@ -52,14 +60,18 @@ enum SOCKETCOM_ERROR {
   SOCKETCOM_ERROR_CREATE = 12,
   SOCKETCOM_ERROR_ALREADY_CLOSED = 16,
   SOCKETCOM_ERROR_CLOSE = 20,
+  SOCKETCOM_ERROR_TIMEOUT_CLOSE = 21, // SOCKETCOM_ERROR_CLOSE | SOCKETCOM_ERROR_TIMEOUT
   SOCKETCOM_ERROR_BIND = 24,
   SOCKETCOM_ERROR_LISTEN = 28,
   SOCKETCOM_ERROR_ACCEPT = 32,
+  SOCKETCOM_ERROR_TIMEOUT_ACCEPT = 33, // SOCKETCOM_ERROR_ACCEPT | SOCKETCOM_ERROR_TIMEOUT
   SOCKETCOM_ERROR_CONNECT = 36,
   SOCKETCOM_ERROR_TIMEOUT_CONNECT = 37, // SOCKETCOM_ERROR_CONNECT | SOCKETCOM_ERROR_TIMEOUT
   SOCKETCOM_ERROR_DISCONNECTED = 40,
   SOCKETCOM_ERROR_RECV = 44,
+  SOCKETCOM_ERROR_TIMEOUT_RECV = 45, // SOCKETCOM_ERROR_RECV | SOCKETCOM_ERROR_TIMEOUT
   SOCKETCOM_ERROR_SEND = 48,
+  SOCKETCOM_ERROR_TIMEOUT_SEND = 49, // SOCKETCOM_ERROR_SEND | SOCKETCOM_ERROR_TIMEOUT
   SOCKETCOM_ERROR_SETKEEPALIVE = 52,
   SOCKETCOM_ERROR_SETREUSEADDR = 56,
 
@@ -83,12 +95,99 @@ enum SOCKETCOM_ERROR {
   SOCKETCOM_ERROR_IOCTL = 104,
 
   SOCKETCOM_ERROR_GETSOCKOPT = 108,
+
+  SOCKETCOM_ERROR_POLLER = 112,
+  SOCKETCOM_ERROR_TIMEOUT_POLLER = 113, //SOCKETCOM_ERROR_POLLER | SOCKETCOM_ERROR_TIMEOUT
+  SOCKETCOM_ERROR_POLLER_CTL = 116,
+  SOCKETCOM_ERROR_POLLER_FULL = 120,
+
+  SOCKETCOM_ERROR_MEMORY = 124,
+
+  SOCKETCOM_ERROR_ENGINE = 128,
+  SOCKETCOM_ERROR_TIMEOUT_ENGINE = 129, //SOCKETCOM_ERROR_ENGINE | SOCKETCOM_ERROR_TIMEOUT
+  SOCKETCOM_ERROR_ENGINE_FULL = 132,
+
+  SOCKETCOM_ERROR_NOTSUPPORTED = 136,
+
+  SOCKETCOM_ERROR_SETREUSEPORT = 140,
+  SOCKETCOM_ERROR_SETZEROCOPY = 144,
+  SOCKETCOM_ERROR_ERRQUEUE = 148,
+  SOCKETCOM_ERROR_SENDFILE = 152,
+  SOCKETCOM_ERROR_SPLICE = 156,
+
+  SOCKETCOM_ERROR_READER_FULL = 160,
+  SOCKETCOM_ERROR_FRAME = 164,
+  SOCKETCOM_ERROR_SETUDPGRO = 168,
+
+  SOCKETCOM_ERROR_RESOLVER = 172,
+  SOCKETCOM_ERROR_TIMEOUT_RESOLVER = 173, //SOCKETCOM_ERROR_RESOLVER | SOCKETCOM_ERROR_TIMEOUT
+
+  SOCKETCOM_ERROR_POOL = 176,
+  SOCKETCOM_ERROR_TIMEOUT_POOL = 177, //SOCKETCOM_ERROR_POOL | SOCKETCOM_ERROR_TIMEOUT
+
+  SOCKETCOM_ERROR_SETFASTOPEN = 180,
+  SOCKETCOM_ERROR_SETBUSYPOLL = 184,
+  SOCKETCOM_ERROR_SETNODELAY = 188,
+  SOCKETCOM_ERROR_SETCORK = 192,
+
+  SOCKETCOM_ERROR_BUFPOOL_EMPTY = 196,
 };
 
 #define SOCKETCOM_IPV4_STR_SIZE 16
+#define SOCKETCOM_IPV6_STR_SIZE 46
+#define SOCKETCOM_IP_STR_SIZE SOCKETCOM_IPV6_STR_SIZE
 
 #define SOCKETCOM_INITIALIZER {0}
 
+/**
+ *  element of scatter-gather buffers; struct iovec on POSIX, WSABUF on WIN32
+ *  access members by SOCKETCOM_IOVEC_BASE()/SOCKETCOM_IOVEC_LEN(), and set them by SOCKETCOM_IOVEC_SET()
+ */
+#ifdef _SOCKETCOM_WIN32_
+typedef WSABUF SocketCom_IoVec;
+#define SOCKETCOM_IOVEC_BASE(v) ((v).buf)
+#define SOCKETCOM_IOVEC_LEN(v) ((v).len)
+#define SOCKETCOM_IOVEC_SET(v, base, len) do{ (v).buf = (char *)(base); (v).len = (ULONG)(len); }while(0)
+#else
+typedef struct iovec SocketCom_IoVec;
+#define SOCKETCOM_IOVEC_BASE(v) ((v).iov_base)
+#define SOCKETCOM_IOVEC_LEN(v) ((v).iov_len)
+#define SOCKETCOM_IOVEC_SET(v, base, len) do{ (v).iov_base = (void *)(base); (v).iov_len = (size_t)(len); }while(0)
+#endif
+
+#ifdef SOCKETCOM_USE_STATS
+/**
+ *  types of errors counted by SocketCom_Stats; classified by errno
+ */
+enum SOCKETCOM_STATS_ERROR {
+  SOCKETCOM_STATS_ERROR_RESET = 0, // ECONNRESET, EPIPE, ECONNABORTED
+  SOCKETCOM_STATS_ERROR_TIMEDOUT, // ETIMEDOUT
+  SOCKETCOM_STATS_ERROR_REFUSED, // ECONNREFUSED
+  SOCKETCOM_STATS_ERROR_UNREACH, // EHOSTUNREACH, ENETUNREACH, ENETDOWN
+  SOCKETCOM_STATS_ERROR_RESOURCE, // EMFILE, ENFILE, ENOBUFS, ENOMEM
+  SOCKETCOM_STATS_ERROR_OTHER,
+  SOCKETCOM_STATS_ERROR_TYPES,
+};
+
+/**
+ *  I/O counters of a sock, or of the process (SocketCom_StatsGetGlobal())
+ *  every syscall of receiving or sending is counted, including retried and failed ones
+ */
+typedef struct SocketCom_Stats {
+  unsigned long long bytes_recv;
+  unsigned long long bytes_sent;
+  unsigned long long recv_calls;
+  unsigned long long send_calls;
+  unsigned long long short_recvs; // received less than requested
+  unsigned long long short_sends; // sent less than requested
+  unsigned long long eagain; // EAGAIN/EWOULDBLOCK
+  unsigned long long eintr; // EINTR; retried
+  unsigned long long eofs; // FIN of the peer
+  unsigned long long errors[SOCKETCOM_STATS_ERROR_TYPES];
+  int last_errno; // errno of the last error; 0 if none
+} SocketCom_Stats;
+#endif
+
 /**
  *  @attention  before to use struct SocketCom, initialize by (1) SocketCom sock = SOCKETCOM_INITIALIZER; or (2) SocketCom_Init(&sock);
  */
@@ -99,7 +198,10 @@ typedef struct SocketCom {
 #else
   int fd;
 #endif
-  sockaddr_in addr;
+  struct sockaddr_storage addr; // IPv4(sockaddr_in) or IPv6(sockaddr_in6); length is given by SocketCom_SockaddrLen()
+#ifdef SOCKETCOM_USE_STATS
+  SocketCom_Stats stats; // reset when the socket is created or accepted
+#endif
 } SocketCom;
 
 /**
@@ -143,8 +245,40 @@ void SocketCom_Init(SocketCom *sock);
  */
 int SocketCom_Create(SocketCom *sock);
 
+/**
+ * create socket of family and type
+ *
+ * @param sock[in/out] sock
+ * @param family AF_INET or AF_INET6
+ * @param type SOCK_STREAM or SOCK_DGRAM
+ *
+ * @retval ==SOCKETCOM_SUCCESS success
+ * @retval !=SOCKETCOM_SUCCESS error
+ */
+int SocketCom_CreateEx(SocketCom *sock, int family, int type);
+
+/**
+ * create datagram(UDP) socket
+ * receive by SocketCom_Bind() and SocketCom_RecvFrom()/SocketCom_RecvMany(), send by SocketCom_SendTo()/SocketCom_SendMany()
+ * SocketCom_Connect() sets the default peer, and then SocketCom_Send()/SocketCom_Recv() send and receive single datagrams
+ *
+ * @param sock[in/out] sock
+ *
+ * @retval ==SOCKETCOM_SUCCESS success
+ * @retval !=SOCKETCOM_SUCCESS error
+ */
+int SocketCom_CreateDgram(SocketCom *sock);
+
+// timeout of SocketCom_Close(); define before including to change it
+#ifndef SOCKETCOM_CLOSE_TIMEOUT_MSEC
+#define SOCKETCOM_CLOSE_TIMEOUT_MSEC (5 * 1000)
+#endif
+#define SOCKETCOM_CLOSE_DRAIN_BUF_SIZE (16 * 1024)
+#define SOCKETCOM_CLOSE_DRAIN_BUDGET (256 * 1024) // max bytes discarded by one SocketCom_CloseDrain()
+
 /**
  *  close connection after checking FIN and clearing buffer
+ *  same as SocketCom_CloseWithTimeout(sock, SOCKETCOM_CLOSE_TIMEOUT_MSEC)
  *
  *  @param sock[in/out] closed sock
  *
@@ -153,6 +287,47 @@ int SocketCom_Create(SocketCom *sock);
  */
 int SocketCom_Close(SocketCom* sock);
 
+/**
+ *  graceful close bounded by timeout
+ *  shut down sending, discard received data until FIN of the peer, and close.
+ *  if the peer does not close in time, close abortively by SocketCom_Abort()
+ *
+ *  @param sock[in/out] closed sock; closed also on error
+ *  @param timeout_msec timeout; -1 for unlimited, 0 to abort unless FIN is already received
+ *  @retval SOCKETCOM_SUCCESS success
+ *  @retval SOCKETCOM_ERROR_TIMEOUT_CLOSE timeout; closed abortively
+ *  @retval !=SOCKETCOM_SUCCESS error
+ */
+int SocketCom_CloseWithTimeout(SocketCom* sock, long timeout_msec);
+
+/**
+ *  start graceful close to be finished by an event loop:
+ *  shut down sending, and make sock non-blocking.
+ *  then call SocketCom_CloseDrain() whenever sock is receivable, and SocketCom_Abort() when the deadline of the loop expires
+ *
+ *  @param sock[in/out] sock; closed on error
+ *  @retval SOCKETCOM_SUCCESS success
+ *  @retval !=SOCKETCOM_SUCCESS error
+ */
+int SocketCom_CloseStart(SocketCom* sock);
+
+/**
+ *  discard received data of sock given to SocketCom_CloseStart(), and close it when FIN is received
+ *
+ *  @param sock[in/out] sock
+ *  @retval SOCKETCOM_SUCCESS closed
+ *  @retval SOCKETCOM_ERROR_WOULDBLOCK FIN is not received yet; call again when sock is receivable
+ *  @retval !=SOCKETCOM_SUCCESS error; closed
+ */
+int SocketCom_CloseDrain(SocketCom* sock);
+
+/**
+ *  close abortively (SO_LINGER 0): unsent and unread data are discarded, the peer gets RST, and no TIME_WAIT is left
+ *
+ *  @param sock[in/out] closed sock
+ */
+int SocketCom_Abort(SocketCom* sock);
+
 /**
  *  Close(Dispose) connection immediately
  *
@@ -163,11 +338,88 @@ int SocketCom_Close(SocketCom* sock);
  */
 int SocketCom_Dispose(SocketCom* sock);
 
+// backlog of SocketCom_Listen(); define before including to change it. the kernel caps it (net.core.somaxconn on Linux)
+#ifndef SOCKETCOM_LISTEN_BACKLOG
+#define SOCKETCOM_LISTEN_BACKLOG SOMAXCONN
+#endif
+
+enum SOCKETCOM_LISTEN_FLAG {
+  SOCKETCOM_LISTEN_FLAG_NONE = 0x00,
+  SOCKETCOM_LISTEN_FLAG_REUSEADDR = 0x01,
+  SOCKETCOM_LISTEN_FLAG_REUSEPORT = 0x02, // several socks can listen on the same port; the kernel balances connections among them
+  SOCKETCOM_LISTEN_FLAG_FASTOPEN = 0x04, // accept data in SYN (TCP Fast Open) if supported; ignored if not
+};
+
+// flags of SocketCom_Listen(); define before including to change it, e.g. to SOCKETCOM_LISTEN_FLAG_FASTOPEN
+#ifndef SOCKETCOM_LISTEN_FLAGS
+#define SOCKETCOM_LISTEN_FLAGS SOCKETCOM_LISTEN_FLAG_NONE
+#endif
+
+// max number of pending TCP Fast Open requests of a listener
+#ifndef SOCKETCOM_FASTOPEN_QLEN
+#define SOCKETCOM_FASTOPEN_QLEN 256
+#endif
+
 int SocketCom_Listen(SocketCom *sock,u_short port);
+
+/**
+ *  bind sock to ip and port, and listen
+ *
+ *  @param[in/out] sock sock
+ *  @param[in] ip IPv4 or IPv6 address to bind; NULL to bind to any address of the family of sock
+ *  @param[in] port port to bind
+ *  @param[in] backlog max length of the queue of pending connections
+ *  @param[in] flags OR of SOCKETCOM_LISTEN_FLAG
+ *  @retval SOCKETCOM_SUCCESS success
+ *  @retval !=SOCKETCOM_SUCCESS error
+ */
+int SocketCom_ListenEx(SocketCom *sock, const char *ip, u_short port, int backlog, int flags);
+
+/**
+ *  bind sock to ip and port without listening; for datagram socks
+ *
+ *  @param[in] ip IPv4 or IPv6 address to bind; NULL to bind to any address of the family of sock
+ *  @param[in] port port to bind; 0 for an ephemeral port
+ *  @retval SOCKETCOM_SUCCESS success
+ *  @retval SOCKETCOM_ERROR_BIND error
+ */
+int SocketCom_Bind(SocketCom *sock, const char *ip, u_short port);
 int SocketCom_Accept(SocketCom *sock,SocketCom *connectedSock);
+
+/**
+ *  accept all pending connections until the accept queue is empty
+ *  accepted socks are non-blocking and close-on-exec (accept4() with SOCK_NONBLOCK|SOCK_CLOEXEC on Linux)
+ *
+ *  @param[in] sock listening sock; if it is blocking, this call blocks only until the first connection
+ *  @param[out] connectedSocks accepted socks
+ *  @param[in/out] connectedSocks_len give length of connectedSocks, return number of accepted socks
+ *  @retval SOCKETCOM_SUCCESS at least one connection is accepted
+ *  @retval SOCKETCOM_ERROR_WOULDBLOCK non-blocking sock has no pending connection
+ *  @retval SOCKETCOM_ERROR_ACCEPT error
+ */
+int SocketCom_AcceptMany(SocketCom *sock, SocketCom connectedSocks[], int *connectedSocks_len);
 int SocketCom_SetAddrin(SocketCom* sock, const sockaddr_in *addr);
+
+/**
+ *  set the address to connect to
+ *
+ *  @param[in] addr sockaddr_in or sockaddr_in6
+ *  @param[in] addrlen length of addr
+ */
+int SocketCom_SetSockaddr(SocketCom* sock, const struct sockaddr *addr, socklen_t addrlen);
+
+/**
+ *  @param[in] ip IPv4 address such as 11.22.33.44, or IPv6 address such as ::1
+ *  @retval SOCKETCOM_SUCCESS success
+ *  @retval SOCKETCOM_ERROR_ILLEGAL_SOCK ip is not a dotted-quad IPv4 or an IPv6 address
+ */
 int SocketCom_SetAddr(SocketCom* sock, const char *ip, u_short port);
 
+/**
+ *  @return length of addr by its family; sizeof(struct sockaddr_storage) for an unknown family
+ */
+socklen_t SocketCom_SockaddrLen(const struct sockaddr_storage *addr);
+
 /**
  * set flag ON SO_REUSEADDR
  *
@@ -175,6 +427,48 @@ int SocketCom_SetAddr(SocketCom* sock, const char *ip, u_short port);
  */
 int SocketCom_SetReuseaddr(SocketCom *sock);
 
+/**
+ * set flag ON SO_REUSEPORT
+ *
+ *  @param[in] sock sock
+ *  @retval SOCKETCOM_ERROR_NOTSUPPORTED SO_REUSEPORT is not supported on the platform (e.g. WIN32)
+ */
+int SocketCom_SetReuseport(SocketCom *sock);
+
+/**
+ *  enable TCP Fast Open on sock to listen; call before listen()
+ *  SYNs carrying data are accepted with a cookie, and the data is receivable when the connection is accepted
+ *
+ *  @param[in] sock sock
+ *  @param[in] qlen max number of pending Fast Open requests; e.g. SOCKETCOM_FASTOPEN_QLEN
+ *  @retval SOCKETCOM_ERROR_SETFASTOPEN error on setsockopt(TCP_FASTOPEN)
+ *  @retval SOCKETCOM_ERROR_NOTSUPPORTED TCP Fast Open is not supported on the platform
+ */
+int SocketCom_SetFastOpen(SocketCom *sock, int qlen);
+
+/**
+ *  set TCP_NODELAY; disable (on!=0) or enable (on==0) Nagle's algorithm
+ *
+ *  @retval SOCKETCOM_ERROR_SETNODELAY error on setsockopt
+ */
+int SocketCom_SetNoDelay(SocketCom *sock, int on);
+
+/**
+ *  set TCP_CORK (TCP_NOPUSH on BSD): while on, partial frames are held until full; turning off sends them
+ *
+ *  @retval SOCKETCOM_ERROR_SETCORK error on setsockopt
+ *  @retval SOCKETCOM_ERROR_NOTSUPPORTED not supported on the platform (e.g. WIN32)
+ */
+int SocketCom_SetCork(SocketCom *sock, int on);
+
+/**
+ *  switch sock to blocking or non-blocking mode
+ *
+ *  @param[in] sock sock
+ */
+int SocketCom_SetBlockingSocket(SocketCom *sock);
+int SocketCom_SetNonBlockingSocket(SocketCom *sock);
+
 int SocketCom_Connect(SocketCom *sock);
 
 int SocketCom_ConnectTo(SocketCom *sock, const char *ip, u_short port);
@@ -203,6 +497,94 @@ int SocketCom_ConnectWithTimeout(SocketCom *sock, unsigned long timeout_msec);
  */
 int SocketCom_ConnectToWithTimeout(SocketCom* sock, const char *ip, u_short port, unsigned long timeout_msec);
 
+/**
+ *  start connect of non-blocking sock to the address by SetAddr(), for event loops
+ *
+ *  @retval SOCKETCOM_SUCCESS connected
+ *  @retval SOCKETCOM_ERROR_WOULDBLOCK in progress; call SocketCom_ConnectFinish() when sock becomes writable
+ *  @retval SOCKETCOM_ERROR_CONNECT error
+ */
+int SocketCom_ConnectStart(SocketCom *sock);
+
+/**
+ *  result of connect started by SocketCom_ConnectStart(), after sock became writable
+ *
+ *  @retval SOCKETCOM_SUCCESS connected
+ *  @retval SOCKETCOM_ERROR_CONNECT connect failed
+ *  @retval SOCKETCOM_ERROR_GETSOCKOPT error
+ */
+int SocketCom_ConnectFinish(SocketCom *sock);
+
+#define SOCKETCOM_CONNECT_MAX_ADDRS 16
+// delay between starting connection attempts to successive addresses (Connection Attempt Delay of RFC 8305)
+#define SOCKETCOM_CONNECT_ATTEMPT_DELAY_MSEC 250
+
+/**
+ *  connect to the first address which accepts the connection, racing addresses ("Happy Eyeballs", RFC 8305)
+ *
+ *  addresses are tried alternating IPv6 and IPv4, starting with the family of addrs[0];
+ *  a new attempt starts every SOCKETCOM_CONNECT_ATTEMPT_DELAY_MSEC or as soon as an attempt fails, while earlier attempts keep running.
+ *  the first connection wins, and the others are closed
+ *
+ *  @param[in/out] sock sock which is not created; created by the family of the winning address, and blocking
+ *  @param[in] addrs addresses (up to SOCKETCOM_CONNECT_MAX_ADDRS are used)
+ *  @param[in] addrs_len number of addrs
+ *  @param[in] port port to connect to; 0 to use ports of addrs
+ *  @param[in] timeout_msec timeout of the whole race; -1 for unlimited
+ *  @retval SOCKETCOM_SUCCESS success
+ *  @retval SOCKETCOM_ERROR_ALREADY_CREATED sock is created
+ *  @retval SOCKETCOM_ERROR_TIMEOUT_CONNECT timeout
+ *  @retval SOCKETCOM_ERROR_CONNECT all addresses refused
+ */
+int SocketCom_ConnectAddrs(SocketCom *sock, const struct sockaddr_storage addrs[], int addrs_len, u_short port, long timeout_msec);
+
+/**
+ *  resolve hostname to all its IPv4 and IPv6 addresses, and connect by SocketCom_ConnectAddrs()
+ *
+ *  @attention  hostname is resolved by a blocking getaddrinfo(); SocketCom_ResolverConnect() (SocketComResolver.h) resolves with cache
+ *  @retval SOCKETCOM_ERROR_SLAVEHOSTNAME error on resolving host name
+ *  @retval !=SOCKETCOM_SUCCESS same as SocketCom_ConnectAddrs()
+ */
+int SocketCom_ConnectHost(SocketCom *sock, const char *hostname, u_short port, long timeout_msec);
+
+// max number of events handled by one wait of SocketCom_ConnectMany()
+#define SOCKETCOM_CONNECT_MANY_EVENTS 256
+
+/**
+ *  connect many socks concurrently
+ *  connects of all socks are started at once without blocking, and waited for by one poller under one deadline,
+ *  so that the whole takes about the slowest handshake instead of the sum of them
+ *
+ *  @param[in/out] socks socks which are created and have addresses (SocketCom_SetAddr()); blocking mode of each sock is kept
+ *  @param[in] socks_len number of socks
+ *  @param[out] results result of each sock: SOCKETCOM_SUCCESS, SOCKETCOM_ERROR_TIMEOUT_CONNECT, SOCKETCOM_ERROR_CONNECT, ...
+ *  @param[in] timeout_msec timeout of the whole; -1 for unlimited
+ *  @retval SOCKETCOM_SUCCESS all socks are connected
+ *  @retval SOCKETCOM_ERROR_CONNECT some socks are not connected; see results, and dispose them
+ *  @retval SOCKETCOM_ERROR_MEMORY error; no connect is started
+ *  @retval SOCKETCOM_ERROR_FCNTL in results; the sock cannot be made non-blocking, and its connect is not started
+ *  @attention socks are polled by SocketCom_Poller: epoll on Linux and poll() on other POSIX, without a limit of the number of socks;
+ *             on Windows by select(), so at most FD_SETSIZE socks can be waited for
+ */
+int SocketCom_ConnectMany(SocketCom *socks[], int socks_len, int results[], long timeout_msec);
+
+/**
+ *  connect sock and send buf, carrying buf in the SYN by TCP Fast Open (MSG_FASTOPEN)
+ *  without a cookie of the server, the SYN requests one and buf is sent after the handshake, as by SocketCom_ConnectWithTimeout() and SocketCom_Send();
+ *  the same is done on platforms without TCP Fast Open
+ *
+ *  @param[in/out] sock created sock with address
+ *  @param[in] buf first data of the connection, e.g. a request
+ *  @param[in] bufLen length of buf; as much as fits in the SYN (about MSS) is carried in it, and the rest is sent after the handshake
+ *  @param[out] synData !=0 if data in the SYN was acknowledged by the server; can be NULL
+ *  @param[in] timeout_msec timeout of the handshake; -1 for unlimited
+ *  @retval SOCKETCOM_SUCCESS connected, and buf is sent
+ *  @retval SOCKETCOM_ERROR_TIMEOUT_CONNECT timeout
+ *  @retval SOCKETCOM_ERROR_SEND connected, and sending the rest of buf failed
+ *  @retval !=SOCKETCOM_SUCCESS error
+ */
+int SocketCom_ConnectSendFastOpen(SocketCom *sock, const void *buf, int bufLen, int *synData, long timeout_msec);
+
 int SocketCom_RecvExWithTimeout(SocketCom *sock,void *buf,int bufLen,int *recvLen,int flags,long timeout_sec,long timeout_usec);
 int SocketCom_RecvWithTimeout(SocketCom *sock,void *buf,int bufLen,int *recvLen,long timeout_sec,long timeout_usec);
 int SocketCom_WaitForRecvablesWithTimeout(SocketCom *socks[],int *socks_len,long timeout_sec,long timeout_usec);
@@ -248,18 +630,386 @@ int SocketCom_WaitForRecvable(SocketCom *sock);
  * @retval ==0(false) sock is not ready to receive
  */
 int SocketCom_IsRecvable(SocketCom *sock);
+
+/**
+ *  This function returns true if idle connection is still usable, without blocking
+ *  cheaper than SocketCom_IsRecvable(): on POSIX, one recv() with MSG_PEEK | MSG_DONTWAIT
+ *
+ * @param[in] sock connected sock which is expected to have nothing to receive
+ * @retval !=0(true) nothing to receive, and peer has not closed the connection
+ * @retval ==0(false) peer closed or reset the connection, or unexpected data is received
+ */
+int SocketCom_IsAlive(SocketCom *sock);
 int SocketCom_RecvEx(SocketCom *sock,void *buf,int bufLen,int *recvLen,int flags);
 int SocketCom_Recv(SocketCom *sock,void *buf,int bufLen,int *recvLen);
 int SocketCom_RecvAll(SocketCom *sock,void *buf,int recvLen);
 int SocketCom_Send(SocketCom *sock,const void *buf,int bufLen);
+
+/**
+ *  consume len bytes from the head of iov
+ *
+ *  @param[in/out] iov give head of buffers, return head of buffers not consumed
+ *  @param[in/out] iovcnt give number of buffers, return number of buffers not consumed (0 if all consumed)
+ *  @param[in] len consumed length
+ */
+void SocketCom_IoVecAdvance(SocketCom_IoVec **iov, int *iovcnt, size_t len);
+
+/**
+ *  send all buffers by as few syscalls as possible (sendmsg/WSASend)
+ *  partial writes and EINTR are resumed; on return, iov and iovcnt tell the part which is not sent yet
+ *
+ *  @param[in] sock sock
+ *  @param[in/out] iov give buffers to send, return buffers not sent (*iov is modified)
+ *  @param[in/out] iovcnt give number of buffers, return number of buffers not sent
+ *  @param[out] sentLen bytes sent by this call; may be NULL
+ *  @retval SOCKETCOM_SUCCESS all buffers are sent
+ *  @retval SOCKETCOM_ERROR_WOULDBLOCK non-blocking sock cannot send more now; call again with returned iov and iovcnt
+ *  @retval SOCKETCOM_ERROR_SEND error
+ */
+int SocketCom_SendV(SocketCom *sock, SocketCom_IoVec **iov, int *iovcnt, size_t *sentLen);
+
+/**
+ *  receive into buffers by one syscall (recvmsg/WSARecv)
+ *
+ *  @param[in] sock sock
+ *  @param[in/out] iov give buffers to fill, return buffers not filled (*iov is modified)
+ *  @param[in/out] iovcnt give number of buffers, return number of buffers not filled
+ *  @param[out] recvLen bytes received; may be NULL
+ *  @retval SOCKETCOM_SUCCESS success
+ *  @retval SOCKETCOM_ERROR_WOULDBLOCK non-blocking sock has no data
+ *  @retval SOCKETCOM_ERROR_DISCONNECTED peer closed the connection
+ *  @retval SOCKETCOM_ERROR_RECV error
+ */
+int SocketCom_RecvV(SocketCom *sock, SocketCom_IoVec **iov, int *iovcnt, size_t *recvLen);
+
+/**
+ *  receive until all buffers are filled
+ *  same as SocketCom_RecvV(), except for retrying until filled; on SOCKETCOM_ERROR_WOULDBLOCK or error, iov, iovcnt and recvLen tell the progress
+ */
+int SocketCom_RecvAllV(SocketCom *sock, SocketCom_IoVec **iov, int *iovcnt, size_t *recvLen);
+
+/**
+ *  set SO_BUSY_POLL (and SO_PREFER_BUSY_POLL): blocking receives and polls of sock spin on the device queue for busy_poll_usec
+ *  before sleeping. raising busy_poll_usec above net.core.busy_read needs CAP_NET_ADMIN
+ *
+ *  @param[in] sock sock
+ *  @param[in] busy_poll_usec time to busy poll; 0 to disable
+ *  @param[in] prefer !=0 to set SO_PREFER_BUSY_POLL, which defers device interrupts while the application busy polls
+ *  @retval SOCKETCOM_ERROR_SETBUSYPOLL error on setsockopt
+ *  @retval SOCKETCOM_ERROR_NOTSUPPORTED not supported on the platform (only Linux is supported)
+ */
+int SocketCom_SetBusyPoll(SocketCom *sock, int busy_poll_usec, int prefer);
+
+/**
+ *  spin-then-wait state for low latency receiving
+ *  a receive first spins on non-blocking recv() for spin_usec, and then waits blocking.
+ *  counters tell how often spinning found data, to tune spin_usec against CPU time
+ *
+ *  @attention  before to use struct SocketCom_BusyPoll, initialize by SocketCom_BusyPollInit()
+ *  @attention  spinning is done only on POSIX; on WIN32 receives wait at once
+ */
+typedef struct SocketCom_BusyPoll {
+  long spin_usec; // budget of spinning per receive
+
+  unsigned long long calls; // receives and waits
+  unsigned long long immediate; // data was ready at the first try
+  unsigned long long spin_hits; // data arrived while spinning
+  unsigned long long blocked; // spinning ran out and the thread waited
+  unsigned long long spin_polls; // non-blocking tries which found nothing
+  unsigned long long spin_usec_total; // time spent spinning
+} SocketCom_BusyPoll;
+
+/**
+ *  @param[in] spin_usec budget of spinning per receive; 0 for no spinning
+ */
+void SocketCom_BusyPollInit(SocketCom_BusyPoll *bp, long spin_usec);
+
+/**
+ *  receive with spinning for bp->spin_usec before waiting
+ *
+ *  @param[in/out] bp state and counters
+ *  @param[in] timeout_msec timeout of waiting after spinning; -1 for unlimited
+ *  @retval SOCKETCOM_SUCCESS success
+ *  @retval SOCKETCOM_ERROR_TIMEOUT_SELECT timeout
+ *  @retval SOCKETCOM_ERROR_DISCONNECTED peer closed the connection
+ *  @retval !=SOCKETCOM_SUCCESS error
+ */
+int SocketCom_RecvBusyPoll(SocketCom_BusyPoll *bp, SocketCom *sock, void *buf, int bufLen, int *recvLen, long timeout_msec);
+
+/**
+ *  SocketCom_WaitForRecvableWithTimeout() with spinning for bp->spin_usec before waiting
+ *
+ *  @retval SOCKETCOM_SUCCESS sock is recvable, or the peer closed the connection
+ *  @retval SOCKETCOM_ERROR_TIMEOUT_SELECT timeout
+ */
+int SocketCom_WaitForRecvableBusyPoll(SocketCom_BusyPoll *bp, SocketCom *sock, long timeout_msec);
+
+#define SOCKETCOM_ZEROCOPY_DEFAULT_THRESHOLD (16 * 1024)
+#define SOCKETCOM_ZEROCOPY_ID_NONE 0xffffffffU
+
+// max zero-copy sends in flight (multiple of 64); more sends are copied until completions are reaped
+#ifndef SOCKETCOM_ZEROCOPY_WINDOW
+#define SOCKETCOM_ZEROCOPY_WINDOW 1024
+#endif
+
+/**
+ *  zero-copy send state of a sock (MSG_ZEROCOPY on Linux)
+ *
+ *  each zero-copy send is numbered by the kernel from 0; the buffer must not be modified until the completion of its id is reaped
+ *  counters tell how often sends avoided the copy
+ *
+ *  @attention  before to use struct SocketCom_ZeroCopy, initialize by SocketCom_ZeroCopyInit()
+ */
+typedef struct SocketCom_ZeroCopy {
+  SocketCom *sock;
+  size_t threshold; // sends shorter than this are copied
+  int enabled; // SO_ZEROCOPY is enabled
+  unsigned int next_id; // id of the next zero-copy send
+  unsigned int completed_next; // all ids before this are completed
+  unsigned long long completed_bits[SOCKETCOM_ZEROCOPY_WINDOW / 64]; // ids completed out of order, by id % SOCKETCOM_ZEROCOPY_WINDOW
+
+  unsigned long long zerocopy_sends; // sends with MSG_ZEROCOPY
+  unsigned long long copied_sends; // sends copied because of threshold, no support or no optmem
+  unsigned long long completions; // completed zero-copy sends
+  unsigned long long kernel_copied; // completed zero-copy sends which the kernel copied anyway (e.g. loopback)
+} SocketCom_ZeroCopy;
+
+/**
+ *  range of zero-copy send ids [lo, hi]; completed ids reaped by SocketCom_ZeroCopyReap(), or ids of a buffer given to SocketCom_ZeroCopySend()
+ */
+typedef struct SocketCom_ZeroCopyRange {
+  unsigned int lo;
+  unsigned int hi;
+  int copied; // the kernel copied the data; zero-copy did not pay off (always 0 for SocketCom_ZeroCopySend())
+} SocketCom_ZeroCopyRange;
+
+/**
+ *  enable zero-copy send on sock
+ *  if the platform or the kernel does not support it, SocketCom_ZeroCopySend() always copies
+ *
+ *  @param[out] zc zero-copy state
+ *  @param[in] sock connected sock
+ *  @param[in] threshold sends shorter than this are copied; 0 for SOCKETCOM_ZEROCOPY_DEFAULT_THRESHOLD
+ *  @retval SOCKETCOM_SUCCESS success
+ *  @retval SOCKETCOM_ERROR_SETZEROCOPY the kernel refused SO_ZEROCOPY; zc is still usable and copies every send
+ *  @retval SOCKETCOM_ERROR_NOTSUPPORTED no zero-copy send on the platform; zc is still usable and copies every send
+ */
+int SocketCom_ZeroCopyInit(SocketCom_ZeroCopy *zc, SocketCom *sock, size_t threshold);
+
+/**
+ *  send buffer without copying it to the kernel if possible
+ *
+ *  @param[in/out] zc zero-copy state
+ *  @param[in] buf buffer; must not be modified until SocketCom_ZeroCopyIsCompleted() of ids is true
+ *  @param[in] bufLen length of buffer
+ *  @param[out] sentLen bytes sent; may be NULL
+ *  @param[out] ids first and last ids used for buf, which may be sent by several zero-copy sends;
+ *                  both SOCKETCOM_ZEROCOPY_ID_NONE if buf was copied and can be reused at once
+ *  @retval SOCKETCOM_SUCCESS success
+ *  @retval SOCKETCOM_ERROR_WOULDBLOCK non-blocking sock cannot send more now; *sentLen tells the progress
+ *  @retval SOCKETCOM_ERROR_SEND error
+ */
+int SocketCom_ZeroCopySend(SocketCom_ZeroCopy *zc, const void *buf, size_t bufLen, size_t *sentLen, SocketCom_ZeroCopyRange *ids);
+
+/**
+ *  read completions from the error queue of the sock (non-blocking)
+ *  the sock becomes SOCKETCOM_POLL_ERR in SocketCom_PollerWait() when completions are queued
+ *
+ *  @param[in/out] zc zero-copy state
+ *  @param[out] ranges completed ids; may be NULL to only update zc
+ *  @param[in/out] ranges_len give length of ranges, return number of ranges
+ *  @retval SOCKETCOM_SUCCESS success
+ *  @retval SOCKETCOM_ERROR_ERRQUEUE error
+ */
+int SocketCom_ZeroCopyReap(SocketCom_ZeroCopy *zc, SocketCom_ZeroCopyRange *ranges, int *ranges_len);
+
+/**
+ *  @param[in] ids ids of a buffer given by SocketCom_ZeroCopySend()
+ *  @retval !=0(true) every id of ids is completed, and the buffer can be reused
+ *  @retval ==0(false) the kernel may still read the buffer
+ */
+int SocketCom_ZeroCopyIsCompleted(const SocketCom_ZeroCopy *zc, const SocketCom_ZeroCopyRange *ids);
+
+/**
+ *  wait until all zero-copy sends are completed, unless timeout
+ *
+ *  @param[in] timeout_msec timeout(in milli second); -1 for unlimited
+ *  @retval SOCKETCOM_SUCCESS all buffers can be reused
+ *  @retval SOCKETCOM_ERROR_TIMEOUT timeout
+ *  @retval SOCKETCOM_ERROR_ERRQUEUE error, or the connection is reset or hung up with sends in flight
+ */
+int SocketCom_ZeroCopyFlush(SocketCom_ZeroCopy *zc, long timeout_msec);
+
+/**
+ *  send a part of file by the kernel (sendfile on Linux), without copying it to user space
+ *
+ *  if give timeout_msec = 0, non blockging(non wait); returns SOCKETCOM_ERROR_WOULDBLOCK when the sock cannot send more now
+ *  if give timeout_msec = -1, unlimited timeout
+ *
+ *  @param[in] sock connected sock
+ *  @param[in] fd file descriptor of file to send
+ *  @param[in] offset offset in file to start sending
+ *  @param[in] len bytes to send; -1 to send until end of file
+ *  @param[out] sentLen bytes sent by this call; may be NULL. resume by offset + *sentLen
+ *  @param[in] timeout_msec timeout(in milli second) of the whole transfer
+ *  @retval SOCKETCOM_SUCCESS success
+ *  @retval SOCKETCOM_ERROR_WOULDBLOCK sock cannot send more now (timeout_msec = 0)
+ *  @retval SOCKETCOM_ERROR_TIMEOUT timeout
+ *  @retval SOCKETCOM_ERROR_SENDFILE error of file, or file is shorter than len
+ *  @retval SOCKETCOM_ERROR_SEND error of sock
+ *  @retval SOCKETCOM_ERROR_NOTSUPPORTED this error occur on only WIN32
+ *
+ *  @attention sendfile()/splice() cannot suppress SIGPIPE; ignore SIGPIPE when the peer may close the connection
+ */
+int SocketCom_SendFile(SocketCom *sock, int fd, long long offset, long long len, long long *sentLen, long timeout_msec);
+
+/**
+ *  relay of bytes from a sock to another sock through a kernel pipe (splice on Linux), without copying them to user space
+ *  bytes which are read from the source but not written to the destination yet are kept in the relay
+ *
+ *  @attention  before to use struct SocketCom_Relay, initialize by SocketCom_RelayInit()
+ */
+typedef struct SocketCom_Relay {
+  int pipefd[2];
+  long long buffered; // bytes in the pipe
+} SocketCom_Relay;
+
+/**
+ *  @retval SOCKETCOM_ERROR_NOTSUPPORTED this error occur on other than Linux
+ */
+int SocketCom_RelayInit(SocketCom_Relay *relay);
+int SocketCom_RelayDestroy(SocketCom_Relay *relay);
+
+/**
+ *  move bytes from sock 'from' to sock 'to'
+ *
+ *  if give timeout_msec = 0, non blockging(non wait); if give timeout_msec = -1, unlimited timeout
+ *
+ *  @param[in/out] relay relay
+ *  @param[in] from source sock
+ *  @param[in] to destination sock
+ *  @param[in] len bytes to move; -1 to move until 'from' is disconnected
+ *  @param[out] movedLen bytes written to 'to' by this call; may be NULL
+ *  @param[in] timeout_msec timeout(in milli second) of the whole transfer
+ *  @retval SOCKETCOM_SUCCESS success (for len = -1, 'from' is disconnected and all bytes are written)
+ *  @retval SOCKETCOM_ERROR_WOULDBLOCK no progress is possible now (timeout_msec = 0)
+ *  @retval SOCKETCOM_ERROR_TIMEOUT timeout
+ *  @retval SOCKETCOM_ERROR_DISCONNECTED 'from' is disconnected before len bytes
+ *  @retval SOCKETCOM_ERROR_SPLICE error
+ */
+int SocketCom_RelayTransfer(SocketCom_Relay *relay, SocketCom *from, SocketCom *to, long long len, long long *movedLen, long timeout_msec);
+
+/**
+ *  send a datagram to addr
+ *
+ *  @retval SOCKETCOM_SUCCESS success
+ *  @retval SOCKETCOM_ERROR_WOULDBLOCK non-blocking sock cannot send now
+ *  @retval SOCKETCOM_ERROR_SEND error
+ */
+int SocketCom_SendTo(SocketCom *sock, const void *buf, int bufLen, const struct sockaddr_storage *addr);
+
+/**
+ *  receive a datagram
+ *
+ *  @param[out] recvLen length of the datagram (a datagram longer than bufLen is truncated)
+ *  @param[out] addr source address; may be NULL
+ *  @retval SOCKETCOM_SUCCESS success
+ *  @retval SOCKETCOM_ERROR_WOULDBLOCK non-blocking sock has no datagram
+ *  @retval SOCKETCOM_ERROR_RECV error
+ */
+int SocketCom_RecvFrom(SocketCom *sock, void *buf, int bufLen, int *recvLen, struct sockaddr_storage *addr);
+
+// max number of datagrams passed to one recvmmsg()/sendmmsg()
+#define SOCKETCOM_DGRAM_BATCH 64
+
+/**
+ *  datagram of SocketCom_RecvMany()/SocketCom_SendMany()
+ *
+ *  with GSO(UDP_SEGMENT) one send of len bytes leaves as datagrams of segSize bytes (the last may be shorter),
+ *  and with GRO(SocketCom_SetUdpGro()) one receive may return several datagrams of segSize bytes from the same source coalesced in buf
+ */
+typedef struct SocketCom_Datagram {
+  void *buf;
+  size_t len; // send: length to send. recv: give size of buf, return received length
+  struct sockaddr_storage addr; // send: destination; AF_UNSPEC(zero) for the peer of connected sock. recv: source
+  int segSize; // send: GSO segment size, 0 not to segment. recv: size of coalesced datagrams, 0 if not coalesced
+} SocketCom_Datagram;
+
+/**
+ *  receive datagrams by one syscall (recvmmsg() on Linux)
+ *  waits for the first datagram as the sock does (blocking or not), and then takes only datagrams already queued
+ *
+ *  @param[in/out] dgrams give buffers, return datagrams
+ *  @param[in/out] dgrams_len give length of dgrams, return number of received datagrams
+ *  @retval SOCKETCOM_SUCCESS at least one datagram is received
+ *  @retval SOCKETCOM_ERROR_WOULDBLOCK non-blocking sock has no datagram
+ *  @retval SOCKETCOM_ERROR_RECV error
+ *
+ *  @attention  on WIN32 one datagram is received per call
+ */
+int SocketCom_RecvMany(SocketCom *sock, SocketCom_Datagram dgrams[], int *dgrams_len);
+
+/**
+ *  send datagrams by as few syscalls as possible (sendmmsg() on Linux)
+ *
+ *  @param[in] dgrams datagrams
+ *  @param[in/out] dgrams_len give number of datagrams, return number of sent datagrams
+ *  @retval SOCKETCOM_SUCCESS all datagrams are sent
+ *  @retval SOCKETCOM_ERROR_WOULDBLOCK non-blocking sock cannot send more now; dgrams_len tells how many are sent
+ *  @retval SOCKETCOM_ERROR_NOTSUPPORTED segSize is given on a platform without UDP_SEGMENT
+ *  @retval SOCKETCOM_ERROR_SEND error
+ */
+int SocketCom_SendMany(SocketCom *sock, const SocketCom_Datagram dgrams[], int *dgrams_len);
+
+/**
+ *  enable or disable GRO(UDP_GRO) on datagram sock; buffers given to SocketCom_RecvMany() should be 64KB
+ *
+ *  @retval SOCKETCOM_SUCCESS success
+ *  @retval SOCKETCOM_ERROR_NOTSUPPORTED the platform has no UDP_GRO
+ *  @retval SOCKETCOM_ERROR_SETUDPGRO error
+ */
+int SocketCom_SetUdpGro(SocketCom *sock, int on);
 int SocketCom_IsClient(const SocketCom* sock);
 int SocketCom_IsServer(const SocketCom* sock);
 int SocketCom_HasAddr(const SocketCom* sock);
 int SocketCom_GetAddrin(const SocketCom *sock, sockaddr_in *addrin);
+int SocketCom_GetSockaddr(const SocketCom *sock, struct sockaddr_storage *addr);
 int SocketCom_IsReady(const SocketCom* sock);
 int SocketCom_GetPort(const SocketCom *sock, u_short *port);
+
+/**
+ *  @param[out] ipstr IPv4 or IPv6 address; SOCKETCOM_IP_STR_SIZE bytes
+ */
 int SocketCom_GetIpStr(SocketCom *sock,char *ipstr);
 
+/**
+ *  state of a TCP connection in the kernel (TCP_INFO)
+ */
+typedef struct SocketCom_TcpInfo {
+  unsigned int state; // TCP_ESTABLISHED etc.
+  unsigned int rtt_usec; // smoothed round trip time
+  unsigned int rttvar_usec;
+  unsigned int retransmits; // retransmissions of the current segment
+  unsigned int total_retrans; // retransmitted segments since connected
+  unsigned int lost; // segments considered lost
+  unsigned int unacked; // segments sent and not acknowledged
+  unsigned int snd_cwnd; // congestion window in segments
+  unsigned int snd_ssthresh;
+  unsigned int snd_mss;
+  unsigned int rcv_mss;
+  unsigned int options; // TCPI_OPT_* of <netinet/tcp.h>
+} SocketCom_TcpInfo;
+
+/**
+ *  get TCP_INFO of connected sock
+ *
+ *  @param[out] info info
+ *  @retval SOCKETCOM_SUCCESS success
+ *  @retval SOCKETCOM_ERROR_GETSOCKOPT error on getsockopt
+ *  @retval SOCKETCOM_ERROR_NOTSUPPORTED TCP_INFO is not supported on the platform (only Linux is supported)
+ */
+int SocketCom_GetTcpInfo(const SocketCom *sock, SocketCom_TcpInfo *info);
+
 /**
  * compare SocketCom
  *
@@ -283,8 +1033,114 @@ int SocketCom_Equal(const SocketCom* sock1, const SocketCom* sock2);
  * @retval SOCKETCOM_ERROR_SLAVEHOSTNAME error on resolving host name
  *
  * @attension if this optaions multiple IP addresses, returns first one
+ * @attention this function blocks on every call; SocketCom_Resolver (SocketComResolver.h) resolves asynchronously with cache
  */
 int SocketCom_ResolveHostname(const char *hostname, char *ip_str);
 
+/**
+ *  events of SocketCom_Poller
+ *
+ *  SOCKETCOM_POLL_IN, SOCKETCOM_POLL_OUT, SOCKETCOM_POLL_ET and SOCKETCOM_POLL_ONESHOT are given to SocketCom_PollerAdd()/SocketCom_PollerModify()
+ *  SOCKETCOM_POLL_ERR and SOCKETCOM_POLL_HUP are always reported by SocketCom_PollerWait() and need not be given
+ */
+enum SOCKETCOM_POLL {
+  SOCKETCOM_POLL_IN = 0x01,
+  SOCKETCOM_POLL_OUT = 0x02,
+  SOCKETCOM_POLL_ERR = 0x04,
+  SOCKETCOM_POLL_HUP = 0x08,
+  SOCKETCOM_POLL_ET = 0x10, // edge-triggered; level-triggered if not given
+  SOCKETCOM_POLL_ONESHOT = 0x20, // disabled after one event until SocketCom_PollerModify()
+};
+
+typedef struct SocketCom_PollEvent {
+  SocketCom *sock;
+  int events;
+} SocketCom_PollEvent;
+
+/**
+ *  persistent interest set of sockets (epoll on Linux, poll on other POSIX, select on WIN32)
+ *
+ *  @attention  before to use struct SocketCom_Poller, initialize by SocketCom_PollerCreate()
+ *  @attention  a registered SocketCom must not be moved in memory and must be removed before SocketCom_Dispose()
+ */
+typedef struct SocketCom_Poller {
+#ifdef _SOCKETCOM_LINUX_
+  int epfd;
+  void *events; // struct epoll_event[max_events]
+  int max_events;
+#else
+  SocketCom **socks;
+  int *interests;
+  void *pfds; // struct pollfd[capacity] (POSIX)
+  int count;
+  int capacity;
+#endif
+} SocketCom_Poller;
+
+/**
+ *  create poller
+ *
+ *  @param[out] poller poller
+ *  @param[in] max_events max number of events returned by one SocketCom_PollerWait()
+ *  @retval SOCKETCOM_SUCCESS success
+ *  @retval !=SOCKETCOM_SUCCESS error
+ */
+int SocketCom_PollerCreate(SocketCom_Poller *poller, int max_events);
+
+/**
+ *  destroy poller; registered sockets are not closed
+ *
+ *  @param[in/out] poller poller
+ */
+int SocketCom_PollerDestroy(SocketCom_Poller *poller);
+
+/**
+ *  register sock to poller
+ *
+ *  @param[in/out] poller poller
+ *  @param[in] sock sock
+ *  @param[in] events OR of SOCKETCOM_POLL_IN, SOCKETCOM_POLL_OUT, SOCKETCOM_POLL_ET, SOCKETCOM_POLL_ONESHOT
+ *  @retval SOCKETCOM_SUCCESS success
+ *  @retval SOCKETCOM_ERROR_POLLER_FULL too many sockets for select(); this error occur on only non-Linux
+ *
+ *  @attention SOCKETCOM_POLL_ET is ignored(level-triggered) on non-Linux
+ */
+int SocketCom_PollerAdd(SocketCom_Poller *poller, SocketCom *sock, int events);
+
+/**
+ *  change events of sock registered to poller (also re-arm SOCKETCOM_POLL_ONESHOT)
+ */
+int SocketCom_PollerModify(SocketCom_Poller *poller, SocketCom *sock, int events);
+
+/**
+ *  unregister sock from poller
+ */
+int SocketCom_PollerRemove(SocketCom_Poller *poller, SocketCom *sock);
+
+/**
+ *  wait for events of registered sockets, unless timeout
+ *
+ *  if give timeout_sec = 0 and timeout_usec = 0, non blockging(non wait)
+ *  if give timeout_sec = -1 or timeout_usec = -1, unlimited timeout(wait until at least one event)
+ *
+ *  @param[in/out] poller poller
+ *  @param[out] events ready sockets and their events
+ *  @param[in/out] events_len give length of events, return number of ready sockets
+ *  @param[in] timeout_sec timeout(in second)
+ *  @param[in] timeout_usec timeout(in micro second)
+ *  @retval SOCKETCOM_SUCCESS success
+ *  @retval SOCKETCOM_ERROR_TIMEOUT_POLLER timeout
+ *  @retval !=SOCKETCOM_SUCCESS error
+ */
+int SocketCom_PollerWait(SocketCom_Poller *poller, SocketCom_PollEvent *events, int *events_len, long timeout_sec, long timeout_usec);
+
+/**
+ *  convert timeout_sec and timeout_usec of SocketCom API to milli seconds of poll(), epoll_wait() and io_uring waits
+ *  a part of a milli second is rounded up, so that a short timeout does not become busy wait, and a long one saturates
+ *
+ *  @return msec; -1 if timeout_sec or timeout_usec is negative (unlimited); at most INT_MAX
+ */
+int SocketCom_ToMsec(long timeout_sec, long timeout_usec);
+
 #endif
 
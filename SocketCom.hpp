@@ -0,0 +1,473 @@
+/*
+SocketCom
+
+Copyright (c) 2017 r01hee
+
+This software is released under the MIT License.
+http://opensource.org/licenses/mit-license.php
+*/
+
+#ifndef __SOCKETCOM_HPP__
+#define __SOCKETCOM_HPP__
+
+/*
+ * header-only C++20 layer over SocketCom
+ *
+ * socketcom::Socket<Mode, Kind, Stats> owns a SocketCom: it is move-only, and disposed when destroyed.
+ * the state of the C struct is encoded in the type instead of checked at runtime:
+ *   Mode  Blocking or NonBlocking; blocking-only operations such as sendAll() do not compile for NonBlocking
+ *   Kind  Stream (connection), Listener or Datagram; e.g. recv() of a Listener or sendTo() of a Stream do not compile
+ *   Stats NoStats or WithStats; WithStats counts I/O of recv()/send() into SocketCom_Stats (needs SOCKETCOM_USE_STATS)
+ *
+ * a socket is obtained by the static functions connect()/listen()/bind()/open() and by accept(), which fail without
+ * changing the output on error. recv()/send() are the bare syscall with no status checks; a default constructed
+ * (empty) socket fails them with the error of the syscall.
+ * errors are SOCKETCOM_ERROR codes as in the C API
+ */
+
+#include "SocketComStats.h"
+
+#include <climits>
+#include <cstddef>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+#ifndef _SOCKETCOM_WIN32_
+#include <errno.h>
+#endif
+
+namespace socketcom {
+
+struct Blocking {};
+struct NonBlocking {};
+
+struct Stream {};
+struct Listener {};
+struct Datagram {};
+
+struct NoStats {};
+struct WithStats {};
+
+/**
+ *  result of one I/O; len is bytes done when res is SOCKETCOM_SUCCESS
+ */
+struct [[nodiscard]] IoResult {
+  int res;
+  std::size_t len;
+
+  explicit operator bool() const noexcept { return res == SOCKETCOM_SUCCESS; }
+};
+
+namespace detail {
+
+#ifdef _SOCKETCOM_WIN32_
+inline int last_error() noexcept { return WSAGetLastError(); }
+inline bool is_eintr(int err) noexcept { return err == WSAEINTR; }
+inline bool is_wouldblock(int err) noexcept { return err == WSAEWOULDBLOCK; }
+constexpr int kNoSignal = 0;
+using ssize = int;
+#else
+inline int last_error() noexcept { return errno; }
+inline bool is_eintr(int err) noexcept { return err == EINTR; }
+inline bool is_wouldblock(int err) noexcept { return err == EAGAIN || err == EWOULDBLOCK; }
+#ifdef MSG_NOSIGNAL
+constexpr int kNoSignal = MSG_NOSIGNAL;
+#else
+constexpr int kNoSignal = 0;
+#endif
+using ssize = ssize_t;
+#endif
+
+// one send()/recv() takes at most INT_MAX bytes (the length is int on Windows);
+// a larger Stream buffer is done partially, as a short send()/recv()
+inline int io_len(std::size_t len) noexcept { return (len > static_cast<std::size_t>(INT_MAX)) ? INT_MAX : static_cast<int>(len); }
+
+template <class T, class... U>
+constexpr bool is_any_of = (std::is_same_v<T, U> || ...);
+
+} // namespace detail
+
+/**
+ *  build the address of ip (IPv4 or IPv6) and port, e.g. for sendTo()
+ */
+inline int address(const char *ip, u_short port, struct sockaddr_storage &addr) noexcept
+{
+  SocketCom tmp;
+  SocketCom_Init(&tmp);
+  int res = SocketCom_SetAddr(&tmp, ip, port);
+  if (res != SOCKETCOM_SUCCESS) {
+    return res;
+  }
+  return SocketCom_GetSockaddr(&tmp, &addr);
+}
+
+template <class Mode = Blocking, class Kind = Stream, class Stats = NoStats>
+class Socket {
+  static_assert(detail::is_any_of<Mode, Blocking, NonBlocking>, "Mode must be Blocking or NonBlocking");
+  static_assert(detail::is_any_of<Kind, Stream, Listener, Datagram>, "Kind must be Stream, Listener or Datagram");
+  static_assert(detail::is_any_of<Stats, NoStats, WithStats>, "Stats must be NoStats or WithStats");
+#ifndef SOCKETCOM_USE_STATS
+  static_assert(!std::is_same_v<Stats, WithStats>, "WithStats needs SOCKETCOM_USE_STATS");
+#endif
+
+  template <class, class, class> friend class Socket;
+
+  static constexpr bool kBlocking = std::is_same_v<Mode, Blocking>;
+  static constexpr bool kStream = std::is_same_v<Kind, Stream>;
+  static constexpr bool kListener = std::is_same_v<Kind, Listener>;
+  static constexpr bool kDatagram = std::is_same_v<Kind, Datagram>;
+
+public:
+  Socket() noexcept { SocketCom_Init(&sock_); }
+  ~Socket() { reset(); }
+
+  Socket(const Socket &) = delete;
+  Socket &operator=(const Socket &) = delete;
+
+  Socket(Socket &&other) noexcept : sock_(other.sock_) { other.sock_.status = SOCKETCOM_STATE_NONE; }
+
+  Socket &operator=(Socket &&other) noexcept
+  {
+    if (this != &other) {
+      reset();
+      sock_ = other.sock_;
+      other.sock_.status = SOCKETCOM_STATE_NONE;
+    }
+    return *this;
+  }
+
+  /**
+   *  connect to ip and port
+   *
+   *  @param[in] timeout_msec timeout; -1 for unlimited
+   */
+  static int connect(Socket &out, const char *ip, u_short port, long timeout_msec = -1) noexcept requires std::is_same_v<Kind, Stream>
+  {
+    Socket sock;
+    struct sockaddr_storage addr;
+    int res = address(ip, port, addr);
+    if (res != SOCKETCOM_SUCCESS) {
+      return res;
+    }
+    res = SocketCom_CreateEx(&sock.sock_, addr.ss_family, SOCK_STREAM);
+    if (res == SOCKETCOM_SUCCESS) {
+      res = SocketCom_SetSockaddr(&sock.sock_, (const struct sockaddr *)&addr, SocketCom_SockaddrLen(&addr));
+    }
+    if (res == SOCKETCOM_SUCCESS) {
+      res = (timeout_msec < 0) ? SocketCom_Connect(&sock.sock_) : SocketCom_ConnectWithTimeout(&sock.sock_, (unsigned long)timeout_msec);
+    }
+    return sock.finish(out, res);
+  }
+
+  /**
+   *  resolve hostname and connect by SocketCom_ConnectHost()
+   */
+  static int connectHost(Socket &out, const char *hostname, u_short port, long timeout_msec) noexcept requires std::is_same_v<Kind, Stream>
+  {
+    Socket sock;
+    return sock.finish(out, SocketCom_ConnectHost(&sock.sock_, hostname, port, timeout_msec));
+  }
+
+  /**
+   *  listen on ip (NULL for any IPv4 address) and port
+   *
+   *  @param[in] flags OR of SOCKETCOM_LISTEN_FLAG
+   */
+  static int listen(Socket &out, const char *ip, u_short port, int backlog = SOCKETCOM_LISTEN_BACKLOG, int flags = SOCKETCOM_LISTEN_FLAGS) noexcept requires std::is_same_v<Kind, Listener>
+  {
+    Socket sock;
+    int family = (ip != NULL && address(ip, port, sock.sock_.addr) == SOCKETCOM_SUCCESS) ? sock.sock_.addr.ss_family : AF_INET;
+    int res = SocketCom_CreateEx(&sock.sock_, family, SOCK_STREAM);
+    if (res == SOCKETCOM_SUCCESS) {
+      res = SocketCom_ListenEx(&sock.sock_, ip, port, backlog, flags);
+    }
+    return sock.finish(out, res);
+  }
+
+  /**
+   *  datagram socket bound to ip (NULL for any IPv4 address) and port
+   */
+  static int bind(Socket &out, const char *ip, u_short port) noexcept requires std::is_same_v<Kind, Datagram>
+  {
+    Socket sock;
+    int family = (ip != NULL && address(ip, port, sock.sock_.addr) == SOCKETCOM_SUCCESS) ? sock.sock_.addr.ss_family : AF_INET;
+    int res = SocketCom_CreateEx(&sock.sock_, family, SOCK_DGRAM);
+    if (res == SOCKETCOM_SUCCESS) {
+      res = SocketCom_Bind(&sock.sock_, ip, port);
+    }
+    return sock.finish(out, res);
+  }
+
+  /**
+   *  unbound datagram socket of family, for sendTo()
+   */
+  static int open(Socket &out, int family = AF_INET) noexcept requires std::is_same_v<Kind, Datagram>
+  {
+    Socket sock;
+    return sock.finish(out, SocketCom_CreateEx(&sock.sock_, family, SOCK_DGRAM));
+  }
+
+  /**
+   *  accept a connection into conn, which may have another Mode and Stats than the listener
+   *
+   *  @retval SOCKETCOM_ERROR_WOULDBLOCK no pending connection on a NonBlocking listener
+   */
+  template <class ConnMode, class ConnStats>
+  int accept(Socket<ConnMode, Stream, ConnStats> &conn) noexcept requires std::is_same_v<Kind, Listener>
+  {
+    Socket<ConnMode, Stream, ConnStats> sock;
+    int res;
+
+    if constexpr (kBlocking) {
+      res = SocketCom_Accept(&sock_, &sock.sock_);
+      if (res == SOCKETCOM_SUCCESS && !std::is_same_v<ConnMode, Blocking>) {
+        res = SocketCom_SetNonBlockingSocket(&sock.sock_);
+      }
+    } else {
+      // accepted socks are non-blocking
+      int len = 1;
+      res = SocketCom_AcceptMany(&sock_, &sock.sock_, &len);
+      if (res == SOCKETCOM_SUCCESS && std::is_same_v<ConnMode, Blocking>) {
+        res = SocketCom_SetBlockingSocket(&sock.sock_);
+      }
+    }
+    if (res != SOCKETCOM_SUCCESS) {
+      return res;
+    }
+    conn = std::move(sock);
+    return SOCKETCOM_SUCCESS;
+  }
+
+  /**
+   *  receive by one syscall
+   *
+   *  @retval SOCKETCOM_ERROR_WOULDBLOCK NonBlocking socket has no data
+   *  @retval SOCKETCOM_ERROR_DISCONNECTED the peer closed the Stream
+   */
+  IoResult recv(std::span<std::byte> buf) noexcept requires (!std::is_same_v<Kind, Listener>)
+  {
+    while (true) {
+      detail::ssize n = ::recv(sock_.fd, reinterpret_cast<char *>(buf.data()), detail::io_len(buf.size()), 0);
+      count(SOCKETCOM_STATS_DIR_RECV, n, static_cast<std::size_t>(detail::io_len(buf.size())));
+      if (n > 0 || (n == 0 && (kDatagram || buf.empty()))) {
+        return {SOCKETCOM_SUCCESS, static_cast<std::size_t>(n)};
+      }
+      if (n == 0) {
+        return {SOCKETCOM_ERROR_DISCONNECTED, 0};
+      }
+      int err = detail::last_error();
+      if (detail::is_eintr(err)) {
+        continue;
+      }
+      return {detail::is_wouldblock(err) ? SOCKETCOM_ERROR_WOULDBLOCK : SOCKETCOM_ERROR_RECV, 0};
+    }
+  }
+
+  /**
+   *  send by one syscall; a Stream may send less than buf
+   *
+   *  @retval SOCKETCOM_ERROR_WOULDBLOCK NonBlocking socket cannot send now
+   *  @retval SOCKETCOM_ERROR_SEND error, or a datagram longer than INT_MAX
+   */
+  IoResult send(std::span<const std::byte> buf) noexcept requires (!std::is_same_v<Kind, Listener>)
+  {
+    if constexpr (kDatagram) {
+      if (buf.size() > static_cast<std::size_t>(INT_MAX)) {
+        return {SOCKETCOM_ERROR_SEND, 0};
+      }
+    }
+    while (true) {
+      detail::ssize n = ::send(sock_.fd, reinterpret_cast<const char *>(buf.data()), detail::io_len(buf.size()), detail::kNoSignal);
+      count(SOCKETCOM_STATS_DIR_SEND, n, static_cast<std::size_t>(detail::io_len(buf.size())));
+      if (n >= 0) {
+        return {SOCKETCOM_SUCCESS, static_cast<std::size_t>(n)};
+      }
+      int err = detail::last_error();
+      if (detail::is_eintr(err)) {
+        continue;
+      }
+      return {detail::is_wouldblock(err) ? SOCKETCOM_ERROR_WOULDBLOCK : SOCKETCOM_ERROR_SEND, 0};
+    }
+  }
+
+  /**
+   *  receive until buf is filled
+   */
+  int recvAll(std::span<std::byte> buf) noexcept requires (std::is_same_v<Mode, Blocking> && std::is_same_v<Kind, Stream>)
+  {
+    while (!buf.empty()) {
+      IoResult r = recv(buf);
+      if (!r) {
+        return r.res;
+      }
+      buf = buf.subspan(r.len);
+    }
+    return SOCKETCOM_SUCCESS;
+  }
+
+  /**
+   *  send all of buf
+   */
+  int sendAll(std::span<const std::byte> buf) noexcept requires (std::is_same_v<Mode, Blocking> && std::is_same_v<Kind, Stream>)
+  {
+    while (!buf.empty()) {
+      IoResult r = send(buf);
+      if (!r) {
+        return r.res;
+      }
+      buf = buf.subspan(r.len);
+    }
+    return SOCKETCOM_SUCCESS;
+  }
+
+  /**
+   *  send a datagram to addr (see socketcom::address())
+   *
+   *  @retval SOCKETCOM_ERROR_SEND error, or buf longer than INT_MAX
+   */
+  IoResult sendTo(std::span<const std::byte> buf, const struct sockaddr_storage &addr) noexcept requires std::is_same_v<Kind, Datagram>
+  {
+    if (buf.size() > static_cast<std::size_t>(INT_MAX)) {
+      return {SOCKETCOM_ERROR_SEND, 0};
+    }
+    while (true) {
+      detail::ssize n = ::sendto(sock_.fd, reinterpret_cast<const char *>(buf.data()), static_cast<int>(buf.size()), detail::kNoSignal,
+                                 reinterpret_cast<const struct sockaddr *>(&addr), SocketCom_SockaddrLen(&addr));
+      count(SOCKETCOM_STATS_DIR_SEND, n, buf.size());
+      if (n >= 0) {
+        return {SOCKETCOM_SUCCESS, static_cast<std::size_t>(n)};
+      }
+      int err = detail::last_error();
+      if (detail::is_eintr(err)) {
+        continue;
+      }
+      return {detail::is_wouldblock(err) ? SOCKETCOM_ERROR_WOULDBLOCK : SOCKETCOM_ERROR_SEND, 0};
+    }
+  }
+
+  /**
+   *  receive a datagram and its sender
+   */
+  IoResult recvFrom(std::span<std::byte> buf, struct sockaddr_storage &addr) noexcept requires std::is_same_v<Kind, Datagram>
+  {
+    while (true) {
+      socklen_t addrlen = sizeof(struct sockaddr_storage);
+      detail::ssize n = ::recvfrom(sock_.fd, reinterpret_cast<char *>(buf.data()), detail::io_len(buf.size()), 0,
+                                   reinterpret_cast<struct sockaddr *>(&addr), &addrlen);
+      count(SOCKETCOM_STATS_DIR_RECV, n, 0);
+      if (n >= 0) {
+        return {SOCKETCOM_SUCCESS, static_cast<std::size_t>(n)};
+      }
+      int err = detail::last_error();
+      if (detail::is_eintr(err)) {
+        continue;
+      }
+      return {detail::is_wouldblock(err) ? SOCKETCOM_ERROR_WOULDBLOCK : SOCKETCOM_ERROR_RECV, 0};
+    }
+  }
+
+  /**
+   *  graceful close by SocketCom_CloseWithTimeout(); the socket becomes empty
+   */
+  int close(long timeout_msec = SOCKETCOM_CLOSE_TIMEOUT_MSEC) noexcept requires std::is_same_v<Kind, Stream>
+  {
+    if (!*this) {
+      return SOCKETCOM_ERROR_ALREADY_CLOSED;
+    }
+    int res = SocketCom_CloseWithTimeout(&sock_, timeout_msec);
+    sock_.status = SOCKETCOM_STATE_NONE;
+    return res;
+  }
+
+  /**
+   *  dispose the socket at once; the socket becomes empty
+   */
+  void reset() noexcept
+  {
+    if (*this) {
+      SocketCom_Dispose(&sock_);
+    }
+    sock_.status = SOCKETCOM_STATE_NONE;
+  }
+
+  /**
+   *  take ownership of sock, which must be created and in the state of Mode and Kind (e.g. connecting for Stream)
+   */
+  static Socket adopt(SocketCom sock) noexcept
+  {
+    Socket out;
+    out.sock_ = sock;
+    return out;
+  }
+
+  /**
+   *  give up ownership of the SocketCom; the socket becomes empty
+   */
+  SocketCom release() noexcept
+  {
+    SocketCom sock = sock_;
+    sock_.status = SOCKETCOM_STATE_NONE;
+    return sock;
+  }
+
+#ifdef SOCKETCOM_USE_STATS
+  /**
+   *  counters of the socket and TCP_INFO
+   */
+  SocketCom_StatsSnapshot stats() const noexcept requires std::is_same_v<Stats, WithStats>
+  {
+    SocketCom_StatsSnapshot snapshot;
+    SocketCom_StatsGet(&sock_, &snapshot);
+    return snapshot;
+  }
+#endif
+
+  /**
+   *  the SocketCom, for the C API such as SocketCom_PollerAdd()
+   */
+  SocketCom *get() noexcept { return &sock_; }
+  const SocketCom *get() const noexcept { return &sock_; }
+
+  explicit operator bool() const noexcept { return (sock_.status & SOCKETCOM_STATE_CREATED) != 0; }
+
+private:
+  /**
+   *  move the socket to out on success, with the fd in Mode
+   */
+  int finish(Socket &out, int res) noexcept
+  {
+    if (res == SOCKETCOM_SUCCESS && !kBlocking) {
+      res = SocketCom_SetNonBlockingSocket(&sock_);
+    }
+    if (res != SOCKETCOM_SUCCESS) {
+      return res;
+    }
+    out = std::move(*this);
+    return SOCKETCOM_SUCCESS;
+  }
+
+  void count(int dir, detail::ssize n, std::size_t want) noexcept
+  {
+#ifdef SOCKETCOM_USE_STATS
+    if constexpr (std::is_same_v<Stats, WithStats>) {
+      SocketCom_StatsCount(&sock_, dir, n, want, (n < 0) ? detail::last_error() : 0);
+    }
+#else
+    (void)dir; (void)n; (void)want;
+#endif
+  }
+
+  SocketCom sock_;
+};
+
+using TcpStream = Socket<Blocking, Stream>;
+using TcpListener = Socket<Blocking, Listener>;
+using UdpSocket = Socket<Blocking, Datagram>;
+using AsyncTcpStream = Socket<NonBlocking, Stream>;
+using AsyncTcpListener = Socket<NonBlocking, Listener>;
+using AsyncUdpSocket = Socket<NonBlocking, Datagram>;
+
+} // namespace socketcom
+
+#endif
@@ -0,0 +1,157 @@
+/*
+SocketCom
+
+Copyright (c) 2017 r01hee
+
+This software is released under the MIT License.
+http://opensource.org/licenses/mit-license.php
+*/
+
+#include "SocketComBufPool.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+#ifdef _SOCKETCOM_POSIX_
+#include <sys/socket.h>
+#define SOCKETCOM_BUFPOOL_RECV_FLAGS MSG_DONTWAIT
+#else
+// no per-call flag; the sock must be non-blocking
+#define SOCKETCOM_BUFPOOL_RECV_FLAGS 0
+#endif
+
+int SocketCom_BufPoolCreate(SocketCom_BufPool *pool, int buf_size, int count)
+{
+  int i;
+
+  memset(pool, 0, sizeof(SocketCom_BufPool));
+  if (count <= 0) {
+    return SOCKETCOM_ERROR_MEMORY;
+  }
+  pool->buf_size = (buf_size > 0) ? buf_size : SOCKETCOM_BUFPOOL_DEFAULT_BUF_SIZE;
+  pool->count = count;
+
+  // pages of the slab are touched only when their buffers are first used
+  pool->slab = (char *)malloc((size_t)pool->buf_size * count);
+  pool->refs = (int *)calloc(count, sizeof(int));
+  pool->free_list = (int *)malloc(sizeof(int) * count);
+  if (pool->slab == NULL || pool->refs == NULL || pool->free_list == NULL) {
+    SocketCom_BufPoolDestroy(pool);
+    return SOCKETCOM_ERROR_MEMORY;
+  }
+
+  // buffer 0 on the top
+  for (i = 0; i < count; i++) {
+    pool->free_list[i] = count - 1 - i;
+  }
+  pool->free_len = count;
+
+  return SOCKETCOM_SUCCESS;
+}
+
+int SocketCom_BufPoolDestroy(SocketCom_BufPool *pool)
+{
+  free(pool->slab);
+  free(pool->refs);
+  free(pool->free_list);
+  memset(pool, 0, sizeof(SocketCom_BufPool));
+  return SOCKETCOM_SUCCESS;
+}
+
+static void SocketCom_BufPoolUse(SocketCom_BufPool *pool, int index, int len, SocketCom_BufSlice *slice)
+{
+  pool->refs[index] = 1;
+  pool->in_use++;
+  if (pool->in_use > pool->high_water) {
+    pool->high_water = pool->in_use;
+  }
+  pool->takes++;
+
+  slice->pool = pool;
+  slice->data = pool->slab + (size_t)pool->buf_size * index;
+  slice->len = len;
+  slice->index = index;
+}
+
+int SocketCom_BufPoolTake(SocketCom_BufPool *pool, SocketCom_BufSlice *slice)
+{
+  if (pool->free_len == 0) {
+    pool->exhausted++;
+    memset(slice, 0, sizeof(SocketCom_BufSlice));
+    return SOCKETCOM_ERROR_BUFPOOL_EMPTY;
+  }
+
+  SocketCom_BufPoolUse(pool, pool->free_list[--pool->free_len], pool->buf_size, slice);
+  return SOCKETCOM_SUCCESS;
+}
+
+int SocketCom_BufPoolClaim(SocketCom_BufPool *pool, int index, int len, SocketCom_BufSlice *slice)
+{
+  if (index < 0 || index >= pool->count || pool->refs[index] != 0 || len < 0 || len > pool->buf_size) {
+    memset(slice, 0, sizeof(SocketCom_BufSlice));
+    return SOCKETCOM_ERROR_ILLEGAL_SOCK;
+  }
+
+  SocketCom_BufPoolUse(pool, index, len, slice);
+  return SOCKETCOM_SUCCESS;
+}
+
+int SocketCom_BufPoolRecv(SocketCom_BufPool *pool, SocketCom *sock, SocketCom_BufSlice *slice)
+{
+  int res;
+  int recvLen;
+
+  res = SocketCom_BufPoolTake(pool, slice);
+  if (res != SOCKETCOM_SUCCESS) {
+    return res;
+  }
+
+  res = SocketCom_RecvEx(sock, slice->data, slice->len, &recvLen, SOCKETCOM_BUFPOOL_RECV_FLAGS);
+  if (res != SOCKETCOM_SUCCESS) {
+    if (res == SOCKETCOM_ERROR_WOULDBLOCK) {
+      pool->empty_recvs++;
+    }
+    SocketCom_BufSliceRelease(slice);
+    return res;
+  }
+
+  slice->len = recvLen;
+  return SOCKETCOM_SUCCESS;
+}
+
+void SocketCom_BufPoolResetHighWater(SocketCom_BufPool *pool)
+{
+  pool->high_water = pool->in_use;
+}
+
+int SocketCom_BufSliceRef(const SocketCom_BufSlice *slice, int offset, int len, SocketCom_BufSlice *out)
+{
+  if (slice->pool == NULL || offset < 0 || len < 0 || offset > slice->len || len > slice->len - offset) {
+    return SOCKETCOM_ERROR_ILLEGAL_SOCK;
+  }
+
+  slice->pool->refs[slice->index]++;
+  out->pool = slice->pool;
+  out->data = slice->data + offset;
+  out->len = len;
+  out->index = slice->index;
+  return SOCKETCOM_SUCCESS;
+}
+
+void SocketCom_BufSliceRelease(SocketCom_BufSlice *slice)
+{
+  SocketCom_BufPool *pool = slice->pool;
+
+  if (pool == NULL) {
+    return;
+  }
+  if (--pool->refs[slice->index] == 0) {
+    pool->in_use--;
+    if (pool->recycle != NULL) {
+      pool->recycle(pool, slice->index);
+    } else {
+      pool->free_list[pool->free_len++] = slice->index;
+    }
+  }
+  memset(slice, 0, sizeof(SocketCom_BufSlice));
+}
@@ -0,0 +1,122 @@
+/*
+SocketCom
+
+Copyright (c) 2017 r01hee
+
+This software is released under the MIT License.
+http://opensource.org/licenses/mit-license.php
+*/
+
+#ifndef __SOCKETCOM_BUFPOOL_H__
+#define __SOCKETCOM_BUFPOOL_H__
+
+#include "SocketCom.h"
+
+#define SOCKETCOM_BUFPOOL_DEFAULT_BUF_SIZE (16 * 1024)
+
+struct SocketCom_BufPool;
+
+/**
+ *  reference to received data in a buffer of SocketCom_BufPool
+ *  the buffer returns to the pool when all slices of it are released
+ */
+typedef struct SocketCom_BufSlice {
+  struct SocketCom_BufPool *pool; // NULL if the slice is empty
+  char *data;
+  int len;
+  int index; // buffer in the pool
+} SocketCom_BufSlice;
+
+/**
+ *  pool of fixed-size receive buffers shared by socks
+ *  instead of a buffer per connection, a buffer is taken only when a sock has data, and is kept only while slices of it are referenced.
+ *  memory is one slab, and free buffers are reused last-in first-out, so that only about high_water buffers are touched
+ *
+ *  @attention  before to use struct SocketCom_BufPool, initialize by SocketCom_BufPoolCreate()
+ *  @attention  not thread safe; use a pool per thread, and release slices on the thread of the pool
+ */
+typedef struct SocketCom_BufPool {
+  char *slab; // count buffers of buf_size bytes
+  int buf_size;
+  int count;
+  int *refs; // references of each buffer; 0 if free
+  int *free_list; // stack of free buffers
+  int free_len;
+
+  // set while free buffers are given to a backend such as an io_uring provided-buffer ring (SocketCom_EngineRegisterBufPool());
+  // released buffers are given to recycle instead of free_list
+  void (*recycle)(struct SocketCom_BufPool *pool, int index);
+  void *recycle_arg;
+
+  int in_use; // buffers referenced by slices
+  int high_water; // max of in_use
+  unsigned long long takes; // buffers taken
+  unsigned long long exhausted; // failures to take a buffer because all are in use
+  unsigned long long empty_recvs; // SocketCom_BufPoolRecv() without data; the buffer is returned at once
+} SocketCom_BufPool;
+
+/**
+ *  create pool
+ *
+ *  @param[out] pool pool
+ *  @param[in] buf_size size of each buffer; 0 for SOCKETCOM_BUFPOOL_DEFAULT_BUF_SIZE
+ *  @param[in] count number of buffers
+ *  @retval SOCKETCOM_SUCCESS success
+ *  @retval SOCKETCOM_ERROR_MEMORY cannot allocate
+ */
+int SocketCom_BufPoolCreate(SocketCom_BufPool *pool, int buf_size, int count);
+
+/**
+ *  free pool; all slices must be released before
+ */
+int SocketCom_BufPoolDestroy(SocketCom_BufPool *pool);
+
+/**
+ *  take a free buffer as a slice of buf_size bytes
+ *
+ *  @retval SOCKETCOM_SUCCESS success
+ *  @retval SOCKETCOM_ERROR_BUFPOOL_EMPTY all buffers are in use
+ */
+int SocketCom_BufPoolTake(SocketCom_BufPool *pool, SocketCom_BufSlice *slice);
+
+/**
+ *  take buffer index which a backend filled with len bytes
+ *
+ *  @retval SOCKETCOM_SUCCESS success
+ *  @retval SOCKETCOM_ERROR_ILLEGAL_SOCK index is out of range or in use
+ */
+int SocketCom_BufPoolClaim(SocketCom_BufPool *pool, int index, int len, SocketCom_BufSlice *slice);
+
+/**
+ *  receive by one non-blocking recv() into a buffer taken from pool
+ *  the buffer is returned at once unless data is received, so an idle sock holds no buffer
+ *
+ *  @param[out] slice received data; release by SocketCom_BufSliceRelease()
+ *  @retval SOCKETCOM_SUCCESS success
+ *  @retval SOCKETCOM_ERROR_WOULDBLOCK no data
+ *  @retval SOCKETCOM_ERROR_DISCONNECTED peer closed the connection
+ *  @retval SOCKETCOM_ERROR_BUFPOOL_EMPTY all buffers are in use
+ *  @retval SOCKETCOM_ERROR_RECV error
+ */
+int SocketCom_BufPoolRecv(SocketCom_BufPool *pool, SocketCom *sock, SocketCom_BufSlice *slice);
+
+/**
+ *  start next high_water from the current in_use, e.g. per interval of metrics
+ */
+void SocketCom_BufPoolResetHighWater(SocketCom_BufPool *pool);
+
+/**
+ *  new reference to len bytes from offset of slice
+ *
+ *  @param[out] out slice sharing the buffer; release it as well
+ *  @retval SOCKETCOM_SUCCESS success
+ *  @retval SOCKETCOM_ERROR_ILLEGAL_SOCK out of the range of slice
+ */
+int SocketCom_BufSliceRef(const SocketCom_BufSlice *slice, int offset, int len, SocketCom_BufSlice *out);
+
+/**
+ *  release slice; the buffer returns to the pool when its last slice is released
+ */
+void SocketCom_BufSliceRelease(SocketCom_BufSlice *slice);
+
+#endif
@@ -0,0 +1,891 @@
+/*
+SocketCom
+
+Copyright (c) 2017 r01hee
+
+This software is released under the MIT License.
+http://opensource.org/licenses/mit-license.php
+*/
+
+#ifndef __SOCKETCOM_CORO_HPP__
+#define __SOCKETCOM_CORO_HPP__
+
+/*
+ * C++20 coroutines over SocketCom_Poller and SocketCom_TimerWheel (header-only)
+ *
+ * socketcom::Loop runs socketcom::Task coroutines on one thread. a socketcom::CoSocket registered to the loop is
+ * awaited by co_await sock.recv()/send()/accept()/connect() with a deadline in msec (-1 for unlimited).
+ * an operation first tries the syscall and suspends only on SOCKETCOM_ERROR_WOULDBLOCK; the loop retries it when the
+ * poller reports the sock ready, and resumes the coroutine when it is done, so a spurious wakeup never resumes it.
+ * sockets are registered once edge-triggered on Linux, so waiting needs no epoll_ctl().
+ *
+ * coroutine frames are allocated from a pool of the loop which last called Loop::open() or is running on the thread;
+ * frames larger than the frame size of the loop, or created without a loop, are allocated from the heap.
+ * awaiting an operation allocates nothing
+ *
+ * exceptions are not propagated: an exception thrown out of a coroutine terminates
+ */
+
+#include "SocketCom.hpp"
+#include "SocketComTimer.h"
+
+#include <coroutine>
+#include <cstddef>
+#include <cstdlib>
+#include <exception>
+#include <new>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// max size of a coroutine frame allocated from the pool of a loop
+#ifndef SOCKETCOM_CORO_FRAME_SIZE
+#define SOCKETCOM_CORO_FRAME_SIZE 2048
+#endif
+
+// frames allocated at once when the pool is empty
+#ifndef SOCKETCOM_CORO_FRAME_CHUNK
+#define SOCKETCOM_CORO_FRAME_CHUNK 64
+#endif
+
+namespace socketcom {
+
+class Loop;
+template <class T> class Task;
+
+namespace detail {
+
+struct alignas(__STDCPP_DEFAULT_NEW_ALIGNMENT__) FrameHeader {
+  class FramePool *pool; // NULL if allocated from the heap
+};
+
+/**
+ *  free list of fixed-size blocks, grown by chunks which are released when the pool is destroyed
+ */
+class FramePool {
+public:
+  FramePool() noexcept = default;
+  FramePool(const FramePool &) = delete;
+  FramePool &operator=(const FramePool &) = delete;
+
+  ~FramePool()
+  {
+    while (chunks_ != NULL) {
+      Chunk *next = chunks_->next;
+      free(chunks_);
+      chunks_ = next;
+    }
+  }
+
+  void init(std::size_t frame_size) noexcept
+  {
+    constexpr std::size_t align = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+    block_size_ = (sizeof(FrameHeader) + frame_size + align - 1) / align * align;
+  }
+
+  /**
+   *  @return block of size bytes; NULL if size does not fit a block or no memory
+   */
+  void *allocate(std::size_t size) noexcept
+  {
+    if (size > block_size_ || (free_ == NULL && !grow())) {
+      heap++;
+      return NULL;
+    }
+    Free *block = free_;
+    free_ = block->next;
+    pooled++;
+    return block;
+  }
+
+  void deallocate(void *block) noexcept
+  {
+    Free *f = (Free *)block;
+    f->next = free_;
+    free_ = f;
+  }
+
+  unsigned long long pooled = 0; // frames allocated from the pool
+  unsigned long long heap = 0; // frames which did not fit the pool
+
+private:
+  struct Free { Free *next; };
+  struct alignas(__STDCPP_DEFAULT_NEW_ALIGNMENT__) Chunk { Chunk *next; };
+
+  bool grow() noexcept
+  {
+    if (block_size_ == 0) {
+      return false;
+    }
+    Chunk *chunk = (Chunk *)malloc(sizeof(Chunk) + block_size_ * SOCKETCOM_CORO_FRAME_CHUNK);
+    if (chunk == NULL) {
+      return false;
+    }
+    chunk->next = chunks_;
+    chunks_ = chunk;
+    char *blocks = (char *)(chunk + 1);
+    for (int i = SOCKETCOM_CORO_FRAME_CHUNK - 1; i >= 0; i--) {
+      deallocate(blocks + block_size_ * i);
+    }
+    return true;
+  }
+
+  Free *free_ = NULL;
+  Chunk *chunks_ = NULL;
+  std::size_t block_size_ = 0;
+};
+
+// pool of frames of coroutines created on this thread
+inline thread_local FramePool *current_pool = NULL;
+
+struct PromiseBase {
+  std::coroutine_handle<> continuation; // awaiting coroutine
+  Loop *loop = NULL; // loop which owns a spawned task
+  PromiseBase *prev = NULL; // list of spawned tasks of loop
+  PromiseBase *next = NULL;
+
+  static void *operator new(std::size_t size)
+  {
+    FramePool *pool = current_pool;
+    FrameHeader *header = (pool != NULL) ? (FrameHeader *)pool->allocate(sizeof(FrameHeader) + size) : NULL;
+    if (header == NULL) {
+      header = (FrameHeader *)::operator new(sizeof(FrameHeader) + size);
+      pool = NULL;
+    }
+    header->pool = pool;
+    return header + 1;
+  }
+
+  static void operator delete(void *frame) noexcept
+  {
+    FrameHeader *header = (FrameHeader *)frame - 1;
+    if (header->pool != NULL) {
+      header->pool->deallocate(header);
+    } else {
+      ::operator delete(header);
+    }
+  }
+
+  std::suspend_always initial_suspend() noexcept { return {}; }
+  void unhandled_exception() noexcept { std::terminate(); }
+
+  struct FinalAwaiter {
+    bool await_ready() noexcept { return false; }
+    template <class Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) noexcept;
+    void await_resume() noexcept {}
+  };
+
+  FinalAwaiter final_suspend() noexcept { return {}; }
+};
+
+template <class T>
+struct Promise : PromiseBase {
+  std::optional<T> value;
+
+  Task<T> get_return_object() noexcept;
+  template <class U>
+  void return_value(U &&v) { value.emplace(std::forward<U>(v)); }
+};
+
+template <>
+struct Promise<void> : PromiseBase {
+  Task<void> get_return_object() noexcept;
+  void return_void() noexcept {}
+};
+
+} // namespace detail
+
+/**
+ *  lazy coroutine returning T; started when awaited or given to Loop::spawn()
+ */
+template <class T = void>
+class [[nodiscard]] Task {
+public:
+  using promise_type = detail::Promise<T>;
+
+  Task() noexcept = default;
+  explicit Task(std::coroutine_handle<promise_type> h) noexcept : h_(h) {}
+  Task(Task &&other) noexcept : h_(std::exchange(other.h_, nullptr)) {}
+  Task &operator=(Task &&other) noexcept
+  {
+    if (this != &other) {
+      if (h_) {
+        h_.destroy();
+      }
+      h_ = std::exchange(other.h_, nullptr);
+    }
+    return *this;
+  }
+  Task(const Task &) = delete;
+  Task &operator=(const Task &) = delete;
+
+  ~Task()
+  {
+    if (h_) {
+      h_.destroy();
+    }
+  }
+
+  bool await_ready() const noexcept { return false; }
+
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+  {
+    h_.promise().continuation = awaiting;
+    return h_;
+  }
+
+  T await_resume() noexcept
+  {
+    if constexpr (!std::is_void_v<T>) {
+      return std::move(*h_.promise().value);
+    }
+  }
+
+  /**
+   *  give up ownership of the coroutine
+   */
+  std::coroutine_handle<promise_type> release() noexcept { return std::exchange(h_, nullptr); }
+
+private:
+  std::coroutine_handle<promise_type> h_;
+};
+
+template <class T>
+Task<T> detail::Promise<T>::get_return_object() noexcept
+{
+  return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+}
+
+inline Task<void> detail::Promise<void>::get_return_object() noexcept
+{
+  return Task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+}
+
+namespace detail {
+
+struct CoState;
+
+/**
+ *  suspended operation; retried by attempt when its sock is ready, and completed by the timer on its deadline
+ */
+struct Waiter {
+  bool (*attempt)(Waiter *w) noexcept = NULL; // true when done; NULL if only the timer completes it
+  Loop *loop = NULL;
+  CoState *state = NULL; // sock waited for; NULL for a sleep
+  Waiter **slot = NULL; // reader or writer of state, while waiting
+  std::coroutine_handle<> handle;
+  SocketCom_Timer timer;
+  int res = SOCKETCOM_SUCCESS;
+  int timeout_res = SOCKETCOM_ERROR_TIMEOUT; // res on the deadline
+  std::size_t len = 0;
+
+  Waiter() noexcept { SocketCom_TimerInit(&timer, NULL, NULL); }
+  Waiter(const Waiter &) = delete;
+  Waiter &operator=(const Waiter &) = delete;
+  inline ~Waiter();
+};
+
+/**
+ *  waiters of a sock registered to a loop; placed just after the sock in CoSocket
+ */
+struct CoState {
+  Loop *loop;
+  Waiter *reader;
+  Waiter *writer;
+
+  inline void wake(int events) noexcept;
+  inline void rearm(SocketCom *sock) noexcept;
+};
+
+struct CoSlot {
+  SocketCom sock;
+  CoState state;
+};
+
+inline CoState *CoStateOf(SocketCom *sock) noexcept
+{
+  return (CoState *)((char *)sock + offsetof(CoSlot, state));
+}
+
+inline SocketCom *CoSockOf(CoState *state) noexcept
+{
+  return (SocketCom *)((char *)state - offsetof(CoSlot, state));
+}
+
+} // namespace detail
+
+/**
+ *  event loop running coroutines on the calling thread of run()
+ *
+ *  @attention  not thread safe; a loop, its sockets and its tasks are used by one thread
+ */
+class Loop {
+public:
+  Loop() noexcept
+  {
+    SocketCom_TimerWheelInit(&wheel_, SocketCom_TimerNowMsec(), 0);
+  }
+
+  ~Loop()
+  {
+    // frames of unfinished tasks release their sockets and timers while the poller and the wheel are alive
+    while (spawned_ != NULL) {
+      detail::PromiseBase *p = spawned_;
+      unlink(p);
+      std::coroutine_handle<detail::Promise<void>>::from_promise(*static_cast<detail::Promise<void> *>(p)).destroy();
+    }
+    if (opened_) {
+      SocketCom_PollerDestroy(&poller_);
+    }
+    if (detail::current_pool == &pool_) {
+      detail::current_pool = NULL;
+    }
+  }
+
+  Loop(const Loop &) = delete;
+  Loop &operator=(const Loop &) = delete;
+
+  /**
+   *  create the poller, and make the pool of the loop current on the calling thread
+   *
+   *  @param[in] max_events max number of events of one wait
+   *  @param[in] frame_size max size of a frame allocated from the pool
+   *  @param[in] tick_msec resolution of deadlines; 0 for SOCKETCOM_TIMER_DEFAULT_TICK_MSEC
+   */
+  int open(int max_events = 256, std::size_t frame_size = SOCKETCOM_CORO_FRAME_SIZE, int tick_msec = 0) noexcept
+  {
+    if (opened_) {
+      return SOCKETCOM_ERROR_ALREADY_CREATED;
+    }
+    int res = SocketCom_PollerCreate(&poller_, max_events);
+    if (res != SOCKETCOM_SUCCESS) {
+      return res;
+    }
+    opened_ = true;
+    events_.resize(max_events);
+    ready_.reserve(max_events);
+    running_.reserve(max_events);
+    SocketCom_TimerWheelInit(&wheel_, SocketCom_TimerNowMsec(), tick_msec);
+    pool_.init(frame_size);
+    detail::current_pool = &pool_;
+    return SOCKETCOM_SUCCESS;
+  }
+
+  /**
+   *  start task on the next iteration of run(); its frame is destroyed when it finishes or with the loop
+   */
+  void spawn(Task<void> task) noexcept
+  {
+    std::coroutine_handle<detail::Promise<void>> h = task.release();
+    detail::PromiseBase *p = &h.promise();
+    p->loop = this;
+    p->next = spawned_;
+    if (spawned_ != NULL) {
+      spawned_->prev = p;
+    }
+    spawned_ = p;
+    tasks_++;
+    schedule(h);
+  }
+
+  /**
+   *  run tasks until all spawned tasks finish or stop()
+   *
+   *  @retval SOCKETCOM_SUCCESS no task is left, or stopped
+   *  @retval !=SOCKETCOM_SUCCESS error of the poller
+   */
+  int run() noexcept
+  {
+    detail::FramePool *prev = detail::current_pool;
+    int res = SOCKETCOM_SUCCESS;
+
+    detail::current_pool = &pool_;
+    stopped_ = false;
+    while (!stopped_ && tasks_ > 0) {
+      running_.swap(ready_);
+      for (std::coroutine_handle<> h : running_) {
+        h.resume();
+      }
+      running_.clear();
+      if (stopped_ || tasks_ == 0) {
+        break;
+      }
+
+      int n = (int)events_.size();
+      // timers of the loop always have callbacks
+      res = SocketCom_PollerWaitTimers(&poller_, &wheel_, events_.data(), &n, ready_.empty() ? -1 : 0, NULL, NULL);
+      if (res == SOCKETCOM_ERROR_TIMEOUT_POLLER) {
+        res = SOCKETCOM_SUCCESS;
+        continue;
+      }
+      if (res != SOCKETCOM_SUCCESS) {
+        break;
+      }
+      for (int i = 0; i < n; i++) {
+        detail::CoStateOf(events_[i].sock)->wake(events_[i].events);
+      }
+    }
+    detail::current_pool = prev;
+
+    return res;
+  }
+
+  /**
+   *  make run() return after the current coroutine suspends
+   */
+  void stop() noexcept { stopped_ = true; }
+
+  class SleepAwaiter : public detail::Waiter {
+  public:
+    SleepAwaiter(Loop *loop, long msec) noexcept : msec_(msec) { this->loop = loop; timeout_res = SOCKETCOM_SUCCESS; }
+    bool await_ready() const noexcept { return msec_ <= 0; }
+    void await_suspend(std::coroutine_handle<> h) noexcept { loop->park(*this, NULL, NULL, h, msec_); }
+    void await_resume() const noexcept {}
+
+  private:
+    long msec_;
+  };
+
+  /**
+   *  co_await loop.sleep(msec) resumes after msec
+   */
+  SleepAwaiter sleep(long msec) noexcept { return SleepAwaiter(this, msec); }
+
+  int tasks() const noexcept { return tasks_; }
+  SocketCom_Poller *poller() noexcept { return &poller_; }
+  // timers added to the wheel must have callbacks; expired timers are not returned from the loop
+  SocketCom_TimerWheel *wheel() noexcept { return &wheel_; }
+
+  unsigned long long framesPooled() const noexcept { return pool_.pooled; }
+  unsigned long long framesHeap() const noexcept { return pool_.heap; }
+
+  /**
+   *  suspend h on w until w is done, or until timeout_msec (-1 for unlimited)
+   */
+  void park(detail::Waiter &w, detail::CoState *state, detail::Waiter **slot, std::coroutine_handle<> h, long timeout_msec) noexcept
+  {
+    w.loop = this;
+    w.state = state;
+    w.slot = slot;
+    w.handle = h;
+    if (slot != NULL) {
+      *slot = &w;
+      state->rearm(detail::CoSockOf(state));
+    }
+    if (timeout_msec >= 0) {
+      SocketCom_TimerInit(&w.timer, fire, &w);
+      SocketCom_TimerAdd(&wheel_, &w.timer, SocketCom_TimerNowMsec() + timeout_msec);
+    }
+  }
+
+  /**
+   *  resume the coroutine of w with its result
+   */
+  void complete(detail::Waiter &w) noexcept
+  {
+    unpark(w);
+    SocketCom_TimerCancel(&wheel_, &w.timer);
+    schedule(w.handle);
+  }
+
+  void unpark(detail::Waiter &w) noexcept
+  {
+    if (w.slot != NULL) {
+      if (*w.slot == &w) {
+        *w.slot = NULL;
+        w.state->rearm(detail::CoSockOf(w.state));
+      }
+      w.slot = NULL;
+    }
+  }
+
+  void cancel(detail::Waiter &w) noexcept
+  {
+    unpark(w);
+    SocketCom_TimerCancel(&wheel_, &w.timer);
+  }
+
+  void schedule(std::coroutine_handle<> h) noexcept { ready_.push_back(h); }
+
+  /**
+   *  called by a spawned task when it finishes
+   */
+  void finish(detail::PromiseBase *p) noexcept
+  {
+    unlink(p);
+    tasks_--;
+  }
+
+private:
+  static void fire(SocketCom_TimerWheel *, SocketCom_Timer *, void *arg) noexcept
+  {
+    detail::Waiter *w = (detail::Waiter *)arg;
+    w->loop->unpark(*w);
+    w->res = w->timeout_res;
+    w->loop->schedule(w->handle);
+  }
+
+  void unlink(detail::PromiseBase *p) noexcept
+  {
+    if (p->prev != NULL) {
+      p->prev->next = p->next;
+    } else {
+      spawned_ = p->next;
+    }
+    if (p->next != NULL) {
+      p->next->prev = p->prev;
+    }
+    p->prev = NULL;
+    p->next = NULL;
+  }
+
+  SocketCom_Poller poller_;
+  SocketCom_TimerWheel wheel_;
+  std::vector<SocketCom_PollEvent> events_;
+  std::vector<std::coroutine_handle<>> ready_;
+  std::vector<std::coroutine_handle<>> running_;
+  detail::FramePool pool_;
+  detail::PromiseBase *spawned_ = NULL;
+  int tasks_ = 0;
+  bool opened_ = false;
+  bool stopped_ = false;
+};
+
+namespace detail {
+
+template <class Promise>
+std::coroutine_handle<> PromiseBase::FinalAwaiter::await_suspend(std::coroutine_handle<Promise> h) noexcept
+{
+  PromiseBase &p = h.promise();
+  if (p.continuation) {
+    return p.continuation;
+  }
+  if (p.loop != NULL) {
+    p.loop->finish(&p);
+    h.destroy();
+  }
+  return std::noop_coroutine();
+}
+
+inline Waiter::~Waiter()
+{
+  // the frame is destroyed while waiting, e.g. with the loop
+  if (loop != NULL) {
+    loop->cancel(*this);
+  }
+}
+
+inline void CoState::wake(int events) noexcept
+{
+  if (reader != NULL && (events & (SOCKETCOM_POLL_IN | SOCKETCOM_POLL_ERR | SOCKETCOM_POLL_HUP))
+      && reader->attempt(reader)) {
+    loop->complete(*reader);
+  }
+  if (writer != NULL && (events & (SOCKETCOM_POLL_OUT | SOCKETCOM_POLL_ERR | SOCKETCOM_POLL_HUP))
+      && writer->attempt(writer)) {
+    loop->complete(*writer);
+  }
+}
+
+inline void CoState::rearm(SocketCom *sock) noexcept
+{
+#ifdef _SOCKETCOM_LINUX_
+  // registered edge-triggered for both directions
+  (void)sock;
+#else
+  SocketCom_PollerModify(loop->poller(), sock, ((reader != NULL) ? SOCKETCOM_POLL_IN : 0) | ((writer != NULL) ? SOCKETCOM_POLL_OUT : 0));
+#endif
+}
+
+/**
+ *  operation of a sock: Op is called as int op(std::size_t &len), and returns SOCKETCOM_ERROR_WOULDBLOCK until done
+ */
+template <class Op, class Result>
+class IoAwaiter : public Waiter {
+public:
+  IoAwaiter(CoState *state, Waiter **slot, long timeout_msec, int timeout_res, Op op) noexcept
+    : slot_(slot), timeout_msec_(timeout_msec), op_(std::move(op))
+  {
+    this->state = state;
+    this->timeout_res = timeout_res;
+    this->attempt = retry;
+  }
+
+  bool await_ready() noexcept
+  {
+    if (*slot_ != NULL) {
+      // another coroutine waits for the same direction
+      res = SOCKETCOM_ERROR_ILLEGAL_SOCK;
+      return true;
+    }
+    res = op_(len);
+    if (res == SOCKETCOM_ERROR_WOULDBLOCK && state->loop == NULL) {
+      res = SOCKETCOM_ERROR_ILLEGAL_SOCK;
+    }
+    return res != SOCKETCOM_ERROR_WOULDBLOCK;
+  }
+
+  void await_suspend(std::coroutine_handle<> h) noexcept { state->loop->park(*this, state, slot_, h, timeout_msec_); }
+
+  Result await_resume() noexcept
+  {
+    loop = NULL;
+    if constexpr (std::is_same_v<Result, IoResult>) {
+      return IoResult{res, len};
+    } else {
+      return res;
+    }
+  }
+
+private:
+  static bool retry(Waiter *w) noexcept
+  {
+    IoAwaiter *self = static_cast<IoAwaiter *>(w);
+    self->res = self->op_(self->len);
+    return self->res != SOCKETCOM_ERROR_WOULDBLOCK;
+  }
+
+  Waiter **slot_;
+  long timeout_msec_;
+  Op op_;
+};
+
+template <class Result, class Op>
+IoAwaiter<Op, Result> MakeIoAwaiter(CoState *state, Waiter **slot, long timeout_msec, int timeout_res, Op op) noexcept
+{
+  return IoAwaiter<Op, Result>(state, slot, timeout_msec, timeout_res, std::move(op));
+}
+
+} // namespace detail
+
+/**
+ *  non-blocking socket registered to a loop, awaited by coroutines
+ *  one coroutine may wait for receiving (recv/accept) and another for sending (send/connect) at the same time
+ *
+ *  @attention  not movable; keep it in the frame of the coroutine which uses it
+ */
+template <class Kind = Stream, class Stats = NoStats>
+class CoSocket {
+public:
+  using socket_type = Socket<NonBlocking, Kind, Stats>;
+
+  CoSocket() noexcept : state_{NULL, NULL, NULL}
+  {
+    static_assert(std::is_standard_layout_v<CoSocket>, "CoSocket must be standard layout");
+    static_assert(offsetof(CoSocket, state_) == offsetof(detail::CoSlot, state), "CoState must follow SocketCom");
+  }
+
+  ~CoSocket() { reset(); }
+
+  CoSocket(const CoSocket &) = delete;
+  CoSocket &operator=(const CoSocket &) = delete;
+
+  /**
+   *  register sock to loop
+   */
+  int open(Loop &loop, socket_type &&sock) noexcept
+  {
+    if (*this) {
+      return SOCKETCOM_ERROR_ALREADY_CREATED;
+    }
+    sock_ = std::move(sock);
+#ifdef _SOCKETCOM_LINUX_
+    int res = SocketCom_PollerAdd(loop.poller(), sock_.get(), SOCKETCOM_POLL_IN | SOCKETCOM_POLL_OUT | SOCKETCOM_POLL_ET);
+#else
+    int res = SocketCom_PollerAdd(loop.poller(), sock_.get(), 0);
+#endif
+    if (res != SOCKETCOM_SUCCESS) {
+      sock = std::move(sock_);
+      return res;
+    }
+    state_.loop = &loop;
+    return SOCKETCOM_SUCCESS;
+  }
+
+  /**
+   *  unregister and dispose the socket
+   */
+  void reset() noexcept
+  {
+    if (state_.loop != NULL) {
+      SocketCom_PollerRemove(state_.loop->poller(), sock_.get());
+      state_.loop = NULL;
+    }
+    sock_.reset();
+  }
+
+  /**
+   *  graceful close of a Stream by SocketCom_CloseWithTimeout(); blocks the loop up to timeout_msec
+   */
+  int close(long timeout_msec = SOCKETCOM_CLOSE_TIMEOUT_MSEC) noexcept requires std::is_same_v<Kind, Stream>
+  {
+    if (state_.loop != NULL) {
+      SocketCom_PollerRemove(state_.loop->poller(), sock_.get());
+      state_.loop = NULL;
+    }
+    return sock_.close(timeout_msec);
+  }
+
+  /**
+   *  co_await connect to ip and port; int of SOCKETCOM_ERROR
+   *  on error the socket is left open to be reset()
+   */
+  auto connect(Loop &loop, const char *ip, u_short port, long timeout_msec = -1) noexcept requires std::is_same_v<Kind, Stream>
+  {
+    auto op = [this, &loop, ip, port, started = false](std::size_t &) mutable noexcept {
+      if (started) {
+        return SocketCom_ConnectFinish(sock_.get());
+      }
+      started = true;
+      return start(loop, ip, port);
+    };
+    return detail::MakeIoAwaiter<int>(&state_, &state_.writer, timeout_msec, SOCKETCOM_ERROR_TIMEOUT_CONNECT, op);
+  }
+
+  /**
+   *  co_await accept into conn; int of SOCKETCOM_ERROR. open conn to a loop to await it
+   */
+  template <class ConnStats>
+  auto accept(Socket<NonBlocking, Stream, ConnStats> &conn, long timeout_msec = -1) noexcept requires std::is_same_v<Kind, Listener>
+  {
+    auto op = [this, &conn](std::size_t &) noexcept { return sock_.accept(conn); };
+    return detail::MakeIoAwaiter<int>(&state_, &state_.reader, timeout_msec, SOCKETCOM_ERROR_TIMEOUT_ACCEPT, op);
+  }
+
+  /**
+   *  co_await receive by one syscall; IoResult as socket_type::recv()
+   */
+  auto recv(std::span<std::byte> buf, long timeout_msec = -1) noexcept requires (!std::is_same_v<Kind, Listener>)
+  {
+    auto op = [this, buf](std::size_t &len) noexcept {
+      IoResult r = sock_.recv(buf);
+      len = r.len;
+      return r.res;
+    };
+    return detail::MakeIoAwaiter<IoResult>(&state_, &state_.reader, timeout_msec, SOCKETCOM_ERROR_TIMEOUT_RECV, op);
+  }
+
+  /**
+   *  co_await send by one syscall; IoResult as socket_type::send()
+   */
+  auto send(std::span<const std::byte> buf, long timeout_msec = -1) noexcept requires (!std::is_same_v<Kind, Listener>)
+  {
+    auto op = [this, buf](std::size_t &len) noexcept {
+      IoResult r = sock_.send(buf);
+      len = r.len;
+      return r.res;
+    };
+    return detail::MakeIoAwaiter<IoResult>(&state_, &state_.writer, timeout_msec, SOCKETCOM_ERROR_TIMEOUT_SEND, op);
+  }
+
+  /**
+   *  co_await receive until buf is filled; IoResult.len is bytes received, also on error or deadline
+   */
+  auto recvAll(std::span<std::byte> buf, long timeout_msec = -1) noexcept requires std::is_same_v<Kind, Stream>
+  {
+    auto op = [this, buf](std::size_t &len) noexcept {
+      while (len < buf.size()) {
+        IoResult r = sock_.recv(buf.subspan(len));
+        if (!r) {
+          return r.res;
+        }
+        len += r.len;
+      }
+      return (int)SOCKETCOM_SUCCESS;
+    };
+    return detail::MakeIoAwaiter<IoResult>(&state_, &state_.reader, timeout_msec, SOCKETCOM_ERROR_TIMEOUT_RECV, op);
+  }
+
+  /**
+   *  co_await send all of buf; IoResult.len is bytes sent, also on error or deadline
+   */
+  auto sendAll(std::span<const std::byte> buf, long timeout_msec = -1) noexcept requires std::is_same_v<Kind, Stream>
+  {
+    auto op = [this, buf](std::size_t &len) noexcept {
+      while (len < buf.size()) {
+        IoResult r = sock_.send(buf.subspan(len));
+        if (!r) {
+          return r.res;
+        }
+        len += r.len;
+      }
+      return (int)SOCKETCOM_SUCCESS;
+    };
+    return detail::MakeIoAwaiter<IoResult>(&state_, &state_.writer, timeout_msec, SOCKETCOM_ERROR_TIMEOUT_SEND, op);
+  }
+
+  /**
+   *  co_await receive a datagram and its sender
+   */
+  auto recvFrom(std::span<std::byte> buf, struct sockaddr_storage &addr, long timeout_msec = -1) noexcept requires std::is_same_v<Kind, Datagram>
+  {
+    auto op = [this, buf, &addr](std::size_t &len) noexcept {
+      IoResult r = sock_.recvFrom(buf, addr);
+      len = r.len;
+      return r.res;
+    };
+    return detail::MakeIoAwaiter<IoResult>(&state_, &state_.reader, timeout_msec, SOCKETCOM_ERROR_TIMEOUT_RECV, op);
+  }
+
+  /**
+   *  co_await send a datagram to addr
+   */
+  auto sendTo(std::span<const std::byte> buf, const struct sockaddr_storage &addr, long timeout_msec = -1) noexcept requires std::is_same_v<Kind, Datagram>
+  {
+    auto op = [this, buf, &addr](std::size_t &len) noexcept {
+      IoResult r = sock_.sendTo(buf, addr);
+      len = r.len;
+      return r.res;
+    };
+    return detail::MakeIoAwaiter<IoResult>(&state_, &state_.writer, timeout_msec, SOCKETCOM_ERROR_TIMEOUT_SEND, op);
+  }
+
+  socket_type &socket() noexcept { return sock_; }
+
+  explicit operator bool() const noexcept { return state_.loop != NULL; }
+
+private:
+  /**
+   *  create, register and start connect
+   */
+  int start(Loop &loop, const char *ip, u_short port) noexcept
+  {
+    struct sockaddr_storage addr;
+    SocketCom sock;
+    SocketCom_Init(&sock);
+    int res = address(ip, port, addr);
+    if (res != SOCKETCOM_SUCCESS) {
+      return res;
+    }
+    res = SocketCom_CreateEx(&sock, addr.ss_family, SOCK_STREAM);
+    if (res != SOCKETCOM_SUCCESS) {
+      return res;
+    }
+    socket_type owner = socket_type::adopt(sock);
+    res = SocketCom_SetSockaddr(owner.get(), (const struct sockaddr *)&addr, SocketCom_SockaddrLen(&addr));
+    if (res == SOCKETCOM_SUCCESS) {
+      res = SocketCom_SetNonBlockingSocket(owner.get());
+    }
+    if (res == SOCKETCOM_SUCCESS) {
+      res = open(loop, std::move(owner));
+    }
+    if (res != SOCKETCOM_SUCCESS) {
+      return res;
+    }
+    return SocketCom_ConnectStart(sock_.get());
+  }
+
+  socket_type sock_; // first, so that the SocketCom of a poller event is the address of the CoSocket
+  detail::CoState state_;
+};
+
+using CoTcpStream = CoSocket<Stream>;
+using CoTcpListener = CoSocket<Listener>;
+using CoUdpSocket = CoSocket<Datagram>;
+
+} // namespace socketcom
+
+#endif
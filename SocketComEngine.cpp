@@ -0,0 +1,1310 @@
+/*
+SocketCom
+
+Copyright (c) 2017 r01hee
+
+This software is released under the MIT License.
+http://opensource.org/licenses/mit-license.php
+*/
+
+#include "SocketComEngine.h"
+#include "SocketComStats.h"
+
+#ifdef _SOCKETCOM_POSIX_
+
+#include <stdio.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#if defined(SOCKETCOM_USE_IOURING) && defined(_SOCKETCOM_LINUX_)
+#define _SOCKETCOM_IOURING_
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+
+#endif
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <limits.h>
+
+#ifdef SOCKETCOM_NDEBUG
+#define PERROR(str) do{}while(0)
+#else
+#define PERROR(str) perror(str)
+#endif
+
+#ifdef _SOCKETCOM_POSIX_
+
+typedef struct SocketCom_EngineOp {
+  struct SocketCom_EngineOp *next;
+  int op;
+  SocketCom *sock;
+  SocketCom *connectedSock;
+  void *buf;
+  int len;
+  int flags;
+  int buf_index;
+  void *user_data;
+  socklen_t addrlen;
+  int result; // bytes or -errno, same as io_uring cqe
+  int connecting; // non-blocking connect is in progress (poller backend)
+  int fl; // fcntl flags before connect (poller backend)
+  SocketCom_BufPool *pool; // SOCKETCOM_ENGINE_OP_RECV_POOL
+  SocketCom_BufSlice slice; // buffer filled by SOCKETCOM_ENGINE_OP_RECV_POOL
+} SocketCom_EngineOp;
+
+typedef struct SocketCom_EngineFd {
+  int fixed; // index of fixed file, -1 if not registered
+  int interest; // events registered to poller, 0 if not registered
+  SocketCom_EngineOp *ops; // operations waiting for readiness
+} SocketCom_EngineFd;
+
+#ifdef _SOCKETCOM_IOURING_
+typedef struct SocketCom_Ring {
+  int fd;
+  unsigned int features;
+  unsigned int sq_entries;
+  unsigned int sqe_tail; // tail of prepared sqes; published by SocketCom_RingEnter()
+  unsigned int *sq_head;
+  unsigned int *sq_tail;
+  unsigned int *sq_mask;
+  struct io_uring_sqe *sqes;
+  unsigned int *cq_head;
+  unsigned int *cq_tail;
+  unsigned int *cq_mask;
+  struct io_uring_cqe *cqes;
+  void *sq_ptr;
+  size_t sq_size;
+  void *cq_ptr;
+  size_t cq_size;
+  size_t sqes_size;
+} SocketCom_Ring;
+#endif
+
+typedef struct SocketCom_EngineImpl {
+  SocketCom_EngineOp *ops;
+  SocketCom_EngineOp *free_ops;
+  unsigned int entries;
+  unsigned int inflight;
+
+  SocketCom_EngineFd *fds;
+  int fds_len;
+  int fixed_files;
+  int fixed_buffers;
+  SocketCom_BufPool *bufpool;
+
+  // poller backend
+  SocketCom_Poller poller;
+  SocketCom_PollEvent *events;
+  SocketCom_EngineOp *queued_head;
+  SocketCom_EngineOp *queued_tail;
+  SocketCom_EngineOp *done_head;
+  SocketCom_EngineOp *done_tail;
+
+#ifdef _SOCKETCOM_IOURING_
+  SocketCom_Ring ring;
+  struct io_uring_buf_ring *pbuf_ring; // provided buffers of bufpool
+  size_t pbuf_ring_size;
+  unsigned int pbuf_mask;
+  unsigned short pbuf_tail; // tail of added buffers; published to pbuf_ring->tail
+#endif
+} SocketCom_EngineImpl;
+
+static SocketCom_EngineFd *SocketCom_EngineGetFd(SocketCom_EngineImpl *impl, int fd)
+{
+  if (fd < 0) {
+    return NULL;
+  }
+  if (fd >= impl->fds_len) {
+    int i;
+    int fds_len = (impl->fds_len == 0) ? 64 : impl->fds_len;
+    while (fds_len <= fd) {
+      fds_len *= 2;
+    }
+    SocketCom_EngineFd *fds = (SocketCom_EngineFd *)realloc(impl->fds, sizeof(SocketCom_EngineFd) * fds_len);
+    if (fds == NULL) {
+      return NULL;
+    }
+    for (i = impl->fds_len; i < fds_len; i++) {
+      fds[i].fixed = -1;
+      fds[i].interest = 0;
+      fds[i].ops = NULL;
+    }
+    impl->fds = fds;
+    impl->fds_len = fds_len;
+  }
+  return &impl->fds[fd];
+}
+
+static void SocketCom_EngineFinish(SocketCom_EngineOp *op, SocketCom_Completion *completion)
+{
+  completion->sock = op->sock;
+  completion->user_data = op->user_data;
+  completion->op = op->op;
+  completion->res = SOCKETCOM_SUCCESS;
+  completion->len = 0;
+  completion->err = 0;
+  memset(&completion->slice, 0, sizeof(SocketCom_BufSlice));
+
+  if (op->op == SOCKETCOM_ENGINE_OP_RECV_POOL && op->result <= 0) {
+    // buffer holds no data; no-op if no buffer was taken
+    SocketCom_BufSliceRelease(&op->slice);
+  }
+
+  switch (op->op) {
+  case SOCKETCOM_ENGINE_OP_RECV:
+  case SOCKETCOM_ENGINE_OP_RECV_FIXED:
+  case SOCKETCOM_ENGINE_OP_RECV_POOL:
+    SOCKETCOM_STATS_COUNT(op->sock, SOCKETCOM_STATS_DIR_RECV, op->result, op->len, -op->result);
+    break;
+  case SOCKETCOM_ENGINE_OP_SEND:
+  case SOCKETCOM_ENGINE_OP_SEND_FIXED:
+    SOCKETCOM_STATS_COUNT(op->sock, SOCKETCOM_STATS_DIR_SEND, op->result, op->len, -op->result);
+    break;
+  default:
+    break;
+  }
+
+  if (op->result < 0) {
+    completion->err = -op->result;
+    switch (op->op) {
+    case SOCKETCOM_ENGINE_OP_RECV:
+    case SOCKETCOM_ENGINE_OP_RECV_FIXED:
+      completion->res = SOCKETCOM_ERROR_RECV;
+      break;
+    case SOCKETCOM_ENGINE_OP_RECV_POOL:
+      completion->res = (op->result == -ENOBUFS) ? SOCKETCOM_ERROR_BUFPOOL_EMPTY : SOCKETCOM_ERROR_RECV;
+      break;
+    case SOCKETCOM_ENGINE_OP_SEND:
+    case SOCKETCOM_ENGINE_OP_SEND_FIXED:
+      completion->res = SOCKETCOM_ERROR_SEND;
+      break;
+    case SOCKETCOM_ENGINE_OP_ACCEPT:
+      completion->res = SOCKETCOM_ERROR_ACCEPT;
+      break;
+    default:
+      completion->res = SOCKETCOM_ERROR_CONNECT;
+      break;
+    }
+    return;
+  }
+
+  switch (op->op) {
+  case SOCKETCOM_ENGINE_OP_RECV:
+  case SOCKETCOM_ENGINE_OP_RECV_FIXED:
+    if (op->result == 0 && op->len > 0) {
+      completion->res = SOCKETCOM_ERROR_DISCONNECTED;
+    }
+    completion->len = op->result;
+    break;
+  case SOCKETCOM_ENGINE_OP_RECV_POOL:
+    if (op->result == 0) {
+      completion->res = SOCKETCOM_ERROR_DISCONNECTED;
+    } else {
+      op->slice.len = op->result;
+      completion->slice = op->slice;
+    }
+    completion->len = op->result;
+    break;
+  case SOCKETCOM_ENGINE_OP_SEND:
+  case SOCKETCOM_ENGINE_OP_SEND_FIXED:
+    completion->len = op->result;
+    break;
+  case SOCKETCOM_ENGINE_OP_ACCEPT:
+    op->connectedSock->fd = op->result;
+    op->connectedSock->status |= SOCKETCOM_STATE_CREATED | SOCKETCOM_STATE_CLIENT | SOCKETCOM_STATE_HAS_ADDR;
+    SOCKETCOM_STATS_RESET(op->connectedSock);
+    completion->sock = op->connectedSock;
+    break;
+  default:
+    op->sock->status |= SOCKETCOM_STATE_CLIENT;
+    break;
+  }
+}
+
+static SocketCom_EngineOp *SocketCom_EngineAllocOp(SocketCom_EngineImpl *impl)
+{
+  SocketCom_EngineOp *op = impl->free_ops;
+  if (op == NULL) {
+    return NULL;
+  }
+  impl->free_ops = op->next;
+  memset(op, 0, sizeof(SocketCom_EngineOp));
+  impl->inflight++;
+  return op;
+}
+
+static void SocketCom_EngineFreeOp(SocketCom_EngineImpl *impl, SocketCom_EngineOp *op)
+{
+  op->next = impl->free_ops;
+  impl->free_ops = op;
+  impl->inflight--;
+}
+
+#ifdef _SOCKETCOM_IOURING_
+
+static int SocketCom_RingSetup(SocketCom_Ring *ring, unsigned int entries, unsigned int *cq_entries)
+{
+  struct io_uring_params p;
+  unsigned int i;
+
+  memset(ring, 0, sizeof(SocketCom_Ring));
+  memset(&p, 0, sizeof(p));
+  p.flags = IORING_SETUP_SUBMIT_ALL | IORING_SETUP_COOP_TASKRUN;
+  ring->fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+  if (ring->fd < 0 && errno == EINVAL) {
+    // older kernel; retry without optional flags
+    memset(&p, 0, sizeof(p));
+    ring->fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+  }
+  if (ring->fd < 0) {
+    PERROR("io_uring_setup() in SocketCom_RingSetup()");
+    return SOCKETCOM_ERROR_ENGINE;
+  }
+
+  ring->features = p.features;
+  ring->sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned int);
+  ring->cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+  if (p.features & IORING_FEAT_SINGLE_MMAP) {
+    if (ring->cq_size > ring->sq_size) {
+      ring->sq_size = ring->cq_size;
+    }
+    ring->cq_size = ring->sq_size;
+  }
+
+  ring->sq_ptr = mmap(NULL, ring->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+  if (ring->sq_ptr == MAP_FAILED) {
+    PERROR("mmap(IORING_OFF_SQ_RING) in SocketCom_RingSetup()");
+    close(ring->fd);
+    return SOCKETCOM_ERROR_ENGINE;
+  }
+  if (p.features & IORING_FEAT_SINGLE_MMAP) {
+    ring->cq_ptr = ring->sq_ptr;
+  } else {
+    ring->cq_ptr = mmap(NULL, ring->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+    if (ring->cq_ptr == MAP_FAILED) {
+      PERROR("mmap(IORING_OFF_CQ_RING) in SocketCom_RingSetup()");
+      munmap(ring->sq_ptr, ring->sq_size);
+      close(ring->fd);
+      return SOCKETCOM_ERROR_ENGINE;
+    }
+  }
+
+  ring->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+  ring->sqes = (struct io_uring_sqe *)mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+  if (ring->sqes == MAP_FAILED) {
+    PERROR("mmap(IORING_OFF_SQES) in SocketCom_RingSetup()");
+    if (ring->cq_ptr != ring->sq_ptr) {
+      munmap(ring->cq_ptr, ring->cq_size);
+    }
+    munmap(ring->sq_ptr, ring->sq_size);
+    close(ring->fd);
+    return SOCKETCOM_ERROR_ENGINE;
+  }
+
+  char *sq = (char *)ring->sq_ptr;
+  char *cq = (char *)ring->cq_ptr;
+  ring->sq_entries = p.sq_entries;
+  ring->sq_head = (unsigned int *)(sq + p.sq_off.head);
+  ring->sq_tail = (unsigned int *)(sq + p.sq_off.tail);
+  ring->sq_mask = (unsigned int *)(sq + p.sq_off.ring_mask);
+  ring->cq_head = (unsigned int *)(cq + p.cq_off.head);
+  ring->cq_tail = (unsigned int *)(cq + p.cq_off.tail);
+  ring->cq_mask = (unsigned int *)(cq + p.cq_off.ring_mask);
+  ring->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+  ring->sqe_tail = *ring->sq_tail;
+
+  // sqe index always equals to the ring index, so the indirection array is filled once
+  unsigned int *sq_array = (unsigned int *)(sq + p.sq_off.array);
+  for (i = 0; i < p.sq_entries; i++) {
+    sq_array[i] = i;
+  }
+
+  *cq_entries = p.cq_entries;
+  return SOCKETCOM_SUCCESS;
+}
+
+static void SocketCom_RingTeardown(SocketCom_Ring *ring)
+{
+  munmap(ring->sqes, ring->sqes_size);
+  if (ring->cq_ptr != ring->sq_ptr) {
+    munmap(ring->cq_ptr, ring->cq_size);
+  }
+  munmap(ring->sq_ptr, ring->sq_size);
+  close(ring->fd);
+}
+
+static struct io_uring_sqe *SocketCom_RingGetSqe(SocketCom_Ring *ring)
+{
+  unsigned int head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+  if (ring->sqe_tail - head >= ring->sq_entries) {
+    return NULL;
+  }
+  struct io_uring_sqe *sqe = &ring->sqes[ring->sqe_tail & *ring->sq_mask];
+  ring->sqe_tail++;
+  memset(sqe, 0, sizeof(struct io_uring_sqe));
+  return sqe;
+}
+
+/**
+ *  submit prepared sqes, and wait for min_complete cqes unless timeout
+ *  @retval >=0 number of submitted sqes
+ *  @retval <0 -errno (-ETIME on timeout)
+ */
+static int SocketCom_RingEnter(SocketCom_Ring *ring, unsigned int min_complete, int timeout_msec)
+{
+  int res;
+  unsigned int flags = 0;
+  unsigned int to_submit;
+
+  __atomic_store_n(ring->sq_tail, ring->sqe_tail, __ATOMIC_RELEASE);
+  to_submit = ring->sqe_tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+
+  if (min_complete > 0) {
+    flags |= IORING_ENTER_GETEVENTS;
+  }
+
+  if (min_complete > 0 && timeout_msec >= 0) {
+    if (ring->features & IORING_FEAT_EXT_ARG) {
+      struct __kernel_timespec ts;
+      struct io_uring_getevents_arg arg;
+      ts.tv_sec = timeout_msec / 1000;
+      ts.tv_nsec = (long long)(timeout_msec % 1000) * 1000000;
+      memset(&arg, 0, sizeof(arg));
+      arg.ts = (unsigned long long)(uintptr_t)&ts;
+      res = (int)syscall(__NR_io_uring_enter, ring->fd, to_submit, min_complete, flags | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+      return (res < 0) ? -errno : res;
+    }
+
+    // no timeout support in io_uring_enter(); the ring fd is readable when cqes are posted
+    res = (int)syscall(__NR_io_uring_enter, ring->fd, to_submit, 0, 0, NULL, 0);
+    if (res < 0) {
+      return -errno;
+    }
+    struct pollfd pfd;
+    pfd.fd = ring->fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    int pres = poll(&pfd, 1, timeout_msec);
+    if (pres < 0) {
+      return -errno;
+    }
+    return (pres == 0) ? -ETIME : res;
+  }
+
+  if (to_submit == 0 && min_complete == 0) {
+    return 0;
+  }
+  res = (int)syscall(__NR_io_uring_enter, ring->fd, to_submit, min_complete, flags, NULL, 0);
+  return (res < 0) ? -errno : res;
+}
+
+static int SocketCom_EngineRingQueue(SocketCom_EngineImpl *impl, SocketCom_EngineOp *op)
+{
+  SocketCom_Ring *ring = &impl->ring;
+  struct io_uring_sqe *sqe;
+  SocketCom_EngineFd *efd;
+
+  sqe = SocketCom_RingGetSqe(ring);
+  if (sqe == NULL) {
+    // submission queue is full; flush it and retry
+    SocketCom_RingEnter(ring, 0, 0);
+    sqe = SocketCom_RingGetSqe(ring);
+    if (sqe == NULL) {
+      return SOCKETCOM_ERROR_ENGINE_FULL;
+    }
+  }
+
+  sqe->fd = op->sock->fd;
+  efd = (op->sock->fd < impl->fds_len) ? &impl->fds[op->sock->fd] : NULL;
+  if (efd != NULL && efd->fixed >= 0) {
+    sqe->fd = efd->fixed;
+    sqe->flags |= IOSQE_FIXED_FILE;
+  }
+  sqe->user_data = (unsigned long long)(uintptr_t)op;
+
+  switch (op->op) {
+  case SOCKETCOM_ENGINE_OP_RECV:
+    sqe->opcode = IORING_OP_RECV;
+    sqe->addr = (unsigned long long)(uintptr_t)op->buf;
+    sqe->len = op->len;
+    sqe->msg_flags = op->flags;
+    break;
+  case SOCKETCOM_ENGINE_OP_SEND:
+    sqe->opcode = IORING_OP_SEND;
+    sqe->addr = (unsigned long long)(uintptr_t)op->buf;
+    sqe->len = op->len;
+    sqe->msg_flags = MSG_NOSIGNAL;
+    break;
+  case SOCKETCOM_ENGINE_OP_RECV_FIXED:
+  case SOCKETCOM_ENGINE_OP_SEND_FIXED:
+    sqe->opcode = (op->op == SOCKETCOM_ENGINE_OP_RECV_FIXED) ? IORING_OP_READ_FIXED : IORING_OP_WRITE_FIXED;
+    sqe->addr = (unsigned long long)(uintptr_t)op->buf;
+    sqe->len = op->len;
+    sqe->off = (unsigned long long)-1; // stream; no file position
+    sqe->buf_index = (unsigned short)op->buf_index;
+    break;
+  case SOCKETCOM_ENGINE_OP_RECV_POOL:
+    // the kernel picks a buffer of the group when data arrives
+    sqe->opcode = IORING_OP_RECV;
+    sqe->flags |= IOSQE_BUFFER_SELECT;
+    sqe->buf_group = SOCKETCOM_ENGINE_BUF_GROUP;
+    sqe->len = op->len;
+    sqe->msg_flags = op->flags;
+    break;
+  case SOCKETCOM_ENGINE_OP_ACCEPT:
+    op->addrlen = sizeof(op->connectedSock->addr);
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->addr = (unsigned long long)(uintptr_t)&op->connectedSock->addr;
+    sqe->addr2 = (unsigned long long)(uintptr_t)&op->addrlen;
+    sqe->accept_flags = SOCK_CLOEXEC;
+    break;
+  default:
+    sqe->opcode = IORING_OP_CONNECT;
+    sqe->addr = (unsigned long long)(uintptr_t)&op->sock->addr;
+    sqe->off = SocketCom_SockaddrLen(&op->sock->addr);
+    break;
+  }
+
+  return SOCKETCOM_SUCCESS;
+}
+
+static int SocketCom_EngineRingReap(SocketCom_EngineImpl *impl, SocketCom_Completion *completions, int *completions_len, long timeout_sec, long timeout_usec)
+{
+  SocketCom_Ring *ring = &impl->ring;
+  unsigned int head;
+  unsigned int tail;
+  int count = 0;
+  int res;
+
+  head = *ring->cq_head;
+  tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+  if (head == tail) {
+    int timeout_msec = SocketCom_ToMsec(timeout_sec, timeout_usec);
+    while (1) {
+      res = SocketCom_RingEnter(ring, (timeout_msec == 0) ? 0 : 1, timeout_msec);
+      if (res != -EINTR) {
+        break;
+      }
+    }
+    if (res < 0 && res != -ETIME) {
+      errno = -res;
+      PERROR("io_uring_enter() in SocketCom_EngineRingReap()");
+      return SOCKETCOM_ERROR_ENGINE;
+    }
+    tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+  } else if (ring->sqe_tail != *ring->sq_tail) {
+    SocketCom_RingEnter(ring, 0, 0);
+  }
+
+  while (head != tail && count < *completions_len) {
+    struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cq_mask];
+    SocketCom_EngineOp *op = (SocketCom_EngineOp *)(uintptr_t)cqe->user_data;
+    op->result = cqe->res;
+    if (op->op == SOCKETCOM_ENGINE_OP_RECV_POOL) {
+      if (cqe->flags & IORING_CQE_F_BUFFER) {
+        SocketCom_BufPoolClaim(op->pool, (int)(cqe->flags >> IORING_CQE_BUFFER_SHIFT), (cqe->res > 0) ? cqe->res : 0, &op->slice);
+      } else if (cqe->res == -ENOBUFS) {
+        op->pool->exhausted++;
+      }
+    }
+    SocketCom_EngineFinish(op, &completions[count]);
+    SocketCom_EngineFreeOp(impl, op);
+    count++;
+    head++;
+  }
+  __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+
+  *completions_len = count;
+  return (count > 0) ? SOCKETCOM_SUCCESS : SOCKETCOM_ERROR_TIMEOUT_ENGINE;
+}
+
+static void SocketCom_EnginePbufAdd(SocketCom_EngineImpl *impl, int index)
+{
+  SocketCom_BufPool *pool = impl->bufpool;
+  // not pbuf_ring->bufs; in C++ __DECLARE_FLEX_ARRAY puts it after an empty struct of 1 byte
+  struct io_uring_buf *buf = &((struct io_uring_buf *)impl->pbuf_ring)[impl->pbuf_tail & impl->pbuf_mask];
+
+  // only addr, len and bid; resv of the first entry is the tail
+  buf->addr = (unsigned long long)(uintptr_t)(pool->slab + (size_t)pool->buf_size * index);
+  buf->len = (unsigned int)pool->buf_size;
+  buf->bid = (unsigned short)index;
+  impl->pbuf_tail++;
+}
+
+/**
+ *  recycle of SocketCom_BufPool; a released buffer goes back to the kernel
+ */
+static void SocketCom_EnginePbufRecycle(SocketCom_BufPool *pool, int index)
+{
+  SocketCom_EngineImpl *impl = (SocketCom_EngineImpl *)pool->recycle_arg;
+
+  SocketCom_EnginePbufAdd(impl, index);
+  __atomic_store_n(&impl->pbuf_ring->tail, impl->pbuf_tail, __ATOMIC_RELEASE);
+}
+
+#endif
+
+// poller backend
+
+static int SocketCom_EngineOpEvents(const SocketCom_EngineOp *op)
+{
+  switch (op->op) {
+  case SOCKETCOM_ENGINE_OP_RECV:
+  case SOCKETCOM_ENGINE_OP_RECV_FIXED:
+  case SOCKETCOM_ENGINE_OP_RECV_POOL:
+  case SOCKETCOM_ENGINE_OP_ACCEPT:
+    return SOCKETCOM_POLL_IN;
+  default:
+    return SOCKETCOM_POLL_OUT;
+  }
+}
+
+/**
+ *  execute op by non-blocking syscall
+ *  @retval 1 op is done (op->result is set)
+ *  @retval 0 op would block
+ */
+static int SocketCom_EngineTry(SocketCom_EngineOp *op)
+{
+  int res;
+  int fd = op->sock->fd;
+
+  while (1) {
+    switch (op->op) {
+    case SOCKETCOM_ENGINE_OP_RECV:
+    case SOCKETCOM_ENGINE_OP_RECV_FIXED:
+      res = recv(fd, (char *)op->buf, op->len, op->flags | MSG_DONTWAIT);
+      break;
+    case SOCKETCOM_ENGINE_OP_RECV_POOL:
+      // a buffer is held only while data is copied; it goes back at once if there is none
+      if (SocketCom_BufPoolTake(op->pool, &op->slice) != SOCKETCOM_SUCCESS) {
+        op->result = -ENOBUFS;
+        return 1;
+      }
+      res = recv(fd, op->slice.data, op->slice.len, op->flags | MSG_DONTWAIT);
+      if (res < 0) {
+        int err = errno;
+        SocketCom_BufSliceRelease(&op->slice);
+        errno = err;
+      }
+      break;
+    case SOCKETCOM_ENGINE_OP_SEND:
+    case SOCKETCOM_ENGINE_OP_SEND_FIXED:
+#ifdef MSG_NOSIGNAL
+      res = send(fd, (const char *)op->buf, op->len, MSG_DONTWAIT | MSG_NOSIGNAL);
+#else
+      res = send(fd, (const char *)op->buf, op->len, MSG_DONTWAIT);
+#endif
+      break;
+    case SOCKETCOM_ENGINE_OP_ACCEPT:
+      op->addrlen = sizeof(op->connectedSock->addr);
+#ifdef _SOCKETCOM_LINUX_
+      res = accept4(fd, (struct sockaddr *)&op->connectedSock->addr, &op->addrlen, SOCK_CLOEXEC);
+#else
+      res = accept(fd, (struct sockaddr *)&op->connectedSock->addr, &op->addrlen);
+#endif
+      break;
+    default:
+      if (!op->connecting) {
+        op->fl = fcntl(fd, F_GETFL, 0);
+        if (op->fl < 0 || fcntl(fd, F_SETFL, op->fl | O_NONBLOCK) < 0) {
+          op->result = -errno;
+          return 1;
+        }
+        res = connect(fd, (struct sockaddr *)&op->sock->addr, SocketCom_SockaddrLen(&op->sock->addr));
+        if (res < 0 && errno == EINPROGRESS) {
+          op->connecting = 1;
+          return 0;
+        }
+        op->result = (res < 0) ? -errno : 0;
+      } else {
+        int error = 0;
+        socklen_t error_len = sizeof(error);
+        if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &error_len) != 0) {
+          error = errno;
+        }
+        op->result = -error;
+      }
+      fcntl(fd, F_SETFL, op->fl);
+      return 1;
+    }
+
+    if (res >= 0) {
+      op->result = res;
+      return 1;
+    }
+    if (errno == EINTR) {
+      continue;
+    }
+    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      if (op->op == SOCKETCOM_ENGINE_OP_RECV_POOL) {
+        op->pool->empty_recvs++;
+      }
+      return 0;
+    }
+    op->result = -errno;
+    return 1;
+  }
+}
+
+static void SocketCom_EngineDone(SocketCom_EngineImpl *impl, SocketCom_EngineOp *op)
+{
+  op->next = NULL;
+  if (impl->done_tail == NULL) {
+    impl->done_head = op;
+  } else {
+    impl->done_tail->next = op;
+  }
+  impl->done_tail = op;
+}
+
+/**
+ *  register the events which waiting operations of efd need
+ */
+static int SocketCom_EngineUpdateInterest(SocketCom_EngineImpl *impl, SocketCom_EngineFd *efd, SocketCom *sock)
+{
+  int res;
+  int interest = 0;
+  SocketCom_EngineOp *op;
+
+  for (op = efd->ops; op != NULL; op = op->next) {
+    interest |= SocketCom_EngineOpEvents(op);
+  }
+  if (interest == efd->interest) {
+    return SOCKETCOM_SUCCESS;
+  }
+
+  if (interest == 0) {
+    // a sock closed after its last operation is already gone from the poller; forget it either way
+    res = SocketCom_PollerRemove(&impl->poller, sock);
+    efd->interest = 0;
+    return res;
+  }
+  if (efd->interest == 0) {
+    res = SocketCom_PollerAdd(&impl->poller, sock, interest);
+  } else {
+    res = SocketCom_PollerModify(&impl->poller, sock, interest);
+  }
+  if (res == SOCKETCOM_SUCCESS) {
+    efd->interest = interest;
+  }
+
+  return res;
+}
+
+/**
+ *  complete waiting operations of efd with err; they cannot wait for readiness
+ */
+static void SocketCom_EngineFailOps(SocketCom_EngineImpl *impl, SocketCom_EngineFd *efd, int err)
+{
+  SocketCom_EngineOp *op = efd->ops;
+
+  efd->ops = NULL;
+  while (op != NULL) {
+    SocketCom_EngineOp *next = op->next;
+    op->result = -err;
+    SocketCom_EngineDone(impl, op);
+    op = next;
+  }
+}
+
+/**
+ *  try waiting operations of efd in order; an operation is not tried while an earlier one of the same direction blocks
+ */
+static void SocketCom_EngineRun(SocketCom_EngineImpl *impl, SocketCom_EngineFd *efd)
+{
+  int blocked = 0;
+  SocketCom_EngineOp **prev = &efd->ops;
+  SocketCom_EngineOp *op = efd->ops;
+
+  while (op != NULL) {
+    SocketCom_EngineOp *next = op->next;
+    int events = SocketCom_EngineOpEvents(op);
+    if (!(blocked & events) && SocketCom_EngineTry(op)) {
+      *prev = next;
+      SocketCom_EngineDone(impl, op);
+    } else {
+      blocked |= events;
+      prev = &op->next;
+    }
+    op = next;
+  }
+}
+
+/**
+ *  start queued operations; an operation which cannot wait for readiness is completed with the error
+ */
+static void SocketCom_EnginePollerSubmit(SocketCom_EngineImpl *impl)
+{
+  SocketCom_EngineOp *op = impl->queued_head;
+
+  impl->queued_head = NULL;
+  impl->queued_tail = NULL;
+
+  while (op != NULL) {
+    SocketCom_EngineOp *next = op->next;
+    SocketCom_EngineFd *efd = SocketCom_EngineGetFd(impl, op->sock->fd);
+    if (efd == NULL) {
+      op->result = -ENOMEM;
+      SocketCom_EngineDone(impl, op);
+      op = next;
+      continue;
+    }
+
+    // accept waits for readiness because the listening sock may be blocking,
+    // and recv into the pool so that a buffer is taken only for a readable sock
+    if (efd->ops == NULL && op->op != SOCKETCOM_ENGINE_OP_ACCEPT && op->op != SOCKETCOM_ENGINE_OP_RECV_POOL && SocketCom_EngineTry(op)) {
+      SocketCom_EngineDone(impl, op);
+      op = next;
+      continue;
+    }
+
+    SocketCom_EngineOp **tail = &efd->ops;
+    while (*tail != NULL) {
+      tail = &(*tail)->next;
+    }
+    op->next = NULL;
+    *tail = op;
+
+    errno = 0;
+    if (SocketCom_EngineUpdateInterest(impl, efd, op->sock) != SOCKETCOM_SUCCESS) {
+      // earlier operations of the sock keep waiting with the registered events
+      *tail = NULL;
+      op->result = (errno != 0) ? -errno : -EINVAL;
+      SocketCom_EngineDone(impl, op);
+    }
+    op = next;
+  }
+}
+
+static int SocketCom_EnginePollerReap(SocketCom_EngineImpl *impl, SocketCom_Completion *completions, int *completions_len, long timeout_sec, long timeout_usec)
+{
+  int res;
+  int i;
+  int count = 0;
+
+  SocketCom_EnginePollerSubmit(impl);
+
+  if (impl->done_head == NULL) {
+    int events_len = (int)impl->entries;
+    res = SocketCom_PollerWait(&impl->poller, impl->events, &events_len, timeout_sec, timeout_usec);
+    if (res == SOCKETCOM_ERROR_TIMEOUT_POLLER) {
+      *completions_len = 0;
+      return SOCKETCOM_ERROR_TIMEOUT_ENGINE;
+    }
+    if (res != SOCKETCOM_SUCCESS) {
+      return SOCKETCOM_ERROR_ENGINE;
+    }
+    for (i = 0; i < events_len; i++) {
+      SocketCom *sock = impl->events[i].sock;
+      SocketCom_EngineFd *efd = &impl->fds[sock->fd];
+      SocketCom_EngineRun(impl, efd);
+      errno = 0;
+      if (SocketCom_EngineUpdateInterest(impl, efd, sock) != SOCKETCOM_SUCCESS) {
+        SocketCom_EngineFailOps(impl, efd, (errno != 0) ? errno : EINVAL);
+      }
+    }
+  }
+
+  while (impl->done_head != NULL && count < *completions_len) {
+    SocketCom_EngineOp *op = impl->done_head;
+    impl->done_head = op->next;
+    if (impl->done_head == NULL) {
+      impl->done_tail = NULL;
+    }
+    SocketCom_EngineFinish(op, &completions[count]);
+    SocketCom_EngineFreeOp(impl, op);
+    count++;
+  }
+
+  *completions_len = count;
+  return (count > 0) ? SOCKETCOM_SUCCESS : SOCKETCOM_ERROR_TIMEOUT_ENGINE;
+}
+
+int SocketCom_EngineCreate(SocketCom_Engine *engine, unsigned int entries, int flags)
+{
+  int res;
+  unsigned int i;
+  SocketCom_EngineImpl *impl;
+
+  if (entries == 0) {
+    entries = 1;
+  }
+
+  impl = (SocketCom_EngineImpl *)calloc(1, sizeof(SocketCom_EngineImpl));
+  if (impl == NULL) {
+    return SOCKETCOM_ERROR_MEMORY;
+  }
+
+  engine->backend = SOCKETCOM_ENGINE_BACKEND_POLLER;
+#ifdef _SOCKETCOM_IOURING_
+  if (!(flags & SOCKETCOM_ENGINE_FLAG_NO_IOURING)) {
+    unsigned int cq_entries;
+    if (SocketCom_RingSetup(&impl->ring, entries, &cq_entries) == SOCKETCOM_SUCCESS) {
+      engine->backend = SOCKETCOM_ENGINE_BACKEND_IOURING;
+      // never more operations in flight than cqes, so the completion queue cannot overflow
+      entries = cq_entries;
+    }
+  }
+#else
+  (void)flags;
+#endif
+
+  if (engine->backend == SOCKETCOM_ENGINE_BACKEND_POLLER) {
+    res = SocketCom_PollerCreate(&impl->poller, (int)entries);
+    if (res != SOCKETCOM_SUCCESS) {
+      free(impl);
+      return res;
+    }
+    impl->events = (SocketCom_PollEvent *)malloc(sizeof(SocketCom_PollEvent) * entries);
+    if (impl->events == NULL) {
+      SocketCom_PollerDestroy(&impl->poller);
+      free(impl);
+      return SOCKETCOM_ERROR_MEMORY;
+    }
+  }
+
+  impl->ops = (SocketCom_EngineOp *)malloc(sizeof(SocketCom_EngineOp) * entries);
+  if (impl->ops == NULL) {
+    engine->impl = impl;
+    SocketCom_EngineDestroy(engine);
+    return SOCKETCOM_ERROR_MEMORY;
+  }
+  for (i = 0; i < entries; i++) {
+    impl->ops[i].next = (i + 1 < entries) ? &impl->ops[i + 1] : NULL;
+  }
+  impl->free_ops = impl->ops;
+  impl->entries = entries;
+
+  engine->impl = impl;
+  return SOCKETCOM_SUCCESS;
+}
+
+int SocketCom_EngineDestroy(SocketCom_Engine *engine)
+{
+  SocketCom_EngineImpl *impl = (SocketCom_EngineImpl *)engine->impl;
+
+  if (impl == NULL) {
+    return SOCKETCOM_ERROR_ENGINE;
+  }
+
+  SocketCom_EngineUnregisterBufPool(engine);
+#ifdef _SOCKETCOM_IOURING_
+  if (engine->backend == SOCKETCOM_ENGINE_BACKEND_IOURING) {
+    SocketCom_RingTeardown(&impl->ring);
+  }
+#endif
+  if (engine->backend == SOCKETCOM_ENGINE_BACKEND_POLLER) {
+    SocketCom_PollerDestroy(&impl->poller);
+    free(impl->events);
+  }
+  free(impl->ops);
+  free(impl->fds);
+  free(impl);
+  engine->impl = NULL;
+
+  return SOCKETCOM_SUCCESS;
+}
+
+int SocketCom_EngineBackend(const SocketCom_Engine *engine)
+{
+  return engine->backend;
+}
+
+int SocketCom_EngineUnregisterFiles(SocketCom_Engine *engine)
+{
+  int i;
+  SocketCom_EngineImpl *impl = (SocketCom_EngineImpl *)engine->impl;
+
+  for (i = 0; i < impl->fds_len; i++) {
+    impl->fds[i].fixed = -1;
+  }
+
+#ifdef _SOCKETCOM_IOURING_
+  if (engine->backend == SOCKETCOM_ENGINE_BACKEND_IOURING && impl->fixed_files > 0) {
+    impl->fixed_files = 0;
+    if (syscall(__NR_io_uring_register, impl->ring.fd, IORING_UNREGISTER_FILES, NULL, 0) < 0) {
+      PERROR("io_uring_register(IORING_UNREGISTER_FILES) in SocketCom_EngineUnregisterFiles()");
+      return SOCKETCOM_ERROR_ENGINE;
+    }
+  }
+#endif
+
+  return SOCKETCOM_SUCCESS;
+}
+
+int SocketCom_EngineRegisterFiles(SocketCom_Engine *engine, SocketCom *socks[], int socks_len)
+{
+  int res;
+  SocketCom_EngineImpl *impl = (SocketCom_EngineImpl *)engine->impl;
+
+  res = SocketCom_EngineUnregisterFiles(engine);
+  if (res != SOCKETCOM_SUCCESS) {
+    return res;
+  }
+  if (engine->backend != SOCKETCOM_ENGINE_BACKEND_IOURING || socks_len <= 0) {
+    return SOCKETCOM_SUCCESS;
+  }
+
+#ifdef _SOCKETCOM_IOURING_
+  int i;
+  int *fds = (int *)malloc(sizeof(int) * socks_len);
+  if (fds == NULL) {
+    return SOCKETCOM_ERROR_MEMORY;
+  }
+  for (i = 0; i < socks_len; i++) {
+    fds[i] = socks[i]->fd;
+    if (SocketCom_EngineGetFd(impl, fds[i]) == NULL) {
+      free(fds);
+      return SOCKETCOM_ERROR_MEMORY;
+    }
+  }
+  if (syscall(__NR_io_uring_register, impl->ring.fd, IORING_REGISTER_FILES, fds, socks_len) < 0) {
+    PERROR("io_uring_register(IORING_REGISTER_FILES) in SocketCom_EngineRegisterFiles()");
+    free(fds);
+    return SOCKETCOM_ERROR_ENGINE;
+  }
+  for (i = 0; i < socks_len; i++) {
+    impl->fds[fds[i]].fixed = i;
+  }
+  impl->fixed_files = socks_len;
+  free(fds);
+#else
+  (void)socks;
+  (void)impl;
+#endif
+
+  return SOCKETCOM_SUCCESS;
+}
+
+int SocketCom_EngineUnregisterBuffers(SocketCom_Engine *engine)
+{
+  SocketCom_EngineImpl *impl = (SocketCom_EngineImpl *)engine->impl;
+
+#ifdef _SOCKETCOM_IOURING_
+  if (engine->backend == SOCKETCOM_ENGINE_BACKEND_IOURING && impl->fixed_buffers > 0) {
+    impl->fixed_buffers = 0;
+    if (syscall(__NR_io_uring_register, impl->ring.fd, IORING_UNREGISTER_BUFFERS, NULL, 0) < 0) {
+      PERROR("io_uring_register(IORING_UNREGISTER_BUFFERS) in SocketCom_EngineUnregisterBuffers()");
+      return SOCKETCOM_ERROR_ENGINE;
+    }
+  }
+#endif
+  impl->fixed_buffers = 0;
+
+  return SOCKETCOM_SUCCESS;
+}
+
+int SocketCom_EngineRegisterBuffers(SocketCom_Engine *engine, void *const bufs[], const unsigned int lens[], int bufs_len)
+{
+  int res;
+  SocketCom_EngineImpl *impl = (SocketCom_EngineImpl *)engine->impl;
+
+  res = SocketCom_EngineUnregisterBuffers(engine);
+  if (res != SOCKETCOM_SUCCESS) {
+    return res;
+  }
+
+#ifdef _SOCKETCOM_IOURING_
+  if (engine->backend == SOCKETCOM_ENGINE_BACKEND_IOURING && bufs_len > 0) {
+    int i;
+    struct iovec *iov = (struct iovec *)malloc(sizeof(struct iovec) * bufs_len);
+    if (iov == NULL) {
+      return SOCKETCOM_ERROR_MEMORY;
+    }
+    for (i = 0; i < bufs_len; i++) {
+      iov[i].iov_base = bufs[i];
+      iov[i].iov_len = lens[i];
+    }
+    res = (int)syscall(__NR_io_uring_register, impl->ring.fd, IORING_REGISTER_BUFFERS, iov, bufs_len);
+    free(iov);
+    if (res < 0) {
+      PERROR("io_uring_register(IORING_REGISTER_BUFFERS) in SocketCom_EngineRegisterBuffers()");
+      return SOCKETCOM_ERROR_ENGINE;
+    }
+  }
+#else
+  (void)bufs;
+  (void)lens;
+#endif
+  impl->fixed_buffers = bufs_len;
+
+  return SOCKETCOM_SUCCESS;
+}
+
+int SocketCom_EngineUnregisterBufPool(SocketCom_Engine *engine)
+{
+  int res = SOCKETCOM_SUCCESS;
+  SocketCom_EngineImpl *impl = (SocketCom_EngineImpl *)engine->impl;
+
+  if (impl->bufpool == NULL) {
+    return SOCKETCOM_SUCCESS;
+  }
+
+#ifdef _SOCKETCOM_IOURING_
+  if (impl->pbuf_ring != NULL) {
+    int i;
+    SocketCom_BufPool *pool = impl->bufpool;
+    struct io_uring_buf_reg reg;
+
+    memset(&reg, 0, sizeof(reg));
+    reg.bgid = SOCKETCOM_ENGINE_BUF_GROUP;
+    if (syscall(__NR_io_uring_register, impl->ring.fd, IORING_UNREGISTER_PBUF_RING, &reg, 1) < 0) {
+      PERROR("io_uring_register(IORING_UNREGISTER_PBUF_RING) in SocketCom_EngineUnregisterBufPool()");
+      res = SOCKETCOM_ERROR_ENGINE;
+    }
+    munmap(impl->pbuf_ring, impl->pbuf_ring_size);
+    impl->pbuf_ring = NULL;
+
+    // buffers not referenced by slices were in the ring
+    pool->recycle = NULL;
+    pool->recycle_arg = NULL;
+    pool->free_len = 0;
+    for (i = pool->count - 1; i >= 0; i--) {
+      if (pool->refs[i] == 0) {
+        pool->free_list[pool->free_len++] = i;
+      }
+    }
+  }
+#endif
+  impl->bufpool = NULL;
+
+  return res;
+}
+
+int SocketCom_EngineRegisterBufPool(SocketCom_Engine *engine, SocketCom_BufPool *pool)
+{
+  int res;
+  SocketCom_EngineImpl *impl = (SocketCom_EngineImpl *)engine->impl;
+
+  res = SocketCom_EngineUnregisterBufPool(engine);
+  if (res != SOCKETCOM_SUCCESS) {
+    return res;
+  }
+
+#ifdef _SOCKETCOM_IOURING_
+  if (engine->backend == SOCKETCOM_ENGINE_BACKEND_IOURING) {
+    unsigned int entries = 1;
+    struct io_uring_buf_reg reg;
+    void *ring;
+
+    if (pool->count > SOCKETCOM_ENGINE_MAX_POOL_BUFS) {
+      return SOCKETCOM_ERROR_ENGINE;
+    }
+    while (entries < (unsigned int)pool->count) {
+      entries <<= 1;
+    }
+
+    // the ring must be page aligned
+    impl->pbuf_ring_size = entries * sizeof(struct io_uring_buf);
+    ring = mmap(NULL, impl->pbuf_ring_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ring == MAP_FAILED) {
+      PERROR("mmap() in SocketCom_EngineRegisterBufPool()");
+      return SOCKETCOM_ERROR_MEMORY;
+    }
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (unsigned long long)(uintptr_t)ring;
+    reg.ring_entries = entries;
+    reg.bgid = SOCKETCOM_ENGINE_BUF_GROUP;
+    if (syscall(__NR_io_uring_register, impl->ring.fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+      int err = errno;
+      PERROR("io_uring_register(IORING_REGISTER_PBUF_RING) in SocketCom_EngineRegisterBufPool()");
+      munmap(ring, impl->pbuf_ring_size);
+      return (err == EINVAL) ? SOCKETCOM_ERROR_NOTSUPPORTED : SOCKETCOM_ERROR_ENGINE;
+    }
+
+    impl->pbuf_ring = (struct io_uring_buf_ring *)ring;
+    impl->pbuf_mask = entries - 1;
+    impl->pbuf_tail = 0;
+    impl->bufpool = pool;
+
+    // the kernel owns free buffers from now on; the pool gets one back by the cqe which uses it
+    while (pool->free_len > 0) {
+      SocketCom_EnginePbufAdd(impl, pool->free_list[--pool->free_len]);
+    }
+    __atomic_store_n(&impl->pbuf_ring->tail, impl->pbuf_tail, __ATOMIC_RELEASE);
+    pool->recycle = SocketCom_EnginePbufRecycle;
+    pool->recycle_arg = impl;
+  }
+#endif
+  impl->bufpool = pool;
+
+  return SOCKETCOM_SUCCESS;
+}
+
+static int SocketCom_EngineQueue(SocketCom_Engine *engine, int type, SocketCom *sock, SocketCom *connectedSock, void *buf, int bufLen, int flags, int buf_index, void *user_data)
+{
+  SocketCom_EngineImpl *impl = (SocketCom_EngineImpl *)engine->impl;
+  SocketCom_EngineOp *op;
+
+  if (!(sock->status & SOCKETCOM_STATE_CREATED)) {
+    return SOCKETCOM_ERROR_ILLEGAL_SOCK;
+  }
+  if ((type == SOCKETCOM_ENGINE_OP_RECV_FIXED || type == SOCKETCOM_ENGINE_OP_SEND_FIXED) && (buf_index < 0 || buf_index >= impl->fixed_buffers)) {
+    return SOCKETCOM_ERROR_ENGINE;
+  }
+  if (type == SOCKETCOM_ENGINE_OP_RECV_POOL && impl->bufpool == NULL) {
+    return SOCKETCOM_ERROR_ENGINE;
+  }
+
+  op = SocketCom_EngineAllocOp(impl);
+  if (op == NULL) {
+    return SOCKETCOM_ERROR_ENGINE_FULL;
+  }
+  op->op = type;
+  op->sock = sock;
+  op->connectedSock = connectedSock;
+  op->buf = buf;
+  op->len = bufLen;
+  op->flags = flags;
+  op->buf_index = buf_index;
+  op->user_data = user_data;
+  if (type == SOCKETCOM_ENGINE_OP_RECV_POOL) {
+    op->pool = impl->bufpool;
+    op->len = impl->bufpool->buf_size;
+  }
+
+#ifdef _SOCKETCOM_IOURING_
+  if (engine->backend == SOCKETCOM_ENGINE_BACKEND_IOURING) {
+    int res = SocketCom_EngineRingQueue(impl, op);
+    if (res != SOCKETCOM_SUCCESS) {
+      SocketCom_EngineFreeOp(impl, op);
+    }
+    return res;
+  }
+#endif
+
+  if (impl->queued_tail == NULL) {
+    impl->queued_head = op;
+  } else {
+    impl->queued_tail->next = op;
+  }
+  impl->queued_tail = op;
+
+  return SOCKETCOM_SUCCESS;
+}
+
+int SocketCom_EngineRecv(SocketCom_Engine *engine, SocketCom *sock, void *buf, int bufLen, int flags, void *user_data)
+{
+  return SocketCom_EngineQueue(engine, SOCKETCOM_ENGINE_OP_RECV, sock, NULL, buf, bufLen, flags, -1, user_data);
+}
+
+int SocketCom_EngineSend(SocketCom_Engine *engine, SocketCom *sock, const void *buf, int bufLen, void *user_data)
+{
+  return SocketCom_EngineQueue(engine, SOCKETCOM_ENGINE_OP_SEND, sock, NULL, (void *)buf, bufLen, 0, -1, user_data);
+}
+
+int SocketCom_EngineRecvFixed(SocketCom_Engine *engine, SocketCom *sock, void *buf, int bufLen, int buf_index, void *user_data)
+{
+  return SocketCom_EngineQueue(engine, SOCKETCOM_ENGINE_OP_RECV_FIXED, sock, NULL, buf, bufLen, 0, buf_index, user_data);
+}
+
+int SocketCom_EngineSendFixed(SocketCom_Engine *engine, SocketCom *sock, const void *buf, int bufLen, int buf_index, void *user_data)
+{
+  return SocketCom_EngineQueue(engine, SOCKETCOM_ENGINE_OP_SEND_FIXED, sock, NULL, (void *)buf, bufLen, 0, buf_index, user_data);
+}
+
+int SocketCom_EngineRecvPool(SocketCom_Engine *engine, SocketCom *sock, int flags, void *user_data)
+{
+  return SocketCom_EngineQueue(engine, SOCKETCOM_ENGINE_OP_RECV_POOL, sock, NULL, NULL, 0, flags, -1, user_data);
+}
+
+int SocketCom_EngineAccept(SocketCom_Engine *engine, SocketCom *sock, SocketCom *connectedSock, void *user_data)
+{
+  if (!(sock->status & SOCKETCOM_STATE_SERVER)) {
+    return SOCKETCOM_ERROR_ILLEGAL_SOCK;
+  }
+  return SocketCom_EngineQueue(engine, SOCKETCOM_ENGINE_OP_ACCEPT, sock, connectedSock, NULL, 0, 0, -1, user_data);
+}
+
+int SocketCom_EngineConnect(SocketCom_Engine *engine, SocketCom *sock, void *user_data)
+{
+  if (!(sock->status & SOCKETCOM_STATE_HAS_ADDR)) {
+    return SOCKETCOM_ERROR_ILLEGAL_SOCK;
+  }
+  return SocketCom_EngineQueue(engine, SOCKETCOM_ENGINE_OP_CONNECT, sock, NULL, NULL, 0, 0, -1, user_data);
+}
+
+int SocketCom_EngineSubmit(SocketCom_Engine *engine)
+{
+  SocketCom_EngineImpl *impl = (SocketCom_EngineImpl *)engine->impl;
+
+#ifdef _SOCKETCOM_IOURING_
+  if (engine->backend == SOCKETCOM_ENGINE_BACKEND_IOURING) {
+    int res = SocketCom_RingEnter(&impl->ring, 0, 0);
+    if (res < 0) {
+      errno = -res;
+      PERROR("io_uring_enter() in SocketCom_EngineSubmit()");
+      return SOCKETCOM_ERROR_ENGINE;
+    }
+    return SOCKETCOM_SUCCESS;
+  }
+#endif
+
+  SocketCom_EnginePollerSubmit(impl);
+  return SOCKETCOM_SUCCESS;
+}
+
+int SocketCom_EngineReap(SocketCom_Engine *engine, SocketCom_Completion *completions, int *completions_len, long timeout_sec, long timeout_usec)
+{
+  SocketCom_EngineImpl *impl = (SocketCom_EngineImpl *)engine->impl;
+
+  if (*completions_len <= 0) {
+    return SOCKETCOM_ERROR_ENGINE;
+  }
+  if (impl->inflight == 0) {
+    // nothing to wait for
+    *completions_len = 0;
+    return SOCKETCOM_ERROR_TIMEOUT_ENGINE;
+  }
+
+#ifdef _SOCKETCOM_IOURING_
+  if (engine->backend == SOCKETCOM_ENGINE_BACKEND_IOURING) {
+    return SocketCom_EngineRingReap(impl, completions, completions_len, timeout_sec, timeout_usec);
+  }
+#endif
+
+  return SocketCom_EnginePollerReap(impl, completions, completions_len, timeout_sec, timeout_usec);
+}
+
+#else
+
+// the readiness backend relies on MSG_DONTWAIT, which WIN32 does not have
+
+int SocketCom_EngineCreate(SocketCom_Engine *engine, unsigned int entries, int flags)
+{
+  (void)entries;
+  (void)flags;
+  engine->backend = 0;
+  engine->impl = NULL;
+  return SOCKETCOM_ERROR_NOTSUPPORTED;
+}
+
+int SocketCom_EngineDestroy(SocketCom_Engine *engine) { (void)engine; return SOCKETCOM_ERROR_NOTSUPPORTED; }
+int SocketCom_EngineBackend(const SocketCom_Engine *engine) { return engine->backend; }
+int SocketCom_EngineRegisterFiles(SocketCom_Engine *engine, SocketCom *socks[], int socks_len) { (void)engine; (void)socks; (void)socks_len; return SOCKETCOM_ERROR_NOTSUPPORTED; }
+int SocketCom_EngineUnregisterFiles(SocketCom_Engine *engine) { (void)engine; return SOCKETCOM_ERROR_NOTSUPPORTED; }
+int SocketCom_EngineRegisterBuffers(SocketCom_Engine *engine, void *const bufs[], const unsigned int lens[], int bufs_len) { (void)engine; (void)bufs; (void)lens; (void)bufs_len; return SOCKETCOM_ERROR_NOTSUPPORTED; }
+int SocketCom_EngineUnregisterBuffers(SocketCom_Engine *engine) { (void)engine; return SOCKETCOM_ERROR_NOTSUPPORTED; }
+int SocketCom_EngineRecv(SocketCom_Engine *engine, SocketCom *sock, void *buf, int bufLen, int flags, void *user_data) { (void)engine; (void)sock; (void)buf; (void)bufLen; (void)flags; (void)user_data; return SOCKETCOM_ERROR_NOTSUPPORTED; }
+int SocketCom_EngineSend(SocketCom_Engine *engine, SocketCom *sock, const void *buf, int bufLen, void *user_data) { (void)engine; (void)sock; (void)buf; (void)bufLen; (void)user_data; return SOCKETCOM_ERROR_NOTSUPPORTED; }
+int SocketCom_EngineRecvFixed(SocketCom_Engine *engine, SocketCom *sock, void *buf, int bufLen, int buf_index, void *user_data) { (void)engine; (void)sock; (void)buf; (void)bufLen; (void)buf_index; (void)user_data; return SOCKETCOM_ERROR_NOTSUPPORTED; }
+int SocketCom_EngineSendFixed(SocketCom_Engine *engine, SocketCom *sock, const void *buf, int bufLen, int buf_index, void *user_data) { (void)engine; (void)sock; (void)buf; (void)bufLen; (void)buf_index; (void)user_data; return SOCKETCOM_ERROR_NOTSUPPORTED; }
+int SocketCom_EngineRegisterBufPool(SocketCom_Engine *engine, SocketCom_BufPool *pool) { (void)engine; (void)pool; return SOCKETCOM_ERROR_NOTSUPPORTED; }
+int SocketCom_EngineUnregisterBufPool(SocketCom_Engine *engine) { (void)engine; return SOCKETCOM_ERROR_NOTSUPPORTED; }
+int SocketCom_EngineRecvPool(SocketCom_Engine *engine, SocketCom *sock, int flags, void *user_data) { (void)engine; (void)sock; (void)flags; (void)user_data; return SOCKETCOM_ERROR_NOTSUPPORTED; }
+int SocketCom_EngineAccept(SocketCom_Engine *engine, SocketCom *sock, SocketCom *connectedSock, void *user_data) { (void)engine; (void)sock; (void)connectedSock; (void)user_data; return SOCKETCOM_ERROR_NOTSUPPORTED; }
+int SocketCom_EngineConnect(SocketCom_Engine *engine, SocketCom *sock, void *user_data) { (void)engine; (void)sock; (void)user_data; return SOCKETCOM_ERROR_NOTSUPPORTED; }
+int SocketCom_EngineSubmit(SocketCom_Engine *engine) { (void)engine; return SOCKETCOM_ERROR_NOTSUPPORTED; }
+int SocketCom_EngineReap(SocketCom_Engine *engine, SocketCom_Completion *completions, int *completions_len, long timeout_sec, long timeout_usec) { (void)engine; (void)completions; (void)completions_len; (void)timeout_sec; (void)timeout_usec; return SOCKETCOM_ERROR_NOTSUPPORTED; }
+
+#endif
@@ -0,0 +1,179 @@
+/*
+SocketCom
+
+Copyright (c) 2017 r01hee
+
+This software is released under the MIT License.
+http://opensource.org/licenses/mit-license.php
+*/
+
+#ifndef __SOCKETCOM_ENGINE_H__
+#define __SOCKETCOM_ENGINE_H__
+
+#include "SocketCom.h"
+#include "SocketComBufPool.h"
+
+// comment out to always use the readiness(SocketCom_Poller) backend
+#define SOCKETCOM_USE_IOURING
+
+enum SOCKETCOM_ENGINE_BACKEND {
+  SOCKETCOM_ENGINE_BACKEND_IOURING = 1,
+  SOCKETCOM_ENGINE_BACKEND_POLLER = 2,
+};
+
+enum SOCKETCOM_ENGINE_FLAG {
+  SOCKETCOM_ENGINE_FLAG_NONE = 0x00,
+  SOCKETCOM_ENGINE_FLAG_NO_IOURING = 0x01, // use the readiness backend even if io_uring is available
+};
+
+enum SOCKETCOM_ENGINE_OP {
+  SOCKETCOM_ENGINE_OP_RECV = 1,
+  SOCKETCOM_ENGINE_OP_SEND = 2,
+  SOCKETCOM_ENGINE_OP_RECV_FIXED = 3,
+  SOCKETCOM_ENGINE_OP_SEND_FIXED = 4,
+  SOCKETCOM_ENGINE_OP_ACCEPT = 5,
+  SOCKETCOM_ENGINE_OP_CONNECT = 6,
+  SOCKETCOM_ENGINE_OP_RECV_POOL = 7,
+};
+
+// buffer group id of the io_uring provided-buffer ring of SocketCom_EngineRegisterBufPool()
+#define SOCKETCOM_ENGINE_BUF_GROUP 0
+
+// max buffers of a pool given to io_uring; buffer ids are 16 bits and ring entries are a power of 2
+#define SOCKETCOM_ENGINE_MAX_POOL_BUFS 32768
+
+/**
+ *  completion of an operation queued to SocketCom_Engine
+ *
+ *  res is SOCKETCOM_SUCCESS or the error code which the blocking API returns for the same operation
+ *  (e.g. SOCKETCOM_ERROR_DISCONNECTED for recv of FIN)
+ */
+typedef struct SocketCom_Completion {
+  SocketCom *sock; // sock given to the operation; connected sock for SOCKETCOM_ENGINE_OP_ACCEPT
+  void *user_data;
+  int op;
+  int res;
+  int len; // bytes received or sent
+  int err; // errno of the failed operation, 0 on success
+  SocketCom_BufSlice slice; // data received by SOCKETCOM_ENGINE_OP_RECV_POOL; release by SocketCom_BufSliceRelease()
+} SocketCom_Completion;
+
+/**
+ *  batched socket operations executed by io_uring,
+ *  or by non-blocking syscalls on SocketCom_Poller readiness when io_uring is unavailable
+ *
+ *  @attention  before to use struct SocketCom_Engine, initialize by SocketCom_EngineCreate()
+ *  @attention  socks and buffers given to operations must stay valid until their completions are reaped
+ */
+typedef struct SocketCom_Engine {
+  int backend;
+  void *impl;
+} SocketCom_Engine;
+
+/**
+ *  create engine
+ *
+ *  @param[out] engine engine
+ *  @param[in] entries max number of operations in flight
+ *  @param[in] flags OR of SOCKETCOM_ENGINE_FLAG
+ *  @retval SOCKETCOM_SUCCESS success
+ *  @retval !=SOCKETCOM_SUCCESS error
+ */
+int SocketCom_EngineCreate(SocketCom_Engine *engine, unsigned int entries, int flags);
+int SocketCom_EngineDestroy(SocketCom_Engine *engine);
+
+/**
+ *  @retval SOCKETCOM_ENGINE_BACKEND_IOURING operations are executed by io_uring
+ *  @retval SOCKETCOM_ENGINE_BACKEND_POLLER operations are executed by non-blocking syscalls
+ */
+int SocketCom_EngineBackend(const SocketCom_Engine *engine);
+
+/**
+ *  register socks as io_uring fixed files; later operations on them skip the per-operation file lookup
+ *  this function succeeds without doing anything on SOCKETCOM_ENGINE_BACKEND_POLLER
+ *
+ *  @attention  the registration replaces previous one, and must be cleared by SocketCom_EngineUnregisterFiles() before the socks are closed
+ */
+int SocketCom_EngineRegisterFiles(SocketCom_Engine *engine, SocketCom *socks[], int socks_len);
+int SocketCom_EngineUnregisterFiles(SocketCom_Engine *engine);
+
+/**
+ *  register buffers used by SocketCom_EngineRecvFixed()/SocketCom_EngineSendFixed()
+ *  on SOCKETCOM_ENGINE_BACKEND_POLLER buffers are only recorded
+ *
+ *  @param[in] bufs buffers
+ *  @param[in] lens length of each buffer
+ *  @param[in] bufs_len number of buffers
+ */
+int SocketCom_EngineRegisterBuffers(SocketCom_Engine *engine, void *const bufs[], const unsigned int lens[], int bufs_len);
+int SocketCom_EngineUnregisterBuffers(SocketCom_Engine *engine);
+
+/**
+ *  share pool among SocketCom_EngineRecvPool() operations
+ *  on SOCKETCOM_ENGINE_BACKEND_IOURING the free buffers are given to the kernel as a provided-buffer ring, and the kernel
+ *  picks one only when data arrives; on SOCKETCOM_ENGINE_BACKEND_POLLER a buffer is taken when the sock is readable.
+ *  either way a waiting recv holds no buffer, and the buffer returns to the pool when the slice of the completion is released
+ *
+ *  @attention  the registration replaces previous one; pool must outlive it, and must not be used by SocketCom_BufPoolTake() while registered
+ *  @retval SOCKETCOM_SUCCESS success
+ *  @retval SOCKETCOM_ERROR_NOTSUPPORTED the kernel has no provided-buffer ring; use SOCKETCOM_ENGINE_FLAG_NO_IOURING
+ *  @retval !=SOCKETCOM_SUCCESS error
+ */
+int SocketCom_EngineRegisterBufPool(SocketCom_Engine *engine, SocketCom_BufPool *pool);
+
+/**
+ *  give the buffers back to the pool; no SocketCom_EngineRecvPool() operation must be in flight
+ */
+int SocketCom_EngineUnregisterBufPool(SocketCom_Engine *engine);
+
+/**
+ *  queue operations; they are started by SocketCom_EngineSubmit() or SocketCom_EngineReap()
+ *
+ *  a send completion may be shorter than bufLen; the completion tells sent length
+ *
+ *  @param[in] buf_index index of the buffer given to SocketCom_EngineRegisterBuffers(); buf must be inside of it
+ *  @param[in] user_data returned by the completion
+ *  @retval SOCKETCOM_SUCCESS success
+ *  @retval SOCKETCOM_ERROR_ENGINE_FULL too many operations in flight; reap completions and retry
+ */
+int SocketCom_EngineRecv(SocketCom_Engine *engine, SocketCom *sock, void *buf, int bufLen, int flags, void *user_data);
+int SocketCom_EngineSend(SocketCom_Engine *engine, SocketCom *sock, const void *buf, int bufLen, void *user_data);
+int SocketCom_EngineRecvFixed(SocketCom_Engine *engine, SocketCom *sock, void *buf, int bufLen, int buf_index, void *user_data);
+int SocketCom_EngineSendFixed(SocketCom_Engine *engine, SocketCom *sock, const void *buf, int bufLen, int buf_index, void *user_data);
+
+/**
+ *  queue recv into a buffer of the pool given to SocketCom_EngineRegisterBufPool()
+ *  the completion has the data in slice; res is SOCKETCOM_ERROR_BUFPOOL_EMPTY if all buffers were in use
+ */
+int SocketCom_EngineRecvPool(SocketCom_Engine *engine, SocketCom *sock, int flags, void *user_data);
+
+/**
+ *  queue accept; connectedSock is filled when the completion is reaped
+ */
+int SocketCom_EngineAccept(SocketCom_Engine *engine, SocketCom *sock, SocketCom *connectedSock, void *user_data);
+
+/**
+ *  queue connect to the address specified by SocketCom_SetAddr() or SocketCom_SetAddrin()
+ */
+int SocketCom_EngineConnect(SocketCom_Engine *engine, SocketCom *sock, void *user_data);
+
+/**
+ *  start all queued operations by one syscall
+ */
+int SocketCom_EngineSubmit(SocketCom_Engine *engine);
+
+/**
+ *  submit queued operations and reap completions, unless timeout
+ *
+ *  if give timeout_sec = 0 and timeout_usec = 0, non blockging(non wait)
+ *  if give timeout_sec = -1 or timeout_usec = -1, unlimited timeout(wait until at least one completion)
+ *
+ *  @param[out] completions completions
+ *  @param[in/out] completions_len give length of completions, return number of completions
+ *  @retval SOCKETCOM_SUCCESS success
+ *  @retval SOCKETCOM_ERROR_TIMEOUT_ENGINE timeout
+ *  @retval !=SOCKETCOM_SUCCESS error
+ */
+int SocketCom_EngineReap(SocketCom_Engine *engine, SocketCom_Completion *completions, int *completions_len, long timeout_sec, long timeout_usec);
+
+#endif
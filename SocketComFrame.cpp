@@ -0,0 +1,169 @@
+/*
+SocketCom
+
+Copyright (c) 2017 r01hee
+
+This software is released under the MIT License.
+http://opensource.org/licenses/mit-license.php
+*/
+
+#include "SocketComFrame.h"
+
+#include <string.h>
+
+static unsigned long long SocketCom_FrameDecodeHeader(const SocketCom_FrameCodec *codec, const unsigned char *header)
+{
+  unsigned long long len = 0;
+  int i;
+
+  if (codec->endian == SOCKETCOM_FRAME_ENDIAN_BIG) {
+    for (i = 0; i < codec->header_size; i++) {
+      len = (len << 8) | header[i];
+    }
+  } else {
+    for (i = codec->header_size - 1; i >= 0; i--) {
+      len = (len << 8) | header[i];
+    }
+  }
+
+  return len;
+}
+
+int SocketCom_FrameCodecInit(SocketCom_FrameCodec *codec, int header_size, int endian, unsigned long long max_size)
+{
+  if (header_size != 1 && header_size != 2 && header_size != 4 && header_size != 8) {
+    return SOCKETCOM_ERROR_FRAME;
+  }
+  if (endian != SOCKETCOM_FRAME_ENDIAN_BIG && endian != SOCKETCOM_FRAME_ENDIAN_LITTLE) {
+    return SOCKETCOM_ERROR_FRAME;
+  }
+
+  unsigned long long limit = (header_size == 8) ? ~0ULL : ((1ULL << (header_size * 8)) - 1);
+  codec->header_size = header_size;
+  codec->endian = endian;
+  codec->max_size = (max_size == 0 || max_size > limit) ? limit : max_size;
+
+  return SOCKETCOM_SUCCESS;
+}
+
+int SocketCom_FrameEncodeHeader(const SocketCom_FrameCodec *codec, unsigned long long len, void *header)
+{
+  unsigned char *p = (unsigned char *)header;
+  int i;
+
+  if (len > codec->max_size) {
+    return SOCKETCOM_ERROR_FRAME;
+  }
+
+  if (codec->endian == SOCKETCOM_FRAME_ENDIAN_BIG) {
+    for (i = codec->header_size - 1; i >= 0; i--) {
+      p[i] = (unsigned char)len;
+      len >>= 8;
+    }
+  } else {
+    for (i = 0; i < codec->header_size; i++) {
+      p[i] = (unsigned char)len;
+      len >>= 8;
+    }
+  }
+
+  return SOCKETCOM_SUCCESS;
+}
+
+int SocketCom_FrameDecode(const SocketCom_FrameCodec *codec, const void *buf, size_t bufLen, SocketCom_FrameView frames[], int *frames_len, size_t *usedLen)
+{
+  const unsigned char *p = (const unsigned char *)buf;
+  size_t used = 0;
+  int n = 0;
+  int res = SOCKETCOM_SUCCESS;
+
+  while (n < *frames_len && bufLen - used >= (size_t)codec->header_size) {
+    unsigned long long len = SocketCom_FrameDecodeHeader(codec, p + used);
+    if (len > codec->max_size) {
+      res = SOCKETCOM_ERROR_FRAME;
+      break;
+    }
+    if (len > bufLen - used - codec->header_size) {
+      break;
+    }
+    frames[n].data = (const char *)p + used + codec->header_size;
+    frames[n].len = (size_t)len;
+    n++;
+    used += codec->header_size + (size_t)len;
+  }
+
+  *frames_len = n;
+  *usedLen = used;
+  return res;
+}
+
+int SocketCom_FrameRecv(const SocketCom_FrameCodec *codec, SocketCom_Reader *reader, SocketCom_FrameView frames[], int *frames_len)
+{
+  int frames_cap = *frames_len;
+
+  *frames_len = 0;
+  while (1) {
+    if (reader->len >= codec->header_size) {
+      int n = frames_cap;
+      size_t used;
+      int res;
+
+      // one view over all buffered bytes; copies only if they wrap around the end of the ring
+      SocketCom_ReaderLinearize(reader, reader->len);
+      res = SocketCom_FrameDecode(codec, reader->buf + reader->head, reader->len, frames, &n, &used);
+      if (n > 0) {
+        // frames are still in the buffer after consuming; they are overwritten by the next fill
+        SocketCom_ReaderConsume(reader, (int)used);
+        *frames_len = n;
+        return SOCKETCOM_SUCCESS;
+      }
+      if (res != SOCKETCOM_SUCCESS) {
+        return res;
+      }
+
+      unsigned long long len = SocketCom_FrameDecodeHeader(codec, (const unsigned char *)reader->buf + reader->head);
+      if (len > (unsigned long long)(reader->capacity - codec->header_size)) {
+        return SOCKETCOM_ERROR_READER_FULL;
+      }
+    }
+
+    int res = SocketCom_ReaderFill(reader);
+    if (res != SOCKETCOM_SUCCESS) {
+      return res;
+    }
+  }
+}
+
+int SocketCom_FrameSend(const SocketCom_FrameCodec *codec, SocketCom *sock, const SocketCom_FrameView frames[], int frames_len)
+{
+  unsigned char headers[SOCKETCOM_FRAME_SEND_BATCH][8];
+  SocketCom_IoVec vec[SOCKETCOM_FRAME_SEND_BATCH * 2];
+  int i;
+
+  for (i = 0; i < frames_len; i++) {
+    if (frames[i].len > codec->max_size) {
+      return SOCKETCOM_ERROR_FRAME;
+    }
+  }
+
+  for (i = 0; i < frames_len; ) {
+    SocketCom_IoVec *iov = vec;
+    int iovcnt = 0;
+    int j;
+
+    for (j = 0; j < SOCKETCOM_FRAME_SEND_BATCH && i < frames_len; j++, i++) {
+      SocketCom_FrameEncodeHeader(codec, frames[i].len, headers[j]);
+      SOCKETCOM_IOVEC_SET(vec[iovcnt], headers[j], codec->header_size);
+      iovcnt++;
+      SOCKETCOM_IOVEC_SET(vec[iovcnt], frames[i].data, frames[i].len);
+      iovcnt++;
+    }
+
+    int res = SocketCom_SendV(sock, &iov, &iovcnt, NULL);
+    if (res != SOCKETCOM_SUCCESS) {
+      return res;
+    }
+  }
+
+  return SOCKETCOM_SUCCESS;
+}
@@ -0,0 +1,102 @@
+/*
+SocketCom
+
+Copyright (c) 2017 r01hee
+
+This software is released under the MIT License.
+http://opensource.org/licenses/mit-license.php
+*/
+
+#ifndef __SOCKETCOM_FRAME_H__
+#define __SOCKETCOM_FRAME_H__
+
+#include "SocketCom.h"
+#include "SocketComReader.h"
+
+// max number of frames sent by one syscall in SocketCom_FrameSend()
+#define SOCKETCOM_FRAME_SEND_BATCH 64
+
+enum SOCKETCOM_FRAME_ENDIAN {
+  SOCKETCOM_FRAME_ENDIAN_BIG = 0, // network byte order
+  SOCKETCOM_FRAME_ENDIAN_LITTLE = 1,
+};
+
+/**
+ *  length-prefixed framing: each frame is a header of header_size bytes telling the length of the body, followed by the body
+ *
+ *  @attention  before to use struct SocketCom_FrameCodec, initialize by SocketCom_FrameCodecInit()
+ */
+typedef struct SocketCom_FrameCodec {
+  int header_size; // 1, 2, 4 or 8
+  int endian; // SOCKETCOM_FRAME_ENDIAN
+  unsigned long long max_size; // max length of body
+} SocketCom_FrameCodec;
+
+/**
+ *  body of a frame
+ *  decoded frames point into the receive buffer; frames to send point to the caller's buffers
+ */
+typedef struct SocketCom_FrameView {
+  const char *data;
+  size_t len;
+} SocketCom_FrameView;
+
+/**
+ *  initialize codec
+ *
+ *  @param[out] codec codec
+ *  @param[in] header_size 1, 2, 4 or 8
+ *  @param[in] endian SOCKETCOM_FRAME_ENDIAN
+ *  @param[in] max_size max length of body; frames longer than this are rejected. 0 for the max which header_size can tell
+ *  @retval SOCKETCOM_SUCCESS success
+ *  @retval SOCKETCOM_ERROR_FRAME illegal header_size or endian
+ */
+int SocketCom_FrameCodecInit(SocketCom_FrameCodec *codec, int header_size, int endian, unsigned long long max_size);
+
+/**
+ *  write the header of a body of len bytes
+ *
+ *  @param[out] header header_size bytes
+ *  @retval SOCKETCOM_SUCCESS success
+ *  @retval SOCKETCOM_ERROR_FRAME len is larger than max_size
+ */
+int SocketCom_FrameEncodeHeader(const SocketCom_FrameCodec *codec, unsigned long long len, void *header);
+
+/**
+ *  decode all complete frames at the head of buf
+ *
+ *  @param[in] buf received bytes
+ *  @param[in] bufLen length of buf
+ *  @param[out] frames bodies of complete frames; they point into buf
+ *  @param[in/out] frames_len give length of frames, return number of decoded frames
+ *  @param[out] usedLen bytes of the decoded frames including their headers
+ *  @retval SOCKETCOM_SUCCESS success; the rest of buf is an incomplete frame
+ *  @retval SOCKETCOM_ERROR_FRAME the next frame is longer than max_size; frames before it are decoded
+ */
+int SocketCom_FrameDecode(const SocketCom_FrameCodec *codec, const void *buf, size_t bufLen, SocketCom_FrameView frames[], int *frames_len, size_t *usedLen);
+
+/**
+ *  receive and decode all complete frames buffered in reader, receiving only if no frame is complete
+ *  decoded frames are consumed from reader, and their views are valid until the next call of a function of the reader
+ *
+ *  @param[out] frames bodies of frames
+ *  @param[in/out] frames_len give length of frames, return number of decoded frames
+ *  @retval SOCKETCOM_SUCCESS at least one frame is decoded
+ *  @retval SOCKETCOM_ERROR_WOULDBLOCK non-blocking sock has not received a complete frame yet
+ *  @retval SOCKETCOM_ERROR_FRAME a frame is longer than max_size
+ *  @retval SOCKETCOM_ERROR_READER_FULL a frame is longer than the capacity of reader
+ *  @retval !=SOCKETCOM_SUCCESS same as SocketCom_ReaderFill()
+ */
+int SocketCom_FrameRecv(const SocketCom_FrameCodec *codec, SocketCom_Reader *reader, SocketCom_FrameView frames[], int *frames_len);
+
+/**
+ *  send frames, batching up to SOCKETCOM_FRAME_SEND_BATCH frames (headers and bodies) into one vectored write
+ *
+ *  @attention  for blocking socks; on non-blocking socks, build the buffers by SocketCom_FrameEncodeHeader() and keep them for resuming SocketCom_SendV()
+ *  @retval SOCKETCOM_SUCCESS all frames are sent
+ *  @retval SOCKETCOM_ERROR_FRAME a frame is longer than max_size; no frame is sent
+ *  @retval !=SOCKETCOM_SUCCESS same as SocketCom_SendV()
+ */
+int SocketCom_FrameSend(const SocketCom_FrameCodec *codec, SocketCom *sock, const SocketCom_FrameView frames[], int frames_len);
+
+#endif
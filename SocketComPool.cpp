@@ -0,0 +1,496 @@
+/*
+SocketCom
+
+Copyright (c) 2017 r01hee
+
+This software is released under the MIT License.
+http://opensource.org/licenses/mit-license.php
+*/
+
+#include "SocketComPool.h"
+
+#ifdef _SOCKETCOM_POSIX_
+
+#include <stdio.h>
+#include <errno.h>
+#include <time.h>
+#include <strings.h>
+#include <pthread.h>
+
+#endif
+
+#include <string.h>
+#include <stdlib.h>
+
+#ifdef SOCKETCOM_NDEBUG
+#define PERROR(str) do{}while(0)
+#else
+#define PERROR(str) perror(str)
+#endif
+
+void SocketCom_PoolConfigInit(SocketCom_PoolConfig *config)
+{
+  config->max_idle = SOCKETCOM_POOL_DEFAULT_MAX_IDLE;
+  config->max_active = SOCKETCOM_POOL_DEFAULT_MAX_ACTIVE;
+  config->idle_timeout_msec = SOCKETCOM_POOL_DEFAULT_IDLE_TIMEOUT_MSEC;
+  config->connect_timeout_msec = SOCKETCOM_POOL_DEFAULT_CONNECT_TIMEOUT_MSEC;
+  config->resolver = NULL;
+}
+
+#ifdef _SOCKETCOM_POSIX_
+
+#define SOCKETCOM_POOL_BUCKETS 64
+
+struct SocketCom_PoolEndpoint;
+
+typedef struct SocketCom_PoolConn {
+  SocketCom sock; // first member; SocketCom * given to the application points to the connection
+  struct SocketCom_PoolEndpoint *endpoint;
+  long long idle_since; // msec of CLOCK_MONOTONIC
+  struct SocketCom_PoolConn *next; // in idle stack
+} SocketCom_PoolConn;
+
+typedef struct SocketCom_PoolEndpoint {
+  char *hostname;
+  u_short port;
+  SocketCom_PoolConn *idle; // stack of idle connections; most recently used first, so that the oldest are at the bottom
+  int idle_len;
+  int active_len; // connections given, including those being connected
+  int waiters; // threads waiting for active_len < max_active
+  pthread_cond_t cond; // a connection is put back
+  struct SocketCom_PoolEndpoint *next; // in bucket
+} SocketCom_PoolEndpoint;
+
+typedef struct SocketCom_PoolImpl {
+  pthread_mutex_t mutex;
+  pthread_cond_t evict_cond; // only signaled to stop
+  pthread_t evict_thread;
+  int evict_running;
+  int stop;
+  SocketCom_PoolConfig config;
+  SocketCom_PoolEndpoint *buckets[SOCKETCOM_POOL_BUCKETS];
+} SocketCom_PoolImpl;
+
+static long long SocketCom_PoolNowMsec(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void SocketCom_PoolDeadline(struct timespec *deadline, long long msec)
+{
+  deadline->tv_sec = msec / 1000;
+  deadline->tv_nsec = (msec % 1000) * 1000000;
+}
+
+static unsigned int SocketCom_PoolHash(const char *hostname, u_short port)
+{
+  // FNV-1a; host names are case insensitive
+  unsigned int h = 2166136261U;
+  for (; *hostname != '\0'; hostname++) {
+    char c = *hostname;
+    if (c >= 'A' && c <= 'Z') {
+      c += 'a' - 'A';
+    }
+    h = (h ^ (unsigned char)c) * 16777619U;
+  }
+  return (h ^ port) % SOCKETCOM_POOL_BUCKETS;
+}
+
+static void SocketCom_PoolFreeConns(SocketCom_PoolConn *conn)
+{
+  while (conn != NULL) {
+    SocketCom_PoolConn *next = conn->next;
+    // idle connections have no request in flight; closing without waiting for the peer does not lose data
+    SocketCom_Dispose(&conn->sock);
+    free(conn);
+    conn = next;
+  }
+}
+
+/**
+ *  find or create the endpoint of hostname:port
+ *  must be called with mutex locked
+ */
+static SocketCom_PoolEndpoint *SocketCom_PoolAcquire(SocketCom_PoolImpl *impl, const char *hostname, u_short port)
+{
+  unsigned int bucket = SocketCom_PoolHash(hostname, port);
+  SocketCom_PoolEndpoint *endpoint;
+  pthread_condattr_t attr;
+
+  for (endpoint = impl->buckets[bucket]; endpoint != NULL; endpoint = endpoint->next) {
+    if (endpoint->port == port && strcasecmp(endpoint->hostname, hostname) == 0) {
+      return endpoint;
+    }
+  }
+
+  endpoint = (SocketCom_PoolEndpoint *)calloc(1, sizeof(SocketCom_PoolEndpoint));
+  if (endpoint == NULL) {
+    return NULL;
+  }
+  endpoint->hostname = strdup(hostname);
+  if (endpoint->hostname == NULL) {
+    free(endpoint);
+    return NULL;
+  }
+  endpoint->port = port;
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  pthread_cond_init(&endpoint->cond, &attr);
+  pthread_condattr_destroy(&attr);
+  endpoint->next = impl->buckets[bucket];
+  impl->buckets[bucket] = endpoint;
+
+  return endpoint;
+}
+
+static void SocketCom_PoolFreeEndpoint(SocketCom_PoolEndpoint *endpoint)
+{
+  SocketCom_PoolFreeConns(endpoint->idle);
+  pthread_cond_destroy(&endpoint->cond);
+  free(endpoint->hostname);
+  free(endpoint);
+}
+
+/**
+ *  detach idle connections expired at now, and free unused endpoints
+ *  must be called with mutex locked
+ *
+ *  @return list of detached connections; close them without the lock
+ */
+static SocketCom_PoolConn *SocketCom_PoolCollect(SocketCom_PoolImpl *impl, long long now)
+{
+  SocketCom_PoolConn *expired = NULL;
+  int i;
+
+  for (i = 0; i < SOCKETCOM_POOL_BUCKETS; i++) {
+    SocketCom_PoolEndpoint **p = &impl->buckets[i];
+    while (*p != NULL) {
+      SocketCom_PoolEndpoint *endpoint = *p;
+
+      // idle_since decreases toward the bottom of the stack: cut it at the first expired connection
+      SocketCom_PoolConn **q = &endpoint->idle;
+      while (*q != NULL && (*q)->idle_since + impl->config.idle_timeout_msec > now) {
+        q = &(*q)->next;
+      }
+      while (*q != NULL) {
+        SocketCom_PoolConn *conn = *q;
+        *q = conn->next;
+        conn->next = expired;
+        expired = conn;
+        endpoint->idle_len--;
+      }
+
+      if (endpoint->idle_len == 0 && endpoint->active_len == 0 && endpoint->waiters == 0) {
+        *p = endpoint->next;
+        SocketCom_PoolFreeEndpoint(endpoint);
+        continue;
+      }
+      p = &endpoint->next;
+    }
+  }
+
+  return expired;
+}
+
+static void *SocketCom_PoolEvictMain(void *arg)
+{
+  SocketCom_PoolImpl *impl = (SocketCom_PoolImpl *)arg;
+  long interval = SOCKETCOM_POOL_EVICT_INTERVAL_MSEC;
+  struct timespec deadline;
+
+  pthread_mutex_lock(&impl->mutex);
+  if (impl->config.idle_timeout_msec <= 0) {
+    // no idle eviction; sleep until stop
+    while (!impl->stop) {
+      pthread_cond_wait(&impl->evict_cond, &impl->mutex);
+    }
+    pthread_mutex_unlock(&impl->mutex);
+    return NULL;
+  }
+  if (impl->config.idle_timeout_msec < interval) {
+    interval = impl->config.idle_timeout_msec;
+  }
+
+  while (!impl->stop) {
+    SocketCom_PoolDeadline(&deadline, SocketCom_PoolNowMsec() + interval);
+    pthread_cond_timedwait(&impl->evict_cond, &impl->mutex, &deadline);
+    if (impl->stop) {
+      break;
+    }
+
+    SocketCom_PoolConn *expired = SocketCom_PoolCollect(impl, SocketCom_PoolNowMsec());
+    if (expired != NULL) {
+      pthread_mutex_unlock(&impl->mutex);
+      SocketCom_PoolFreeConns(expired);
+      pthread_mutex_lock(&impl->mutex);
+    }
+  }
+  pthread_mutex_unlock(&impl->mutex);
+
+  return NULL;
+}
+
+int SocketCom_PoolCreate(SocketCom_Pool *pool, const SocketCom_PoolConfig *config)
+{
+  SocketCom_PoolImpl *impl;
+  pthread_condattr_t attr;
+
+  pool->impl = NULL;
+
+  impl = (SocketCom_PoolImpl *)calloc(1, sizeof(SocketCom_PoolImpl));
+  if (impl == NULL) {
+    return SOCKETCOM_ERROR_MEMORY;
+  }
+  if (config != NULL) {
+    impl->config = *config;
+  } else {
+    SocketCom_PoolConfigInit(&impl->config);
+  }
+  if (impl->config.max_idle < 0) {
+    impl->config.max_idle = 0;
+  }
+  if (impl->config.max_active <= 0) {
+    impl->config.max_active = SOCKETCOM_POOL_DEFAULT_MAX_ACTIVE;
+  }
+
+  pthread_mutex_init(&impl->mutex, NULL);
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  pthread_cond_init(&impl->evict_cond, &attr);
+  pthread_condattr_destroy(&attr);
+  pool->impl = impl;
+
+  if (pthread_create(&impl->evict_thread, NULL, SocketCom_PoolEvictMain, impl) != 0) {
+    PERROR("pthread_create() in SocketCom_PoolCreate()");
+    SocketCom_PoolDestroy(pool);
+    return SOCKETCOM_ERROR_POOL;
+  }
+  impl->evict_running = 1;
+
+  return SOCKETCOM_SUCCESS;
+}
+
+int SocketCom_PoolDestroy(SocketCom_Pool *pool)
+{
+  SocketCom_PoolImpl *impl = (SocketCom_PoolImpl *)pool->impl;
+  int i;
+
+  if (impl == NULL) {
+    return SOCKETCOM_ERROR_POOL;
+  }
+
+  pthread_mutex_lock(&impl->mutex);
+  impl->stop = 1;
+  pthread_cond_signal(&impl->evict_cond);
+  pthread_mutex_unlock(&impl->mutex);
+  if (impl->evict_running) {
+    pthread_join(impl->evict_thread, NULL);
+  }
+
+  for (i = 0; i < SOCKETCOM_POOL_BUCKETS; i++) {
+    while (impl->buckets[i] != NULL) {
+      SocketCom_PoolEndpoint *endpoint = impl->buckets[i];
+      impl->buckets[i] = endpoint->next;
+      SocketCom_PoolFreeEndpoint(endpoint);
+    }
+  }
+
+  pthread_cond_destroy(&impl->evict_cond);
+  pthread_mutex_destroy(&impl->mutex);
+  free(impl);
+  pool->impl = NULL;
+
+  return SOCKETCOM_SUCCESS;
+}
+
+/**
+ *  release the slot of a connection which is not given to the application
+ *  must be called with mutex locked
+ */
+static void SocketCom_PoolRelease(SocketCom_PoolEndpoint *endpoint)
+{
+  endpoint->active_len--;
+  if (endpoint->waiters > 0) {
+    pthread_cond_signal(&endpoint->cond);
+  }
+}
+
+int SocketCom_PoolGet(SocketCom_Pool *pool, const char *hostname, u_short port, SocketCom **sock, long timeout_msec)
+{
+  SocketCom_PoolImpl *impl = (SocketCom_PoolImpl *)pool->impl;
+  long long deadline_msec = (timeout_msec >= 0) ? SocketCom_PoolNowMsec() + timeout_msec : -1;
+  struct timespec deadline;
+  SocketCom_PoolConn *conn;
+  int res;
+
+  *sock = NULL;
+  if (deadline_msec >= 0) {
+    SocketCom_PoolDeadline(&deadline, deadline_msec);
+  }
+
+  pthread_mutex_lock(&impl->mutex);
+  SocketCom_PoolEndpoint *endpoint = SocketCom_PoolAcquire(impl, hostname, port);
+  if (endpoint == NULL) {
+    pthread_mutex_unlock(&impl->mutex);
+    return SOCKETCOM_ERROR_MEMORY;
+  }
+
+  while (endpoint->active_len >= impl->config.max_active) {
+    if (timeout_msec == 0) {
+      pthread_mutex_unlock(&impl->mutex);
+      return SOCKETCOM_ERROR_TIMEOUT_POOL;
+    }
+    endpoint->waiters++;
+    if (deadline_msec < 0) {
+      pthread_cond_wait(&endpoint->cond, &impl->mutex);
+      res = 0;
+    } else {
+      res = pthread_cond_timedwait(&endpoint->cond, &impl->mutex, &deadline);
+    }
+    endpoint->waiters--;
+    if (res == ETIMEDOUT && endpoint->active_len >= impl->config.max_active) {
+      pthread_mutex_unlock(&impl->mutex);
+      return SOCKETCOM_ERROR_TIMEOUT_POOL;
+    }
+  }
+  endpoint->active_len++;
+
+  // reuse the most recently used connection which is still alive
+  while ((conn = endpoint->idle) != NULL) {
+    endpoint->idle = conn->next;
+    endpoint->idle_len--;
+    pthread_mutex_unlock(&impl->mutex);
+
+    if (SocketCom_IsAlive(&conn->sock)) {
+      *sock = &conn->sock;
+      return SOCKETCOM_SUCCESS;
+    }
+    conn->next = NULL;
+    SocketCom_PoolFreeConns(conn);
+
+    pthread_mutex_lock(&impl->mutex);
+  }
+  pthread_mutex_unlock(&impl->mutex);
+
+  // connect a new connection; the endpoint is not freed while active_len > 0
+  long connect_timeout_msec = impl->config.connect_timeout_msec;
+  if (deadline_msec >= 0) {
+    long long remain = deadline_msec - SocketCom_PoolNowMsec();
+    if (remain < 0) {
+      remain = 0;
+    }
+    if (connect_timeout_msec < 0 || remain < connect_timeout_msec) {
+      connect_timeout_msec = (long)remain;
+    }
+  }
+
+  conn = (SocketCom_PoolConn *)calloc(1, sizeof(SocketCom_PoolConn));
+  if (conn == NULL) {
+    res = SOCKETCOM_ERROR_MEMORY;
+  } else {
+    SocketCom_Init(&conn->sock);
+    conn->endpoint = endpoint;
+    if (impl->config.resolver != NULL) {
+      res = SocketCom_ResolverConnect(impl->config.resolver, &conn->sock, endpoint->hostname, port, connect_timeout_msec);
+    } else {
+      res = SocketCom_ConnectHost(&conn->sock, endpoint->hostname, port, connect_timeout_msec);
+    }
+  }
+  if (res != SOCKETCOM_SUCCESS) {
+    free(conn);
+    pthread_mutex_lock(&impl->mutex);
+    SocketCom_PoolRelease(endpoint);
+    pthread_mutex_unlock(&impl->mutex);
+    return res;
+  }
+
+  *sock = &conn->sock;
+  return SOCKETCOM_SUCCESS;
+}
+
+int SocketCom_PoolPut(SocketCom_Pool *pool, SocketCom *sock, int reusable)
+{
+  SocketCom_PoolImpl *impl = (SocketCom_PoolImpl *)pool->impl;
+  SocketCom_PoolConn *conn = (SocketCom_PoolConn *)sock;
+  SocketCom_PoolEndpoint *endpoint = conn->endpoint;
+
+  pthread_mutex_lock(&impl->mutex);
+  SocketCom_PoolRelease(endpoint);
+  if (reusable && (sock->status & SOCKETCOM_STATE_CREATED) && endpoint->idle_len < impl->config.max_idle) {
+    conn->idle_since = SocketCom_PoolNowMsec();
+    conn->next = endpoint->idle;
+    endpoint->idle = conn;
+    endpoint->idle_len++;
+    conn = NULL;
+  }
+  pthread_mutex_unlock(&impl->mutex);
+
+  if (conn != NULL) {
+    if (sock->status & SOCKETCOM_STATE_CREATED) {
+      SocketCom_Dispose(sock);
+    }
+    free(conn);
+  }
+
+  return SOCKETCOM_SUCCESS;
+}
+
+int SocketCom_PoolGetCounts(SocketCom_Pool *pool, const char *hostname, u_short port, int *idle_len, int *active_len)
+{
+  SocketCom_PoolImpl *impl = (SocketCom_PoolImpl *)pool->impl;
+  SocketCom_PoolEndpoint *endpoint;
+
+  pthread_mutex_lock(&impl->mutex);
+  for (endpoint = impl->buckets[SocketCom_PoolHash(hostname, port)]; endpoint != NULL; endpoint = endpoint->next) {
+    if (endpoint->port == port && strcasecmp(endpoint->hostname, hostname) == 0) {
+      break;
+    }
+  }
+  if (idle_len != NULL) {
+    *idle_len = (endpoint != NULL) ? endpoint->idle_len : 0;
+  }
+  if (active_len != NULL) {
+    *active_len = (endpoint != NULL) ? endpoint->active_len : 0;
+  }
+  pthread_mutex_unlock(&impl->mutex);
+
+  return SOCKETCOM_SUCCESS;
+}
+
+#else
+
+int SocketCom_PoolCreate(SocketCom_Pool *pool, const SocketCom_PoolConfig *config)
+{
+  (void)config;
+  pool->impl = NULL;
+  return SOCKETCOM_ERROR_NOTSUPPORTED;
+}
+
+int SocketCom_PoolDestroy(SocketCom_Pool *pool)
+{
+  (void)pool;
+  return SOCKETCOM_ERROR_NOTSUPPORTED;
+}
+
+int SocketCom_PoolGet(SocketCom_Pool *pool, const char *hostname, u_short port, SocketCom **sock, long timeout_msec)
+{
+  (void)pool; (void)hostname; (void)port; (void)timeout_msec;
+  *sock = NULL;
+  return SOCKETCOM_ERROR_NOTSUPPORTED;
+}
+
+int SocketCom_PoolPut(SocketCom_Pool *pool, SocketCom *sock, int reusable)
+{
+  (void)pool; (void)sock; (void)reusable;
+  return SOCKETCOM_ERROR_NOTSUPPORTED;
+}
+
+int SocketCom_PoolGetCounts(SocketCom_Pool *pool, const char *hostname, u_short port, int *idle_len, int *active_len)
+{
+  (void)pool; (void)hostname; (void)port; (void)idle_len; (void)active_len;
+  return SOCKETCOM_ERROR_NOTSUPPORTED;
+}
+
+#endif
@@ -0,0 +1,99 @@
+/*
+SocketCom
+
+Copyright (c) 2017 r01hee
+
+This software is released under the MIT License.
+http://opensource.org/licenses/mit-license.php
+*/
+
+#ifndef __SOCKETCOM_POOL_H__
+#define __SOCKETCOM_POOL_H__
+
+#include "SocketCom.h"
+#include "SocketComResolver.h"
+
+#define SOCKETCOM_POOL_DEFAULT_MAX_IDLE 8
+#define SOCKETCOM_POOL_DEFAULT_MAX_ACTIVE 64
+#define SOCKETCOM_POOL_DEFAULT_IDLE_TIMEOUT_MSEC (60 * 1000)
+#define SOCKETCOM_POOL_DEFAULT_CONNECT_TIMEOUT_MSEC (10 * 1000)
+#define SOCKETCOM_POOL_EVICT_INTERVAL_MSEC 1000
+
+/**
+ *  configuration of pool; limits are per endpoint (hostname and port)
+ *
+ *  @attention  before to use struct SocketCom_PoolConfig, initialize by SocketCom_PoolConfigInit()
+ */
+typedef struct SocketCom_PoolConfig {
+  int max_idle; // max number of idle connections kept; 0 not to keep connections
+  int max_active; // max number of connections given by SocketCom_PoolGet() and not put back yet
+  long idle_timeout_msec; // idle connections are closed after this; 0 or less to keep them (unused endpoints are then freed only by SocketCom_PoolDestroy())
+  long connect_timeout_msec; // -1 for unlimited
+  SocketCom_Resolver *resolver; // resolver of host names; NULL to call getaddrinfo() on each connect
+} SocketCom_PoolConfig;
+
+/**
+ *  client-side pool of connections
+ *  SocketCom_PoolGet() gives the most recently used idle connection of the endpoint, or connects a new one.
+ *  idle connections are checked by SocketCom_IsAlive() before reuse, and closed by a background thread after idle_timeout_msec
+ *
+ *  @attention  before to use struct SocketCom_Pool, initialize by SocketCom_PoolCreate()
+ *  @attention  not supported on WIN32
+ */
+typedef struct SocketCom_Pool {
+  void *impl;
+} SocketCom_Pool;
+
+/**
+ *  set default values to config
+ */
+void SocketCom_PoolConfigInit(SocketCom_PoolConfig *config);
+
+/**
+ *  create pool and start its eviction thread
+ *
+ *  @param[out] pool pool
+ *  @param[in] config configuration; NULL for default values
+ *  @retval SOCKETCOM_SUCCESS success
+ *  @retval !=SOCKETCOM_SUCCESS error
+ */
+int SocketCom_PoolCreate(SocketCom_Pool *pool, const SocketCom_PoolConfig *config);
+
+/**
+ *  stop eviction thread and close idle connections
+ *
+ *  @attention  all connections must be put back, and no thread may be in SocketCom_PoolGet() of this pool
+ */
+int SocketCom_PoolDestroy(SocketCom_Pool *pool);
+
+/**
+ *  get a connected sock to hostname:port
+ *  if max_active connections of the endpoint are in use, wait until one is put back
+ *
+ *  @param[in] hostname host name or IP address
+ *  @param[out] sock connected blocking sock owned by the pool; give it back by SocketCom_PoolPut()
+ *  @param[in] timeout_msec timeout of waiting and connecting; -1 for unlimited (connecting is limited by connect_timeout_msec)
+ *  @retval SOCKETCOM_SUCCESS success
+ *  @retval SOCKETCOM_ERROR_TIMEOUT_POOL timeout while max_active connections are in use
+ *  @retval SOCKETCOM_ERROR_MEMORY error
+ *  @retval !=SOCKETCOM_SUCCESS same as SocketCom_ConnectHost() or SocketCom_ResolverConnect()
+ */
+int SocketCom_PoolGet(SocketCom_Pool *pool, const char *hostname, u_short port, SocketCom **sock, long timeout_msec);
+
+/**
+ *  put back sock given by SocketCom_PoolGet()
+ *
+ *  @param[in] sock sock
+ *  @param[in] reusable !=0 if the connection is in a clean state (a complete request and response); 0 to close it
+ */
+int SocketCom_PoolPut(SocketCom_Pool *pool, SocketCom *sock, int reusable);
+
+/**
+ *  numbers of connections of hostname:port
+ *
+ *  @param[out] idle_len number of idle connections; can be NULL
+ *  @param[out] active_len number of connections in use; can be NULL
+ */
+int SocketCom_PoolGetCounts(SocketCom_Pool *pool, const char *hostname, u_short port, int *idle_len, int *active_len);
+
+#endif
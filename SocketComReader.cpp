@@ -0,0 +1,205 @@
+/*
+SocketCom
+
+Copyright (c) 2017 r01hee
+
+This software is released under the MIT License.
+http://opensource.org/licenses/mit-license.php
+*/
+
+#include "SocketComReader.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+static void SocketCom_ReaderReverse(char *begin, char *end)
+{
+  while (begin < --end) {
+    char c = *begin;
+    *begin++ = *end;
+    *end = c;
+  }
+}
+
+int SocketCom_ReaderInit(SocketCom_Reader *reader, SocketCom *sock, void *buf, int capacity)
+{
+  memset(reader, 0, sizeof(SocketCom_Reader));
+  reader->sock = sock;
+  reader->capacity = (capacity > 0) ? capacity : SOCKETCOM_READER_DEFAULT_CAPACITY;
+
+  if (buf != NULL) {
+    reader->buf = (char *)buf;
+  } else {
+    reader->buf = (char *)malloc(reader->capacity);
+    if (reader->buf == NULL) {
+      return SOCKETCOM_ERROR_MEMORY;
+    }
+    reader->own = 1;
+  }
+
+  return SOCKETCOM_SUCCESS;
+}
+
+int SocketCom_ReaderDestroy(SocketCom_Reader *reader)
+{
+  if (reader->own) {
+    free(reader->buf);
+  }
+  reader->buf = NULL;
+  reader->capacity = 0;
+  reader->head = 0;
+  reader->len = 0;
+  reader->scanned = 0;
+  reader->own = 0;
+
+  return SOCKETCOM_SUCCESS;
+}
+
+int SocketCom_ReaderFill(SocketCom_Reader *reader)
+{
+  SocketCom_IoVec vec[2];
+  SocketCom_IoVec *iov = vec;
+  int iovcnt = 0;
+  size_t recvLen = 0;
+  int res;
+
+  if (reader->len == reader->capacity) {
+    return SOCKETCOM_ERROR_READER_FULL;
+  }
+  if (reader->len == 0) {
+    // restart from the beginning, so that following data does not wrap
+    reader->head = 0;
+  }
+
+  // free space is [tail, capacity) + [0, head), or [tail, head) if data wraps
+  int tail = reader->head + reader->len;
+  if (tail >= reader->capacity) {
+    tail -= reader->capacity;
+    SOCKETCOM_IOVEC_SET(vec[iovcnt], reader->buf + tail, reader->head - tail);
+    iovcnt++;
+  } else {
+    SOCKETCOM_IOVEC_SET(vec[iovcnt], reader->buf + tail, reader->capacity - tail);
+    iovcnt++;
+    if (reader->head > 0) {
+      SOCKETCOM_IOVEC_SET(vec[iovcnt], reader->buf, reader->head);
+      iovcnt++;
+    }
+  }
+
+  res = SocketCom_RecvV(reader->sock, &iov, &iovcnt, &recvLen);
+  reader->len += (int)recvLen;
+
+  return res;
+}
+
+int SocketCom_ReaderBuffered(const SocketCom_Reader *reader)
+{
+  return reader->len;
+}
+
+void SocketCom_ReaderLinearize(SocketCom_Reader *reader, int len)
+{
+  int first = reader->capacity - reader->head;
+
+  if (len <= first) {
+    return;
+  }
+
+  if (reader->capacity - reader->len >= first) {
+    // the free gap can hold the first segment: shift the wrapped part behind it, and copy the first segment in front
+    memmove(reader->buf + first, reader->buf, reader->len - first);
+    memcpy(reader->buf, reader->buf + reader->head, first);
+  } else {
+    // rotate the whole ring left by head in place
+    SocketCom_ReaderReverse(reader->buf, reader->buf + reader->head);
+    SocketCom_ReaderReverse(reader->buf + reader->head, reader->buf + reader->capacity);
+    SocketCom_ReaderReverse(reader->buf, reader->buf + reader->capacity);
+  }
+  reader->head = 0;
+}
+
+int SocketCom_ReaderPeek(SocketCom_Reader *reader, int len, const char **data)
+{
+  if (len > reader->capacity) {
+    return SOCKETCOM_ERROR_READER_FULL;
+  }
+
+  while (reader->len < len) {
+    int res = SocketCom_ReaderFill(reader);
+    if (res != SOCKETCOM_SUCCESS) {
+      return res;
+    }
+  }
+
+  SocketCom_ReaderLinearize(reader, len);
+  *data = reader->buf + reader->head;
+
+  return SOCKETCOM_SUCCESS;
+}
+
+void SocketCom_ReaderConsume(SocketCom_Reader *reader, int len)
+{
+  if (len > reader->len) {
+    len = reader->len;
+  }
+
+  reader->head += len;
+  if (reader->head >= reader->capacity) {
+    reader->head -= reader->capacity;
+  }
+  reader->len -= len;
+  reader->scanned = (reader->scanned > len) ? (reader->scanned - len) : 0;
+  if (reader->len == 0) {
+    reader->head = 0;
+  }
+}
+
+int SocketCom_ReaderReadExact(SocketCom_Reader *reader, int len, const char **data)
+{
+  int res = SocketCom_ReaderPeek(reader, len, data);
+  if (res == SOCKETCOM_SUCCESS) {
+    SocketCom_ReaderConsume(reader, len);
+  }
+  return res;
+}
+
+int SocketCom_ReaderReadUntil(SocketCom_Reader *reader, const void *delim, int delimLen, const char **data, int *len)
+{
+  const char *d = (const char *)delim;
+
+  if (delimLen <= 0 || delimLen > reader->capacity) {
+    return SOCKETCOM_ERROR_READER_FULL;
+  }
+
+  while (1) {
+    if (reader->len >= delimLen) {
+      SocketCom_ReaderLinearize(reader, reader->len);
+
+      const char *begin = reader->buf + reader->head;
+      const char *end = begin + reader->len - delimLen + 1; // last position where delimiter can start
+      // skip bytes searched by previous calls, except for a delimiter which was split by the end of data
+      const char *p = begin + ((reader->scanned >= delimLen) ? (reader->scanned - delimLen + 1) : 0);
+
+      while (p < end) {
+        p = (const char *)memchr(p, d[0], end - p);
+        if (p == NULL) {
+          break;
+        }
+        if (memcmp(p, d, delimLen) == 0) {
+          *data = begin;
+          *len = (int)(p - begin) + delimLen;
+          SocketCom_ReaderConsume(reader, *len);
+          reader->scanned = 0;
+          return SOCKETCOM_SUCCESS;
+        }
+        p++;
+      }
+      reader->scanned = reader->len;
+    }
+
+    int res = SocketCom_ReaderFill(reader);
+    if (res != SOCKETCOM_SUCCESS) {
+      return res;
+    }
+  }
+}
@@ -0,0 +1,104 @@
+/*
+SocketCom
+
+Copyright (c) 2017 r01hee
+
+This software is released under the MIT License.
+http://opensource.org/licenses/mit-license.php
+*/
+
+#ifndef __SOCKETCOM_READER_H__
+#define __SOCKETCOM_READER_H__
+
+#include "SocketCom.h"
+
+#define SOCKETCOM_READER_DEFAULT_CAPACITY (64 * 1024)
+
+/**
+ *  buffered reader of a sock
+ *  a ring buffer is filled by large reads, and data is returned as views into the buffer instead of copies
+ *
+ *  a view returned by SocketCom_ReaderPeek(), SocketCom_ReaderReadExact() or SocketCom_ReaderReadUntil()
+ *  is valid until the next call of a function of the reader other than SocketCom_ReaderConsume() and SocketCom_ReaderBuffered()
+ *
+ *  @attention  before to use struct SocketCom_Reader, initialize by SocketCom_ReaderInit()
+ */
+typedef struct SocketCom_Reader {
+  SocketCom *sock;
+  char *buf;
+  int capacity;
+  int head; // offset of the first buffered byte
+  int len; // number of buffered bytes
+  int scanned; // number of buffered bytes already searched by SocketCom_ReaderReadUntil()
+  int own; // buf is allocated by the reader
+} SocketCom_Reader;
+
+/**
+ *  initialize reader
+ *
+ *  @param[out] reader reader
+ *  @param[in] sock sock to read
+ *  @param[in] buf buffer of capacity bytes; NULL to allocate it
+ *  @param[in] capacity size of buffer; 0 for SOCKETCOM_READER_DEFAULT_CAPACITY. max length of a view
+ *  @retval SOCKETCOM_SUCCESS success
+ *  @retval SOCKETCOM_ERROR_MEMORY cannot allocate buffer
+ */
+int SocketCom_ReaderInit(SocketCom_Reader *reader, SocketCom *sock, void *buf, int capacity);
+int SocketCom_ReaderDestroy(SocketCom_Reader *reader);
+
+/**
+ *  receive into free space of the buffer by one syscall
+ *
+ *  @retval SOCKETCOM_SUCCESS success
+ *  @retval SOCKETCOM_ERROR_READER_FULL no free space
+ *  @retval !=SOCKETCOM_SUCCESS same as SocketCom_RecvV()
+ */
+int SocketCom_ReaderFill(SocketCom_Reader *reader);
+
+/**
+ *  @return number of buffered bytes
+ */
+int SocketCom_ReaderBuffered(const SocketCom_Reader *reader);
+
+/**
+ *  view len bytes without consuming them, receiving as needed
+ *
+ *  @param[out] data head of len contiguous bytes
+ *  @retval SOCKETCOM_SUCCESS success
+ *  @retval SOCKETCOM_ERROR_WOULDBLOCK non-blocking sock has not received len bytes yet; buffered bytes are kept
+ *  @retval SOCKETCOM_ERROR_READER_FULL len is larger than capacity
+ *  @retval !=SOCKETCOM_SUCCESS same as SocketCom_RecvV()
+ */
+int SocketCom_ReaderPeek(SocketCom_Reader *reader, int len, const char **data);
+
+/**
+ *  discard len buffered bytes
+ */
+void SocketCom_ReaderConsume(SocketCom_Reader *reader, int len);
+
+/**
+ *  view and consume len bytes
+ *  same as SocketCom_ReaderPeek() followed by SocketCom_ReaderConsume()
+ */
+int SocketCom_ReaderReadExact(SocketCom_Reader *reader, int len, const char **data);
+
+/**
+ *  view and consume bytes up to and including delimiter
+ *
+ *  @param[in] delim delimiter such as "\r\n"
+ *  @param[in] delimLen length of delimiter
+ *  @param[out] data head of the bytes
+ *  @param[out] len length of the bytes including delimiter
+ *  @retval SOCKETCOM_SUCCESS success
+ *  @retval SOCKETCOM_ERROR_WOULDBLOCK non-blocking sock has not received delimiter yet; buffered bytes are kept
+ *  @retval SOCKETCOM_ERROR_READER_FULL delimiter is not found in capacity bytes
+ *  @retval !=SOCKETCOM_SUCCESS same as SocketCom_RecvV()
+ */
+int SocketCom_ReaderReadUntil(SocketCom_Reader *reader, const void *delim, int delimLen, const char **data, int *len);
+
+/**
+ *  make the first len buffered bytes contiguous (they are contiguous unless they wrap around the end of the ring)
+ */
+void SocketCom_ReaderLinearize(SocketCom_Reader *reader, int len);
+
+#endif
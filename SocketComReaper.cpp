@@ -0,0 +1,343 @@
+/*
+SocketCom
+
+Copyright (c) 2017 r01hee
+
+This software is released under the MIT License.
+http://opensource.org/licenses/mit-license.php
+*/
+
+#include "SocketComReaper.h"
+#include "SocketComTimer.h"
+
+#ifdef _SOCKETCOM_POSIX_
+
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+
+#endif
+
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+
+#ifdef SOCKETCOM_NDEBUG
+#define PERROR(str) do{}while(0)
+#else
+#define PERROR(str) perror(str)
+#endif
+
+#ifdef _SOCKETCOM_POSIX_
+
+typedef struct SocketCom_ReaperConn {
+  SocketCom sock; // first member; events of the poller point to the connection
+  SocketCom_Timer timer;
+  struct SocketCom_ReaperConn *prev;
+  struct SocketCom_ReaperConn *next; // in list of connections being closed, or in queue of handed connections
+} SocketCom_ReaperConn;
+
+typedef struct SocketCom_ReaperImpl {
+  pthread_mutex_t mutex;
+  pthread_t thread;
+  int running;
+  int stop;
+  long timeout_msec;
+  SocketCom_ReaperConn *queue; // handed by SocketCom_ReaperClose(); protected by mutex
+  // owned by the thread
+  SocketCom_Poller poller;
+  SocketCom_TimerWheel wheel;
+  SocketCom_ReaperConn *conns;
+  SocketCom wakeup; // read end of the pipe waking up the thread
+  int wakeup_fd; // write end
+} SocketCom_ReaperImpl;
+
+static void SocketCom_ReaperFree(SocketCom_ReaperImpl *impl, SocketCom_ReaperConn *conn)
+{
+  if (conn->prev != NULL) {
+    conn->prev->next = conn->next;
+  } else {
+    impl->conns = conn->next;
+  }
+  if (conn->next != NULL) {
+    conn->next->prev = conn->prev;
+  }
+  SocketCom_TimerCancel(&impl->wheel, &conn->timer);
+  free(conn);
+}
+
+static void SocketCom_ReaperExpire(SocketCom_TimerWheel *wheel, SocketCom_Timer *timer, void *arg)
+{
+  SocketCom_ReaperImpl *impl = (SocketCom_ReaperImpl *)arg;
+  SocketCom_ReaperConn *conn = (SocketCom_ReaperConn *)((char *)timer - offsetof(SocketCom_ReaperConn, timer));
+
+  (void)wheel;
+  SocketCom_PollerRemove(&impl->poller, &conn->sock);
+  SocketCom_Abort(&conn->sock);
+  SocketCom_ReaperFree(impl, conn);
+}
+
+/**
+ *  SocketCom_CloseDrain() which keeps sock open, so that it stays registered to the poller while data is left
+ *
+ *  @retval SOCKETCOM_ERROR_WOULDBLOCK wait for the next event
+ *  @retval others finished; remove sock from the poller, then close it
+ */
+static int SocketCom_ReaperDrain(SocketCom *sock)
+{
+  char buf[SOCKETCOM_CLOSE_DRAIN_BUF_SIZE];
+  long drained = 0;
+
+  while (drained < SOCKETCOM_CLOSE_DRAIN_BUDGET) {
+    int recvLen = 0;
+    int res = SocketCom_RecvEx(sock, buf, sizeof(buf), &recvLen, 0);
+    if (res != SOCKETCOM_SUCCESS) {
+      return res;
+    }
+    drained += recvLen;
+  }
+
+  return SOCKETCOM_ERROR_WOULDBLOCK;
+}
+
+/**
+ *  start draining connections handed by SocketCom_ReaperClose()
+ */
+static void SocketCom_ReaperTake(SocketCom_ReaperImpl *impl)
+{
+  SocketCom_ReaperConn *queue;
+  char buf[64];
+  long long now = SocketCom_TimerNowMsec();
+
+  while (read(impl->wakeup.fd, buf, sizeof(buf)) > 0) {
+  }
+
+  pthread_mutex_lock(&impl->mutex);
+  queue = impl->queue;
+  impl->queue = NULL;
+  pthread_mutex_unlock(&impl->mutex);
+
+  while (queue != NULL) {
+    SocketCom_ReaperConn *conn = queue;
+    queue = conn->next;
+
+    if (SocketCom_PollerAdd(&impl->poller, &conn->sock, SOCKETCOM_POLL_IN) != SOCKETCOM_SUCCESS) {
+      SocketCom_Abort(&conn->sock);
+      free(conn);
+      continue;
+    }
+    conn->prev = NULL;
+    conn->next = impl->conns;
+    if (impl->conns != NULL) {
+      impl->conns->prev = conn;
+    }
+    impl->conns = conn;
+    SocketCom_TimerInit(&conn->timer, SocketCom_ReaperExpire, impl);
+    SocketCom_TimerAdd(&impl->wheel, &conn->timer, now + impl->timeout_msec);
+  }
+}
+
+static void *SocketCom_ReaperMain(void *arg)
+{
+  SocketCom_ReaperImpl *impl = (SocketCom_ReaperImpl *)arg;
+  SocketCom_PollEvent events[SOCKETCOM_REAPER_MAX_EVENTS];
+  int i;
+
+  while (1) {
+    pthread_mutex_lock(&impl->mutex);
+    int stop = impl->stop;
+    pthread_mutex_unlock(&impl->mutex);
+    if (stop) {
+      break;
+    }
+
+    // events are handled before expiring timers, so that no event points to a freed connection
+    long wait = SocketCom_TimerWheelNextTimeout(&impl->wheel, SocketCom_TimerNowMsec());
+    int events_len = SOCKETCOM_REAPER_MAX_EVENTS;
+    int res = SocketCom_PollerWait(&impl->poller, events, &events_len, (wait < 0) ? -1 : wait / 1000, (wait < 0) ? -1 : (wait % 1000) * 1000);
+    if (res == SOCKETCOM_SUCCESS) {
+      for (i = 0; i < events_len; i++) {
+        if (events[i].sock == &impl->wakeup) {
+          SocketCom_ReaperTake(impl);
+          continue;
+        }
+        SocketCom_ReaperConn *conn = (SocketCom_ReaperConn *)events[i].sock;
+        // level-triggered; the registration is kept until the drain finishes
+        if (SocketCom_ReaperDrain(&conn->sock) == SOCKETCOM_ERROR_WOULDBLOCK) {
+          continue;
+        }
+        SocketCom_PollerRemove(&impl->poller, &conn->sock);
+        SocketCom_Dispose(&conn->sock);
+        SocketCom_ReaperFree(impl, conn);
+      }
+    }
+    SocketCom_TimerWheelAdvance(&impl->wheel, SocketCom_TimerNowMsec(), NULL, NULL);
+  }
+
+  return NULL;
+}
+
+int SocketCom_ReaperCreate(SocketCom_Reaper *reaper, long timeout_msec)
+{
+  SocketCom_ReaperImpl *impl;
+  int fds[2];
+  int res;
+
+  reaper->impl = NULL;
+
+  impl = (SocketCom_ReaperImpl *)calloc(1, sizeof(SocketCom_ReaperImpl));
+  if (impl == NULL) {
+    return SOCKETCOM_ERROR_MEMORY;
+  }
+  impl->timeout_msec = (timeout_msec < 0) ? SOCKETCOM_CLOSE_TIMEOUT_MSEC : timeout_msec;
+  SocketCom_TimerWheelInit(&impl->wheel, SocketCom_TimerNowMsec(), 0);
+  SocketCom_Init(&impl->wakeup);
+  impl->wakeup_fd = -1;
+  pthread_mutex_init(&impl->mutex, NULL);
+
+  res = SocketCom_PollerCreate(&impl->poller, SOCKETCOM_REAPER_MAX_EVENTS);
+  if (res != SOCKETCOM_SUCCESS) {
+    pthread_mutex_destroy(&impl->mutex);
+    free(impl);
+    return res;
+  }
+  reaper->impl = impl;
+
+  if (pipe(fds) < 0) {
+    PERROR("pipe() in SocketCom_ReaperCreate()");
+    SocketCom_ReaperDestroy(reaper);
+    return SOCKETCOM_ERROR_CREATE;
+  }
+  fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+  fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+  fcntl(fds[0], F_SETFL, O_NONBLOCK);
+  impl->wakeup.fd = fds[0];
+  impl->wakeup.status = SOCKETCOM_STATE_CREATED;
+  impl->wakeup_fd = fds[1];
+
+  res = SocketCom_PollerAdd(&impl->poller, &impl->wakeup, SOCKETCOM_POLL_IN);
+  if (res != SOCKETCOM_SUCCESS) {
+    SocketCom_ReaperDestroy(reaper);
+    return res;
+  }
+
+  if (pthread_create(&impl->thread, NULL, SocketCom_ReaperMain, impl) != 0) {
+    PERROR("pthread_create() in SocketCom_ReaperCreate()");
+    SocketCom_ReaperDestroy(reaper);
+    return SOCKETCOM_ERROR_CREATE;
+  }
+  impl->running = 1;
+
+  return SOCKETCOM_SUCCESS;
+}
+
+int SocketCom_ReaperDestroy(SocketCom_Reaper *reaper)
+{
+  SocketCom_ReaperImpl *impl = (SocketCom_ReaperImpl *)reaper->impl;
+  char c = 0;
+
+  if (impl == NULL) {
+    return SOCKETCOM_ERROR_CLOSE;
+  }
+
+  if (impl->running) {
+    pthread_mutex_lock(&impl->mutex);
+    impl->stop = 1;
+    pthread_mutex_unlock(&impl->mutex);
+    if (write(impl->wakeup_fd, &c, 1) < 0) {
+      PERROR("write() in SocketCom_ReaperDestroy()");
+    }
+    pthread_join(impl->thread, NULL);
+  }
+
+  // finish the rest abortively
+  while (impl->queue != NULL) {
+    SocketCom_ReaperConn *conn = impl->queue;
+    impl->queue = conn->next;
+    SocketCom_Abort(&conn->sock);
+    free(conn);
+  }
+  while (impl->conns != NULL) {
+    SocketCom_ReaperConn *conn = impl->conns;
+    SocketCom_PollerRemove(&impl->poller, &conn->sock);
+    SocketCom_Abort(&conn->sock);
+    SocketCom_ReaperFree(impl, conn);
+  }
+
+  SocketCom_PollerDestroy(&impl->poller);
+  if (impl->wakeup.status & SOCKETCOM_STATE_CREATED) {
+    SocketCom_Dispose(&impl->wakeup);
+  }
+  if (impl->wakeup_fd >= 0) {
+    close(impl->wakeup_fd);
+  }
+  pthread_mutex_destroy(&impl->mutex);
+  free(impl);
+  reaper->impl = NULL;
+
+  return SOCKETCOM_SUCCESS;
+}
+
+int SocketCom_ReaperClose(SocketCom_Reaper *reaper, SocketCom *sock)
+{
+  SocketCom_ReaperImpl *impl = (SocketCom_ReaperImpl *)reaper->impl;
+  SocketCom_ReaperConn *conn;
+  char c = 0;
+  int res;
+
+  res = SocketCom_CloseStart(sock);
+  if (res != SOCKETCOM_SUCCESS) {
+    return res;
+  }
+  // the peer may have closed already
+  res = SocketCom_CloseDrain(sock);
+  if (res != SOCKETCOM_ERROR_WOULDBLOCK) {
+    return res;
+  }
+
+  conn = (SocketCom_ReaperConn *)calloc(1, sizeof(SocketCom_ReaperConn));
+  if (conn == NULL) {
+    SocketCom_Abort(sock);
+    return SOCKETCOM_ERROR_MEMORY;
+  }
+  conn->sock = *sock;
+  // the connection belongs to the reaper now
+  sock->status = SOCKETCOM_STATE_HAS_ADDR;
+
+  pthread_mutex_lock(&impl->mutex);
+  int wake = (impl->queue == NULL);
+  conn->next = impl->queue;
+  impl->queue = conn;
+  pthread_mutex_unlock(&impl->mutex);
+
+  if (wake && write(impl->wakeup_fd, &c, 1) < 0) {
+    PERROR("write() in SocketCom_ReaperClose()");
+  }
+
+  return SOCKETCOM_SUCCESS;
+}
+
+#else
+
+int SocketCom_ReaperCreate(SocketCom_Reaper *reaper, long timeout_msec)
+{
+  (void)timeout_msec;
+  reaper->impl = NULL;
+  return SOCKETCOM_ERROR_NOTSUPPORTED;
+}
+
+int SocketCom_ReaperDestroy(SocketCom_Reaper *reaper)
+{
+  (void)reaper;
+  return SOCKETCOM_ERROR_NOTSUPPORTED;
+}
+
+int SocketCom_ReaperClose(SocketCom_Reaper *reaper, SocketCom *sock)
+{
+  (void)reaper;
+  // close in the calling thread instead
+  return SocketCom_Close(sock);
+}
+
+#endif
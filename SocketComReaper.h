@@ -0,0 +1,54 @@
+/*
+SocketCom
+
+Copyright (c) 2017 r01hee
+
+This software is released under the MIT License.
+http://opensource.org/licenses/mit-license.php
+*/
+
+#ifndef __SOCKETCOM_REAPER_H__
+#define __SOCKETCOM_REAPER_H__
+
+#include "SocketCom.h"
+
+#define SOCKETCOM_REAPER_MAX_EVENTS 256
+
+/**
+ *  background thread finishing graceful closes
+ *  SocketCom_ReaperClose() returns at once; the thread discards data until FIN of the peer,
+ *  and closes abortively (SocketCom_Abort()) if the peer does not close within timeout
+ *
+ *  @attention  before to use struct SocketCom_Reaper, initialize by SocketCom_ReaperCreate()
+ *  @attention  not supported on WIN32
+ */
+typedef struct SocketCom_Reaper {
+  void *impl;
+} SocketCom_Reaper;
+
+/**
+ *  create reaper and start its thread
+ *
+ *  @param[out] reaper reaper
+ *  @param[in] timeout_msec timeout of each close; -1 for SOCKETCOM_CLOSE_TIMEOUT_MSEC
+ *  @retval SOCKETCOM_SUCCESS success
+ *  @retval !=SOCKETCOM_SUCCESS error
+ */
+int SocketCom_ReaperCreate(SocketCom_Reaper *reaper, long timeout_msec);
+
+/**
+ *  stop thread; closes in progress are finished abortively
+ */
+int SocketCom_ReaperDestroy(SocketCom_Reaper *reaper);
+
+/**
+ *  close sock in background
+ *  the connection is handed to reaper, and sock is closed for the caller when this function returns
+ *
+ *  @param sock[in/out] closed sock
+ *  @retval SOCKETCOM_SUCCESS success; closed, or will be closed
+ *  @retval !=SOCKETCOM_SUCCESS error; closed
+ */
+int SocketCom_ReaperClose(SocketCom_Reaper *reaper, SocketCom *sock);
+
+#endif
@@ -0,0 +1,564 @@
+/*
+SocketCom
+
+Copyright (c) 2017 r01hee
+
+This software is released under the MIT License.
+http://opensource.org/licenses/mit-license.php
+*/
+
+#include "SocketComResolver.h"
+
+#ifdef _SOCKETCOM_POSIX_
+
+#include <stdio.h>
+#include <errno.h>
+#include <time.h>
+#include <strings.h>
+#include <netdb.h>
+#include <arpa/inet.h>
+#include <pthread.h>
+
+#endif
+
+#include <string.h>
+#include <stdlib.h>
+
+#ifdef SOCKETCOM_NDEBUG
+#define PERROR(str) do{}while(0)
+#else
+#define PERROR(str) perror(str)
+#endif
+
+#ifdef _SOCKETCOM_POSIX_
+
+#define SOCKETCOM_RESOLVER_BUCKETS 256
+
+enum SOCKETCOM_RESOLVER_STATE {
+  SOCKETCOM_RESOLVER_STATE_PENDING = 1,
+  SOCKETCOM_RESOLVER_STATE_DONE = 2,
+};
+
+typedef struct SocketCom_ResolverWaiter {
+  SocketCom_ResolveCallback callback;
+  void *arg;
+  struct SocketCom_ResolverWaiter *next;
+} SocketCom_ResolverWaiter;
+
+typedef struct SocketCom_ResolverEntry {
+  char *hostname;
+  int family;
+  int state;
+  long long expires; // msec of CLOCK_MONOTONIC
+  int refs; // threads using the entry without the lock; not freed while refs > 0
+  SocketCom_ResolveResult result;
+  SocketCom_ResolverWaiter *waiters;
+  struct SocketCom_ResolverEntry *next; // in bucket
+  struct SocketCom_ResolverEntry *next_job; // in queue of pending entries
+} SocketCom_ResolverEntry;
+
+typedef struct SocketCom_ResolverImpl {
+  pthread_mutex_t mutex;
+  pthread_cond_t job_cond; // a job is queued
+  pthread_cond_t done_cond; // a job is done
+  pthread_t *threads;
+  int threads_len;
+  int stop;
+  long positive_ttl_msec;
+  long negative_ttl_msec;
+  SocketCom_ResolverEntry *buckets[SOCKETCOM_RESOLVER_BUCKETS];
+  SocketCom_ResolverEntry *jobs_head;
+  SocketCom_ResolverEntry *jobs_tail;
+  SocketCom_ResolverStats stats;
+} SocketCom_ResolverImpl;
+
+static long long SocketCom_ResolverNowMsec(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static unsigned int SocketCom_ResolverHash(const char *hostname, int family)
+{
+  // FNV-1a; host names are case insensitive
+  unsigned int h = 2166136261U;
+  for (; *hostname != '\0'; hostname++) {
+    char c = *hostname;
+    if (c >= 'A' && c <= 'Z') {
+      c += 'a' - 'A';
+    }
+    h = (h ^ (unsigned char)c) * 16777619U;
+  }
+  return (h ^ (unsigned int)family) % SOCKETCOM_RESOLVER_BUCKETS;
+}
+
+/**
+ *  convert an IP address string without resolving
+ *  an address of the other family than family fails with SOCKETCOM_ERROR_SLAVEHOSTNAME in result->res, as getaddrinfo() would
+ *
+ *  @retval 1 hostname is an IP address string; result is set
+ *  @retval 0 hostname is to be resolved
+ */
+static int SocketCom_ResolverNumeric(const char *hostname, int family, SocketCom_ResolveResult *result)
+{
+  struct sockaddr_in addr4;
+  struct sockaddr_in6 addr6;
+
+  memset(&addr4, 0, sizeof(addr4));
+  memset(&addr6, 0, sizeof(addr6));
+  memset(result, 0, sizeof(SocketCom_ResolveResult));
+  if (inet_pton(AF_INET, hostname, &addr4.sin_addr) == 1) {
+    if (family == AF_INET6) {
+      result->res = SOCKETCOM_ERROR_SLAVEHOSTNAME;
+      return 1;
+    }
+    addr4.sin_family = AF_INET;
+    memcpy(&result->addrs[0], &addr4, sizeof(addr4));
+    result->addrs_len = 1;
+    return 1;
+  }
+  if (inet_pton(AF_INET6, hostname, &addr6.sin6_addr) == 1) {
+    if (family == AF_INET) {
+      result->res = SOCKETCOM_ERROR_SLAVEHOSTNAME;
+      return 1;
+    }
+    addr6.sin6_family = AF_INET6;
+    memcpy(&result->addrs[0], &addr6, sizeof(addr6));
+    result->addrs_len = 1;
+    return 1;
+  }
+  return 0;
+}
+
+static void SocketCom_ResolverGetaddrinfo(const char *hostname, int family, SocketCom_ResolveResult *result)
+{
+  struct addrinfo hints, *resolved_addr, *ai;
+
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_family = family;
+  hints.ai_flags = AI_ADDRCONFIG;
+
+  memset(result, 0, sizeof(SocketCom_ResolveResult));
+  if (getaddrinfo(hostname, NULL, &hints, &resolved_addr) != 0) {
+    result->res = SOCKETCOM_ERROR_SLAVEHOSTNAME;
+    return;
+  }
+
+  for (ai = resolved_addr; ai != NULL && result->addrs_len < SOCKETCOM_RESOLVER_MAX_ADDRS; ai = ai->ai_next) {
+    if ((ai->ai_family != AF_INET && ai->ai_family != AF_INET6) || ai->ai_addrlen > sizeof(struct sockaddr_storage)) {
+      continue;
+    }
+    memcpy(&result->addrs[result->addrs_len], ai->ai_addr, ai->ai_addrlen);
+    result->addrs_len++;
+  }
+  freeaddrinfo(resolved_addr);
+
+  result->res = (result->addrs_len > 0) ? SOCKETCOM_SUCCESS : SOCKETCOM_ERROR_SLAVEHOSTNAME;
+}
+
+static void SocketCom_ResolverFreeEntry(SocketCom_ResolverEntry *entry)
+{
+  free(entry->hostname);
+  free(entry);
+}
+
+/**
+ *  find the entry of hostname, and free other entries of the bucket which are expired and not used
+ *  must be called with mutex locked
+ */
+static SocketCom_ResolverEntry *SocketCom_ResolverFind(SocketCom_ResolverImpl *impl, const char *hostname, int family, long long now)
+{
+  SocketCom_ResolverEntry **p = &impl->buckets[SocketCom_ResolverHash(hostname, family)];
+  SocketCom_ResolverEntry *found = NULL;
+
+  while (*p != NULL) {
+    SocketCom_ResolverEntry *entry = *p;
+    if (entry->family == family && strcasecmp(entry->hostname, hostname) == 0) {
+      found = entry;
+    } else if (entry->state == SOCKETCOM_RESOLVER_STATE_DONE && entry->expires <= now && entry->refs == 0) {
+      *p = entry->next;
+      SocketCom_ResolverFreeEntry(entry);
+      continue;
+    }
+    p = &entry->next;
+  }
+
+  return found;
+}
+
+/**
+ *  return the entry of hostname, and start resolving it unless it is cached or in progress
+ *  must be called with mutex locked
+ */
+static SocketCom_ResolverEntry *SocketCom_ResolverAcquire(SocketCom_ResolverImpl *impl, const char *hostname, int family, long long now)
+{
+  SocketCom_ResolverEntry *entry = SocketCom_ResolverFind(impl, hostname, family, now);
+
+  impl->stats.requests++;
+  if (entry == NULL) {
+    unsigned int bucket = SocketCom_ResolverHash(hostname, family);
+    entry = (SocketCom_ResolverEntry *)calloc(1, sizeof(SocketCom_ResolverEntry));
+    if (entry == NULL) {
+      return NULL;
+    }
+    entry->hostname = strdup(hostname);
+    if (entry->hostname == NULL) {
+      free(entry);
+      return NULL;
+    }
+    entry->family = family;
+    entry->next = impl->buckets[bucket];
+    impl->buckets[bucket] = entry;
+  } else if (entry->state == SOCKETCOM_RESOLVER_STATE_PENDING) {
+    impl->stats.coalesced++;
+    return entry;
+  } else if (entry->expires > now) {
+    impl->stats.cache_hits++;
+    if (entry->result.res != SOCKETCOM_SUCCESS) {
+      impl->stats.negative_hits++;
+    }
+    return entry;
+  }
+
+  entry->state = SOCKETCOM_RESOLVER_STATE_PENDING;
+  entry->next_job = NULL;
+  if (impl->jobs_tail != NULL) {
+    impl->jobs_tail->next_job = entry;
+  } else {
+    impl->jobs_head = entry;
+  }
+  impl->jobs_tail = entry;
+  pthread_cond_signal(&impl->job_cond);
+
+  return entry;
+}
+
+static void SocketCom_ResolverNotify(SocketCom_ResolverEntry *entry, SocketCom_ResolverWaiter *waiters, const SocketCom_ResolveResult *result)
+{
+  while (waiters != NULL) {
+    SocketCom_ResolverWaiter *next = waiters->next;
+    waiters->callback(entry->hostname, result, waiters->arg);
+    free(waiters);
+    waiters = next;
+  }
+}
+
+static void *SocketCom_ResolverMain(void *arg)
+{
+  SocketCom_ResolverImpl *impl = (SocketCom_ResolverImpl *)arg;
+  SocketCom_ResolveResult result;
+
+  pthread_mutex_lock(&impl->mutex);
+  while (1) {
+    while (!impl->stop && impl->jobs_head == NULL) {
+      pthread_cond_wait(&impl->job_cond, &impl->mutex);
+    }
+    if (impl->stop) {
+      break;
+    }
+
+    SocketCom_ResolverEntry *entry = impl->jobs_head;
+    impl->jobs_head = entry->next_job;
+    if (impl->jobs_head == NULL) {
+      impl->jobs_tail = NULL;
+    }
+    impl->stats.resolves++;
+    // hostname and family of a pending entry are not changed, and the entry is not freed
+    pthread_mutex_unlock(&impl->mutex);
+
+    SocketCom_ResolverGetaddrinfo(entry->hostname, entry->family, &result);
+
+    pthread_mutex_lock(&impl->mutex);
+    entry->result = result;
+    entry->expires = SocketCom_ResolverNowMsec() + ((result.res == SOCKETCOM_SUCCESS) ? impl->positive_ttl_msec : impl->negative_ttl_msec);
+    entry->state = SOCKETCOM_RESOLVER_STATE_DONE;
+    SocketCom_ResolverWaiter *waiters = entry->waiters;
+    entry->waiters = NULL;
+    pthread_cond_broadcast(&impl->done_cond);
+
+    if (waiters != NULL) {
+      entry->refs++;
+      pthread_mutex_unlock(&impl->mutex);
+      SocketCom_ResolverNotify(entry, waiters, &result);
+      pthread_mutex_lock(&impl->mutex);
+      entry->refs--;
+    }
+  }
+  pthread_mutex_unlock(&impl->mutex);
+
+  return NULL;
+}
+
+int SocketCom_ResolverCreate(SocketCom_Resolver *resolver, int threads, long positive_ttl_msec, long negative_ttl_msec)
+{
+  SocketCom_ResolverImpl *impl;
+  pthread_condattr_t attr;
+  int i;
+
+  resolver->impl = NULL;
+  if (threads <= 0) {
+    threads = SOCKETCOM_RESOLVER_DEFAULT_THREADS;
+  }
+
+  impl = (SocketCom_ResolverImpl *)calloc(1, sizeof(SocketCom_ResolverImpl));
+  if (impl == NULL) {
+    return SOCKETCOM_ERROR_MEMORY;
+  }
+  impl->threads = (pthread_t *)calloc(threads, sizeof(pthread_t));
+  if (impl->threads == NULL) {
+    free(impl);
+    return SOCKETCOM_ERROR_MEMORY;
+  }
+  impl->positive_ttl_msec = (positive_ttl_msec < 0) ? SOCKETCOM_RESOLVER_DEFAULT_POSITIVE_TTL_MSEC : positive_ttl_msec;
+  impl->negative_ttl_msec = (negative_ttl_msec < 0) ? SOCKETCOM_RESOLVER_DEFAULT_NEGATIVE_TTL_MSEC : negative_ttl_msec;
+
+  pthread_mutex_init(&impl->mutex, NULL);
+  pthread_cond_init(&impl->job_cond, NULL);
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  pthread_cond_init(&impl->done_cond, &attr);
+  pthread_condattr_destroy(&attr);
+  resolver->impl = impl;
+
+  for (i = 0; i < threads; i++) {
+    if (pthread_create(&impl->threads[i], NULL, SocketCom_ResolverMain, impl) != 0) {
+      PERROR("pthread_create() in SocketCom_ResolverCreate()");
+      SocketCom_ResolverDestroy(resolver);
+      return SOCKETCOM_ERROR_RESOLVER;
+    }
+    impl->threads_len++;
+  }
+
+  return SOCKETCOM_SUCCESS;
+}
+
+int SocketCom_ResolverDestroy(SocketCom_Resolver *resolver)
+{
+  SocketCom_ResolverImpl *impl = (SocketCom_ResolverImpl *)resolver->impl;
+  SocketCom_ResolveResult result;
+  int i;
+
+  if (impl == NULL) {
+    return SOCKETCOM_ERROR_RESOLVER;
+  }
+
+  pthread_mutex_lock(&impl->mutex);
+  impl->stop = 1;
+  pthread_cond_broadcast(&impl->job_cond);
+  pthread_mutex_unlock(&impl->mutex);
+  for (i = 0; i < impl->threads_len; i++) {
+    pthread_join(impl->threads[i], NULL);
+  }
+
+  memset(&result, 0, sizeof(result));
+  result.res = SOCKETCOM_ERROR_RESOLVER;
+  for (i = 0; i < SOCKETCOM_RESOLVER_BUCKETS; i++) {
+    while (impl->buckets[i] != NULL) {
+      SocketCom_ResolverEntry *entry = impl->buckets[i];
+      impl->buckets[i] = entry->next;
+      SocketCom_ResolverNotify(entry, entry->waiters, &result);
+      SocketCom_ResolverFreeEntry(entry);
+    }
+  }
+
+  pthread_cond_destroy(&impl->done_cond);
+  pthread_cond_destroy(&impl->job_cond);
+  pthread_mutex_destroy(&impl->mutex);
+  free(impl->threads);
+  free(impl);
+  resolver->impl = NULL;
+
+  return SOCKETCOM_SUCCESS;
+}
+
+int SocketCom_ResolverResolve(SocketCom_Resolver *resolver, const char *hostname, int family, SocketCom_ResolveCallback callback, void *arg)
+{
+  SocketCom_ResolverImpl *impl = (SocketCom_ResolverImpl *)resolver->impl;
+  SocketCom_ResolveResult result;
+
+  if (SocketCom_ResolverNumeric(hostname, family, &result)) {
+    callback(hostname, &result, arg);
+    return SOCKETCOM_SUCCESS;
+  }
+
+  SocketCom_ResolverWaiter *waiter = (SocketCom_ResolverWaiter *)malloc(sizeof(SocketCom_ResolverWaiter));
+  if (waiter == NULL) {
+    return SOCKETCOM_ERROR_MEMORY;
+  }
+  waiter->callback = callback;
+  waiter->arg = arg;
+
+  pthread_mutex_lock(&impl->mutex);
+  SocketCom_ResolverEntry *entry = SocketCom_ResolverAcquire(impl, hostname, family, SocketCom_ResolverNowMsec());
+  if (entry == NULL) {
+    pthread_mutex_unlock(&impl->mutex);
+    free(waiter);
+    return SOCKETCOM_ERROR_MEMORY;
+  }
+  if (entry->state == SOCKETCOM_RESOLVER_STATE_DONE) {
+    // cached
+    result = entry->result;
+    pthread_mutex_unlock(&impl->mutex);
+    free(waiter);
+    callback(hostname, &result, arg);
+    return SOCKETCOM_SUCCESS;
+  }
+  waiter->next = entry->waiters;
+  entry->waiters = waiter;
+  pthread_mutex_unlock(&impl->mutex);
+
+  return SOCKETCOM_SUCCESS;
+}
+
+int SocketCom_ResolverLookup(SocketCom_Resolver *resolver, const char *hostname, int family, SocketCom_ResolveResult *result, long timeout_msec)
+{
+  SocketCom_ResolverImpl *impl = (SocketCom_ResolverImpl *)resolver->impl;
+  struct timespec deadline;
+  int res = SOCKETCOM_SUCCESS;
+
+  if (SocketCom_ResolverNumeric(hostname, family, result)) {
+    return result->res;
+  }
+
+  if (timeout_msec > 0) {
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += timeout_msec / 1000;
+    deadline.tv_nsec += (timeout_msec % 1000) * 1000000;
+    if (deadline.tv_nsec >= 1000000000) {
+      deadline.tv_sec++;
+      deadline.tv_nsec -= 1000000000;
+    }
+  }
+
+  pthread_mutex_lock(&impl->mutex);
+  SocketCom_ResolverEntry *entry = SocketCom_ResolverAcquire(impl, hostname, family, SocketCom_ResolverNowMsec());
+  if (entry == NULL) {
+    pthread_mutex_unlock(&impl->mutex);
+    return SOCKETCOM_ERROR_MEMORY;
+  }
+
+  entry->refs++;
+  while (entry->state == SOCKETCOM_RESOLVER_STATE_PENDING) {
+    if (timeout_msec == 0) {
+      res = SOCKETCOM_ERROR_TIMEOUT_RESOLVER;
+      break;
+    }
+    if (timeout_msec < 0) {
+      pthread_cond_wait(&impl->done_cond, &impl->mutex);
+    } else if (pthread_cond_timedwait(&impl->done_cond, &impl->mutex, &deadline) == ETIMEDOUT
+               && entry->state == SOCKETCOM_RESOLVER_STATE_PENDING) {
+      res = SOCKETCOM_ERROR_TIMEOUT_RESOLVER;
+      break;
+    }
+  }
+  if (res == SOCKETCOM_SUCCESS) {
+    *result = entry->result;
+    res = result->res;
+  }
+  entry->refs--;
+  pthread_mutex_unlock(&impl->mutex);
+
+  return res;
+}
+
+int SocketCom_ResolverConnect(SocketCom_Resolver *resolver, SocketCom *sock, const char *hostname, u_short port, long timeout_msec)
+{
+  SocketCom_ResolveResult result;
+  long long start = SocketCom_ResolverNowMsec();
+
+  int res = SocketCom_ResolverLookup(resolver, hostname, AF_UNSPEC, &result, timeout_msec);
+  if (res != SOCKETCOM_SUCCESS) {
+    return res;
+  }
+
+  if (timeout_msec >= 0) {
+    long long elapsed = SocketCom_ResolverNowMsec() - start;
+    timeout_msec = (elapsed < timeout_msec) ? (long)(timeout_msec - elapsed) : 0;
+  }
+
+  return SocketCom_ConnectAddrs(sock, result.addrs, result.addrs_len, port, timeout_msec);
+}
+
+int SocketCom_ResolverFlush(SocketCom_Resolver *resolver)
+{
+  SocketCom_ResolverImpl *impl = (SocketCom_ResolverImpl *)resolver->impl;
+  int i;
+
+  pthread_mutex_lock(&impl->mutex);
+  for (i = 0; i < SOCKETCOM_RESOLVER_BUCKETS; i++) {
+    SocketCom_ResolverEntry **p = &impl->buckets[i];
+    while (*p != NULL) {
+      SocketCom_ResolverEntry *entry = *p;
+      if (entry->state == SOCKETCOM_RESOLVER_STATE_DONE && entry->refs == 0) {
+        *p = entry->next;
+        SocketCom_ResolverFreeEntry(entry);
+        continue;
+      }
+      p = &entry->next;
+    }
+  }
+  pthread_mutex_unlock(&impl->mutex);
+
+  return SOCKETCOM_SUCCESS;
+}
+
+int SocketCom_ResolverGetStats(SocketCom_Resolver *resolver, SocketCom_ResolverStats *stats)
+{
+  SocketCom_ResolverImpl *impl = (SocketCom_ResolverImpl *)resolver->impl;
+
+  pthread_mutex_lock(&impl->mutex);
+  *stats = impl->stats;
+  pthread_mutex_unlock(&impl->mutex);
+
+  return SOCKETCOM_SUCCESS;
+}
+
+#else
+
+int SocketCom_ResolverCreate(SocketCom_Resolver *resolver, int threads, long positive_ttl_msec, long negative_ttl_msec)
+{
+  (void)threads; (void)positive_ttl_msec; (void)negative_ttl_msec;
+  resolver->impl = NULL;
+  return SOCKETCOM_ERROR_NOTSUPPORTED;
+}
+
+int SocketCom_ResolverDestroy(SocketCom_Resolver *resolver)
+{
+  (void)resolver;
+  return SOCKETCOM_ERROR_NOTSUPPORTED;
+}
+
+int SocketCom_ResolverResolve(SocketCom_Resolver *resolver, const char *hostname, int family, SocketCom_ResolveCallback callback, void *arg)
+{
+  (void)resolver; (void)hostname; (void)family; (void)callback; (void)arg;
+  return SOCKETCOM_ERROR_NOTSUPPORTED;
+}
+
+int SocketCom_ResolverLookup(SocketCom_Resolver *resolver, const char *hostname, int family, SocketCom_ResolveResult *result, long timeout_msec)
+{
+  (void)resolver; (void)hostname; (void)family; (void)result; (void)timeout_msec;
+  return SOCKETCOM_ERROR_NOTSUPPORTED;
+}
+
+int SocketCom_ResolverConnect(SocketCom_Resolver *resolver, SocketCom *sock, const char *hostname, u_short port, long timeout_msec)
+{
+  (void)resolver; (void)sock; (void)hostname; (void)port; (void)timeout_msec;
+  return SOCKETCOM_ERROR_NOTSUPPORTED;
+}
+
+int SocketCom_ResolverFlush(SocketCom_Resolver *resolver)
+{
+  (void)resolver;
+  return SOCKETCOM_ERROR_NOTSUPPORTED;
+}
+
+int SocketCom_ResolverGetStats(SocketCom_Resolver *resolver, SocketCom_ResolverStats *stats)
+{
+  (void)resolver;
+  memset(stats, 0, sizeof(SocketCom_ResolverStats));
+  return SOCKETCOM_ERROR_NOTSUPPORTED;
+}
+
+#endif
@@ -0,0 +1,134 @@
+/*
+SocketCom
+
+Copyright (c) 2017 r01hee
+
+This software is released under the MIT License.
+http://opensource.org/licenses/mit-license.php
+*/
+
+#ifndef __SOCKETCOM_RESOLVER_H__
+#define __SOCKETCOM_RESOLVER_H__
+
+#include "SocketCom.h"
+
+#ifdef _SOCKETCOM_WIN32_
+#include <ws2tcpip.h>
+#else
+#include <sys/socket.h>
+#endif
+
+#define SOCKETCOM_RESOLVER_MAX_ADDRS 16
+#define SOCKETCOM_RESOLVER_DEFAULT_THREADS 4
+#define SOCKETCOM_RESOLVER_DEFAULT_POSITIVE_TTL_MSEC (60 * 1000)
+#define SOCKETCOM_RESOLVER_DEFAULT_NEGATIVE_TTL_MSEC (5 * 1000)
+
+/**
+ *  result of resolving a host name
+ */
+typedef struct SocketCom_ResolveResult {
+  int res; // SOCKETCOM_SUCCESS, or SOCKETCOM_ERROR_SLAVEHOSTNAME if the name is not resolved
+  int addrs_len;
+  struct sockaddr_storage addrs[SOCKETCOM_RESOLVER_MAX_ADDRS]; // IPv4(A) and IPv6(AAAA) addresses in the order of getaddrinfo(); ports are 0
+} SocketCom_ResolveResult;
+
+/**
+ *  counters of a resolver
+ */
+typedef struct SocketCom_ResolverStats {
+  unsigned long long requests; // names given to SocketCom_ResolverResolve()/SocketCom_ResolverLookup(), except IP address strings
+  unsigned long long cache_hits; // requests answered from the cache, including negative_hits
+  unsigned long long negative_hits; // requests answered by a cached failure
+  unsigned long long coalesced; // requests which joined a getaddrinfo() in progress
+  unsigned long long resolves; // getaddrinfo() calls
+} SocketCom_ResolverStats;
+
+/**
+ *  called with the result of SocketCom_ResolverResolve()
+ *  on the calling thread if the result is cached, otherwise on a thread of the resolver
+ */
+typedef void (*SocketCom_ResolveCallback)(const char *hostname, const SocketCom_ResolveResult *result, void *arg);
+
+/**
+ *  asynchronous caching resolver
+ *  host names are resolved by getaddrinfo() on a pool of threads; concurrent requests for the same name share one getaddrinfo(),
+ *  and results are cached for positive_ttl_msec (resolved) or negative_ttl_msec (not resolved)
+ *
+ *  getaddrinfo() does not tell TTLs of DNS records, so the TTLs of the cache are given by the application
+ *
+ *  @attention  before to use struct SocketCom_Resolver, initialize by SocketCom_ResolverCreate()
+ *  @attention  not supported on WIN32
+ */
+typedef struct SocketCom_Resolver {
+  void *impl;
+} SocketCom_Resolver;
+
+/**
+ *  create resolver and start its threads
+ *
+ *  @param[out] resolver resolver
+ *  @param[in] threads number of threads; 0 for SOCKETCOM_RESOLVER_DEFAULT_THREADS
+ *  @param[in] positive_ttl_msec lifetime of cached addresses; -1 for SOCKETCOM_RESOLVER_DEFAULT_POSITIVE_TTL_MSEC, 0 not to cache
+ *  @param[in] negative_ttl_msec lifetime of cached failures; -1 for SOCKETCOM_RESOLVER_DEFAULT_NEGATIVE_TTL_MSEC, 0 not to cache
+ *  @retval SOCKETCOM_SUCCESS success
+ *  @retval !=SOCKETCOM_SUCCESS error
+ */
+int SocketCom_ResolverCreate(SocketCom_Resolver *resolver, int threads, long positive_ttl_msec, long negative_ttl_msec);
+
+/**
+ *  stop threads and free cache
+ *  callbacks of requests in progress are called with SOCKETCOM_ERROR_RESOLVER
+ *
+ *  @attention  no thread may be in SocketCom_ResolverLookup() of this resolver
+ */
+int SocketCom_ResolverDestroy(SocketCom_Resolver *resolver);
+
+/**
+ *  resolve hostname asynchronously
+ *  an IP address string is converted without resolving; one of the other family than family fails with SOCKETCOM_ERROR_SLAVEHOSTNAME
+ *
+ *  @param[in] hostname host name such as xxxxx.com
+ *  @param[in] family AF_UNSPEC for both IPv4 and IPv6, AF_INET or AF_INET6
+ *  @param[in] callback called with the result once
+ *  @param[in] arg given to callback
+ *  @retval SOCKETCOM_SUCCESS callback is called, or will be called
+ *  @retval SOCKETCOM_ERROR_MEMORY error
+ */
+int SocketCom_ResolverResolve(SocketCom_Resolver *resolver, const char *hostname, int family, SocketCom_ResolveCallback callback, void *arg);
+
+/**
+ *  resolve hostname, waiting for the result unless timeout
+ *
+ *  @param[out] result result
+ *  @param[in] timeout_msec -1 for unlimited; 0 to return only a cached result (resolving starts in background otherwise)
+ *  @retval SOCKETCOM_SUCCESS hostname is resolved
+ *  @retval SOCKETCOM_ERROR_SLAVEHOSTNAME hostname is not resolved
+ *  @retval SOCKETCOM_ERROR_TIMEOUT_RESOLVER timeout; resolving continues in background and its result is cached
+ *  @retval !=SOCKETCOM_SUCCESS error
+ */
+int SocketCom_ResolverLookup(SocketCom_Resolver *resolver, const char *hostname, int family, SocketCom_ResolveResult *result, long timeout_msec);
+
+/**
+ *  resolve hostname by SocketCom_ResolverLookup(), and connect by SocketCom_ConnectAddrs() racing all its addresses
+ *
+ *  @param[in/out] sock sock which is not created
+ *  @param[in] timeout_msec timeout of resolving and connecting; -1 for unlimited
+ *  @retval SOCKETCOM_SUCCESS success
+ *  @retval !=SOCKETCOM_SUCCESS same as SocketCom_ResolverLookup() or SocketCom_ConnectAddrs()
+ */
+int SocketCom_ResolverConnect(SocketCom_Resolver *resolver, SocketCom *sock, const char *hostname, u_short port, long timeout_msec);
+
+/**
+ *  drop all cached results
+ */
+int SocketCom_ResolverFlush(SocketCom_Resolver *resolver);
+
+/**
+ *  counters of resolver
+ *
+ *  @param[out] stats counters
+ *  @retval SOCKETCOM_SUCCESS success
+ */
+int SocketCom_ResolverGetStats(SocketCom_Resolver *resolver, SocketCom_ResolverStats *stats);
+
+#endif
@@ -0,0 +1,311 @@
+/*
+SocketCom
+
+Copyright (c) 2017 r01hee
+
+This software is released under the MIT License.
+http://opensource.org/licenses/mit-license.php
+*/
+
+#include "SocketComShard.h"
+
+#ifdef _SOCKETCOM_POSIX_
+
+#include <stdio.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#ifdef _SOCKETCOM_LINUX_
+#include <sched.h>
+#endif
+
+#endif
+
+#include <string.h>
+#include <stdlib.h>
+
+#ifdef SOCKETCOM_NDEBUG
+#define PERROR(str) do{}while(0)
+#else
+#define PERROR(str) perror(str)
+#endif
+
+#ifdef _SOCKETCOM_POSIX_
+
+static long long SocketCom_ShardNowMsec(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ *  keep the level-triggered listening sock from waking the shard up again and again for an accept which keeps failing
+ */
+static void SocketCom_ShardAcceptError(SocketCom_Shard *shard, int err)
+{
+  if ((err == EMFILE || err == ENFILE) && shard->reserve_fd >= 0) {
+    // free one fd to accept and close the first pending connection; the queue drains instead of staying readable
+    close(shard->reserve_fd);
+    int fd = accept(shard->listener.fd, NULL, NULL);
+    if (fd >= 0) {
+      close(fd);
+    }
+    shard->reserve_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+      return;
+    }
+  }
+
+  PERROR("accept() in SocketCom_ShardAcceptError()");
+  if (SocketCom_PollerModify(&shard->poller, &shard->listener, 0) == SOCKETCOM_SUCCESS) {
+    shard->accept_resume_msec = SocketCom_ShardNowMsec() + SOCKETCOM_SHARD_ACCEPT_BACKOFF_MSEC;
+  }
+}
+
+static void SocketCom_ShardAccept(SocketCom_Shard *shard)
+{
+  SocketCom_ShardedListener *listener = shard->owner;
+  SocketCom connectedSocks[SOCKETCOM_SHARD_ACCEPT_BATCH];
+  int i;
+
+  // the listening sock is non-blocking; drain the accept queue
+  while (1) {
+    int connectedSocks_len = SOCKETCOM_SHARD_ACCEPT_BATCH;
+    int res = SocketCom_AcceptMany(&shard->listener, connectedSocks, &connectedSocks_len);
+    if (res != SOCKETCOM_SUCCESS) {
+      if (res == SOCKETCOM_ERROR_ACCEPT) {
+        SocketCom_ShardAcceptError(shard, errno);
+      }
+      break;
+    }
+    for (i = 0; i < connectedSocks_len; i++) {
+      listener->on_accept(shard, &connectedSocks[i], listener->arg);
+    }
+    if (connectedSocks_len < SOCKETCOM_SHARD_ACCEPT_BATCH) {
+      break;
+    }
+  }
+}
+
+static void *SocketCom_ShardMain(void *arg)
+{
+  SocketCom_Shard *shard = (SocketCom_Shard *)arg;
+  SocketCom_ShardedListener *listener = shard->owner;
+  SocketCom_PollEvent events[SOCKETCOM_SHARD_MAX_EVENTS];
+  int i;
+
+  while (!__atomic_load_n(&listener->stop, __ATOMIC_ACQUIRE)) {
+    int events_len = SOCKETCOM_SHARD_MAX_EVENTS;
+    long timeout_sec = -1;
+    long timeout_usec = -1;
+    if (shard->accept_resume_msec != 0) {
+      long long wait_msec = shard->accept_resume_msec - SocketCom_ShardNowMsec();
+      if (wait_msec <= 0) {
+        if (SocketCom_PollerModify(&shard->poller, &shard->listener, SOCKETCOM_POLL_IN) == SOCKETCOM_SUCCESS) {
+          shard->accept_resume_msec = 0;
+        }
+      } else {
+        timeout_sec = (long)(wait_msec / 1000);
+        timeout_usec = (long)(wait_msec % 1000) * 1000;
+      }
+    }
+    int res = SocketCom_PollerWait(&shard->poller, events, &events_len, timeout_sec, timeout_usec);
+    if (res != SOCKETCOM_SUCCESS) {
+      continue;
+    }
+    for (i = 0; i < events_len; i++) {
+      SocketCom *sock = events[i].sock;
+      if (sock == &shard->listener) {
+        SocketCom_ShardAccept(shard);
+      } else if (sock == &shard->wakeup) {
+        // only woken up by SocketCom_ShardedListenerStop()
+      } else if (listener->on_event != NULL) {
+        listener->on_event(shard, sock, events[i].events, listener->arg);
+      }
+    }
+  }
+
+  return NULL;
+}
+
+static void SocketCom_ShardClose(SocketCom_Shard *shard)
+{
+  SocketCom_PollerDestroy(&shard->poller);
+  if (shard->listener.status & SOCKETCOM_STATE_CREATED) {
+    SocketCom_Dispose(&shard->listener);
+  }
+  if (shard->wakeup.status & SOCKETCOM_STATE_CREATED) {
+    SocketCom_Dispose(&shard->wakeup);
+  }
+  if (shard->wakeup_fd >= 0) {
+    close(shard->wakeup_fd);
+    shard->wakeup_fd = -1;
+  }
+  if (shard->reserve_fd >= 0) {
+    close(shard->reserve_fd);
+    shard->reserve_fd = -1;
+  }
+}
+
+static int SocketCom_ShardOpenSocks(SocketCom_Shard *shard, const char *ip, u_short port, int backlog)
+{
+  int res;
+  int fds[2];
+
+  if (pipe(fds) < 0) {
+    PERROR("pipe() in SocketCom_ShardOpenSocks()");
+    return SOCKETCOM_ERROR_CREATE;
+  }
+  fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+  fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+  shard->wakeup.fd = fds[0];
+  shard->wakeup.status = SOCKETCOM_STATE_CREATED;
+  shard->wakeup_fd = fds[1];
+
+  // without it accept errors fall back to disarming the listening sock
+  shard->reserve_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+
+  res = SocketCom_CreateEx(&shard->listener, (ip != NULL && strchr(ip, ':') != NULL) ? AF_INET6 : AF_INET, SOCK_STREAM);
+  if (res != SOCKETCOM_SUCCESS) {
+    return res;
+  }
+  res = SocketCom_ListenEx(&shard->listener, ip, port, backlog, SOCKETCOM_LISTEN_FLAG_REUSEADDR | SOCKETCOM_LISTEN_FLAG_REUSEPORT);
+  if (res != SOCKETCOM_SUCCESS) {
+    return res;
+  }
+  res = SocketCom_SetNonBlockingSocket(&shard->listener);
+  if (res != SOCKETCOM_SUCCESS) {
+    return res;
+  }
+
+  res = SocketCom_PollerAdd(&shard->poller, &shard->listener, SOCKETCOM_POLL_IN);
+  if (res != SOCKETCOM_SUCCESS) {
+    return res;
+  }
+  return SocketCom_PollerAdd(&shard->poller, &shard->wakeup, SOCKETCOM_POLL_IN);
+}
+
+static int SocketCom_ShardOpen(SocketCom_Shard *shard, const char *ip, u_short port, int backlog)
+{
+  int res;
+
+  SocketCom_Init(&shard->listener);
+  SocketCom_Init(&shard->wakeup);
+  shard->wakeup_fd = -1;
+  shard->reserve_fd = -1;
+  shard->accept_resume_msec = 0;
+
+  res = SocketCom_PollerCreate(&shard->poller, SOCKETCOM_SHARD_MAX_EVENTS);
+  if (res != SOCKETCOM_SUCCESS) {
+    return res;
+  }
+
+  res = SocketCom_ShardOpenSocks(shard, ip, port, backlog);
+  if (res != SOCKETCOM_SUCCESS) {
+    SocketCom_ShardClose(shard);
+  }
+  return res;
+}
+
+int SocketCom_ShardedListenerStart(SocketCom_ShardedListener *listener, const char *ip, u_short port, int backlog, int shards_len, int flags,
+                                   SocketCom_ShardAcceptCallback on_accept, SocketCom_ShardEventCallback on_event, void *arg)
+{
+  int res;
+  int i;
+
+  if (shards_len <= 0 || on_accept == NULL) {
+    return SOCKETCOM_ERROR_ILLEGAL_SOCK;
+  }
+
+  listener->shards = (SocketCom_Shard *)calloc(shards_len, sizeof(SocketCom_Shard));
+  if (listener->shards == NULL) {
+    return SOCKETCOM_ERROR_MEMORY;
+  }
+  listener->shards_len = 0;
+  listener->on_accept = on_accept;
+  listener->on_event = on_event;
+  listener->arg = arg;
+  __atomic_store_n(&listener->stop, 0, __ATOMIC_RELEASE);
+
+  // open all listening socks before starting threads, so that no shard misses the first connections
+  for (i = 0; i < shards_len; i++) {
+    SocketCom_Shard *shard = &listener->shards[i];
+    shard->index = i;
+    shard->owner = listener;
+    res = SocketCom_ShardOpen(shard, ip, port, backlog);
+    if (res != SOCKETCOM_SUCCESS) {
+      SocketCom_ShardedListenerStop(listener);
+      return res;
+    }
+    listener->shards_len++;
+  }
+
+  for (i = 0; i < shards_len; i++) {
+    SocketCom_Shard *shard = &listener->shards[i];
+    if (pthread_create(&shard->thread, NULL, SocketCom_ShardMain, shard) != 0) {
+      PERROR("pthread_create() in SocketCom_ShardedListenerStart()");
+      SocketCom_ShardedListenerStop(listener);
+      return SOCKETCOM_ERROR_CREATE;
+    }
+    shard->running = 1;
+#ifdef _SOCKETCOM_LINUX_
+    if (flags & SOCKETCOM_SHARD_FLAG_PIN_CPU) {
+      long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      CPU_SET((cpus > 0) ? (i % cpus) : 0, &set);
+      pthread_setaffinity_np(shard->thread, sizeof(set), &set);
+    }
+#else
+    (void)flags;
+#endif
+  }
+
+  return SOCKETCOM_SUCCESS;
+}
+
+int SocketCom_ShardedListenerStop(SocketCom_ShardedListener *listener)
+{
+  int i;
+  char c = 0;
+
+  __atomic_store_n(&listener->stop, 1, __ATOMIC_RELEASE);
+  for (i = 0; i < listener->shards_len; i++) {
+    SocketCom_Shard *shard = &listener->shards[i];
+    if (shard->running) {
+      if (write(shard->wakeup_fd, &c, 1) < 0) {
+        PERROR("write() in SocketCom_ShardedListenerStop()");
+      }
+      pthread_join(shard->thread, NULL);
+      shard->running = 0;
+    }
+    SocketCom_ShardClose(shard);
+  }
+
+  free(listener->shards);
+  listener->shards = NULL;
+  listener->shards_len = 0;
+
+  return SOCKETCOM_SUCCESS;
+}
+
+#else
+
+int SocketCom_ShardedListenerStart(SocketCom_ShardedListener *listener, const char *ip, u_short port, int backlog, int shards_len, int flags,
+                                   SocketCom_ShardAcceptCallback on_accept, SocketCom_ShardEventCallback on_event, void *arg)
+{
+  (void)ip; (void)port; (void)backlog; (void)shards_len; (void)flags; (void)on_accept; (void)on_event; (void)arg;
+  listener->shards = NULL;
+  listener->shards_len = 0;
+  return SOCKETCOM_ERROR_NOTSUPPORTED;
+}
+
+int SocketCom_ShardedListenerStop(SocketCom_ShardedListener *listener)
+{
+  (void)listener;
+  return SOCKETCOM_ERROR_NOTSUPPORTED;
+}
+
+#endif
@@ -0,0 +1,100 @@
+/*
+SocketCom
+
+Copyright (c) 2017 r01hee
+
+This software is released under the MIT License.
+http://opensource.org/licenses/mit-license.php
+*/
+
+#ifndef __SOCKETCOM_SHARD_H__
+#define __SOCKETCOM_SHARD_H__
+
+#include "SocketCom.h"
+
+#ifdef _SOCKETCOM_POSIX_
+#include <pthread.h>
+#endif
+
+#define SOCKETCOM_SHARD_MAX_EVENTS 256
+#define SOCKETCOM_SHARD_ACCEPT_BATCH 64
+
+// time the listening sock of a shard is disarmed after an accept error, instead of spinning on the readable sock
+#ifndef SOCKETCOM_SHARD_ACCEPT_BACKOFF_MSEC
+#define SOCKETCOM_SHARD_ACCEPT_BACKOFF_MSEC 100
+#endif
+
+enum SOCKETCOM_SHARD_FLAG {
+  SOCKETCOM_SHARD_FLAG_NONE = 0x00,
+  SOCKETCOM_SHARD_FLAG_PIN_CPU = 0x01, // pin the thread of shard i to CPU (i % number of CPUs); Linux only
+};
+
+struct SocketCom_Shard;
+
+/**
+ *  called on the thread of shard for each accepted connection
+ *
+ *  connectedSock is non-blocking, and valid only while the callback runs; copy it to keep the connection.
+ *  to handle the connection on the shard, register the copy to shard->poller; its events are given to SocketCom_ShardEventCallback
+ */
+typedef void (*SocketCom_ShardAcceptCallback)(struct SocketCom_Shard *shard, SocketCom *connectedSock, void *arg);
+
+/**
+ *  called on the thread of shard for each event of sockets registered to shard->poller by the application
+ */
+typedef void (*SocketCom_ShardEventCallback)(struct SocketCom_Shard *shard, SocketCom *sock, int events, void *arg);
+
+typedef struct SocketCom_Shard {
+  int index;
+  SocketCom listener;
+  SocketCom wakeup; // read end of the pipe waking up the thread
+  SocketCom_Poller poller;
+  struct SocketCom_ShardedListener *owner;
+#ifdef _SOCKETCOM_POSIX_
+  int wakeup_fd; // write end
+  int reserve_fd; // given up to accept and drop a connection when out of fds
+  long long accept_resume_msec; // the listening sock is disarmed until then after an accept error; 0 if armed
+  pthread_t thread;
+  int running;
+#endif
+} SocketCom_Shard;
+
+/**
+ *  N listening socks bound to the same port by SO_REUSEPORT, each with its own thread, accept loop and poller
+ *
+ *  @attention  not supported on WIN32
+ */
+typedef struct SocketCom_ShardedListener {
+  SocketCom_Shard *shards;
+  int shards_len;
+  SocketCom_ShardAcceptCallback on_accept;
+  SocketCom_ShardEventCallback on_event;
+  void *arg;
+  int stop; // accessed by __atomic builtins
+} SocketCom_ShardedListener;
+
+/**
+ *  open shards_len listening socks on ip:port and start their threads
+ *
+ *  @param[out] listener listener
+ *  @param[in] ip IPv4 or IPv6 address to bind; NULL to bind to any IPv4 address
+ *  @param[in] port port to listen
+ *  @param[in] backlog backlog of each shard
+ *  @param[in] shards_len number of shards(threads)
+ *  @param[in] flags OR of SOCKETCOM_SHARD_FLAG
+ *  @param[in] on_accept called for each accepted connection
+ *  @param[in] on_event called for each event of sockets registered by the application; may be NULL
+ *  @param[in] arg given to the callbacks
+ *  @retval SOCKETCOM_SUCCESS success
+ *  @retval !=SOCKETCOM_SUCCESS error
+ */
+int SocketCom_ShardedListenerStart(SocketCom_ShardedListener *listener, const char *ip, u_short port, int backlog, int shards_len, int flags,
+                                   SocketCom_ShardAcceptCallback on_accept, SocketCom_ShardEventCallback on_event, void *arg);
+
+/**
+ *  stop all shard threads, and close the listening socks
+ *  sockets registered by the application are not closed
+ */
+int SocketCom_ShardedListenerStop(SocketCom_ShardedListener *listener);
+
+#endif
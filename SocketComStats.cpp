@@ -0,0 +1,182 @@
+/*
+SocketCom
+
+Copyright (c) 2017 r01hee
+
+This software is released under the MIT License.
+http://opensource.org/licenses/mit-license.php
+*/
+
+#include "SocketComStats.h"
+
+#ifdef SOCKETCOM_USE_STATS
+
+#include <errno.h>
+#include <string.h>
+#include <new>
+#include <atomic>
+
+/**
+ *  counters of a thread; linked into the list of all shards and never freed.
+ *  when the thread exits, the shard is released with its counters, and taken over by a new thread
+ */
+typedef struct SocketCom_StatsShard {
+  SocketCom_Stats stats;
+  struct SocketCom_StatsShard *next;
+  std::atomic<int> in_use;
+} SocketCom_StatsShard;
+
+static std::atomic<SocketCom_StatsShard *> SocketCom_stats_shards(NULL);
+
+// used when a shard cannot be allocated; counts of such threads may be lost by races
+static SocketCom_StatsShard SocketCom_stats_spare;
+
+thread_local SocketCom_Stats *SocketCom_stats_shard = NULL;
+
+/**
+ *  releases the shard of a thread when the thread exits
+ */
+struct SocketCom_StatsShardOwner {
+  SocketCom_StatsShard *shard;
+  ~SocketCom_StatsShardOwner()
+  {
+    if (shard != NULL) {
+      SocketCom_stats_shard = NULL;
+      shard->in_use.store(0, std::memory_order_release);
+    }
+  }
+};
+
+static thread_local SocketCom_StatsShardOwner SocketCom_stats_owner = { NULL };
+
+SocketCom_Stats *SocketCom_StatsAttachShard(void)
+{
+  SocketCom_StatsShard *shard;
+  int err = errno; // callers read errno after counting
+
+  // take over a released shard
+  for (shard = SocketCom_stats_shards.load(std::memory_order_acquire); shard != NULL; shard = shard->next) {
+    int expected = 0;
+    if (shard->in_use.load(std::memory_order_relaxed) == 0 && shard->in_use.compare_exchange_strong(expected, 1, std::memory_order_acquire)) {
+      break;
+    }
+  }
+
+  if (shard == NULL) {
+    shard = new (std::nothrow) SocketCom_StatsShard;
+    if (shard == NULL) {
+      errno = err;
+      SocketCom_stats_shard = &SocketCom_stats_spare.stats;
+      return SocketCom_stats_shard;
+    }
+    memset(&shard->stats, 0, sizeof(shard->stats));
+    shard->in_use.store(1, std::memory_order_relaxed);
+    shard->next = SocketCom_stats_shards.load(std::memory_order_relaxed);
+    while (!SocketCom_stats_shards.compare_exchange_weak(shard->next, shard, std::memory_order_release, std::memory_order_relaxed)) {
+    }
+  }
+
+  SocketCom_stats_owner.shard = shard;
+  SocketCom_stats_shard = &shard->stats;
+  errno = err;
+  return SocketCom_stats_shard;
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+#define SOCKETCOM_STATS_LOAD(counter) __atomic_load_n(&(counter), __ATOMIC_RELAXED)
+#else
+#define SOCKETCOM_STATS_LOAD(counter) (counter)
+#endif
+
+static void SocketCom_StatsSum(SocketCom_Stats *sum, const SocketCom_Stats *stats)
+{
+  int i;
+
+  sum->bytes_recv += SOCKETCOM_STATS_LOAD(stats->bytes_recv);
+  sum->bytes_sent += SOCKETCOM_STATS_LOAD(stats->bytes_sent);
+  sum->recv_calls += SOCKETCOM_STATS_LOAD(stats->recv_calls);
+  sum->send_calls += SOCKETCOM_STATS_LOAD(stats->send_calls);
+  sum->short_recvs += SOCKETCOM_STATS_LOAD(stats->short_recvs);
+  sum->short_sends += SOCKETCOM_STATS_LOAD(stats->short_sends);
+  sum->eagain += SOCKETCOM_STATS_LOAD(stats->eagain);
+  sum->eintr += SOCKETCOM_STATS_LOAD(stats->eintr);
+  sum->eofs += SOCKETCOM_STATS_LOAD(stats->eofs);
+  for (i = 0; i < SOCKETCOM_STATS_ERROR_TYPES; i++) {
+    sum->errors[i] += SOCKETCOM_STATS_LOAD(stats->errors[i]);
+  }
+}
+
+void SocketCom_StatsGetGlobal(SocketCom_Stats *stats)
+{
+  SocketCom_StatsShard *shard;
+
+  memset(stats, 0, sizeof(*stats));
+  for (shard = SocketCom_stats_shards.load(std::memory_order_acquire); shard != NULL; shard = shard->next) {
+    SocketCom_StatsSum(stats, &shard->stats);
+  }
+  SocketCom_StatsSum(stats, &SocketCom_stats_spare.stats);
+  if (SocketCom_stats_shard != NULL) {
+    stats->last_errno = SocketCom_stats_shard->last_errno;
+  }
+}
+
+int SocketCom_StatsGet(const SocketCom *sock, SocketCom_StatsSnapshot *snapshot)
+{
+  snapshot->io = sock->stats;
+  snapshot->has_tcp = 0;
+  memset(&snapshot->tcp, 0, sizeof(snapshot->tcp));
+  if ((sock->status & SOCKETCOM_STATE_CREATED) && !(sock->status & SOCKETCOM_STATE_DGRAM)) {
+    snapshot->has_tcp = (SocketCom_GetTcpInfo(sock, &snapshot->tcp) == SOCKETCOM_SUCCESS);
+  }
+
+  return SOCKETCOM_SUCCESS;
+}
+
+void SocketCom_StatsReset(SocketCom *sock)
+{
+  memset(&sock->stats, 0, sizeof(sock->stats));
+}
+
+int SocketCom_StatsErrorType(int err)
+{
+  switch (err) {
+#ifdef _SOCKETCOM_WIN32_
+  case WSAECONNRESET:
+  case WSAECONNABORTED:
+    return SOCKETCOM_STATS_ERROR_RESET;
+  case WSAETIMEDOUT:
+    return SOCKETCOM_STATS_ERROR_TIMEDOUT;
+  case WSAECONNREFUSED:
+    return SOCKETCOM_STATS_ERROR_REFUSED;
+  case WSAEHOSTUNREACH:
+  case WSAENETUNREACH:
+  case WSAENETDOWN:
+    return SOCKETCOM_STATS_ERROR_UNREACH;
+  case WSAEMFILE:
+  case WSAENOBUFS:
+    return SOCKETCOM_STATS_ERROR_RESOURCE;
+#else
+  case ECONNRESET:
+  case EPIPE:
+  case ECONNABORTED:
+    return SOCKETCOM_STATS_ERROR_RESET;
+  case ETIMEDOUT:
+    return SOCKETCOM_STATS_ERROR_TIMEDOUT;
+  case ECONNREFUSED:
+    return SOCKETCOM_STATS_ERROR_REFUSED;
+  case EHOSTUNREACH:
+  case ENETUNREACH:
+  case ENETDOWN:
+    return SOCKETCOM_STATS_ERROR_UNREACH;
+  case EMFILE:
+  case ENFILE:
+  case ENOBUFS:
+  case ENOMEM:
+    return SOCKETCOM_STATS_ERROR_RESOURCE;
+#endif
+  default:
+    return SOCKETCOM_STATS_ERROR_OTHER;
+  }
+}
+
+#endif
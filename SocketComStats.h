@@ -0,0 +1,149 @@
+/*
+SocketCom
+
+Copyright (c) 2017 r01hee
+
+This software is released under the MIT License.
+http://opensource.org/licenses/mit-license.php
+*/
+
+#ifndef __SOCKETCOM_STATS_H__
+#define __SOCKETCOM_STATS_H__
+
+#include "SocketCom.h"
+
+enum SOCKETCOM_STATS_DIR {
+  SOCKETCOM_STATS_DIR_RECV = 0,
+  SOCKETCOM_STATS_DIR_SEND = 1,
+};
+
+#ifdef SOCKETCOM_USE_STATS
+
+#ifndef _SOCKETCOM_WIN32_
+#include <errno.h>
+#endif
+#include <stddef.h>
+
+/**
+ *  counters of sock and TCP_INFO at a moment
+ */
+typedef struct SocketCom_StatsSnapshot {
+  SocketCom_Stats io;
+  SocketCom_TcpInfo tcp;
+  int has_tcp; // !=0 if tcp is valid; TCP_INFO is available only for TCP on Linux
+} SocketCom_StatsSnapshot;
+
+/**
+ *  get counters of sock, and TCP_INFO if available
+ *
+ *  @param[in] sock sock
+ *  @param[out] snapshot snapshot
+ *  @retval SOCKETCOM_SUCCESS success
+ */
+int SocketCom_StatsGet(const SocketCom *sock, SocketCom_StatsSnapshot *snapshot);
+
+/**
+ *  sum of counters of all socks of the process, including closed ones
+ *  counters are kept per thread and summed here, so that counting needs no lock nor atomic read-modify-write
+ *
+ *  @param[out] stats sum; last_errno is of the calling thread
+ */
+void SocketCom_StatsGetGlobal(SocketCom_Stats *stats);
+
+/**
+ *  clear counters of sock; global counters are not changed
+ */
+void SocketCom_StatsReset(SocketCom *sock);
+
+/**
+ *  @return SOCKETCOM_STATS_ERROR_* of errno err
+ */
+int SocketCom_StatsErrorType(int err);
+
+// counters of the calling thread; used by SocketCom_StatsCount()
+extern thread_local SocketCom_Stats *SocketCom_stats_shard;
+SocketCom_Stats *SocketCom_StatsAttachShard(void);
+
+// a counter is written only by its owner thread, and may be read by others
+#if defined(__GNUC__) || defined(__clang__)
+#define SOCKETCOM_STATS_ADD(counter, n) __atomic_store_n(&(counter), __atomic_load_n(&(counter), __ATOMIC_RELAXED) + (n), __ATOMIC_RELAXED)
+#else
+#define SOCKETCOM_STATS_ADD(counter, n) ((counter) += (n))
+#endif
+
+static inline void SocketCom_StatsCountTo(SocketCom_Stats *stats, int dir, long long res, size_t want, int err)
+{
+  if (dir == SOCKETCOM_STATS_DIR_SEND) {
+    SOCKETCOM_STATS_ADD(stats->send_calls, 1);
+    if (res > 0) {
+      SOCKETCOM_STATS_ADD(stats->bytes_sent, (unsigned long long)res);
+      if ((size_t)res < want) {
+        SOCKETCOM_STATS_ADD(stats->short_sends, 1);
+      }
+      return;
+    }
+  } else {
+    SOCKETCOM_STATS_ADD(stats->recv_calls, 1);
+    if (res > 0) {
+      SOCKETCOM_STATS_ADD(stats->bytes_recv, (unsigned long long)res);
+      if ((size_t)res < want) {
+        SOCKETCOM_STATS_ADD(stats->short_recvs, 1);
+      }
+      return;
+    }
+    if (res == 0 && want > 0) {
+      SOCKETCOM_STATS_ADD(stats->eofs, 1);
+      return;
+    }
+  }
+  if (res == 0) {
+    return;
+  }
+
+#ifdef _SOCKETCOM_WIN32_
+  if (err == WSAEINTR) {
+    SOCKETCOM_STATS_ADD(stats->eintr, 1);
+  } else if (err == WSAEWOULDBLOCK) {
+#else
+  if (err == EINTR) {
+    SOCKETCOM_STATS_ADD(stats->eintr, 1);
+  } else if (err == EAGAIN || err == EWOULDBLOCK) {
+#endif
+    SOCKETCOM_STATS_ADD(stats->eagain, 1);
+  } else {
+    SOCKETCOM_STATS_ADD(stats->errors[SocketCom_StatsErrorType(err)], 1);
+    stats->last_errno = err;
+  }
+}
+
+/**
+ *  count a syscall of receiving or sending on sock and on the calling thread
+ *
+ *  @param[in] dir SOCKETCOM_STATS_DIR_RECV or SOCKETCOM_STATS_DIR_SEND
+ *  @param[in] res result of the syscall; bytes, or <0 on error
+ *  @param[in] want requested bytes; a smaller result is counted as short
+ *  @param[in] err errno if res < 0
+ */
+static inline void SocketCom_StatsCount(SocketCom *sock, int dir, long long res, size_t want, int err)
+{
+  SocketCom_Stats *shard = SocketCom_stats_shard;
+
+  if (shard == NULL) {
+    shard = SocketCom_StatsAttachShard();
+  }
+  SocketCom_StatsCountTo(&sock->stats, dir, res, want, err);
+  SocketCom_StatsCountTo(shard, dir, res, want, err);
+}
+
+#define SOCKETCOM_STATS_COUNT(sock, dir, res, want, err) SocketCom_StatsCount((sock), (dir), (long long)(res), (size_t)(want), (err))
+#define SOCKETCOM_STATS_RESET(sock) SocketCom_StatsReset(sock)
+
+#else
+
+// compiled out; arguments are not evaluated
+#define SOCKETCOM_STATS_COUNT(sock, dir, res, want, err) do{}while(0)
+#define SOCKETCOM_STATS_RESET(sock) do{}while(0)
+
+#endif
+
+#endif
@@ -0,0 +1,405 @@
+/*
+SocketCom
+
+Copyright (c) 2017 r01hee
+
+This software is released under the MIT License.
+http://opensource.org/licenses/mit-license.php
+*/
+
+#include "SocketComTimer.h"
+
+#ifdef _SOCKETCOM_POSIX_
+#include <time.h>
+#endif
+
+#include <string.h>
+
+#define SOCKETCOM_TIMER_SLOT_MASK (SOCKETCOM_TIMER_SLOTS - 1)
+// ticks covered by the wheel; later timers are kept at this distance
+#define SOCKETCOM_TIMER_RANGE (1LL << (SOCKETCOM_TIMER_SLOT_BITS * SOCKETCOM_TIMER_LEVELS))
+
+long long SocketCom_TimerNowMsec(void)
+{
+#ifdef _SOCKETCOM_WIN32_
+  return (long long)GetTickCount64();
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+#endif
+}
+
+/**
+ *  number of trailing zero bits; bits must not be 0
+ */
+static int SocketCom_TimerCtz(unsigned long long bits)
+{
+#ifdef _MSC_VER
+  unsigned long index;
+  _BitScanForward64(&index, bits);
+  return (int)index;
+#else
+  return __builtin_ctzll(bits);
+#endif
+}
+
+/**
+ *  rotate bits right so that bit n comes to bit 0
+ */
+static unsigned long long SocketCom_TimerRotate(unsigned long long bits, int n)
+{
+  return (n == 0) ? bits : ((bits >> n) | (bits << (SOCKETCOM_TIMER_SLOTS - n)));
+}
+
+static long long SocketCom_TimerToTick(const SocketCom_TimerWheel *wheel, long long msec)
+{
+  long long elapsed = msec - wheel->base_msec;
+  return (elapsed > 0) ? elapsed / wheel->tick_msec : 0;
+}
+
+static void SocketCom_TimerLink(SocketCom_TimerWheel *wheel, SocketCom_Timer *timer)
+{
+  long long expires = timer->expires;
+  long long delta = expires - wheel->tick;
+  int level = 0;
+  int slot;
+
+  if (delta < 0) {
+    // already expired: expire on the next SocketCom_TimerWheelAdvance()
+    timer->next = wheel->expired;
+    if (wheel->expired != NULL) {
+      wheel->expired->pprev = &timer->next;
+    }
+    wheel->expired = timer;
+    timer->pprev = &wheel->expired;
+    return;
+  }
+
+  if (delta >= SOCKETCOM_TIMER_RANGE) {
+    expires = wheel->tick + SOCKETCOM_TIMER_RANGE - 1;
+    delta = SOCKETCOM_TIMER_RANGE - 1;
+  }
+  while (level < SOCKETCOM_TIMER_LEVELS - 1 && delta >= (1LL << (SOCKETCOM_TIMER_SLOT_BITS * (level + 1)))) {
+    level++;
+  }
+  slot = (int)((expires >> (SOCKETCOM_TIMER_SLOT_BITS * level)) & SOCKETCOM_TIMER_SLOT_MASK);
+
+  SocketCom_Timer **head = &wheel->slots[level][slot];
+  timer->next = *head;
+  if (*head != NULL) {
+    (*head)->pprev = &timer->next;
+  }
+  *head = timer;
+  timer->pprev = head;
+  wheel->occupied[level] |= 1ULL << slot;
+}
+
+static void SocketCom_TimerUnlink(SocketCom_TimerWheel *wheel, SocketCom_Timer *timer)
+{
+  SocketCom_Timer **head = timer->pprev;
+
+  *head = timer->next;
+  if (timer->next != NULL) {
+    timer->next->pprev = head;
+  }
+  timer->next = NULL;
+  timer->pprev = NULL;
+
+  // clear the bit of a slot which became empty
+  if (*head == NULL && head >= &wheel->slots[0][0] && head < &wheel->slots[0][0] + SOCKETCOM_TIMER_LEVELS * SOCKETCOM_TIMER_SLOTS) {
+    int index = (int)(head - &wheel->slots[0][0]);
+    wheel->occupied[index / SOCKETCOM_TIMER_SLOTS] &= ~(1ULL << (index % SOCKETCOM_TIMER_SLOTS));
+  }
+}
+
+/**
+ *  move all timers of a slot to list; timers in list stay pending, and are unlinked from list one by one
+ */
+static void SocketCom_TimerDetachSlot(SocketCom_TimerWheel *wheel, int level, int slot, SocketCom_Timer **list)
+{
+  *list = wheel->slots[level][slot];
+  wheel->slots[level][slot] = NULL;
+  wheel->occupied[level] &= ~(1ULL << slot);
+  if (*list != NULL) {
+    (*list)->pprev = list;
+  }
+}
+
+/**
+ *  move timers of the upper level slots reached at wheel->tick down to lower levels
+ */
+static void SocketCom_TimerCascade(SocketCom_TimerWheel *wheel)
+{
+  SocketCom_Timer *list;
+  int level;
+
+  for (level = 1; level < SOCKETCOM_TIMER_LEVELS; level++) {
+    int slot = (int)((wheel->tick >> (SOCKETCOM_TIMER_SLOT_BITS * level)) & SOCKETCOM_TIMER_SLOT_MASK);
+    SocketCom_TimerDetachSlot(wheel, level, slot, &list);
+    while (list != NULL) {
+      SocketCom_Timer *timer = list;
+      SocketCom_TimerUnlink(wheel, timer);
+      SocketCom_TimerLink(wheel, timer);
+    }
+    if (slot != 0) {
+      break;
+    }
+  }
+}
+
+void SocketCom_TimerWheelInit(SocketCom_TimerWheel *wheel, long long now_msec, int tick_msec)
+{
+  memset(wheel, 0, sizeof(SocketCom_TimerWheel));
+  wheel->base_msec = now_msec;
+  wheel->tick_msec = (tick_msec > 0) ? tick_msec : SOCKETCOM_TIMER_DEFAULT_TICK_MSEC;
+}
+
+void SocketCom_TimerInit(SocketCom_Timer *timer, SocketCom_TimerCallback callback, void *arg)
+{
+  memset(timer, 0, sizeof(SocketCom_Timer));
+  timer->callback = callback;
+  timer->arg = arg;
+}
+
+void SocketCom_TimerAdd(SocketCom_TimerWheel *wheel, SocketCom_Timer *timer, long long expires_msec)
+{
+  SocketCom_TimerCancel(wheel, timer);
+
+  // round up, so that the timer never expires early
+  long long elapsed = expires_msec - wheel->base_msec;
+  timer->expires = (elapsed > 0) ? (elapsed + wheel->tick_msec - 1) / wheel->tick_msec : 0;
+  SocketCom_TimerLink(wheel, timer);
+  wheel->count++;
+}
+
+void SocketCom_TimerCancel(SocketCom_TimerWheel *wheel, SocketCom_Timer *timer)
+{
+  if (timer->pprev == NULL) {
+    return;
+  }
+  SocketCom_TimerUnlink(wheel, timer);
+  wheel->count--;
+}
+
+int SocketCom_TimerIsPending(const SocketCom_Timer *timer)
+{
+  return (timer->pprev != NULL) ? 1 : 0;
+}
+
+long SocketCom_TimerWheelNextTimeout(const SocketCom_TimerWheel *wheel, long long now_msec)
+{
+  long long next = -1;
+  int level;
+
+  if (wheel->count == 0) {
+    return -1;
+  }
+  if (wheel->expired != NULL) {
+    return 0;
+  }
+
+  for (level = 0; level < SOCKETCOM_TIMER_LEVELS; level++) {
+    int shift = SOCKETCOM_TIMER_SLOT_BITS * level;
+    long long window = wheel->tick >> shift;
+    unsigned long long bits = wheel->occupied[level];
+
+    if (bits == 0) {
+      continue;
+    }
+    // the slot of the current window of an upper level is already moved down, unless the window starts at the next tick
+    if (level > 0 && (wheel->tick & ((1LL << shift) - 1)) != 0) {
+      window++;
+    }
+    int k = SocketCom_TimerCtz(SocketCom_TimerRotate(bits, (int)(window & SOCKETCOM_TIMER_SLOT_MASK)));
+    long long tick = (level == 0) ? wheel->tick + k : (window + k) << shift;
+    if (next < 0 || tick < next) {
+      next = tick;
+    }
+  }
+  if (next < 0) {
+    return -1;
+  }
+
+  long long remain = wheel->base_msec + next * wheel->tick_msec - now_msec;
+  if (remain <= 0) {
+    return 0;
+  }
+  return (remain > 0x7fffffffL) ? 0x7fffffffL : (long)remain;
+}
+
+/**
+ *  expire timers of list
+ *
+ *  @return number of expired timers
+ */
+static int SocketCom_TimerExpireList(SocketCom_TimerWheel *wheel, SocketCom_Timer **list, SocketCom_Timer *expired[], int capacity, int *returned)
+{
+  int fired = 0;
+
+  while (*list != NULL) {
+    SocketCom_Timer *timer = *list;
+    SocketCom_TimerUnlink(wheel, timer);
+    if (timer->callback == NULL && expired != NULL && *returned == capacity) {
+      // no room; linked to wheel->expired, and expire on the next call
+      SocketCom_TimerLink(wheel, timer);
+      continue;
+    }
+    wheel->count--;
+    fired++;
+    if (timer->callback != NULL) {
+      timer->callback(wheel, timer, timer->arg);
+    } else if (expired != NULL) {
+      expired[(*returned)++] = timer;
+    }
+  }
+
+  return fired;
+}
+
+int SocketCom_TimerWheelAdvance(SocketCom_TimerWheel *wheel, long long now_msec, SocketCom_Timer *expired[], int *expired_len)
+{
+  long long target = SocketCom_TimerToTick(wheel, now_msec);
+  int capacity = (expired != NULL) ? *expired_len : 0;
+  int returned = 0;
+  int fired = 0;
+  SocketCom_Timer *list;
+
+  // timers added after their time; those added by callbacks from here expire on the next call
+  list = wheel->expired;
+  wheel->expired = NULL;
+  if (list != NULL) {
+    list->pprev = &list;
+    fired += SocketCom_TimerExpireList(wheel, &list, expired, capacity, &returned);
+  }
+
+  while (wheel->tick <= target && !(expired != NULL && returned == capacity)) {
+    int slot = (int)(wheel->tick & SOCKETCOM_TIMER_SLOT_MASK);
+
+    if (wheel->count == 0) {
+      wheel->tick = target + 1;
+      break;
+    }
+    if (slot != 0 && (wheel->occupied[0] >> slot) == 0) {
+      // nothing until the next cascade
+      long long skip = (wheel->tick | SOCKETCOM_TIMER_SLOT_MASK) + 1;
+      wheel->tick = (skip <= target) ? skip : target + 1;
+      continue;
+    }
+    if (slot == 0) {
+      SocketCom_TimerCascade(wheel);
+    }
+
+    // timers added by callbacks for this tick are added to wheel->expired
+    SocketCom_TimerDetachSlot(wheel, 0, slot, &list);
+    wheel->tick++;
+    fired += SocketCom_TimerExpireList(wheel, &list, expired, capacity, &returned);
+  }
+
+  if (expired_len != NULL) {
+    *expired_len = returned;
+  }
+  return fired;
+}
+
+int SocketCom_PollerWaitTimers(SocketCom_Poller *poller, SocketCom_TimerWheel *wheel, SocketCom_PollEvent *events, int *events_len, long timeout_msec,
+                               SocketCom_Timer *expired[], int *expired_len)
+{
+  long wait = SocketCom_TimerWheelNextTimeout(wheel, SocketCom_TimerNowMsec());
+  if (wait < 0 || (timeout_msec >= 0 && timeout_msec < wait)) {
+    wait = timeout_msec;
+  }
+
+  int res = SocketCom_PollerWait(poller, events, events_len, (wait < 0) ? -1 : wait / 1000, (wait < 0) ? -1 : (wait % 1000) * 1000);
+  SocketCom_TimerWheelAdvance(wheel, SocketCom_TimerNowMsec(), expired, expired_len);
+
+  return res;
+}
+
+static void SocketCom_SockTimerFire(SocketCom_TimerWheel *wheel, SocketCom_Timer *timer, void *arg)
+{
+  SocketCom_SockTimers *timers = (SocketCom_SockTimers *)arg;
+  int type = SOCKETCOM_SOCK_TIMER_IDLE;
+
+  SocketCom_SockTimersOf(timer, &type);
+  timers->callback(wheel, timers, type, timers->arg);
+}
+
+void SocketCom_SockTimersInit(SocketCom_SockTimers *timers, SocketCom *sock, SocketCom_SockTimerCallback callback, void *arg)
+{
+  SocketCom_TimerCallback fire = (callback != NULL) ? SocketCom_SockTimerFire : NULL;
+
+  timers->sock = sock;
+  timers->idle_timeout_msec = 0;
+  timers->callback = callback;
+  timers->arg = arg;
+  SocketCom_TimerInit(&timers->idle, fire, timers);
+  SocketCom_TimerInit(&timers->read, fire, timers);
+  SocketCom_TimerInit(&timers->write, fire, timers);
+  timers->idle.kind = SOCKETCOM_SOCK_TIMER;
+  timers->read.kind = SOCKETCOM_SOCK_TIMER;
+  timers->write.kind = SOCKETCOM_SOCK_TIMER;
+}
+
+void SocketCom_SockTimersSetIdle(SocketCom_TimerWheel *wheel, SocketCom_SockTimers *timers, long idle_timeout_msec, long long now_msec)
+{
+  timers->idle_timeout_msec = (idle_timeout_msec > 0) ? idle_timeout_msec : 0;
+  if (timers->idle_timeout_msec == 0) {
+    SocketCom_TimerCancel(wheel, &timers->idle);
+    return;
+  }
+  SocketCom_TimerAdd(wheel, &timers->idle, now_msec + timers->idle_timeout_msec);
+}
+
+void SocketCom_SockTimersTouch(SocketCom_TimerWheel *wheel, SocketCom_SockTimers *timers, long long now_msec)
+{
+  if (timers->idle_timeout_msec > 0) {
+    SocketCom_TimerAdd(wheel, &timers->idle, now_msec + timers->idle_timeout_msec);
+  }
+}
+
+void SocketCom_SockTimersSetReadDeadline(SocketCom_TimerWheel *wheel, SocketCom_SockTimers *timers, long long deadline_msec)
+{
+  if (deadline_msec < 0) {
+    SocketCom_TimerCancel(wheel, &timers->read);
+  } else {
+    SocketCom_TimerAdd(wheel, &timers->read, deadline_msec);
+  }
+}
+
+void SocketCom_SockTimersSetWriteDeadline(SocketCom_TimerWheel *wheel, SocketCom_SockTimers *timers, long long deadline_msec)
+{
+  if (deadline_msec < 0) {
+    SocketCom_TimerCancel(wheel, &timers->write);
+  } else {
+    SocketCom_TimerAdd(wheel, &timers->write, deadline_msec);
+  }
+}
+
+void SocketCom_SockTimersCancel(SocketCom_TimerWheel *wheel, SocketCom_SockTimers *timers)
+{
+  SocketCom_TimerCancel(wheel, &timers->idle);
+  SocketCom_TimerCancel(wheel, &timers->read);
+  SocketCom_TimerCancel(wheel, &timers->write);
+}
+
+SocketCom_SockTimers *SocketCom_SockTimersOf(SocketCom_Timer *timer, int *type)
+{
+  SocketCom_SockTimers *timers = (SocketCom_SockTimers *)timer->arg;
+  int t;
+
+  if (timer->kind != SOCKETCOM_SOCK_TIMER) {
+    return NULL;
+  }
+  if (timer == &timers->idle) {
+    t = SOCKETCOM_SOCK_TIMER_IDLE;
+  } else if (timer == &timers->read) {
+    t = SOCKETCOM_SOCK_TIMER_READ;
+  } else {
+    t = SOCKETCOM_SOCK_TIMER_WRITE;
+  }
+  if (type != NULL) {
+    *type = t;
+  }
+  return timers;
+}
@@ -0,0 +1,198 @@
+/*
+SocketCom
+
+Copyright (c) 2017 r01hee
+
+This software is released under the MIT License.
+http://opensource.org/licenses/mit-license.php
+*/
+
+#ifndef __SOCKETCOM_TIMER_H__
+#define __SOCKETCOM_TIMER_H__
+
+#include "SocketCom.h"
+
+#define SOCKETCOM_TIMER_LEVELS 4
+#define SOCKETCOM_TIMER_SLOT_BITS 6
+#define SOCKETCOM_TIMER_SLOTS (1 << SOCKETCOM_TIMER_SLOT_BITS)
+#define SOCKETCOM_TIMER_DEFAULT_TICK_MSEC 1
+
+struct SocketCom_TimerWheel;
+struct SocketCom_Timer;
+
+/**
+ *  called by SocketCom_TimerWheelAdvance() when timer expires
+ *  the callback may add or cancel any timer, including timer itself
+ */
+typedef void (*SocketCom_TimerCallback)(struct SocketCom_TimerWheel *wheel, struct SocketCom_Timer *timer, void *arg);
+
+/**
+ *  timer, linked into a slot of SocketCom_TimerWheel without allocation
+ *
+ *  @attention  before to use struct SocketCom_Timer, initialize by SocketCom_TimerInit()
+ *  @attention  a pending timer must not be moved in memory
+ */
+typedef struct SocketCom_Timer {
+  struct SocketCom_Timer *next;
+  struct SocketCom_Timer **pprev; // NULL if not pending
+  long long expires; // in ticks of the wheel
+  SocketCom_TimerCallback callback; // NULL to return the timer from SocketCom_TimerWheelAdvance() instead
+  void *arg;
+  int kind; // free for the application; SOCKETCOM_SOCK_TIMER for timers of SocketCom_SockTimers
+} SocketCom_Timer;
+
+/**
+ *  hierarchical timer wheel
+ *  SOCKETCOM_TIMER_LEVELS levels of SOCKETCOM_TIMER_SLOTS slots; level n covers SOCKETCOM_TIMER_SLOTS^(n+1) ticks.
+ *  adding and canceling a timer are O(1), and timers of upper levels are moved down when their slot is reached.
+ *  timers beyond the last level are kept in the last level and moved again when reached
+ *
+ *  times are msec of SocketCom_TimerNowMsec(); the wheel is driven by SocketCom_TimerWheelAdvance() or SocketCom_PollerWaitTimers()
+ *
+ *  @attention  before to use struct SocketCom_TimerWheel, initialize by SocketCom_TimerWheelInit()
+ *  @attention  not thread safe; use a wheel per event loop
+ */
+typedef struct SocketCom_TimerWheel {
+  SocketCom_Timer *slots[SOCKETCOM_TIMER_LEVELS][SOCKETCOM_TIMER_SLOTS];
+  unsigned long long occupied[SOCKETCOM_TIMER_LEVELS]; // bit n is set if slots[level][n] is not empty
+  SocketCom_Timer *expired; // timers added after their time
+  long long tick; // next tick to process
+  long long base_msec; // time of tick 0
+  int tick_msec;
+  int count; // number of pending timers
+} SocketCom_TimerWheel;
+
+/**
+ *  @return current time in msec of a monotonic clock
+ */
+long long SocketCom_TimerNowMsec(void);
+
+/**
+ *  initialize wheel
+ *
+ *  @param[in] now_msec current time
+ *  @param[in] tick_msec resolution; 0 for SOCKETCOM_TIMER_DEFAULT_TICK_MSEC. timers never expire early, and may expire up to one tick late
+ */
+void SocketCom_TimerWheelInit(SocketCom_TimerWheel *wheel, long long now_msec, int tick_msec);
+
+void SocketCom_TimerInit(SocketCom_Timer *timer, SocketCom_TimerCallback callback, void *arg);
+
+/**
+ *  add timer which expires at expires_msec; a pending timer is moved
+ *  a timer which is already expired expires on the next SocketCom_TimerWheelAdvance()
+ */
+void SocketCom_TimerAdd(SocketCom_TimerWheel *wheel, SocketCom_Timer *timer, long long expires_msec);
+
+/**
+ *  cancel timer; nothing is done if timer is not pending
+ */
+void SocketCom_TimerCancel(SocketCom_TimerWheel *wheel, SocketCom_Timer *timer);
+
+/**
+ *  @retval !=0(true) timer is added and not expired yet
+ */
+int SocketCom_TimerIsPending(const SocketCom_Timer *timer);
+
+/**
+ *  msec until the next timer may expire; give to the timeout of polling
+ *  a timer in an upper level is counted at the time its slot is reached, so the result may be earlier than the exact expiry
+ *
+ *  @return msec; 0 if a timer is expired; -1 if no timer is pending
+ */
+long SocketCom_TimerWheelNextTimeout(const SocketCom_TimerWheel *wheel, long long now_msec);
+
+/**
+ *  expire timers up to now_msec
+ *  callbacks of expired timers are called; expired timers without callback are returned in expired
+ *
+ *  @param[out] expired expired timers without callback; NULL if all timers have callbacks (others are dropped)
+ *  @param[in/out] expired_len give length of expired, return number of returned timers;
+ *                 if it is filled, timers may be left expired; call again
+ *  @return number of expired timers
+ */
+int SocketCom_TimerWheelAdvance(SocketCom_TimerWheel *wheel, long long now_msec, SocketCom_Timer *expired[], int *expired_len);
+
+/**
+ *  SocketCom_PollerWait() whose timeout is shortened to the next expiry of wheel, and SocketCom_TimerWheelAdvance() after it
+ *  callbacks of timers are called on the calling thread
+ *
+ *  @param[in] timeout_msec timeout; -1 for unlimited (until an event or a timer)
+ *  @param[out] expired expired timers without callback, as SocketCom_TimerWheelAdvance(); NULL only if all timers of wheel have callbacks
+ *  @param[in/out] expired_len give length of expired, return number of returned timers; NULL if expired is NULL
+ *  @retval same as SocketCom_PollerWait(); expired timers are returned even if it is SOCKETCOM_ERROR_TIMEOUT_POLLER
+ */
+int SocketCom_PollerWaitTimers(SocketCom_Poller *poller, SocketCom_TimerWheel *wheel, SocketCom_PollEvent *events, int *events_len, long timeout_msec,
+                               SocketCom_Timer *expired[], int *expired_len);
+
+#define SOCKETCOM_SOCK_TIMER 0x534f434b // kind of timers of SocketCom_SockTimers
+
+enum SOCKETCOM_SOCK_TIMER_TYPE {
+  SOCKETCOM_SOCK_TIMER_IDLE = 0x01,
+  SOCKETCOM_SOCK_TIMER_READ = 0x02,
+  SOCKETCOM_SOCK_TIMER_WRITE = 0x04,
+};
+
+struct SocketCom_SockTimers;
+
+/**
+ *  called when a deadline of sock expires
+ *
+ *  @param[in] type SOCKETCOM_SOCK_TIMER_IDLE, SOCKETCOM_SOCK_TIMER_READ or SOCKETCOM_SOCK_TIMER_WRITE
+ */
+typedef void (*SocketCom_SockTimerCallback)(SocketCom_TimerWheel *wheel, struct SocketCom_SockTimers *timers, int type, void *arg);
+
+/**
+ *  idle timeout, read deadline and write deadline of a sock
+ *
+ *  if callback is NULL, expired timers are returned by SocketCom_TimerWheelAdvance();
+ *  find sock and type of an expired timer by SocketCom_SockTimersOf()
+ *
+ *  @attention  before to use struct SocketCom_SockTimers, initialize by SocketCom_SockTimersInit()
+ *  @attention  cancel by SocketCom_SockTimersCancel() before disposing sock
+ */
+typedef struct SocketCom_SockTimers {
+  SocketCom *sock;
+  SocketCom_Timer idle;
+  SocketCom_Timer read;
+  SocketCom_Timer write;
+  long idle_timeout_msec; // 0 if idle timeout is not set
+  SocketCom_SockTimerCallback callback;
+  void *arg;
+} SocketCom_SockTimers;
+
+void SocketCom_SockTimersInit(SocketCom_SockTimers *timers, SocketCom *sock, SocketCom_SockTimerCallback callback, void *arg);
+
+/**
+ *  expire when no activity is told by SocketCom_SockTimersTouch() for idle_timeout_msec
+ *
+ *  @param[in] idle_timeout_msec timeout; 0 to cancel
+ */
+void SocketCom_SockTimersSetIdle(SocketCom_TimerWheel *wheel, SocketCom_SockTimers *timers, long idle_timeout_msec, long long now_msec);
+
+/**
+ *  tell activity of sock; restart idle timeout
+ */
+void SocketCom_SockTimersTouch(SocketCom_TimerWheel *wheel, SocketCom_SockTimers *timers, long long now_msec);
+
+/**
+ *  expire at deadline_msec unless canceled, e.g. when the expected data is received
+ *
+ *  @param[in] deadline_msec time of deadline; -1 to cancel
+ */
+void SocketCom_SockTimersSetReadDeadline(SocketCom_TimerWheel *wheel, SocketCom_SockTimers *timers, long long deadline_msec);
+void SocketCom_SockTimersSetWriteDeadline(SocketCom_TimerWheel *wheel, SocketCom_SockTimers *timers, long long deadline_msec);
+
+/**
+ *  cancel all timers of sock
+ */
+void SocketCom_SockTimersCancel(SocketCom_TimerWheel *wheel, SocketCom_SockTimers *timers);
+
+/**
+ *  find SocketCom_SockTimers of expired timer returned by SocketCom_TimerWheelAdvance()
+ *
+ *  @param[out] type SOCKETCOM_SOCK_TIMER_IDLE, SOCKETCOM_SOCK_TIMER_READ or SOCKETCOM_SOCK_TIMER_WRITE; can be NULL
+ *  @return timers; NULL if timer is not of SocketCom_SockTimers
+ */
+SocketCom_SockTimers *SocketCom_SockTimersOf(SocketCom_Timer *timer, int *type);
+
+#endif
@@ -0,0 +1,631 @@
+/*
+SocketCom
+
+Copyright (c) 2017 r01hee
+
+This software is released under the MIT License.
+http://opensource.org/licenses/mit-license.php
+*/
+
+#include "SocketComWorkers.h"
+
+#ifdef _SOCKETCOM_LINUX_
+
+#include <stdio.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sched.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#include <atomic>
+#include <new>
+
+#endif
+
+#include <string.h>
+#include <stdlib.h>
+
+#ifdef SOCKETCOM_NDEBUG
+#define PERROR(str) do{}while(0)
+#else
+#define PERROR(str) perror(str)
+#endif
+
+#ifdef _SOCKETCOM_LINUX_
+
+#if (SOCKETCOM_WORKERS_DEQUE_SIZE & (SOCKETCOM_WORKERS_DEQUE_SIZE - 1)) != 0
+#error SOCKETCOM_WORKERS_DEQUE_SIZE must be a power of 2
+#endif
+
+// counters are written only by their worker, and may be read by others
+#define SOCKETCOM_WORKERS_INC(counter) (counter).store((counter).load(std::memory_order_relaxed) + 1, std::memory_order_relaxed)
+
+struct SocketCom_WorkersImpl;
+
+/**
+ *  worker thread, its epoll set and its deque
+ *
+ *  the deque is the Chase-Lev deque with the memory orders of Le et al., "Correct and Efficient Work-Stealing for Weak Memory Models":
+ *  the owner pushes and pops at bottom, and thieves take from top by CAS. its capacity is fixed, so no buffer is reclaimed
+ */
+typedef struct alignas(64) SocketCom_Worker {
+  alignas(64) std::atomic<long long> top;
+  alignas(64) std::atomic<long long> bottom;
+  std::atomic<SocketCom_WorkerConn *> deque[SOCKETCOM_WORKERS_DEQUE_SIZE];
+
+  struct SocketCom_WorkersImpl *impl;
+  int index;
+  int epfd;
+  int wakeup_fd; // eventfd in epfd, with data.ptr NULL
+  unsigned int seed; // of the choice of victims
+  pthread_t thread;
+  int running;
+  std::atomic<int> sleeping; // waiting in epoll_wait() without work
+
+  std::atomic<unsigned long long> polled;
+  std::atomic<unsigned long long> executed;
+  std::atomic<unsigned long long> stolen;
+  std::atomic<unsigned long long> stolen_polled;
+  std::atomic<unsigned long long> overflows;
+  std::atomic<unsigned long long> rearm_failures;
+  std::atomic<unsigned long long> sleeps;
+  std::atomic<unsigned long long> wakeups;
+} SocketCom_Worker;
+
+typedef struct SocketCom_WorkersImpl {
+  SocketCom_Workers *owner;
+  SocketCom_Worker *workers;
+  int workers_len;
+  SocketCom_WorkerCallback callback;
+  void *arg;
+  std::atomic<int> stop;
+  std::atomic<int> idle; // number of sleeping workers
+  std::atomic<unsigned int> next; // worker of the next added conn
+} SocketCom_WorkersImpl;
+
+/**
+ *  push by the owner
+ *
+ *  @retval 0 the deque is full
+ */
+static int SocketCom_WorkerPush(SocketCom_Worker *w, SocketCom_WorkerConn *conn)
+{
+  long long b = w->bottom.load(std::memory_order_relaxed);
+  long long t = w->top.load(std::memory_order_acquire);
+
+  if (b - t >= SOCKETCOM_WORKERS_DEQUE_SIZE) {
+    return 0;
+  }
+  w->deque[b & (SOCKETCOM_WORKERS_DEQUE_SIZE - 1)].store(conn, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  w->bottom.store(b + 1, std::memory_order_relaxed);
+  return 1;
+}
+
+/**
+ *  pop the newest by the owner
+ *
+ *  @return NULL if empty
+ */
+static SocketCom_WorkerConn *SocketCom_WorkerPop(SocketCom_Worker *w)
+{
+  long long b = w->bottom.load(std::memory_order_relaxed) - 1;
+  long long t;
+  SocketCom_WorkerConn *conn;
+
+  w->bottom.store(b, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  t = w->top.load(std::memory_order_relaxed);
+
+  if (t > b) {
+    w->bottom.store(b + 1, std::memory_order_relaxed);
+    return NULL;
+  }
+  conn = w->deque[b & (SOCKETCOM_WORKERS_DEQUE_SIZE - 1)].load(std::memory_order_relaxed);
+  if (t == b) {
+    // the last one; race with thieves
+    if (!w->top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+      conn = NULL;
+    }
+    w->bottom.store(b + 1, std::memory_order_relaxed);
+  }
+  return conn;
+}
+
+/**
+ *  take the oldest by a thief
+ *
+ *  @return NULL if empty or lost the race
+ */
+static SocketCom_WorkerConn *SocketCom_WorkerSteal(SocketCom_Worker *w)
+{
+  long long t = w->top.load(std::memory_order_acquire);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  long long b = w->bottom.load(std::memory_order_acquire);
+  SocketCom_WorkerConn *conn;
+
+  if (t >= b) {
+    return NULL;
+  }
+  conn = w->deque[t & (SOCKETCOM_WORKERS_DEQUE_SIZE - 1)].load(std::memory_order_relaxed);
+  if (!w->top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+    return NULL;
+  }
+  return conn;
+}
+
+static int SocketCom_WorkersArm(SocketCom_WorkersImpl *impl, SocketCom_WorkerConn *conn, int op)
+{
+  struct epoll_event ev;
+
+  memset(&ev, 0, sizeof(ev));
+  ev.events = EPOLLONESHOT;
+  if (conn->interest & SOCKETCOM_POLL_IN) {
+    ev.events |= EPOLLIN | EPOLLRDHUP;
+  }
+  if (conn->interest & SOCKETCOM_POLL_OUT) {
+    ev.events |= EPOLLOUT;
+  }
+  ev.data.ptr = conn;
+  if (epoll_ctl(impl->workers[conn->worker].epfd, op, conn->sock->fd, &ev) != 0) {
+    PERROR("epoll_ctl() in SocketCom_WorkersArm()");
+    return SOCKETCOM_ERROR_POLLER_CTL;
+  }
+  return SOCKETCOM_SUCCESS;
+}
+
+static void SocketCom_WorkerRun(SocketCom_Worker *w, SocketCom_WorkerConn *conn)
+{
+  SocketCom_WorkersImpl *impl = w->impl;
+
+  SOCKETCOM_WORKERS_INC(w->executed);
+  if (impl->callback(impl->owner, w->index, conn, conn->events, impl->arg) != SOCKETCOM_WORKERS_REARM
+      || SocketCom_WorkersArm(impl, conn, EPOLL_CTL_MOD) == SOCKETCOM_SUCCESS) {
+    return;
+  }
+
+  // conn would never be polled again; tell the application once, so that it can remove conn
+  SOCKETCOM_WORKERS_INC(w->rearm_failures);
+  conn->events = SOCKETCOM_POLL_ERR;
+  SOCKETCOM_WORKERS_INC(w->executed);
+  if (impl->callback(impl->owner, w->index, conn, conn->events, impl->arg) == SOCKETCOM_WORKERS_REARM
+      && SocketCom_WorkersArm(impl, conn, EPOLL_CTL_MOD) != SOCKETCOM_SUCCESS) {
+    SOCKETCOM_WORKERS_INC(w->rearm_failures);
+  }
+}
+
+static void SocketCom_WorkerWake(SocketCom_Worker *w, int n)
+{
+  SocketCom_WorkersImpl *impl = w->impl;
+  unsigned long long one = 1;
+  int i;
+
+  // pushes before are seen by a worker which is going to sleep, or it is counted in idle
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  for (i = 1; i < impl->workers_len && n > 0 && impl->idle.load(std::memory_order_relaxed) > 0; i++) {
+    SocketCom_Worker *other = &impl->workers[(w->index + i) % impl->workers_len];
+    int sleeping = 1;
+    if (other->sleeping.compare_exchange_strong(sleeping, 0)) {
+      if (write(other->wakeup_fd, &one, sizeof(one)) < 0) {
+        PERROR("write() in SocketCom_WorkerWake()");
+      }
+      SOCKETCOM_WORKERS_INC(w->wakeups);
+      n--;
+    }
+  }
+}
+
+/**
+ *  push ready connections of the epoll set of from (w or another worker) into the deque of w
+ *
+ *  @return number of ready connections
+ */
+static int SocketCom_WorkerPoll(SocketCom_Worker *w, SocketCom_Worker *from, struct epoll_event events[], int timeout_msec)
+{
+  int n = epoll_wait(from->epfd, events, SOCKETCOM_WORKERS_MAX_EVENTS, timeout_msec);
+  int pushed = 0;
+  int ready = 0;
+  int i;
+
+  for (i = 0; i < n; i++) {
+    SocketCom_WorkerConn *conn = (SocketCom_WorkerConn *)events[i].data.ptr;
+    if (conn == NULL) {
+      unsigned long long count;
+      // the wakeup of another worker is left to it
+      if (from == w && read(w->wakeup_fd, &count, sizeof(count)) < 0 && errno != EAGAIN) {
+        PERROR("read() in SocketCom_WorkerPoll()");
+      }
+      continue;
+    }
+
+    conn->events = 0;
+    if (events[i].events & EPOLLIN) {
+      conn->events |= SOCKETCOM_POLL_IN;
+    }
+    if (events[i].events & EPOLLOUT) {
+      conn->events |= SOCKETCOM_POLL_OUT;
+    }
+    if (events[i].events & EPOLLERR) {
+      conn->events |= SOCKETCOM_POLL_ERR;
+    }
+    if (events[i].events & (EPOLLHUP | EPOLLRDHUP)) {
+      conn->events |= SOCKETCOM_POLL_HUP;
+    }
+    SOCKETCOM_WORKERS_INC(w->polled);
+    ready++;
+
+    if (SocketCom_WorkerPush(w, conn)) {
+      pushed++;
+    } else {
+      SOCKETCOM_WORKERS_INC(w->overflows);
+      SocketCom_WorkerRun(w, conn);
+    }
+  }
+
+  // the worker takes one, and others can steal the rest
+  if (pushed > 1) {
+    SocketCom_WorkerWake(w, pushed - 1);
+  }
+
+  return ready;
+}
+
+static SocketCom_WorkerConn *SocketCom_WorkerStealAny(SocketCom_Worker *w)
+{
+  SocketCom_WorkersImpl *impl = w->impl;
+  int start;
+  int i;
+
+  w->seed = w->seed * 1103515245u + 12345u;
+  start = (int)((w->seed >> 16) % (unsigned int)impl->workers_len);
+  for (i = 0; i < impl->workers_len; i++) {
+    int victim = (start + i) % impl->workers_len;
+    if (victim != w->index) {
+      SocketCom_WorkerConn *conn = SocketCom_WorkerSteal(&impl->workers[victim]);
+      if (conn != NULL) {
+        return conn;
+      }
+    }
+  }
+  return NULL;
+}
+
+/**
+ *  poll the epoll set of a busy worker without waiting, so that its connections are not left while it runs a long callback.
+ *  a sleeping worker is skipped; it is woken by its own connections
+ *
+ *  @return number of ready connections pushed into the deque of w
+ */
+static int SocketCom_WorkerStealPoll(SocketCom_Worker *w, struct epoll_event events[])
+{
+  SocketCom_WorkersImpl *impl = w->impl;
+  int start;
+  int i;
+
+  w->seed = w->seed * 1103515245u + 12345u;
+  start = (int)((w->seed >> 16) % (unsigned int)impl->workers_len);
+  for (i = 0; i < impl->workers_len; i++) {
+    SocketCom_Worker *victim = &impl->workers[(start + i) % impl->workers_len];
+    if (victim == w || victim->sleeping.load(std::memory_order_relaxed)) {
+      continue;
+    }
+    // EPOLLONESHOT gives each ready connection to one worker; it is re-armed in the epoll set of its own worker
+    int n = SocketCom_WorkerPoll(w, victim, events, 0);
+    if (n > 0) {
+      w->stolen_polled.store(w->stolen_polled.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+      return n;
+    }
+  }
+  return 0;
+}
+
+static int SocketCom_WorkersHasWork(SocketCom_WorkersImpl *impl)
+{
+  int i;
+
+  for (i = 0; i < impl->workers_len; i++) {
+    SocketCom_Worker *w = &impl->workers[i];
+    if (w->bottom.load(std::memory_order_seq_cst) - w->top.load(std::memory_order_seq_cst) > 0) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static void *SocketCom_WorkerMain(void *arg)
+{
+  SocketCom_Worker *w = (SocketCom_Worker *)arg;
+  SocketCom_WorkersImpl *impl = w->impl;
+  struct epoll_event events[SOCKETCOM_WORKERS_MAX_EVENTS];
+  SocketCom_WorkerConn *conn;
+
+  while (!impl->stop.load(std::memory_order_acquire)) {
+    conn = SocketCom_WorkerPop(w);
+    if (conn != NULL) {
+      SocketCom_WorkerRun(w, conn);
+      continue;
+    }
+    if (SocketCom_WorkerPoll(w, w, events, 0) > 0) {
+      continue;
+    }
+    conn = SocketCom_WorkerStealAny(w);
+    if (conn != NULL) {
+      SOCKETCOM_WORKERS_INC(w->stolen);
+      SocketCom_WorkerRun(w, conn);
+      continue;
+    }
+    if (SocketCom_WorkerStealPoll(w, events) > 0) {
+      continue;
+    }
+
+    // no work; sleep until own connections are ready, woken by a busy worker, or the next try to steal
+    w->sleeping.store(1, std::memory_order_seq_cst);
+    impl->idle.fetch_add(1, std::memory_order_seq_cst);
+    if (!SocketCom_WorkersHasWork(impl) && !impl->stop.load(std::memory_order_acquire)) {
+      SOCKETCOM_WORKERS_INC(w->sleeps);
+      SocketCom_WorkerPoll(w, w, events, SOCKETCOM_WORKERS_IDLE_MSEC);
+    }
+    w->sleeping.store(0, std::memory_order_relaxed);
+    impl->idle.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  return NULL;
+}
+
+static void SocketCom_WorkersFree(SocketCom_WorkersImpl *impl)
+{
+  int i;
+
+  for (i = 0; i < impl->workers_len; i++) {
+    SocketCom_Worker *w = &impl->workers[i];
+    if (w->epfd >= 0) {
+      close(w->epfd);
+    }
+    if (w->wakeup_fd >= 0) {
+      close(w->wakeup_fd);
+    }
+  }
+  delete[] impl->workers;
+  delete impl;
+}
+
+static int SocketCom_WorkerOpen(SocketCom_Worker *w)
+{
+  struct epoll_event ev;
+
+  w->epfd = epoll_create1(EPOLL_CLOEXEC);
+  if (w->epfd < 0) {
+    PERROR("epoll_create1() in SocketCom_WorkerOpen()");
+    return SOCKETCOM_ERROR_POLLER;
+  }
+  w->wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (w->wakeup_fd < 0) {
+    PERROR("eventfd() in SocketCom_WorkerOpen()");
+    return SOCKETCOM_ERROR_CREATE;
+  }
+
+  memset(&ev, 0, sizeof(ev));
+  ev.events = EPOLLIN;
+  ev.data.ptr = NULL;
+  if (epoll_ctl(w->epfd, EPOLL_CTL_ADD, w->wakeup_fd, &ev) != 0) {
+    PERROR("epoll_ctl() in SocketCom_WorkerOpen()");
+    return SOCKETCOM_ERROR_POLLER_CTL;
+  }
+  return SOCKETCOM_SUCCESS;
+}
+
+int SocketCom_WorkersCreate(SocketCom_Workers *workers, int workers_len, int flags, SocketCom_WorkerCallback callback, void *arg)
+{
+  SocketCom_WorkersImpl *impl;
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  int res;
+  int i;
+
+  workers->impl = NULL;
+  if (workers_len <= 0) {
+    workers_len = (cpus > 0) ? (int)cpus : 1;
+  }
+
+  impl = new (std::nothrow) SocketCom_WorkersImpl;
+  if (impl == NULL) {
+    return SOCKETCOM_ERROR_MEMORY;
+  }
+  impl->workers = new (std::nothrow) SocketCom_Worker[workers_len];
+  if (impl->workers == NULL) {
+    delete impl;
+    return SOCKETCOM_ERROR_MEMORY;
+  }
+  impl->owner = workers;
+  impl->workers_len = workers_len;
+  impl->callback = callback;
+  impl->arg = arg;
+  impl->stop.store(0);
+  impl->idle.store(0);
+  impl->next.store(0);
+
+  for (i = 0; i < workers_len; i++) {
+    SocketCom_Worker *w = &impl->workers[i];
+    w->top.store(0);
+    w->bottom.store(0);
+    w->impl = impl;
+    w->index = i;
+    w->epfd = -1;
+    w->wakeup_fd = -1;
+    w->seed = (unsigned int)i * 2654435761u + 1;
+    w->running = 0;
+    w->sleeping.store(0);
+    w->polled.store(0);
+    w->executed.store(0);
+    w->stolen.store(0);
+    w->stolen_polled.store(0);
+    w->overflows.store(0);
+    w->rearm_failures.store(0);
+    w->sleeps.store(0);
+    w->wakeups.store(0);
+  }
+  for (i = 0; i < workers_len; i++) {
+    res = SocketCom_WorkerOpen(&impl->workers[i]);
+    if (res != SOCKETCOM_SUCCESS) {
+      SocketCom_WorkersFree(impl);
+      return res;
+    }
+  }
+
+  workers->impl = impl;
+  for (i = 0; i < workers_len; i++) {
+    SocketCom_Worker *w = &impl->workers[i];
+    if (pthread_create(&w->thread, NULL, SocketCom_WorkerMain, w) != 0) {
+      PERROR("pthread_create() in SocketCom_WorkersCreate()");
+      SocketCom_WorkersDestroy(workers);
+      return SOCKETCOM_ERROR_CREATE;
+    }
+    w->running = 1;
+    if (flags & SOCKETCOM_WORKERS_FLAG_PIN_CPU) {
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      CPU_SET((cpus > 0) ? (i % cpus) : 0, &set);
+      pthread_setaffinity_np(w->thread, sizeof(set), &set);
+    }
+  }
+
+  return SOCKETCOM_SUCCESS;
+}
+
+int SocketCom_WorkersDestroy(SocketCom_Workers *workers)
+{
+  SocketCom_WorkersImpl *impl = (SocketCom_WorkersImpl *)workers->impl;
+  unsigned long long one = 1;
+  int i;
+
+  if (impl == NULL) {
+    return SOCKETCOM_ERROR_ILLEGAL_SOCK;
+  }
+
+  impl->stop.store(1, std::memory_order_release);
+  for (i = 0; i < impl->workers_len; i++) {
+    SocketCom_Worker *w = &impl->workers[i];
+    if (w->running) {
+      if (write(w->wakeup_fd, &one, sizeof(one)) < 0) {
+        PERROR("write() in SocketCom_WorkersDestroy()");
+      }
+    }
+  }
+  for (i = 0; i < impl->workers_len; i++) {
+    SocketCom_Worker *w = &impl->workers[i];
+    if (w->running) {
+      pthread_join(w->thread, NULL);
+      w->running = 0;
+    }
+  }
+
+  SocketCom_WorkersFree(impl);
+  workers->impl = NULL;
+
+  return SOCKETCOM_SUCCESS;
+}
+
+int SocketCom_WorkersAdd(SocketCom_Workers *workers, SocketCom_WorkerConn *conn, SocketCom *sock, int events, void *arg)
+{
+  SocketCom_WorkersImpl *impl = (SocketCom_WorkersImpl *)workers->impl;
+
+  conn->sock = sock;
+  conn->arg = arg;
+  conn->interest = events;
+  conn->events = 0;
+  conn->worker = (int)(impl->next.fetch_add(1, std::memory_order_relaxed) % (unsigned int)impl->workers_len);
+
+  return SocketCom_WorkersArm(impl, conn, EPOLL_CTL_ADD);
+}
+
+int SocketCom_WorkersRearm(SocketCom_Workers *workers, SocketCom_WorkerConn *conn)
+{
+  return SocketCom_WorkersArm((SocketCom_WorkersImpl *)workers->impl, conn, EPOLL_CTL_MOD);
+}
+
+int SocketCom_WorkersRemove(SocketCom_Workers *workers, SocketCom_WorkerConn *conn)
+{
+  SocketCom_WorkersImpl *impl = (SocketCom_WorkersImpl *)workers->impl;
+
+  if (epoll_ctl(impl->workers[conn->worker].epfd, EPOLL_CTL_DEL, conn->sock->fd, NULL) != 0) {
+    PERROR("epoll_ctl() in SocketCom_WorkersRemove()");
+    return SOCKETCOM_ERROR_POLLER_CTL;
+  }
+  return SOCKETCOM_SUCCESS;
+}
+
+int SocketCom_WorkersCount(const SocketCom_Workers *workers)
+{
+  const SocketCom_WorkersImpl *impl = (const SocketCom_WorkersImpl *)workers->impl;
+
+  return (impl != NULL) ? impl->workers_len : 0;
+}
+
+int SocketCom_WorkersGetStats(const SocketCom_Workers *workers, int worker, SocketCom_WorkersStats *stats)
+{
+  const SocketCom_WorkersImpl *impl = (const SocketCom_WorkersImpl *)workers->impl;
+  const SocketCom_Worker *w;
+
+  if (impl == NULL || worker < 0 || worker >= impl->workers_len) {
+    return SOCKETCOM_ERROR_ILLEGAL_SOCK;
+  }
+  w = &impl->workers[worker];
+  stats->polled = w->polled.load(std::memory_order_relaxed);
+  stats->executed = w->executed.load(std::memory_order_relaxed);
+  stats->stolen = w->stolen.load(std::memory_order_relaxed);
+  stats->stolen_polled = w->stolen_polled.load(std::memory_order_relaxed);
+  stats->overflows = w->overflows.load(std::memory_order_relaxed);
+  stats->rearm_failures = w->rearm_failures.load(std::memory_order_relaxed);
+  stats->sleeps = w->sleeps.load(std::memory_order_relaxed);
+  stats->wakeups = w->wakeups.load(std::memory_order_relaxed);
+
+  return SOCKETCOM_SUCCESS;
+}
+
+#else
+
+int SocketCom_WorkersCreate(SocketCom_Workers *workers, int workers_len, int flags, SocketCom_WorkerCallback callback, void *arg)
+{
+  (void)workers_len; (void)flags; (void)callback; (void)arg;
+  workers->impl = NULL;
+  return SOCKETCOM_ERROR_NOTSUPPORTED;
+}
+
+int SocketCom_WorkersDestroy(SocketCom_Workers *workers)
+{
+  (void)workers;
+  return SOCKETCOM_ERROR_NOTSUPPORTED;
+}
+
+int SocketCom_WorkersAdd(SocketCom_Workers *workers, SocketCom_WorkerConn *conn, SocketCom *sock, int events, void *arg)
+{
+  (void)workers; (void)conn; (void)sock; (void)events; (void)arg;
+  return SOCKETCOM_ERROR_NOTSUPPORTED;
+}
+
+int SocketCom_WorkersRearm(SocketCom_Workers *workers, SocketCom_WorkerConn *conn)
+{
+  (void)workers; (void)conn;
+  return SOCKETCOM_ERROR_NOTSUPPORTED;
+}
+
+int SocketCom_WorkersRemove(SocketCom_Workers *workers, SocketCom_WorkerConn *conn)
+{
+  (void)workers; (void)conn;
+  return SOCKETCOM_ERROR_NOTSUPPORTED;
+}
+
+int SocketCom_WorkersCount(const SocketCom_Workers *workers)
+{
+  (void)workers;
+  return 0;
+}
+
+int SocketCom_WorkersGetStats(const SocketCom_Workers *workers, int worker, SocketCom_WorkersStats *stats)
+{
+  (void)workers; (void)worker; (void)stats;
+  return SOCKETCOM_ERROR_NOTSUPPORTED;
+}
+
+#endif
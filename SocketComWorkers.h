@@ -0,0 +1,156 @@
+/*
+SocketCom
+
+Copyright (c) 2017 r01hee
+
+This software is released under the MIT License.
+http://opensource.org/licenses/mit-license.php
+*/
+
+#ifndef __SOCKETCOM_WORKERS_H__
+#define __SOCKETCOM_WORKERS_H__
+
+#include "SocketCom.h"
+
+// capacity of the deque of a worker (power of 2); ready connections beyond it are handled at once by the polling worker
+#ifndef SOCKETCOM_WORKERS_DEQUE_SIZE
+#define SOCKETCOM_WORKERS_DEQUE_SIZE 4096
+#endif
+
+#define SOCKETCOM_WORKERS_MAX_EVENTS 256
+
+// max sleep of an idle worker before it tries to steal again
+#ifndef SOCKETCOM_WORKERS_IDLE_MSEC
+#define SOCKETCOM_WORKERS_IDLE_MSEC 10
+#endif
+
+enum SOCKETCOM_WORKERS_FLAG {
+  SOCKETCOM_WORKERS_FLAG_NONE = 0x00,
+  SOCKETCOM_WORKERS_FLAG_PIN_CPU = 0x01, // pin worker i to CPU (i % number of CPUs); Linux only
+};
+
+enum SOCKETCOM_WORKERS_NEXT {
+  SOCKETCOM_WORKERS_REARM = 0, // wait for the next events of conn
+  SOCKETCOM_WORKERS_DISARM = 1, // leave conn disarmed; the callback removed it, or re-arms it later by SocketCom_WorkersRearm()
+};
+
+struct SocketCom_Workers;
+
+/**
+ *  connection registered to workers; allocated by the application and kept until it is removed
+ *
+ *  @attention  do not change members while registered
+ */
+typedef struct SocketCom_WorkerConn {
+  SocketCom *sock;
+  void *arg; // free for the application
+  int interest; // OR of SOCKETCOM_POLL_IN and SOCKETCOM_POLL_OUT
+  int events; // ready events given to the callback
+  int worker; // worker polling conn
+} SocketCom_WorkerConn;
+
+/**
+ *  called on a worker thread for ready conn
+ *  conn is disarmed while the callback runs, so the callbacks of one conn never run at the same time.
+ *  if conn cannot be re-armed for SOCKETCOM_WORKERS_REARM, the callback is called again at once with only SOCKETCOM_POLL_ERR;
+ *  conn is left disarmed, so remove it, or return SOCKETCOM_WORKERS_REARM to try once more
+ *
+ *  @param[in] worker index of the worker running the callback
+ *  @param[in] events OR of SOCKETCOM_POLL_IN, SOCKETCOM_POLL_OUT, SOCKETCOM_POLL_ERR, SOCKETCOM_POLL_HUP
+ *  @return SOCKETCOM_WORKERS_REARM or SOCKETCOM_WORKERS_DISARM
+ */
+typedef int (*SocketCom_WorkerCallback)(struct SocketCom_Workers *workers, int worker, SocketCom_WorkerConn *conn, int events, void *arg);
+
+/**
+ *  counters of a worker
+ */
+typedef struct SocketCom_WorkersStats {
+  unsigned long long polled; // ready connections polled by the worker
+  unsigned long long executed; // callbacks run by the worker
+  unsigned long long stolen; // callbacks of connections stolen from other workers
+  unsigned long long stolen_polled; // ready connections polled from the epoll sets of busy workers
+  unsigned long long overflows; // callbacks run at once because the deque was full
+  unsigned long long rearm_failures; // failures to re-arm a conn for SOCKETCOM_WORKERS_REARM
+  unsigned long long sleeps; // waits without work
+  unsigned long long wakeups; // idle workers woken by the worker
+} SocketCom_WorkersStats;
+
+/**
+ *  work-stealing pool of worker threads running callbacks of ready connections
+ *
+ *  each worker polls its own set of connections (epoll with EPOLLONESHOT) and pushes ready ones into its own lock-free
+ *  deque (Chase-Lev): the owner pops the newest, and idle workers steal the oldest from others. an idle worker also polls
+ *  the sets of busy workers without waiting, so one slow callback delays neither the connections in its deque nor those
+ *  not yet polled. a polled connection is disarmed until its callback returns, so it is in at most one deque and never
+ *  handled by two workers at the same time
+ *
+ *  @attention  before to use struct SocketCom_Workers, initialize by SocketCom_WorkersCreate()
+ *  @attention  supported only on Linux
+ */
+typedef struct SocketCom_Workers {
+  void *impl;
+} SocketCom_Workers;
+
+/**
+ *  create workers and start their threads
+ *
+ *  @param[out] workers workers
+ *  @param[in] workers_len number of worker threads; 0 for the number of CPUs
+ *  @param[in] flags OR of SOCKETCOM_WORKERS_FLAG
+ *  @param[in] callback called for each ready connection
+ *  @param[in] arg given to callback
+ *  @retval SOCKETCOM_SUCCESS success
+ *  @retval SOCKETCOM_ERROR_NOTSUPPORTED not Linux
+ *  @retval !=SOCKETCOM_SUCCESS error
+ */
+int SocketCom_WorkersCreate(SocketCom_Workers *workers, int workers_len, int flags, SocketCom_WorkerCallback callback, void *arg);
+
+/**
+ *  stop and join the threads; registered socks are not closed
+ */
+int SocketCom_WorkersDestroy(SocketCom_Workers *workers);
+
+/**
+ *  register conn for sock; workers are given connections in turn
+ *
+ *  @param[out] conn conn kept until it is removed
+ *  @param[in] sock non-blocking sock
+ *  @param[in] events OR of SOCKETCOM_POLL_IN and SOCKETCOM_POLL_OUT
+ *  @param[in] arg stored to conn->arg
+ *  @retval SOCKETCOM_SUCCESS success
+ *  @retval SOCKETCOM_ERROR_POLLER_CTL error
+ */
+int SocketCom_WorkersAdd(SocketCom_Workers *workers, SocketCom_WorkerConn *conn, SocketCom *sock, int events, void *arg);
+
+/**
+ *  arm conn disarmed by SOCKETCOM_WORKERS_DISARM again, with conn->interest
+ *
+ *  @retval SOCKETCOM_SUCCESS success
+ *  @retval SOCKETCOM_ERROR_POLLER_CTL error
+ */
+int SocketCom_WorkersRearm(SocketCom_Workers *workers, SocketCom_WorkerConn *conn);
+
+/**
+ *  unregister conn; call from its callback or while it is disarmed, then conn can be freed and sock closed
+ *
+ *  @retval SOCKETCOM_SUCCESS success
+ *  @retval SOCKETCOM_ERROR_POLLER_CTL error
+ */
+int SocketCom_WorkersRemove(SocketCom_Workers *workers, SocketCom_WorkerConn *conn);
+
+/**
+ *  @return number of workers
+ */
+int SocketCom_WorkersCount(const SocketCom_Workers *workers);
+
+/**
+ *  counters of a worker
+ *
+ *  @param[in] worker index of the worker
+ *  @param[out] stats counters
+ *  @retval SOCKETCOM_SUCCESS success
+ *  @retval SOCKETCOM_ERROR_ILLEGAL_SOCK worker is out of range
+ */
+int SocketCom_WorkersGetStats(const SocketCom_Workers *workers, int worker, SocketCom_WorkersStats *stats);
+
+#endif
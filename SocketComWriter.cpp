@@ -0,0 +1,192 @@
+/*
+SocketCom
+
+Copyright (c) 2017 r01hee
+
+This software is released under the MIT License.
+http://opensource.org/licenses/mit-license.php
+*/
+
+#include "SocketComWriter.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+int SocketCom_WriterInit(SocketCom_Writer *writer, SocketCom *sock, void *buf, int capacity, int policy, int threshold)
+{
+  memset(writer, 0, sizeof(SocketCom_Writer));
+  writer->sock = sock;
+  writer->capacity = (capacity > 0) ? capacity : SOCKETCOM_WRITER_DEFAULT_CAPACITY;
+  writer->policy = policy;
+  writer->threshold = (threshold > 0 && threshold < writer->capacity) ? threshold : writer->capacity;
+
+  if (buf != NULL) {
+    writer->buf = (char *)buf;
+  } else {
+    writer->buf = (char *)malloc(writer->capacity);
+    if (writer->buf == NULL) {
+      return SOCKETCOM_ERROR_MEMORY;
+    }
+    writer->own = 1;
+  }
+
+  // Nagle would only delay the coalesced sends; ignore errors such as of non-TCP socks
+  SocketCom_SetNoDelay(sock, 1);
+
+  return SOCKETCOM_SUCCESS;
+}
+
+int SocketCom_WriterDestroy(SocketCom_Writer *writer)
+{
+  if (writer->corked) {
+    SocketCom_SetCork(writer->sock, 0);
+  }
+  if (writer->own) {
+    free(writer->buf);
+  }
+  writer->buf = NULL;
+  writer->capacity = 0;
+  writer->head = 0;
+  writer->len = 0;
+  writer->own = 0;
+  writer->corked = 0;
+
+  return SOCKETCOM_SUCCESS;
+}
+
+/**
+ *  copy data after the buffered data; the caller checks that it fits
+ */
+static void SocketCom_WriterAppend(SocketCom_Writer *writer, const void *data, int len)
+{
+  if (writer->head + writer->len + len > writer->capacity) {
+    memmove(writer->buf, writer->buf + writer->head, writer->len);
+    writer->head = 0;
+  }
+  memcpy(writer->buf + writer->head + writer->len, data, len);
+  writer->len += len;
+}
+
+/**
+ *  under SOCKETCOM_WRITER_POLICY_CORK, hold partial frames of sends before the explicit flush
+ */
+static void SocketCom_WriterCork(SocketCom_Writer *writer)
+{
+  if (writer->policy == SOCKETCOM_WRITER_POLICY_CORK && !writer->corked) {
+    writer->corked = (SocketCom_SetCork(writer->sock, 1) == SOCKETCOM_SUCCESS);
+  }
+}
+
+/**
+ *  send buffered data followed by data (can be NULL) by one writev()
+ *
+ *  @param[out] dataSent bytes of data sent
+ */
+static int SocketCom_WriterSend(SocketCom_Writer *writer, const void *data, int dataLen, int *dataSent)
+{
+  SocketCom_IoVec vec[2];
+  SocketCom_IoVec *iov = vec;
+  int iovcnt = 0;
+  size_t sent = 0;
+  int res;
+
+  *dataSent = 0;
+  if (writer->len > 0) {
+    SOCKETCOM_IOVEC_SET(vec[iovcnt], writer->buf + writer->head, writer->len);
+    iovcnt++;
+  }
+  if (dataLen > 0) {
+    SOCKETCOM_IOVEC_SET(vec[iovcnt], data, dataLen);
+    iovcnt++;
+  }
+  if (iovcnt == 0) {
+    return SOCKETCOM_SUCCESS;
+  }
+
+  SocketCom_WriterCork(writer);
+  res = SocketCom_SendV(writer->sock, &iov, &iovcnt, &sent);
+  writer->sends++;
+  writer->bytes += sent;
+
+  // buffered data goes first
+  if (sent >= (size_t)writer->len) {
+    *dataSent = (int)(sent - writer->len);
+    writer->head = 0;
+    writer->len = 0;
+  } else {
+    writer->head += (int)sent;
+    writer->len -= (int)sent;
+  }
+
+  return res;
+}
+
+int SocketCom_WriterWrite(SocketCom_Writer *writer, const void *buf, int bufLen, int *writtenLen)
+{
+  int sent;
+  int res;
+
+  if (writtenLen != NULL) {
+    *writtenLen = 0;
+  }
+  writer->writes++;
+
+  if (bufLen <= writer->capacity - writer->len) {
+    SocketCom_WriterAppend(writer, buf, bufLen);
+    if (writtenLen != NULL) {
+      *writtenLen = bufLen;
+    }
+
+    if (writer->policy == SOCKETCOM_WRITER_POLICY_IMMEDIATE
+        || (writer->policy == SOCKETCOM_WRITER_POLICY_CORK && writer->len >= writer->threshold)) {
+      res = SocketCom_WriterSend(writer, NULL, 0, &sent);
+      // data not sent by a non-blocking sock is kept buffered
+      return (res == SOCKETCOM_ERROR_WOULDBLOCK) ? SOCKETCOM_SUCCESS : res;
+    }
+    return SOCKETCOM_SUCCESS;
+  }
+
+  // does not fit; send with the buffered data, without copying
+  res = SocketCom_WriterSend(writer, buf, bufLen, &sent);
+  if (res == SOCKETCOM_ERROR_WOULDBLOCK && bufLen - sent <= writer->capacity - writer->len) {
+    SocketCom_WriterAppend(writer, (const char *)buf + sent, bufLen - sent);
+    sent = bufLen;
+    res = SOCKETCOM_SUCCESS;
+  }
+  if (writtenLen != NULL) {
+    *writtenLen = sent;
+  }
+  return res;
+}
+
+int SocketCom_WriterFlush(SocketCom_Writer *writer)
+{
+  int sent;
+  int res;
+
+  res = SocketCom_WriterSend(writer, NULL, 0, &sent);
+  if (res != SOCKETCOM_SUCCESS) {
+    return res;
+  }
+
+  if (writer->corked) {
+    writer->corked = 0;
+    res = SocketCom_SetCork(writer->sock, 0);
+  }
+
+  return res;
+}
+
+int SocketCom_WriterLoopEnd(SocketCom_Writer *writer)
+{
+  if (writer->policy == SOCKETCOM_WRITER_POLICY_CORK) {
+    return SOCKETCOM_SUCCESS;
+  }
+
+  return SocketCom_WriterFlush(writer);
+}
+
+int SocketCom_WriterBuffered(const SocketCom_Writer *writer)
+{
+  return writer->len;
+}
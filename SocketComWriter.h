@@ -0,0 +1,98 @@
+/*
+SocketCom
+
+Copyright (c) 2017 r01hee
+
+This software is released under the MIT License.
+http://opensource.org/licenses/mit-license.php
+*/
+
+#ifndef __SOCKETCOM_WRITER_H__
+#define __SOCKETCOM_WRITER_H__
+
+#include "SocketCom.h"
+
+#define SOCKETCOM_WRITER_DEFAULT_CAPACITY (64 * 1024)
+
+enum SOCKETCOM_WRITER_POLICY {
+  SOCKETCOM_WRITER_POLICY_IMMEDIATE = 0, // every write is sent at once, through the buffer
+  SOCKETCOM_WRITER_POLICY_CORK = 1, // writes are buffered until SocketCom_WriterFlush() or threshold; TCP_CORK holds partial frames of earlier sends
+  SOCKETCOM_WRITER_POLICY_LOOP_END = 2, // writes are buffered until SocketCom_WriterLoopEnd() at the end of the event loop iteration
+};
+
+/**
+ *  buffered writer of a sock, coalescing small writes into few packets and syscalls
+ *  small writes are copied into a buffer, and a write which does not fit is sent together with the buffered data by one writev()
+ *  without being copied. since the writer coalesces by itself, TCP_NODELAY is set on sock
+ *
+ *  on a non-blocking sock, data which cannot be sent is kept buffered; flush again when sock becomes writable
+ *
+ *  @attention  before to use struct SocketCom_Writer, initialize by SocketCom_WriterInit()
+ */
+typedef struct SocketCom_Writer {
+  SocketCom *sock;
+  char *buf;
+  int capacity;
+  int head; // offset of the first buffered byte
+  int len; // number of buffered bytes
+  int own; // buf is allocated by the writer
+  int policy; // SOCKETCOM_WRITER_POLICY
+  int threshold; // SOCKETCOM_WRITER_POLICY_CORK sends when this many bytes are buffered
+  int corked; // TCP_CORK is set on sock
+
+  unsigned long long writes; // calls of SocketCom_WriterWrite()
+  unsigned long long sends; // sends to sock; each is one writev() unless it is partial
+  unsigned long long bytes; // bytes sent
+} SocketCom_Writer;
+
+/**
+ *  initialize writer
+ *
+ *  @param[out] writer writer
+ *  @param[in] sock connected sock to write
+ *  @param[in] buf buffer of capacity bytes; NULL to allocate it
+ *  @param[in] capacity size of buffer; 0 for SOCKETCOM_WRITER_DEFAULT_CAPACITY
+ *  @param[in] policy SOCKETCOM_WRITER_POLICY
+ *  @param[in] threshold buffered bytes which make SOCKETCOM_WRITER_POLICY_CORK send; 0 for capacity
+ *  @retval SOCKETCOM_SUCCESS success
+ *  @retval SOCKETCOM_ERROR_MEMORY cannot allocate buffer
+ */
+int SocketCom_WriterInit(SocketCom_Writer *writer, SocketCom *sock, void *buf, int capacity, int policy, int threshold);
+
+/**
+ *  release writer; buffered data is discarded, so flush before
+ */
+int SocketCom_WriterDestroy(SocketCom_Writer *writer);
+
+/**
+ *  write bufLen bytes; they are buffered or sent by the policy
+ *
+ *  @param[out] writtenLen bytes sent or buffered; bufLen unless SOCKETCOM_ERROR_WOULDBLOCK or error. can be NULL
+ *  @retval SOCKETCOM_SUCCESS all of buf is sent or buffered
+ *  @retval SOCKETCOM_ERROR_WOULDBLOCK non-blocking sock cannot send, and the buffer cannot keep the rest of buf; write the rest again
+ *  @retval !=SOCKETCOM_SUCCESS same as SocketCom_SendV()
+ */
+int SocketCom_WriterWrite(SocketCom_Writer *writer, const void *buf, int bufLen, int *writtenLen);
+
+/**
+ *  send all buffered data, and release TCP_CORK so that the last partial frame is sent
+ *
+ *  @retval SOCKETCOM_SUCCESS nothing is left buffered
+ *  @retval SOCKETCOM_ERROR_WOULDBLOCK non-blocking sock cannot send more now; flush again when writable
+ *  @retval !=SOCKETCOM_SUCCESS same as SocketCom_SendV()
+ */
+int SocketCom_WriterFlush(SocketCom_Writer *writer);
+
+/**
+ *  tell the end of an event loop iteration; flush unless the policy is SOCKETCOM_WRITER_POLICY_CORK
+ *
+ *  @retval same as SocketCom_WriterFlush()
+ */
+int SocketCom_WriterLoopEnd(SocketCom_Writer *writer);
+
+/**
+ *  @return number of buffered bytes
+ */
+int SocketCom_WriterBuffered(const SocketCom_Writer *writer);
+
+#endif
@@ -0,0 +1,546 @@
+/*
+SocketCom
+
+Copyright (c) 2017 r01hee
+
+This software is released under the MIT License.
+http://opensource.org/licenses/mit-license.php
+*/
+
+/*
+ * loopback benchmark suite of the SocketCom API
+ *
+ * build: g++ -O2 -I.. SocketComBench.cpp ../SocketCom.cpp ../SocketComStats.cpp -lpthread -o SocketComBench
+ *        (add -DSOCKETCOM_USE_STATS to all files to include global I/O counters in the results)
+ * usage: SocketComBench [output.json] [scale]
+ *
+ * latency:    ping-pong of one connection; round trip times in histograms (p50/p99/p999)
+ * throughput: one-way stream of one connection at several message sizes
+ * churn:      connection setup and teardown by SocketCom_ConnectWithTimeout()/SocketCom_Accept(),
+ *             closed abortively (SocketCom_Abort()) or gracefully (SocketCom_Close())
+ * fanin:      one receiver waiting on many connections by SocketCom_WaitForRecvables()
+ *
+ * results are written as JSON to output.json ("-" or omitted for stdout), a summary to stderr.
+ * scale multiplies the number of iterations (default 1)
+ */
+
+#include "SocketComStats.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#define BENCH_PORT 40300
+#define BENCH_FANIN_CONNS 256
+#define BENCH_STREAM_BUF_SIZE (64 * 1024)
+
+/*
+ * histogram of nano seconds in the manner of HdrHistogram:
+ * values below 2^BENCH_HIST_SUB_BITS are exact, and each larger power of two is split into
+ * 2^(BENCH_HIST_SUB_BITS - 1) buckets, so that any value is recorded within 1/64 (1.6%) of it
+ */
+#define BENCH_HIST_SUB_BITS 7
+#define BENCH_HIST_HALF (1 << (BENCH_HIST_SUB_BITS - 1))
+#define BENCH_HIST_BUCKETS ((64 - BENCH_HIST_SUB_BITS + 2) * BENCH_HIST_HALF)
+
+typedef struct BenchHist {
+  unsigned long long counts[BENCH_HIST_BUCKETS];
+  unsigned long long count;
+  unsigned long long min;
+  unsigned long long max;
+  double sum;
+} BenchHist;
+
+static void bench_hist_init(BenchHist *hist)
+{
+  memset(hist, 0, sizeof(BenchHist));
+  hist->min = ~0ULL;
+}
+
+static int bench_hist_index(unsigned long long value)
+{
+  int msb;
+  int shift;
+
+  if (value < (1ULL << BENCH_HIST_SUB_BITS)) {
+    return (int)value;
+  }
+  msb = 63 - __builtin_clzll(value);
+  shift = msb - BENCH_HIST_SUB_BITS + 1;
+  return shift * BENCH_HIST_HALF + (int)(value >> shift);
+}
+
+/**
+ *  @return the highest value recorded in the bucket of index
+ */
+static unsigned long long bench_hist_value(int index)
+{
+  int shift;
+
+  if (index < (1 << BENCH_HIST_SUB_BITS)) {
+    return (unsigned long long)index;
+  }
+  shift = (index >> (BENCH_HIST_SUB_BITS - 1)) - 1;
+  return ((unsigned long long)(index - shift * BENCH_HIST_HALF) << shift) + (1ULL << shift) - 1;
+}
+
+static void bench_hist_record(BenchHist *hist, unsigned long long value)
+{
+  hist->counts[bench_hist_index(value)]++;
+  hist->count++;
+  hist->sum += (double)value;
+  if (value < hist->min) {
+    hist->min = value;
+  }
+  if (value > hist->max) {
+    hist->max = value;
+  }
+}
+
+/**
+ *  @param[in] percentile 0 - 100
+ */
+static unsigned long long bench_hist_percentile(const BenchHist *hist, double percentile)
+{
+  unsigned long long target = (unsigned long long)(percentile / 100.0 * hist->count + 0.5);
+  unsigned long long seen = 0;
+  int i;
+
+  if (hist->count == 0) {
+    return 0;
+  }
+  if (target < 1) {
+    target = 1;
+  }
+  for (i = 0; i < BENCH_HIST_BUCKETS; i++) {
+    seen += hist->counts[i];
+    if (seen >= target) {
+      unsigned long long value = bench_hist_value(i);
+      return (value > hist->max) ? hist->max : value;
+    }
+  }
+  return hist->max;
+}
+
+static void bench_hist_json(FILE *out, const char *prefix, const BenchHist *hist)
+{
+  fprintf(out, "\"%scount\": %llu, \"%smin_ns\": %llu, \"%smean_ns\": %.0f, \"%sp50_ns\": %llu, \"%sp90_ns\": %llu, \"%sp99_ns\": %llu, \"%sp999_ns\": %llu, \"%smax_ns\": %llu",
+          prefix, hist->count,
+          prefix, (hist->count > 0) ? hist->min : 0,
+          prefix, (hist->count > 0) ? hist->sum / hist->count : 0.0,
+          prefix, bench_hist_percentile(hist, 50.0),
+          prefix, bench_hist_percentile(hist, 90.0),
+          prefix, bench_hist_percentile(hist, 99.0),
+          prefix, bench_hist_percentile(hist, 99.9),
+          prefix, hist->max);
+}
+
+static unsigned long long bench_now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void bench_fail(const char *name, const char *what)
+{
+  fprintf(stderr, "%s: %s\n", name, what);
+  exit(1);
+}
+
+static void bench_listen(SocketCom *listener, u_short port, const char *name)
+{
+  SocketCom_Init(listener);
+  if (SocketCom_Create(listener) != SOCKETCOM_SUCCESS
+      || SocketCom_SetReuseaddr(listener) != SOCKETCOM_SUCCESS
+      || SocketCom_ListenEx(listener, "127.0.0.1", port, 1024, 0) != SOCKETCOM_SUCCESS) {
+    bench_fail(name, "cannot listen on loopback");
+  }
+}
+
+/**
+ *  connect client to listener and accept it as server
+ */
+static void bench_pair(SocketCom *listener, u_short port, SocketCom *client, SocketCom *server, const char *name)
+{
+  SocketCom_Init(client);
+  SocketCom_Init(server);
+  if (SocketCom_Create(client) != SOCKETCOM_SUCCESS
+      || SocketCom_ConnectToWithTimeout(client, "127.0.0.1", port, 1000) != SOCKETCOM_SUCCESS
+      || SocketCom_Accept(listener, server) != SOCKETCOM_SUCCESS) {
+    bench_fail(name, "cannot connect on loopback");
+  }
+}
+
+// latency
+
+typedef struct BenchEcho {
+  SocketCom *sock;
+  int msg_size;
+} BenchEcho;
+
+static void *bench_echo(void *arg)
+{
+  BenchEcho *echo = (BenchEcho *)arg;
+  char *buf = (char *)malloc(echo->msg_size);
+
+  while (SocketCom_RecvAll(echo->sock, buf, echo->msg_size) == SOCKETCOM_SUCCESS) {
+    if (SocketCom_Send(echo->sock, buf, echo->msg_size) != SOCKETCOM_SUCCESS) {
+      break;
+    }
+  }
+
+  free(buf);
+  return NULL;
+}
+
+static void bench_latency(FILE *out, int msg_size, int rounds, u_short port, int first)
+{
+  SocketCom listener, client, server;
+  BenchEcho echo;
+  BenchHist *hist = (BenchHist *)malloc(sizeof(BenchHist));
+  char *buf = (char *)calloc(1, msg_size);
+  pthread_t thread;
+  int i;
+
+  bench_listen(&listener, port, "latency");
+  bench_pair(&listener, port, &client, &server, "latency");
+  SocketCom_Dispose(&listener);
+  echo.sock = &server;
+  echo.msg_size = msg_size;
+  pthread_create(&thread, NULL, bench_echo, &echo);
+
+  // warm up
+  for (i = 0; i < rounds / 10; i++) {
+    SocketCom_Send(&client, buf, msg_size);
+    SocketCom_RecvAll(&client, buf, msg_size);
+  }
+
+  bench_hist_init(hist);
+  for (i = 0; i < rounds; i++) {
+    unsigned long long start = bench_now_ns();
+    if (SocketCom_Send(&client, buf, msg_size) != SOCKETCOM_SUCCESS
+        || SocketCom_RecvAll(&client, buf, msg_size) != SOCKETCOM_SUCCESS) {
+      bench_fail("latency", "connection lost");
+    }
+    bench_hist_record(hist, bench_now_ns() - start);
+  }
+
+  SocketCom_Dispose(&client);
+  pthread_join(thread, NULL);
+  SocketCom_Dispose(&server);
+
+  fprintf(stderr, "latency     size=%-6d rounds=%d: p50 %.1f us, p99 %.1f us, p999 %.1f us\n", msg_size, rounds,
+          bench_hist_percentile(hist, 50.0) / 1e3, bench_hist_percentile(hist, 99.0) / 1e3, bench_hist_percentile(hist, 99.9) / 1e3);
+  fprintf(out, "%s    {\"size\": %d, ", first ? "" : ",\n", msg_size);
+  bench_hist_json(out, "rtt_", hist);
+  fprintf(out, "}");
+
+  free(buf);
+  free(hist);
+}
+
+// throughput
+
+typedef struct BenchStream {
+  SocketCom *sock;
+  int msg_size;
+  long long bytes;
+} BenchStream;
+
+static void *bench_stream_send(void *arg)
+{
+  BenchStream *stream = (BenchStream *)arg;
+  char *buf = (char *)calloc(1, stream->msg_size);
+  long long sent;
+
+  for (sent = 0; sent < stream->bytes; sent += stream->msg_size) {
+    if (SocketCom_Send(stream->sock, buf, stream->msg_size) != SOCKETCOM_SUCCESS) {
+      break;
+    }
+  }
+
+  free(buf);
+  return NULL;
+}
+
+static void bench_throughput(FILE *out, int msg_size, long long bytes, u_short port, int first)
+{
+  SocketCom listener, client, server;
+  BenchStream stream;
+  char *buf = (char *)malloc(BENCH_STREAM_BUF_SIZE);
+  pthread_t thread;
+  long long received = 0;
+  int len;
+
+  bench_listen(&listener, port, "throughput");
+  bench_pair(&listener, port, &client, &server, "throughput");
+  SocketCom_Dispose(&listener);
+  stream.sock = &client;
+  stream.msg_size = msg_size;
+  stream.bytes = bytes / msg_size * msg_size;
+
+  unsigned long long start = bench_now_ns();
+  pthread_create(&thread, NULL, bench_stream_send, &stream);
+  while (received < stream.bytes) {
+    if (SocketCom_Recv(&server, buf, BENCH_STREAM_BUF_SIZE, &len) != SOCKETCOM_SUCCESS) {
+      bench_fail("throughput", "connection lost");
+    }
+    received += len;
+  }
+  double elapsed = (bench_now_ns() - start) / 1e9;
+  pthread_join(thread, NULL);
+
+  SocketCom_Dispose(&client);
+  SocketCom_Dispose(&server);
+
+  fprintf(stderr, "throughput  size=%-6d bytes=%lld: %.1f MB/s, %.0f msgs/s\n", msg_size, received,
+          received / elapsed / 1e6, received / msg_size / elapsed);
+  fprintf(out, "%s    {\"size\": %d, \"bytes\": %lld, \"seconds\": %.6f, \"mb_per_sec\": %.2f, \"msgs_per_sec\": %.0f}",
+          first ? "" : ",\n", msg_size, received, elapsed, received / elapsed / 1e6, received / msg_size / elapsed);
+
+  free(buf);
+}
+
+// churn
+
+typedef struct BenchAcceptor {
+  SocketCom *listener;
+  int count;
+} BenchAcceptor;
+
+static void *bench_accept(void *arg)
+{
+  BenchAcceptor *acceptor = (BenchAcceptor *)arg;
+  int i;
+
+  for (i = 0; i < acceptor->count; i++) {
+    SocketCom sock;
+    SocketCom_Init(&sock);
+    if (SocketCom_Accept(acceptor->listener, &sock) != SOCKETCOM_SUCCESS) {
+      break;
+    }
+    SocketCom_Dispose(&sock);
+  }
+
+  return NULL;
+}
+
+/**
+ *  @param[in] graceful close by SocketCom_Close() if !=0, SocketCom_Abort() otherwise
+ */
+static void bench_churn(FILE *out, int graceful, int count, u_short port, int first)
+{
+  const char *mode = graceful ? "close" : "abort";
+  SocketCom listener;
+  BenchAcceptor acceptor;
+  BenchHist *connect_hist = (BenchHist *)malloc(sizeof(BenchHist));
+  BenchHist *close_hist = (BenchHist *)malloc(sizeof(BenchHist));
+  pthread_t thread;
+  int i;
+
+  bench_listen(&listener, port, "churn");
+  acceptor.listener = &listener;
+  acceptor.count = count;
+  pthread_create(&thread, NULL, bench_accept, &acceptor);
+
+  bench_hist_init(connect_hist);
+  bench_hist_init(close_hist);
+  unsigned long long start = bench_now_ns();
+  for (i = 0; i < count; i++) {
+    SocketCom sock;
+    unsigned long long t0 = bench_now_ns();
+    SocketCom_Init(&sock);
+    if (SocketCom_Create(&sock) != SOCKETCOM_SUCCESS
+        || SocketCom_SetAddr(&sock, "127.0.0.1", port) != SOCKETCOM_SUCCESS
+        || SocketCom_ConnectWithTimeout(&sock, 1000) != SOCKETCOM_SUCCESS) {
+      bench_fail("churn", "cannot connect on loopback");
+    }
+    unsigned long long t1 = bench_now_ns();
+    if (graceful) {
+      SocketCom_Close(&sock);
+    } else {
+      SocketCom_Abort(&sock);
+    }
+    bench_hist_record(connect_hist, t1 - t0);
+    bench_hist_record(close_hist, bench_now_ns() - t1);
+  }
+  double elapsed = (bench_now_ns() - start) / 1e9;
+  pthread_join(thread, NULL);
+  SocketCom_Dispose(&listener);
+
+  fprintf(stderr, "churn       %-6s conns=%d: %.0f conns/s, connect p50 %.1f us, p99 %.1f us\n", mode, count, count / elapsed,
+          bench_hist_percentile(connect_hist, 50.0) / 1e3, bench_hist_percentile(connect_hist, 99.0) / 1e3);
+  fprintf(out, "%s    {\"mode\": \"%s\", \"connections\": %d, \"seconds\": %.6f, \"conns_per_sec\": %.0f, ",
+          first ? "" : ",\n", mode, count, elapsed, count / elapsed);
+  bench_hist_json(out, "connect_", connect_hist);
+  fprintf(out, ", ");
+  bench_hist_json(out, "close_", close_hist);
+  fprintf(out, "}");
+
+  free(close_hist);
+  free(connect_hist);
+}
+
+// fan-in
+
+typedef struct BenchFanin {
+  SocketCom *clients;
+  int conns_len;
+  int rounds;
+  int msg_size;
+} BenchFanin;
+
+static void *bench_fanin_send(void *arg)
+{
+  BenchFanin *fanin = (BenchFanin *)arg;
+  char *buf = (char *)calloc(1, fanin->msg_size);
+  int r, i;
+
+  for (r = 0; r < fanin->rounds; r++) {
+    for (i = 0; i < fanin->conns_len; i++) {
+      SocketCom_Send(&fanin->clients[i], buf, fanin->msg_size);
+    }
+  }
+
+  free(buf);
+  return NULL;
+}
+
+static void bench_fanin(FILE *out, int conns_len, int rounds, int msg_size, u_short port)
+{
+  SocketCom listener;
+  SocketCom *clients = (SocketCom *)calloc(conns_len, sizeof(SocketCom));
+  SocketCom *servers = (SocketCom *)calloc(conns_len, sizeof(SocketCom));
+  SocketCom **socks = (SocketCom **)malloc(sizeof(SocketCom *) * conns_len);
+  char *buf = (char *)malloc(BENCH_STREAM_BUF_SIZE);
+  BenchFanin fanin;
+  pthread_t thread;
+  long long expected = (long long)conns_len * rounds * msg_size;
+  long long received = 0;
+  long long waits = 0;
+  long long readies = 0;
+  int i;
+
+  bench_listen(&listener, port, "fanin");
+  for (i = 0; i < conns_len; i++) {
+    bench_pair(&listener, port, &clients[i], &servers[i], "fanin");
+    socks[i] = &servers[i];
+  }
+  SocketCom_Dispose(&listener);
+  fanin.clients = clients;
+  fanin.conns_len = conns_len;
+  fanin.rounds = rounds;
+  fanin.msg_size = msg_size;
+
+  unsigned long long start = bench_now_ns();
+  pthread_create(&thread, NULL, bench_fanin_send, &fanin);
+  while (received < expected) {
+    // socks keeps all connections, with ready ones moved to its head
+    int socks_len = conns_len;
+    if (SocketCom_WaitForRecvables(socks, &socks_len) != SOCKETCOM_SUCCESS) {
+      bench_fail("fanin", "SocketCom_WaitForRecvables() failed");
+    }
+    waits++;
+    readies += socks_len;
+    for (i = 0; i < socks_len; i++) {
+      int len;
+      if (SocketCom_Recv(socks[i], buf, BENCH_STREAM_BUF_SIZE, &len) != SOCKETCOM_SUCCESS) {
+        bench_fail("fanin", "connection lost");
+      }
+      received += len;
+    }
+  }
+  double elapsed = (bench_now_ns() - start) / 1e9;
+  pthread_join(thread, NULL);
+
+  for (i = 0; i < conns_len; i++) {
+    SocketCom_Dispose(&clients[i]);
+    SocketCom_Dispose(&servers[i]);
+  }
+
+  double msgs = (double)conns_len * rounds;
+  fprintf(stderr, "fanin       conns=%d size=%d: %.0f msgs/s, %.1f ready socks/wait\n", conns_len, msg_size, msgs / elapsed, (double)readies / waits);
+  fprintf(out, "    \"connections\": %d, \"size\": %d, \"messages\": %.0f, \"seconds\": %.6f, \"msgs_per_sec\": %.0f, \"waits\": %lld, \"ready_per_wait\": %.2f\n",
+          conns_len, msg_size, msgs, elapsed, msgs / elapsed, waits, (double)readies / waits);
+
+  free(buf);
+  free(socks);
+  free(servers);
+  free(clients);
+}
+
+#ifdef SOCKETCOM_USE_STATS
+static void bench_stats(FILE *out)
+{
+  SocketCom_Stats stats;
+  int i;
+
+  SocketCom_StatsGetGlobal(&stats);
+  fprintf(out, ",\n  \"stats\": {\"bytes_recv\": %llu, \"bytes_sent\": %llu, \"recv_calls\": %llu, \"send_calls\": %llu, \"short_recvs\": %llu, \"short_sends\": %llu, \"eagain\": %llu, \"eintr\": %llu, \"eofs\": %llu, \"errors\": [",
+          stats.bytes_recv, stats.bytes_sent, stats.recv_calls, stats.send_calls, stats.short_recvs, stats.short_sends, stats.eagain, stats.eintr, stats.eofs);
+  for (i = 0; i < SOCKETCOM_STATS_ERROR_TYPES; i++) {
+    fprintf(out, "%s%llu", (i > 0) ? ", " : "", stats.errors[i]);
+  }
+  fprintf(out, "]}");
+}
+#endif
+
+int main(int argc, char *argv[])
+{
+  static const int latency_sizes[] = { 64, 1024, 16 * 1024 };
+  static const int throughput_sizes[] = { 64, 1024, 16 * 1024, 64 * 1024 };
+  const char *path = (argc > 1) ? argv[1] : "-";
+  int scale = (argc > 2) ? atoi(argv[2]) : 1;
+  u_short port = BENCH_PORT;
+  FILE *out;
+  size_t i;
+
+  if (scale <= 0) {
+    fprintf(stderr, "usage: %s [output.json] [scale]\n", argv[0]);
+    return 1;
+  }
+  out = (strcmp(path, "-") == 0) ? stdout : fopen(path, "w");
+  if (out == NULL) {
+    perror(path);
+    return 1;
+  }
+
+  SocketCom_Startup();
+
+  fprintf(out, "{\n  \"bench\": \"SocketComBench\",\n  \"version\": 1,\n  \"scale\": %d,\n  \"time\": %lld,\n", scale, (long long)time(NULL));
+
+  fprintf(out, "  \"latency\": [\n");
+  for (i = 0; i < sizeof(latency_sizes) / sizeof(latency_sizes[0]); i++) {
+    bench_latency(out, latency_sizes[i], 20000 * scale, port++, i == 0);
+  }
+  fprintf(out, "\n  ],\n");
+
+  fprintf(out, "  \"throughput\": [\n");
+  for (i = 0; i < sizeof(throughput_sizes) / sizeof(throughput_sizes[0]); i++) {
+    long long bytes = (throughput_sizes[i] < 1024) ? 16LL << 20 : 256LL << 20;
+    bench_throughput(out, throughput_sizes[i], bytes * scale, port++, i == 0);
+  }
+  fprintf(out, "\n  ],\n");
+
+  fprintf(out, "  \"churn\": [\n");
+  bench_churn(out, 0, 2000 * scale, port++, 1);
+  bench_churn(out, 1, 2000 * scale, port++, 0);
+  fprintf(out, "\n  ],\n");
+
+  fprintf(out, "  \"fanin\": {\n");
+  bench_fanin(out, BENCH_FANIN_CONNS, 200 * scale, 64, port++);
+  fprintf(out, "  }");
+
+#ifdef SOCKETCOM_USE_STATS
+  bench_stats(out);
+#endif
+  fprintf(out, "\n}\n");
+
+  if (out != stdout) {
+    fclose(out);
+  }
+  return 0;
+}
@@ -0,0 +1,216 @@
+/*
+SocketCom
+
+Copyright (c) 2017 r01hee
+
+This software is released under the MIT License.
+http://opensource.org/licenses/mit-license.php
+*/
+
+/*
+ * loopback benchmark of SocketCom_Engine against the blocking API
+ *
+ * build: g++ -O2 -I.. SocketComEngineBench.cpp ../SocketCom.cpp ../SocketComEngine.cpp ../SocketComBufPool.cpp -lpthread -o SocketComEngineBench
+ * usage: SocketComEngineBench [connections] [rounds] [message size]
+ *
+ * every round, the client sends one message on each connection and receives the echo of all of them
+ */
+
+#include "SocketComEngine.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#define BENCH_PORT 40200
+#define BENCH_MAX_CONNS 1024
+
+typedef struct BenchServer {
+  SocketCom listener;
+  SocketCom conns[BENCH_MAX_CONNS];
+  int conns_len;
+  int msg_size;
+} BenchServer;
+
+static double bench_now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void *bench_echo(void *arg)
+{
+  BenchServer *server = (BenchServer *)arg;
+  SocketCom_Poller poller;
+  SocketCom_PollEvent events[BENCH_MAX_CONNS];
+  char *buf = (char *)malloc(server->msg_size);
+  int i;
+  int open_conns = server->conns_len;
+
+  SocketCom_PollerCreate(&poller, BENCH_MAX_CONNS);
+  for (i = 0; i < server->conns_len; i++) {
+    SocketCom_PollerAdd(&poller, &server->conns[i], SOCKETCOM_POLL_IN);
+  }
+
+  while (open_conns > 0) {
+    int events_len = BENCH_MAX_CONNS;
+    if (SocketCom_PollerWait(&poller, events, &events_len, -1, -1) != SOCKETCOM_SUCCESS) {
+      break;
+    }
+    for (i = 0; i < events_len; i++) {
+      SocketCom *sock = events[i].sock;
+      if (SocketCom_RecvAll(sock, buf, server->msg_size) != SOCKETCOM_SUCCESS) {
+        SocketCom_PollerRemove(&poller, sock);
+        open_conns--;
+        continue;
+      }
+      SocketCom_Send(sock, buf, server->msg_size);
+    }
+  }
+
+  SocketCom_PollerDestroy(&poller);
+  free(buf);
+  return NULL;
+}
+
+static double bench_blocking(SocketCom *conns, int conns_len, int rounds, int msg_size)
+{
+  char *buf = (char *)calloc(1, msg_size);
+  int r, i;
+  double start = bench_now();
+
+  for (r = 0; r < rounds; r++) {
+    for (i = 0; i < conns_len; i++) {
+      SocketCom_Send(&conns[i], buf, msg_size);
+    }
+    for (i = 0; i < conns_len; i++) {
+      SocketCom_RecvAll(&conns[i], buf, msg_size);
+    }
+  }
+
+  free(buf);
+  return bench_now() - start;
+}
+
+static double bench_engine(SocketCom_Engine *engine, SocketCom *conns, int conns_len, int rounds, int msg_size)
+{
+  char *sbuf = (char *)calloc(1, msg_size);
+  char *rbuf = (char *)calloc(conns_len, msg_size);
+  SocketCom_Completion *completions = (SocketCom_Completion *)malloc(sizeof(SocketCom_Completion) * conns_len * 2);
+  int r, i;
+  double start = bench_now();
+
+  for (r = 0; r < rounds; r++) {
+    int pending = 0;
+    for (i = 0; i < conns_len; i++) {
+      SocketCom_EngineSend(engine, &conns[i], sbuf, msg_size, NULL);
+      SocketCom_EngineRecv(engine, &conns[i], rbuf + (size_t)i * msg_size, msg_size, MSG_WAITALL, NULL);
+      pending += 2;
+    }
+    SocketCom_EngineSubmit(engine);
+    while (pending > 0) {
+      int completions_len = conns_len * 2;
+      int res = SocketCom_EngineReap(engine, completions, &completions_len, -1, -1);
+      if (res != SOCKETCOM_SUCCESS) {
+        fprintf(stderr, "SocketCom_EngineReap() failed: %d\n", res);
+        exit(1);
+      }
+      pending -= completions_len;
+    }
+  }
+
+  free(completions);
+  free(rbuf);
+  free(sbuf);
+  return bench_now() - start;
+}
+
+static int bench_connect(BenchServer *server, SocketCom *conns, int conns_len, u_short port)
+{
+  int i;
+
+  SocketCom_Init(&server->listener);
+  if (SocketCom_Create(&server->listener) != SOCKETCOM_SUCCESS
+      || SocketCom_SetReuseaddr(&server->listener) != SOCKETCOM_SUCCESS
+      || SocketCom_Listen(&server->listener, port) != SOCKETCOM_SUCCESS) {
+    return -1;
+  }
+
+  for (i = 0; i < conns_len; i++) {
+    SocketCom_Init(&conns[i]);
+    SocketCom_Init(&server->conns[i]);
+    if (SocketCom_Create(&conns[i]) != SOCKETCOM_SUCCESS
+        || SocketCom_ConnectToWithTimeout(&conns[i], "127.0.0.1", port, 1000) != SOCKETCOM_SUCCESS
+        || SocketCom_Accept(&server->listener, &server->conns[i]) != SOCKETCOM_SUCCESS) {
+      return -1;
+    }
+  }
+  server->conns_len = conns_len;
+
+  return 0;
+}
+
+static void bench_run(const char *name, int mode, int conns_len, int rounds, int msg_size, u_short port)
+{
+  BenchServer *server = (BenchServer *)calloc(1, sizeof(BenchServer));
+  SocketCom *conns = (SocketCom *)calloc(conns_len, sizeof(SocketCom));
+  SocketCom_Engine engine;
+  pthread_t thread;
+  double elapsed;
+  int i;
+
+  server->msg_size = msg_size;
+  if (bench_connect(server, conns, conns_len, port) != 0) {
+    fprintf(stderr, "%s: cannot connect on loopback\n", name);
+    exit(1);
+  }
+  pthread_create(&thread, NULL, bench_echo, server);
+
+  if (mode == 0) {
+    elapsed = bench_blocking(conns, conns_len, rounds, msg_size);
+  } else {
+    SocketCom_EngineCreate(&engine, conns_len * 2, (mode == 1) ? SOCKETCOM_ENGINE_FLAG_NONE : SOCKETCOM_ENGINE_FLAG_NO_IOURING);
+    if (mode == 1 && SocketCom_EngineBackend(&engine) != SOCKETCOM_ENGINE_BACKEND_IOURING) {
+      name = "engine(io_uring unavailable, poller)";
+    }
+    elapsed = bench_engine(&engine, conns, conns_len, rounds, msg_size);
+    SocketCom_EngineDestroy(&engine);
+  }
+
+  for (i = 0; i < conns_len; i++) {
+    SocketCom_Dispose(&conns[i]);
+  }
+  pthread_join(thread, NULL);
+  for (i = 0; i < conns_len; i++) {
+    SocketCom_Dispose(&server->conns[i]);
+  }
+  SocketCom_Dispose(&server->listener);
+
+  double msgs = (double)conns_len * rounds;
+  printf("%-36s conns=%d size=%d: %.0f msgs/s, %.2f us/round\n", name, conns_len, msg_size, msgs / elapsed, elapsed * 1e6 / rounds);
+
+  free(conns);
+  free(server);
+}
+
+int main(int argc, char *argv[])
+{
+  int conns_len = (argc > 1) ? atoi(argv[1]) : 64;
+  int rounds = (argc > 2) ? atoi(argv[2]) : 2000;
+  int msg_size = (argc > 3) ? atoi(argv[3]) : 64;
+
+  if (conns_len <= 0 || conns_len > BENCH_MAX_CONNS || rounds <= 0 || msg_size <= 0) {
+    fprintf(stderr, "usage: %s [connections(1-%d)] [rounds] [message size]\n", argv[0], BENCH_MAX_CONNS);
+    return 1;
+  }
+
+  SocketCom_Startup();
+  bench_run("blocking", 0, conns_len, rounds, msg_size, BENCH_PORT);
+  bench_run("engine(io_uring)", 1, conns_len, rounds, msg_size, BENCH_PORT + 1);
+  bench_run("engine(poller)", 2, conns_len, rounds, msg_size, BENCH_PORT + 2);
+
+  return 0;
+}
@@ -0,0 +1,225 @@
+/*
+SocketCom
+
+Copyright (c) 2017 r01hee
+
+This software is released under the MIT License.
+http://opensource.org/licenses/mit-license.php
+*/
+
+/*
+ * test of SocketCom_Resolver against names of /etc/hosts
+ *
+ * build: g++ -O2 -I.. SocketComResolverTest.cpp ../SocketCom.cpp ../SocketComResolver.cpp -lpthread -o SocketComResolverTest
+ * usage: SocketComResolverTest [host name in /etc/hosts]
+ *
+ * checks coalescing of concurrent requests, the positive and negative TTLs of the cache, and A/AAAA results
+ * exit status is 0 if all checks pass
+ */
+
+#include "SocketComResolver.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+
+#define TEST_TTL_MSEC 200
+#define TEST_REQUESTS 16
+// RFC 6761; never resolved
+#define TEST_MISSING_NAME "socketcom-test.invalid"
+
+static int test_failures = 0;
+
+#define TEST_CHECK(cond, name) do { \
+    if (cond) { \
+      printf("PASS %s\n", name); \
+    } else { \
+      printf("FAIL %s (%s:%d)\n", name, __FILE__, __LINE__); \
+      test_failures++; \
+    } \
+  } while (0)
+
+typedef struct TestWait {
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  int done;
+  int succeeded;
+} TestWait;
+
+static void test_on_resolved(const char *hostname, const SocketCom_ResolveResult *result, void *arg)
+{
+  TestWait *wait = (TestWait *)arg;
+  (void)hostname;
+
+  pthread_mutex_lock(&wait->mutex);
+  wait->done++;
+  if (result->res == SOCKETCOM_SUCCESS) {
+    wait->succeeded++;
+  }
+  pthread_cond_signal(&wait->cond);
+  pthread_mutex_unlock(&wait->mutex);
+}
+
+static int test_has_addr(const SocketCom_ResolveResult *result, int family, const char *ip)
+{
+  int i;
+  char addr[16];
+
+  if (inet_pton(family, ip, addr) != 1) {
+    return 0;
+  }
+  for (i = 0; i < result->addrs_len; i++) {
+    const struct sockaddr_storage *ss = &result->addrs[i];
+    if (ss->ss_family == AF_INET && family == AF_INET && memcmp(&((const struct sockaddr_in *)ss)->sin_addr, addr, 4) == 0) {
+      return 1;
+    }
+    if (ss->ss_family == AF_INET6 && family == AF_INET6 && memcmp(&((const struct sockaddr_in6 *)ss)->sin6_addr, addr, 16) == 0) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static int test_only_family(const SocketCom_ResolveResult *result, int family)
+{
+  int i;
+  for (i = 0; i < result->addrs_len; i++) {
+    if (result->addrs[i].ss_family != family) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+static void test_coalescing(const char *hostname)
+{
+  SocketCom_Resolver resolver;
+  SocketCom_ResolverStats stats;
+  TestWait wait;
+  int i;
+
+  memset(&wait, 0, sizeof(wait));
+  pthread_mutex_init(&wait.mutex, NULL);
+  pthread_cond_init(&wait.cond, NULL);
+
+  SocketCom_ResolverCreate(&resolver, 4, -1, -1);
+  for (i = 0; i < TEST_REQUESTS; i++) {
+    SocketCom_ResolverResolve(&resolver, hostname, AF_UNSPEC, test_on_resolved, &wait);
+  }
+  pthread_mutex_lock(&wait.mutex);
+  while (wait.done < TEST_REQUESTS) {
+    pthread_cond_wait(&wait.cond, &wait.mutex);
+  }
+  pthread_mutex_unlock(&wait.mutex);
+
+  SocketCom_ResolverGetStats(&resolver, &stats);
+  printf("     requests %llu resolves %llu coalesced %llu cache_hits %llu\n", stats.requests, stats.resolves, stats.coalesced, stats.cache_hits);
+  TEST_CHECK(wait.succeeded == TEST_REQUESTS, "coalescing: every request is answered");
+  TEST_CHECK(stats.requests == TEST_REQUESTS, "coalescing: requests are counted");
+  TEST_CHECK(stats.resolves == 1, "coalescing: concurrent requests share one getaddrinfo()");
+  TEST_CHECK(stats.coalesced + stats.cache_hits == TEST_REQUESTS - 1, "coalescing: the others wait for it or hit the cache");
+
+  SocketCom_ResolverDestroy(&resolver);
+  pthread_cond_destroy(&wait.cond);
+  pthread_mutex_destroy(&wait.mutex);
+}
+
+static void test_positive_ttl(const char *hostname)
+{
+  SocketCom_Resolver resolver;
+  SocketCom_ResolverStats stats;
+  SocketCom_ResolveResult result;
+
+  SocketCom_ResolverCreate(&resolver, 1, TEST_TTL_MSEC, TEST_TTL_MSEC);
+  TEST_CHECK(SocketCom_ResolverLookup(&resolver, hostname, AF_UNSPEC, &result, -1) == SOCKETCOM_SUCCESS, "positive ttl: first lookup resolves");
+  TEST_CHECK(SocketCom_ResolverLookup(&resolver, hostname, AF_UNSPEC, &result, 0) == SOCKETCOM_SUCCESS, "positive ttl: cached result without waiting");
+  SocketCom_ResolverGetStats(&resolver, &stats);
+  TEST_CHECK(stats.resolves == 1 && stats.cache_hits == 1, "positive ttl: second lookup is a cache hit");
+
+  usleep((TEST_TTL_MSEC + 100) * 1000);
+  TEST_CHECK(SocketCom_ResolverLookup(&resolver, hostname, AF_UNSPEC, &result, -1) == SOCKETCOM_SUCCESS, "positive ttl: lookup after expiry");
+  SocketCom_ResolverGetStats(&resolver, &stats);
+  TEST_CHECK(stats.resolves == 2, "positive ttl: expired entry is resolved again");
+
+  SocketCom_ResolverFlush(&resolver);
+  SocketCom_ResolverLookup(&resolver, hostname, AF_UNSPEC, &result, -1);
+  SocketCom_ResolverGetStats(&resolver, &stats);
+  TEST_CHECK(stats.resolves == 3, "positive ttl: flushed entry is resolved again");
+
+  SocketCom_ResolverDestroy(&resolver);
+}
+
+static void test_negative_ttl(void)
+{
+  SocketCom_Resolver resolver;
+  SocketCom_ResolverStats stats;
+  SocketCom_ResolveResult result;
+
+  SocketCom_ResolverCreate(&resolver, 1, TEST_TTL_MSEC, TEST_TTL_MSEC);
+  TEST_CHECK(SocketCom_ResolverLookup(&resolver, TEST_MISSING_NAME, AF_UNSPEC, &result, -1) == SOCKETCOM_ERROR_SLAVEHOSTNAME, "negative ttl: missing name fails");
+  TEST_CHECK(SocketCom_ResolverLookup(&resolver, TEST_MISSING_NAME, AF_UNSPEC, &result, 0) == SOCKETCOM_ERROR_SLAVEHOSTNAME, "negative ttl: cached failure without waiting");
+  SocketCom_ResolverGetStats(&resolver, &stats);
+  TEST_CHECK(stats.resolves == 1 && stats.negative_hits == 1, "negative ttl: second lookup is a negative hit");
+
+  usleep((TEST_TTL_MSEC + 100) * 1000);
+  SocketCom_ResolverLookup(&resolver, TEST_MISSING_NAME, AF_UNSPEC, &result, -1);
+  SocketCom_ResolverGetStats(&resolver, &stats);
+  TEST_CHECK(stats.resolves == 2, "negative ttl: expired failure is resolved again");
+
+  SocketCom_ResolverDestroy(&resolver);
+}
+
+static void test_families(const char *hostname)
+{
+  SocketCom_Resolver resolver;
+  SocketCom_ResolverStats stats;
+  SocketCom_ResolveResult result4;
+  SocketCom_ResolveResult result6;
+  SocketCom_ResolveResult result;
+  int res6;
+
+  SocketCom_ResolverCreate(&resolver, 2, -1, -1);
+
+  TEST_CHECK(SocketCom_ResolverLookup(&resolver, hostname, AF_INET, &result4, -1) == SOCKETCOM_SUCCESS, "A: resolved");
+  TEST_CHECK(result4.addrs_len > 0 && test_only_family(&result4, AF_INET), "A: only IPv4 addresses");
+  if (strcmp(hostname, "localhost") == 0) {
+    TEST_CHECK(test_has_addr(&result4, AF_INET, "127.0.0.1"), "A: localhost is 127.0.0.1");
+  }
+
+  // the host may have no IPv6 entry for the name; then AAAA fails as a whole
+  res6 = SocketCom_ResolverLookup(&resolver, hostname, AF_INET6, &result6, -1);
+  TEST_CHECK(res6 == SOCKETCOM_SUCCESS || res6 == SOCKETCOM_ERROR_SLAVEHOSTNAME, "AAAA: resolved or not found");
+  TEST_CHECK(res6 != SOCKETCOM_SUCCESS || (result6.addrs_len > 0 && test_only_family(&result6, AF_INET6)), "AAAA: only IPv6 addresses");
+  if (res6 == SOCKETCOM_SUCCESS && strcmp(hostname, "localhost") == 0) {
+    TEST_CHECK(test_has_addr(&result6, AF_INET6, "::1"), "AAAA: localhost is ::1");
+  }
+
+  SocketCom_ResolverGetStats(&resolver, &stats);
+  TEST_CHECK(stats.resolves == 2, "A/AAAA: families are cached separately");
+
+  TEST_CHECK(SocketCom_ResolverLookup(&resolver, "::1", AF_INET6, &result, 0) == SOCKETCOM_SUCCESS && result.addrs_len == 1
+             && test_has_addr(&result, AF_INET6, "::1"), "AAAA: IPv6 address string without resolving");
+  TEST_CHECK(SocketCom_ResolverLookup(&resolver, "127.0.0.1", AF_INET6, &result, -1) == SOCKETCOM_ERROR_SLAVEHOSTNAME && result.addrs_len == 0,
+             "AAAA: IPv4 address string is not IPv6");
+  TEST_CHECK(SocketCom_ResolverLookup(&resolver, "::1", AF_INET, &result, -1) == SOCKETCOM_ERROR_SLAVEHOSTNAME && result.addrs_len == 0,
+             "A: IPv6 address string is not IPv4");
+  SocketCom_ResolverGetStats(&resolver, &stats);
+  TEST_CHECK(stats.requests == 2 && stats.resolves == 2, "A/AAAA: address strings are neither requested nor resolved");
+
+  SocketCom_ResolverDestroy(&resolver);
+}
+
+int main(int argc, char *argv[])
+{
+  const char *hostname = (argc > 1) ? argv[1] : "localhost";
+
+  test_coalescing(hostname);
+  test_positive_ttl(hostname);
+  test_negative_ttl();
+  test_families(hostname);
+
+  printf("%s: %d failure(s)\n", (test_failures == 0) ? "OK" : "NG", test_failures);
+  return (test_failures == 0) ? 0 : 1;
+}